@@ -5,18 +5,26 @@
 #include "filesystemfunc.h"
 
 #include <direct.h> //for _getcwd()
-#include <algorithm> //for std::transform()
+#include <string.h> //for memchr()
 
 #include <sys/types.h>
 #include <sys/stat.h>
 #ifndef WIN32
 #include <unistd.h>
+#include <dirent.h> //for opendir()
+#include <fcntl.h> //for open()
+#include <errno.h>
+#include <sys/mman.h> //for mmap()
 #endif
 #ifdef WIN32
 #define stat _stat
 #include <Windows.h> //for GetShortPathName()
+#include <process.h> //for _getpid()
+#define getpid _getpid
 #endif
 
+#include "nativefunc.h"
+
 namespace filesystem
 {
 
@@ -80,25 +88,30 @@ namespace filesystem
     if (iPath == NULL || iPath[0] == '\0')
       return false;
 
-    std::string localFolder = getCurrentFolder();
-    bool success = (_chdir(iPath) == 0);
-    if (success)
-      _chdir(localFolder.c_str());
-    return success;
+    //the current directory of the process must not be changed: other threads may use relative paths
+#ifdef WIN32
+    DWORD attributes = GetFileAttributes(iPath);
+    return (attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+#else
+    struct stat info;
+    return (stat(iPath, &info) == 0 && S_ISDIR(info.st_mode));
+#endif
   }
 
   std::string getTemporaryFileName()
   {
-    //get positive random value
-    int value = rand();
-    if (value < 0)
-      value *= -1;
-
-    //RAND_MAX expected to get as high as 32768
-    //5 characters is required for printing the value
+    //A counter shared by all threads makes the name unique within the process.
+    //The process id and the clock make the name unique between processes.
+    static volatile long counter = 0;
+#ifdef WIN32
+    unsigned int value = (unsigned int)InterlockedIncrement(&counter);
+#else
+    unsigned int value = (unsigned int)__sync_add_and_fetch(&counter, 1);
+#endif
+    uint32_t clock = (uint32_t)nativefunc::getHighResolutionTime();
 
-    char str[1024];
-    sprintf(str, "random.%05d.tmp", value);
+    char str[64];
+    sprintf(str, "random.%u.%05u.%08x.tmp", (unsigned int)getpid(), value, clock);
 
     return std::string(str);
   }
@@ -130,50 +143,233 @@ namespace filesystem
     return parent;
   }
 
+  //Converts a character of a long name to the character of a short name.
+  //Returns 0 if the character is removed.
+  inline char toShortNameCharacter(unsigned char c)
+  {
+    if (c == ' ' || c == '.' || c < 0x20 || strchr("\"*/:<>?\\|", c) != NULL)
+      return 0;
+    if (strchr("+,;=[]", c) != NULL)
+      return '_';
+    if (c >= 'a' && c <= 'z')
+      return (char)(c - 'a' + 'A');
+    if (c >= 0xE0 && c <= 0xFE && c != 0xF7)
+      return (char)(c - 0x20); //Latin-1 accented letters
+    return (char)c;
+  }
+
+  //Checksum of a long name used by the hashed short names
+  uint16_t getShortNameChecksum(const char * iName, size_t iLength)
+  {
+    const unsigned char * name = (const unsigned char *)iName;
+    if (iLength == 0)
+      return 0;
+    if (iLength == 1)
+      return name[0];
+
+    uint16_t hash = (uint16_t)((name[0] << 8) + name[1]);
+    uint16_t saved = hash;
+    for(size_t i=2; i<iLength; i+=2)
+    {
+      hash = (uint16_t)((hash << 7) + name[i]);
+      hash = (uint16_t)((saved >> 1) + (hash << 8));
+      if (i + 1 < iLength)
+        hash = (uint16_t)(hash + name[i+1]);
+      saved = hash;
+    }
+    return hash;
+  }
+
+  bool isShortName(const char * iName, size_t iLength)
+  {
+    if ((iLength == 1 && iName[0] == '.') || (iLength == 2 && iName[0] == '.' && iName[1] == '.'))
+      return true;
+    if (iLength == 0 || iLength > 12)
+      return false;
+
+    size_t dot = iLength;
+    for(size_t i=0; i<iLength; i++)
+    {
+      unsigned char c = (unsigned char)iName[i];
+      if (c == '.')
+      {
+        if (dot != iLength || i == 0)
+          return false; //leading or multiple periods
+        dot = i;
+      }
+      else if (c == ' ' || c < 0x20 || strchr("\"*/:<>?\\|+,;=[]", c) != NULL)
+        return false;
+    }
+
+    size_t baseLength = dot;
+    size_t extLength = (dot == iLength ? 0 : iLength - dot - 1);
+    if (dot != iLength && extLength == 0)
+      return false; //trailing period
+    return (baseLength <= 8 && extLength <= 3);
+  }
+
+  std::string buildShortName(const char * iName, size_t iLength, unsigned long iIndex)
+  {
+    //the extension follows the last period. Leading periods are ignored.
+    size_t start = 0;
+    while(start < iLength && iName[start] == '.')
+      start++;
+    size_t dot = iLength;
+    for(size_t i=iLength; i>start; i--)
+    {
+      if (iName[i-1] == '.')
+      {
+        dot = i-1;
+        break;
+      }
+    }
+
+    std::string base;
+    for(size_t i=start; i<dot && base.size() < 6; i++)
+    {
+      char c = toShortNameCharacter((unsigned char)iName[i]);
+      if (c != 0)
+        base += c;
+    }
+    std::string extension;
+    for(size_t i=dot+1; i<iLength && extension.size() < 3; i++)
+    {
+      char c = toShortNameCharacter((unsigned char)iName[i]);
+      if (c != 0)
+        extension += c;
+    }
+
+    //~1 to ~4 keep the name. The following names are hashed.
+    char tail[16];
+    if (iIndex <= 4)
+    {
+      sprintf(tail, "~%u", (unsigned int)iIndex);
+    }
+    else
+    {
+      static const char * HEX = "0123456789ABCDEF";
+      uint16_t checksum = getShortNameChecksum(iName, iLength);
+      base.resize(base.size() < 2 ? base.size() : 2);
+      for(int i=3; i>=0; i--)
+        base += HEX[(checksum >> (i*4)) & 0x0F];
+      sprintf(tail, "~%u", (unsigned int)(iIndex - 4));
+    }
+
+    size_t tailLength = strlen(tail);
+    std::string shortName = base.substr(0, 8 - tailLength);
+    shortName.append(tail);
+    if (!extension.empty())
+    {
+      shortName.append(".");
+      shortName.append(extension);
+    }
+    return shortName;
+  }
+
   std::string getShortPathFormEstimation(const std::string & iPath)
   {
     std::string shortPath;
+    shortPath.reserve(iPath.size());
+
+    PathTokenizer tokenizer(iPath);
+    if (tokenizer.isUnc())
+      shortPath.append("\\\\");
+    size_t numRootElements = (tokenizer.isUnc() ? 2 : (tokenizer.hasDrive() ? 1 : 0));
 
-    std::vector<std::string> pathElements;
-    splitPath(iPath, pathElements);
-    for(size_t i=0; i<pathElements.size(); i++)
+    PathElement element;
+    for(size_t i=0; tokenizer.next(element); i++)
     {
-      const std::string & element = pathElements[i];
-      if (element.size() > 12 || element.find(' ') != std::string::npos)
+      if (i > 0)
+        shortPath.append("\\");
+
+      if (i < numRootElements || isShortName(element.value, element.length))
       {
-        std::string element83 = element;
-        std::string ext = getFileExtention(element);
-        stringfunc::strReplace(element83, (std::string(".")+ext).c_str(), ""); //remove extension from filename
-        stringfunc::strReplace(ext, " ", ""); //remove spaces in extension
-        ext = ext.substr(0, 3); //truncate file extension
-        stringfunc::strReplace(element83, " ", ""); //remove spaces
-        element83 = element83.substr(0, 6); //truncate file name
-        element83.append("~1");
-        if (!ext.empty())
-        {
-          element83.append(".");
-          element83.append(ext);
-        }
- 
-        //uppercase everything
-        std::transform(element83.begin(), element83.end(), element83.begin(), ::toupper);
- 
-        //add to shortPath
-        if (!shortPath.empty())
-          shortPath.append("\\");
-        shortPath.append(element83);
+        //drive, server, share and valid 8.3 names are copied from the path
+        shortPath.append(element.value, element.length);
       }
       else
       {
-        if (!shortPath.empty())
-          shortPath.append("\\");
-        shortPath.append(element);
+        //without a folder context, each name is the first of its folder
+        shortPath.append(buildShortName(element.value, element.length, 1));
       }
     }
 
     return shortPath;
   }
 
+  std::string ShortNameGenerator::getShortName(FOLDER & ioFolder, const char * iName, size_t iLength)
+  {
+    std::string key = stringfunc::uppercase(std::string(iName, iLength));
+    std::map<std::string, std::string>::const_iterator found = ioFolder.names.find(key);
+    if (found != ioFolder.names.end())
+      return found->second;
+
+    std::string shortName;
+    if (isShortName(iName, iLength))
+      shortName.assign(iName, iLength);
+    else
+    {
+      for(unsigned long index=1; shortName.empty(); index++)
+      {
+        std::string candidate = buildShortName(iName, iLength, index);
+        if (ioFolder.shortNames.find(candidate) == ioFolder.shortNames.end())
+          shortName = candidate;
+      }
+    }
+
+    ioFolder.names[key] = shortName;
+    ioFolder.shortNames.insert(stringfunc::uppercase(shortName));
+    return shortName;
+  }
+
+  std::string ShortNameGenerator::getShortName(const std::string & iFolder, const std::string & iName)
+  {
+    //folders are identified by their uppercase elements
+    std::string key;
+    PathTokenizer tokenizer(iFolder);
+    PathElement element;
+    while(tokenizer.next(element))
+    {
+      key.append("\\");
+      key.append(element.value, element.length);
+    }
+    FOLDER & folder = mFolders[stringfunc::uppercase(key)];
+    return getShortName(folder, iName.c_str(), iName.size());
+  }
+
+  std::string ShortNameGenerator::getShortPath(const std::string & iPath)
+  {
+    std::string shortPath;
+
+    PathTokenizer tokenizer(iPath);
+    if (tokenizer.isUnc())
+      shortPath.append("\\\\");
+    size_t numRootElements = (tokenizer.isUnc() ? 2 : (tokenizer.hasDrive() ? 1 : 0));
+
+    std::string folder; //uppercase long path of the parent folder
+    PathElement element;
+    for(size_t i=0; tokenizer.next(element); i++)
+    {
+      if (i > 0)
+        shortPath.append("\\");
+
+      if (i < numRootElements)
+        shortPath.append(element.value, element.length);
+      else
+        shortPath.append(getShortName(mFolders[folder], element.value, element.length));
+
+      folder.append("\\");
+      folder.append(stringfunc::uppercase(std::string(element.value, element.length)));
+    }
+
+    return shortPath;
+  }
+
+  void ShortNameGenerator::clear()
+  {
+    mFolders.clear();
+  }
+
   std::string getShortPathFormWin32(const std::string & iPath)
   {
     std::string shortPath;
@@ -242,27 +438,76 @@ namespace filesystem
   void splitPath(const std::string & iPath, std::vector<std::string> & oElements)
   {
     oElements.clear();
-    std::string s = iPath;
-    std::string accumulator;
-    for(unsigned int i = 0; i<s.size(); i++)
+    PathTokenizer tokenizer(iPath);
+    oElements.reserve(tokenizer.count());
+    PathElement element;
+    while(tokenizer.next(element))
     {
-      const char & c = s[i];
-      if ((c == '/' || c == '\\'))
-      {
-        if (accumulator.size() > 0)
-        {
-          oElements.push_back(accumulator);
-          accumulator = "";
-        }
-      }
-      else
-        accumulator += c;
+      oElements.push_back(std::string(element.value, element.length));
     }
-    if (accumulator.size() > 0)
+  }
+
+  inline bool isPathSeparator(char c)
+  {
+    return (c == '/' || c == '\\');
+  }
+
+  PathTokenizer::PathTokenizer(const char * iPath) :
+    mPath(iPath == NULL ? "" : iPath),
+    mLength(iPath == NULL ? 0 : strlen(iPath)),
+    mOffset(0)
+  {
+  }
+
+  PathTokenizer::PathTokenizer(const std::string & iPath) :
+    mPath(iPath.c_str()),
+    mLength(iPath.size()),
+    mOffset(0)
+  {
+  }
+
+  bool PathTokenizer::next(PathElement & oElement)
+  {
+    //skip separators, including the leading separators of a UNC path
+    while(mOffset < mLength && isPathSeparator(mPath[mOffset]))
+      mOffset++;
+    if (mOffset == mLength)
+      return false;
+
+    size_t start = mOffset;
+    while(mOffset < mLength && !isPathSeparator(mPath[mOffset]))
+      mOffset++;
+
+    oElement.value = mPath + start;
+    oElement.length = mOffset - start;
+    return true;
+  }
+
+  void PathTokenizer::reset()
+  {
+    mOffset = 0;
+  }
+
+  size_t PathTokenizer::count() const
+  {
+    size_t count = 0;
+    for(size_t i=0; i<mLength; i++)
     {
-      oElements.push_back(accumulator);
-      accumulator = "";
+      //count the first character of each element
+      if (!isPathSeparator(mPath[i]) && (i == 0 || isPathSeparator(mPath[i-1])))
+        count++;
     }
+    return count;
+  }
+
+  bool PathTokenizer::hasDrive() const
+  {
+    return (mLength >= 2 && mPath[1] == ':' && isalpha((unsigned char)mPath[0]));
+  }
+
+  bool PathTokenizer::isUnc() const
+  {
+    return (mLength >= 2 && isPathSeparator(mPath[0]) && isPathSeparator(mPath[1]));
   }
 
   char getPathSeparator()
@@ -419,4 +664,267 @@ namespace filesystem
     return mod_time;
   }
 
+  bool findFiles(const char * iFolder, bool iRecursive, std::vector<std::string> & oFiles)
+  {
+    if (iFolder == NULL || iFolder[0] == '\0')
+      return false;
+
+    std::string folder = iFolder;
+    if (folder[folder.size()-1] != getPathSeparator())
+      folder += getPathSeparator();
+
+    std::vector<std::string> subFolders;
+
+#ifdef WIN32
+    std::string pattern = folder + "*";
+    WIN32_FIND_DATA findData;
+    HANDLE hFind = FindFirstFile(pattern.c_str(), &findData);
+    if (hFind == INVALID_HANDLE_VALUE)
+      return false;
+    do
+    {
+      std::string name = findData.cFileName;
+      if (name == "." || name == "..")
+        continue;
+      if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        subFolders.push_back(folder + name);
+      else
+        oFiles.push_back(folder + name);
+    }
+    while (FindNextFile(hFind, &findData) != 0);
+    FindClose(hFind);
+#else
+    DIR * dir = opendir(folder.c_str());
+    if (dir == NULL)
+      return false;
+    struct dirent * entry = NULL;
+    while ((entry = readdir(dir)) != NULL)
+    {
+      std::string name = entry->d_name;
+      if (name == "." || name == "..")
+        continue;
+      std::string path = folder + name;
+      struct stat result;
+      if (stat(path.c_str(), &result) != 0)
+        continue;
+      if (S_ISDIR(result.st_mode))
+        subFolders.push_back(path);
+      else
+        oFiles.push_back(path);
+    }
+    closedir(dir);
+#endif
+
+    if (iRecursive)
+    {
+      for(size_t i=0; i<subFolders.size(); i++)
+      {
+        findFiles(subFolders[i].c_str(), iRecursive, oFiles);
+      }
+    }
+    return true;
+  }
+
+  bool createFolder(const char * iPath)
+  {
+    if (iPath == NULL || iPath[0] == '\0')
+      return false;
+
+    if (folderExists(iPath))
+      return true;
+
+#ifdef WIN32
+    return (_mkdir(iPath) == 0);
+#else
+    return (mkdir(iPath, 0755) == 0);
+#endif
+  }
+
+  //Creates or truncates a file and writes the whole buffer
+  bool writeFileContent(const char * iPath, const void * iData, size_t iSize)
+  {
+    const char * data = (const char *)iData;
+#ifdef WIN32
+    HANDLE f = CreateFileA(iPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE)
+      return false;
+    bool success = true;
+    while(iSize > 0 && success)
+    {
+      DWORD written = 0;
+      success = (WriteFile(f, data, (DWORD)iSize, &written, NULL) != 0 && written > 0);
+      data += written;
+      iSize -= written;
+    }
+    return (CloseHandle(f) != 0) && success;
+#else
+    int f = open(iPath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (f == -1)
+      return false;
+    bool success = true;
+    while(iSize > 0 && success)
+    {
+      ssize_t written = write(f, data, iSize);
+      if (written == -1 && errno == EINTR)
+        continue;
+      success = (written > 0);
+      if (success)
+      {
+        data += written;
+        iSize -= written;
+      }
+    }
+    return (close(f) == 0) && success;
+#endif
+  }
+
+  bool writeFile(const char * iPath, const void * iData, size_t iSize, bool iAtomic)
+  {
+    if (iPath == NULL || iPath[0] == '\0')
+      return false;
+
+    if (!iAtomic)
+      return writeFileContent(iPath, iData, iSize);
+
+    //the temporary file must be in the same folder to be renamed
+    std::string path = iPath;
+    std::size_t offset = path.find_last_of("/\\");
+    std::string temp = (offset == std::string::npos ? std::string() : path.substr(0, offset+1)) + getTemporaryFileName();
+
+    bool success = writeFileContent(temp.c_str(), iData, iSize) && renameFile(temp.c_str(), iPath);
+    if (!success)
+      remove(temp.c_str());
+    return success;
+  }
+
+  bool renameFile(const char * iPath, const char * iNewPath)
+  {
+    if (iPath == NULL || iNewPath == NULL)
+      return false;
+#ifdef WIN32
+    return (MoveFileExA(iPath, iNewPath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+    return (rename(iPath, iNewPath) == 0);
+#endif
+  }
+
+  bool syncFile(const char * iPath)
+  {
+    if (iPath == NULL || iPath[0] == '\0')
+      return false;
+#ifdef WIN32
+    HANDLE f = CreateFileA(iPath, GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE)
+      return false;
+    bool success = (FlushFileBuffers(f) != 0);
+    return (CloseHandle(f) != 0) && success;
+#else
+    int f = open(iPath, O_RDONLY);
+    if (f == -1)
+      return false;
+    bool success = (fsync(f) == 0);
+    return (close(f) == 0) && success;
+#endif
+  }
+
+  bool syncFolder(const char * iPath)
+  {
+    if (iPath == NULL || iPath[0] == '\0')
+      return false;
+#ifdef WIN32
+    return folderExists(iPath);
+#else
+    int f = open(iPath, O_RDONLY);
+    if (f == -1)
+      return false;
+    bool success = (fsync(f) == 0);
+    return (close(f) == 0) && success;
+#endif
+  }
+
+  MappedFile::MappedFile() :
+    mBuffer(NULL),
+    mSize(0)
+  {
+  }
+
+  MappedFile::~MappedFile()
+  {
+    close();
+  }
+
+  bool MappedFile::open(const char * iPath)
+  {
+    close();
+    if (iPath == NULL || iPath[0] == '\0')
+      return false;
+#ifdef WIN32
+    HANDLE f = CreateFileA(iPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE)
+      return false;
+    LARGE_INTEGER size;
+    bool success = (GetFileSizeEx(f, &size) != 0 && (uint64_t)size.QuadPart <= (size_t)-1);
+    if (success && size.QuadPart > 0)
+    {
+      //the view keeps the mapping alive once the handles are closed
+      HANDLE mapping = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+      success = (mapping != NULL);
+      if (success)
+      {
+        mBuffer = (const unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        success = (mBuffer != NULL);
+        CloseHandle(mapping);
+      }
+    }
+    CloseHandle(f);
+    if (!success)
+      return false;
+    mSize = (size_t)size.QuadPart;
+    return true;
+#else
+    int f = ::open(iPath, O_RDONLY);
+    if (f == -1)
+      return false;
+    struct stat info;
+    bool success = (fstat(f, &info) == 0 && (uint64_t)info.st_size <= (size_t)-1);
+    if (success && info.st_size > 0)
+    {
+      //the mapping stays valid once the file is closed
+      void * buffer = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, f, 0);
+      success = (buffer != MAP_FAILED);
+      if (success)
+        mBuffer = (const unsigned char *)buffer;
+    }
+    ::close(f);
+    if (!success)
+      return false;
+    mSize = (size_t)info.st_size;
+    return true;
+#endif
+  }
+
+  void MappedFile::close()
+  {
+    if (mBuffer)
+    {
+#ifdef WIN32
+      UnmapViewOfFile(mBuffer);
+#else
+      munmap((void *)mBuffer, mSize);
+#endif
+    }
+    mBuffer = NULL;
+    mSize = 0;
+  }
+
+  const unsigned char * MappedFile::getBuffer() const
+  {
+    return mBuffer;
+  }
+
+  size_t MappedFile::getSize() const
+  {
+    return mSize;
+  }
+
 }; //filesystem
@@ -3,6 +3,8 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
+#include <map>
+#include <set>
 
 namespace filesystem
 {
@@ -37,6 +39,7 @@ namespace filesystem
 
   ///<summary>
   ///Determine if a folder exists.
+  ///The current folder of the process is not modified.
   ///</summary>
   ///<param name="iPath">An valid folder path.</param>
   ///<return>Returns true when the folder exists. Returns false otherwise.<return>
@@ -44,6 +47,7 @@ namespace filesystem
 
   ///<summary>
   ///Returns the file name of a tempporary file.
+  ///Each call returns a different name, including calls from different threads.
   ///</summary>
   ///<return>Returns the file name of a tempporary file.<return>
   std::string getTemporaryFileName();
@@ -69,6 +73,77 @@ namespace filesystem
   ///<param name="iPath">The input path to convert.</param>
   ///<return>Returns the short path form of the given path.<return>
   std::string getShortPathForm(const std::string & iPath);
+
+  ///<summary>
+  ///Estimates the short path form (8.3 format) of a long file path
+  ///without accessing the file system. The path does not need to exist.
+  ///</summary>
+  ///<param name="iPath">The input path to convert.</param>
+  ///<return>Returns the estimated short path form of the given path.<return>
+  std::string getShortPathFormEstimation(const std::string & iPath);
+
+  ///<summary>
+  ///Determine if a name is a valid 8.3 name which is its own short name (ie "README.TXT").
+  ///The case of the letters is ignored.
+  ///</summary>
+  ///<param name="iName">The name of a file or a folder. Not NULL terminated.</param>
+  ///<param name="iLength">The length of the name.</param>
+  ///<return>Returns true when the name is a valid 8.3 name. Returns false otherwise.<return>
+  bool isShortName(const char * iName, size_t iLength);
+
+  ///<summary>
+  ///Builds a short name (8.3 format) of a long name like Windows does.
+  ///Letters are uppercased, spaces and periods other than the extension's are removed
+  ///and the characters "+,;=[]" are replaced by '_'. The name is truncated to make room for a "~N" tail.
+  ///The first 4 names of a folder keep 6 characters of the name (ie "PROGRA~1").
+  ///The following names keep 2 characters followed by a 4 digits hash of the long name (ie "PR3F2A~1").
+  ///</summary>
+  ///<param name="iName">The long name of a file or a folder. Not NULL terminated.</param>
+  ///<param name="iLength">The length of the long name.</param>
+  ///<param name="iIndex">The number of names of the folder which share the same short name, starting at 1.</param>
+  ///<return>Returns the short name of the given name.<return>
+  std::string buildShortName(const char * iName, size_t iLength, unsigned long iIndex);
+
+  ///<summary>
+  ///Generates the short names (8.3 format) of many paths without accessing the file system.
+  ///The short names assigned in each folder are remembered: a name which collides with
+  ///a previous name of the same folder gets the next free "~N" tail, like Windows does
+  ///when the files are created in the same order. The same long name always gets the same short name.
+  ///</summary>
+  class ShortNameGenerator
+  {
+  public:
+    ///<summary>
+    ///Returns the short name of a file or a folder located in the given folder.
+    ///</summary>
+    ///<param name="iFolder">The long path of the parent folder.</param>
+    ///<param name="iName">The long name of the file or the folder.</param>
+    ///<return>Returns the short name of the given name.<return>
+    std::string getShortName(const std::string & iFolder, const std::string & iName);
+
+    ///<summary>
+    ///Returns the short path form of a long path. Each element is named within its parent folder.
+    ///The drive (ie "C:") and the server and share of a UNC path are not modified.
+    ///</summary>
+    ///<param name="iPath">The long path to convert.</param>
+    ///<return>Returns the short path form of the given path.<return>
+    std::string getShortPath(const std::string & iPath);
+
+    ///<summary>
+    ///Forgets all names.
+    ///</summary>
+    void clear();
+
+  private:
+    struct FOLDER
+    {
+      std::map<std::string, std::string> names; //short name of each long name, by uppercase long name
+      std::set<std::string> shortNames;         //uppercase short names in use
+    };
+    std::string getShortName(FOLDER & ioFolder, const char * iName, size_t iLength);
+
+    std::map<std::string, FOLDER> mFolders;     //by uppercase folder path
+  };
  
   ///<summary>
   ///Splits a path into a folder and a filename.
@@ -85,6 +160,61 @@ namespace filesystem
   ///<param name="oElements">The output list which contains all path elements.</param>
   void splitPath(const std::string & iPath, std::vector<std::string> & oElements);
 
+  ///<summary>
+  ///An element of a path. The value points inside the tokenized path and is not NULL terminated.
+  ///</summary>
+  struct PathElement
+  {
+    const char * value;
+    size_t length;
+  };
+
+  ///<summary>
+  ///Iterates over the elements of a path without allocating memory.
+  ///Both '/' and '\' are separators and empty elements are skipped:
+  ///"C:\Program Files\7-Zip" gives "C:", "Program Files" and "7-Zip",
+  ///"\\server\share\file.txt" gives "server", "share" and "file.txt".
+  ///The path must remain valid while the tokenizer is used.
+  ///</summary>
+  class PathTokenizer
+  {
+  public:
+    PathTokenizer(const char * iPath);
+    PathTokenizer(const std::string & iPath);
+
+    ///<summary>
+    ///Gets the next element of the path.
+    ///</summary>
+    ///<param name="oElement">The output element.</param>
+    ///<return>Returns true if an element is found. Returns false when all elements were returned.<return>
+    bool next(PathElement & oElement);
+
+    ///<summary>
+    ///Restarts at the first element of the path.
+    ///</summary>
+    void reset();
+
+    ///<summary>
+    ///Returns the number of elements of the path.
+    ///</summary>
+    size_t count() const;
+
+    ///<summary>
+    ///Returns true if the path starts with a drive letter (ie "C:").
+    ///</summary>
+    bool hasDrive() const;
+
+    ///<summary>
+    ///Returns true if the path starts with two separators (ie "\\server\share").
+    ///</summary>
+    bool isUnc() const;
+
+  private:
+    const char * mPath;
+    size_t mLength;
+    size_t mOffset;
+  };
+
   ///<summary>
   ///Gets the character that represents the path separator.
   ///</summary>
@@ -128,4 +258,88 @@ namespace filesystem
   ///<return>Returns the modified date of the given file.<return>
   uint64_t getFileModifiedDate(const std::string & iPath);
 
+  ///<summary>
+  ///Finds all files of a folder.
+  ///Folders are not listed but their files are when searching recursively.
+  ///</summary>
+  ///<param name="iFolder">The path of the folder to search.</param>
+  ///<param name="iRecursive">Also search the files of the sub folders.</param>
+  ///<param name="oFiles">The output list which receives the path of each file found. Paths are appended to the list.</param>
+  ///<return>Returns true if the folder can be searched. Returns false otherwise.<return>
+  bool findFiles(const char * iFolder, bool iRecursive, std::vector<std::string> & oFiles);
+
+  ///<summary>
+  ///Creates a folder. The parent folder must already exist.
+  ///</summary>
+  ///<param name="iPath">The path of the folder to create.</param>
+  ///<return>Returns true if the folder is created or already exists. Returns false otherwise.<return>
+  bool createFolder(const char * iPath);
+
+  ///<summary>
+  ///Writes a buffer to a file with native write calls, without an intermediate stdio buffer.
+  ///In atomic mode, the data is written to a temporary file of the same folder which then replaces
+  ///the destination file: readers see either the previous file or the complete new file.
+  ///</summary>
+  ///<param name="iPath">The path of the file to write. An existing file is replaced.</param>
+  ///<param name="iData">The data to write.</param>
+  ///<param name="iSize">The size of the data in bytes.</param>
+  ///<param name="iAtomic">True to replace the file atomically.</param>
+  ///<return>Returns true if all the data is written. Returns false otherwise.<return>
+  bool writeFile(const char * iPath, const void * iData, size_t iSize, bool iAtomic);
+
+  ///<summary>
+  ///Moves a file to a new path of the same volume. An existing file at the new path is replaced atomically.
+  ///</summary>
+  ///<param name="iPath">The path of the file to move.</param>
+  ///<param name="iNewPath">The new path of the file.</param>
+  ///<return>Returns true if the file is moved. Returns false otherwise.<return>
+  bool renameFile(const char * iPath, const char * iNewPath);
+
+  ///<summary>
+  ///Flushes the content of a file to the storage device.
+  ///</summary>
+  ///<param name="iPath">The path of the file.</param>
+  ///<return>Returns true if the file is flushed. Returns false otherwise.<return>
+  bool syncFile(const char * iPath);
+
+  ///<summary>
+  ///Flushes the entries of a folder (ie a renamed file) to the storage device.
+  ///On Windows, folders cannot be flushed and the function only checks that the folder exists.
+  ///</summary>
+  ///<param name="iPath">The path of the folder.</param>
+  ///<return>Returns true if the folder is flushed. Returns false otherwise.<return>
+  bool syncFolder(const char * iPath);
+
+  ///<summary>
+  ///A whole file mapped read-only in memory. The pages are read from the disk when they are accessed.
+  ///</summary>
+  class MappedFile
+  {
+  public:
+    MappedFile();
+    virtual ~MappedFile();
+
+    ///<summary>
+    ///Maps a file in memory. A previously mapped file is released.
+    ///</summary>
+    ///<param name="iPath">The path of the file to map.</param>
+    ///<return>Returns true if the file is mapped. Returns false otherwise.<return>
+    bool open(const char * iPath);
+
+    ///<summary>
+    ///Releases the mapping. The buffer is no longer valid.
+    ///</summary>
+    void close();
+
+    const unsigned char * getBuffer() const;
+    size_t getSize() const;
+
+  private:
+    MappedFile(const MappedFile &);
+    MappedFile & operator = (const MappedFile &);
+
+    const unsigned char * mBuffer;
+    size_t mSize;
+  };
+
 }; //filesystem
@@ -8,9 +8,17 @@
   #undef min
   #undef max
 #elif _POSIX_C_SOURCE >= 199309L
-  #include <time.h>   // for nanosleep()
+  #include <time.h>   // for nanosleep() and clock_gettime()
 #else
   #include <unistd.h> // for usleep()
+  #include <time.h>   // for clock_gettime()
+#endif
+#if !defined(WIN32)
+  #include <pthread.h>      // for pthread_self()
+  #if defined(__linux__)
+    #include <unistd.h>
+    #include <sys/syscall.h> // for SYS_gettid
+  #endif
 #endif
 
 
@@ -44,4 +52,37 @@ namespace nativefunc
   #endif
   }
 
+  uint64_t getHighResolutionTime()
+  {
+  #if defined(WIN32)
+    //the frequency is queried on each call: a cached value would be shared between threads
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    //split the conversion to prevent overflowing 64 bits
+    const uint64_t ticks = (uint64_t)counter.QuadPart;
+    const uint64_t ticksPerSecond = (uint64_t)frequency.QuadPart;
+    const uint64_t seconds = ticks / ticksPerSecond;
+    const uint64_t remainder = ticks % ticksPerSecond;
+    return seconds * 1000000000ull + (remainder * 1000000000ull) / ticksPerSecond;
+  #else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+  #endif
+  }
+
+  uint32_t getCurrentThreadId()
+  {
+  #if defined(WIN32)
+    return (uint32_t)GetCurrentThreadId();
+  #elif defined(__linux__)
+    return (uint32_t)syscall(SYS_gettid);
+  #else
+    return (uint32_t)(size_t)pthread_self();
+  #endif
+  }
+
 }; //nativefunc
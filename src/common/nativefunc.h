@@ -14,6 +14,19 @@ namespace nativefunc
   ///        If the call is interrupted or encounters an error, then it returns -1<return>
   int millisleep(uint32_t milliseconds);
 
+  ///<summary>
+  ///Returns the value of a monotonic high resolution clock.
+  ///The value has no meaning by itself and must only be used to compute elapsed time.
+  ///</summary>
+  ///<return>Returns the current time of the clock in nanoseconds.<return>
+  uint64_t getHighResolutionTime();
+
+  ///<summary>
+  ///Returns the identifier of the calling thread.
+  ///</summary>
+  ///<return>Returns the identifier of the calling thread as known by the operating system.<return>
+  uint32_t getCurrentThreadId();
+
 }; //nativefunc
 
 #endif //NATIVEFUNC_H
@@ -0,0 +1,402 @@
+#include "Archive.h"
+#include "StageTimer.h"
+#include "Reader.h"
+#include <string.h> //for memcmp()
+
+namespace lnk
+{
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// Defines, Pre-declarations & typedefs
+//----------------------------------------------------------------------------------------------------------------------------------------
+//ZIP records, see the .ZIP File Format Specification (APPNOTE.TXT)
+static const uint32_t ZIP_END_SIGNATURE = 0x06054b50;
+static const uint32_t ZIP64_END_LOCATOR_SIGNATURE = 0x07064b50;
+static const uint32_t ZIP64_END_SIGNATURE = 0x06064b50;
+static const uint32_t ZIP_CENTRAL_SIGNATURE = 0x02014b50;
+static const uint32_t ZIP_LOCAL_SIGNATURE = 0x04034b50;
+static const uint64_t ZIP_END_SIZE = 22;
+static const uint64_t ZIP64_END_LOCATOR_SIZE = 20;
+static const uint64_t ZIP64_END_SIZE = 56;
+static const uint64_t ZIP_CENTRAL_SIZE = 46;
+static const uint64_t ZIP_LOCAL_SIZE = 30;
+static const uint64_t ZIP_MAX_COMMENT_SIZE = 0xFFFF;
+static const uint16_t ZIP64_EXTRA_ID = 0x0001;
+static const uint16_t ZIP_FLAG_ENCRYPTED = 0x0001;
+static const uint16_t ZIP_METHOD_STORED = 0;
+static const uint16_t ZIP_METHOD_DEFLATED = 8;
+
+//TAR headers, see the ustar format of POSIX.1-1988 and the pax format of POSIX.1-2001
+static const uint64_t TAR_BLOCK_SIZE = 512;
+static const size_t TAR_NAME_OFFSET = 0;
+static const size_t TAR_NAME_SIZE = 100;
+static const size_t TAR_SIZE_OFFSET = 124;
+static const size_t TAR_SIZE_SIZE = 12;
+static const size_t TAR_CHECKSUM_OFFSET = 148;
+static const size_t TAR_CHECKSUM_SIZE = 8;
+static const size_t TAR_TYPE_OFFSET = 156;
+static const size_t TAR_MAGIC_OFFSET = 257;
+static const size_t TAR_PREFIX_OFFSET = 345;
+static const size_t TAR_PREFIX_SIZE = 155;
+
+inline uint16_t readLittleEndian16(const unsigned char * iBuffer)
+{
+  return (uint16_t)(iBuffer[0] | (iBuffer[1] << 8));
+}
+
+inline uint32_t readLittleEndian32(const unsigned char * iBuffer)
+{
+  return (uint32_t)iBuffer[0] | ((uint32_t)iBuffer[1] << 8) | ((uint32_t)iBuffer[2] << 16) | ((uint32_t)iBuffer[3] << 24);
+}
+
+inline uint64_t readLittleEndian64(const unsigned char * iBuffer)
+{
+  return (uint64_t)readLittleEndian32(iBuffer) | ((uint64_t)readLittleEndian32(iBuffer + 4) << 32);
+}
+
+//Returns true if iSize bytes at iOffset are within an archive of iArchiveSize bytes.
+inline bool isInArchive(uint64_t iOffset, uint64_t iSize, uint64_t iArchiveSize)
+{
+  return iOffset <= iArchiveSize && iSize <= iArchiveSize - iOffset;
+}
+
+//Reads the 64 bits sizes and offset of a ZIP64 extended information extra field.
+//A value is only stored in the field when its 32 bits value in the central header is 0xFFFFFFFF.
+bool readZip64Extra(const unsigned char * iExtra, uint16_t iExtraSize, uint64_t & ioUncompressedSize, uint64_t & ioCompressedSize, uint64_t & ioLocalOffset)
+{
+  size_t offset = 0;
+  while(offset + 4 <= iExtraSize)
+  {
+    const uint16_t id = readLittleEndian16(iExtra + offset);
+    const uint16_t size = readLittleEndian16(iExtra + offset + 2);
+    offset += 4;
+    if (offset + size > iExtraSize)
+      return false;
+    if (id == ZIP64_EXTRA_ID)
+    {
+      const unsigned char * field = iExtra + offset;
+      const unsigned char * end = field + size;
+      uint64_t * values[] = {&ioUncompressedSize, &ioCompressedSize, &ioLocalOffset};
+      for(size_t i=0; i<sizeof(values)/sizeof(values[0]); i++)
+      {
+        if (*values[i] != 0xFFFFFFFF)
+          continue;
+        if (end - field < 8)
+          return false;
+        *values[i] = readLittleEndian64(field);
+        field += 8;
+      }
+      return true;
+    }
+    offset += size;
+  }
+  return true;
+}
+
+//Reads a numeric field of a TAR header: octal digits or, for large values, a base-256 number flagged by the high bit of the first byte.
+bool readTarNumber(const unsigned char * iField, size_t iSize, uint64_t & oValue)
+{
+  oValue = 0;
+  if (iField[0] & 0x80)
+  {
+    if (iField[0] != 0x80)
+      return false; //negative or larger than 64 bits
+    for(size_t i=1; i<iSize; i++)
+    {
+      if (oValue >> 56)
+        return false;
+      oValue = (oValue << 8) | iField[i];
+    }
+    return true;
+  }
+
+  size_t i = 0;
+  while(i < iSize && iField[i] == ' ')
+    i++;
+  bool digits = false;
+  for(; i<iSize && iField[i] >= '0' && iField[i] <= '7'; i++)
+  {
+    if (oValue >> 61)
+      return false;
+    oValue = (oValue << 3) | (iField[i] - '0');
+    digits = true;
+  }
+  return digits && (i == iSize || iField[i] == ' ' || iField[i] == '\0');
+}
+
+//Returns true if the checksum of a TAR header is valid.
+//The checksum is the sum of the bytes of the header where the checksum field is counted as spaces.
+//Some old archivers used signed bytes: both sums are accepted.
+bool hasTarChecksum(const unsigned char * iHeader)
+{
+  uint64_t checksum = 0;
+  if (!readTarNumber(iHeader + TAR_CHECKSUM_OFFSET, TAR_CHECKSUM_SIZE, checksum))
+    return false;
+  uint64_t unsignedSum = 0;
+  int64_t signedSum = 0;
+  for(size_t i=0; i<TAR_BLOCK_SIZE; i++)
+  {
+    const unsigned char value = (i >= TAR_CHECKSUM_OFFSET && i < TAR_CHECKSUM_OFFSET + TAR_CHECKSUM_SIZE ? ' ' : iHeader[i]);
+    unsignedSum += value;
+    signedSum += (signed char)value;
+  }
+  return checksum == unsignedSum || (int64_t)checksum == signedSum;
+}
+
+//Returns the content of a NULL padded field of a TAR header.
+std::string readTarString(const unsigned char * iField, size_t iSize)
+{
+  size_t length = 0;
+  while(length < iSize && iField[length] != '\0')
+    length++;
+  return std::string((const char *)iField, length);
+}
+
+//Finds the "path" record of a pax extended header. Each record is "<length> <keyword>=<value>\n".
+bool readPaxPath(const unsigned char * iRecords, uint64_t iSize, std::string & oPath)
+{
+  uint64_t offset = 0;
+  while(offset < iSize)
+  {
+    uint64_t length = 0;
+    uint64_t i = offset;
+    for(; i<iSize && iRecords[i] >= '0' && iRecords[i] <= '9' && length < iSize; i++)
+      length = length*10 + (iRecords[i] - '0');
+    if (i == iSize || iRecords[i] != ' ' || length > iSize - offset || i + 1 >= offset + length)
+      return false;
+    const char * record = (const char *)iRecords + i + 1;
+    const uint64_t recordSize = offset + length - (i + 1);
+    static const char PATH_KEYWORD[] = "path=";
+    static const size_t PATH_KEYWORD_SIZE = sizeof(PATH_KEYWORD) - 1;
+    if (recordSize > PATH_KEYWORD_SIZE && memcmp(record, PATH_KEYWORD, PATH_KEYWORD_SIZE) == 0 && record[recordSize - 1] == '\n')
+    {
+      oPath.assign(record + PATH_KEYWORD_SIZE, (size_t)(recordSize - PATH_KEYWORD_SIZE - 1));
+      return true;
+    }
+    offset += length;
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// global functions
+//----------------------------------------------------------------------------------------------------------------------------------------
+Archive::Archive()
+{
+}
+
+bool Archive::open(const char * iPath)
+{
+  LNK_TRACE_SCOPE("openArchive");
+
+  close();
+  if (!mFile.open(iPath))
+    return false;
+  //a TAR archive starts with a header which has a checksum while a ZIP archive is read from its end
+  if (readTar())
+    return true;
+  mMembers.clear();
+  if (readZip())
+    return true;
+  close();
+  return false;
+}
+
+void Archive::close()
+{
+  mFile.close();
+  mMembers.clear();
+}
+
+const std::vector<ArchiveMember> & Archive::getMembers() const
+{
+  return mMembers;
+}
+
+bool Archive::readZip()
+{
+  const unsigned char * buffer = mFile.getBuffer();
+  const uint64_t size = mFile.getSize();
+  if (size < ZIP_END_SIZE)
+    return false;
+
+  //the end of central directory record is followed by a comment of 64K at most
+  const uint64_t first = (size - ZIP_END_SIZE > ZIP_MAX_COMMENT_SIZE ? size - ZIP_END_SIZE - ZIP_MAX_COMMENT_SIZE : 0);
+  uint64_t end = size - ZIP_END_SIZE + 1;
+  bool found = false;
+  while(end > first && !found)
+  {
+    end--;
+    found = (readLittleEndian32(buffer + end) == ZIP_END_SIGNATURE && end + ZIP_END_SIZE + readLittleEndian16(buffer + end + 20) <= size);
+  }
+  if (!found)
+    return false;
+  uint64_t numEntries = readLittleEndian16(buffer + end + 10);
+  uint64_t directorySize = readLittleEndian32(buffer + end + 12);
+  uint64_t directoryOffset = readLittleEndian32(buffer + end + 16);
+
+  //ZIP64 archives store the real values in another record, found by a locator before the end record
+  if ((numEntries == 0xFFFF || directorySize == 0xFFFFFFFF || directoryOffset == 0xFFFFFFFF) &&
+      end >= ZIP64_END_LOCATOR_SIZE && readLittleEndian32(buffer + end - ZIP64_END_LOCATOR_SIZE) == ZIP64_END_LOCATOR_SIGNATURE)
+  {
+    const uint64_t zip64End = readLittleEndian64(buffer + end - ZIP64_END_LOCATOR_SIZE + 8);
+    if (!isInArchive(zip64End, ZIP64_END_SIZE, size) || readLittleEndian32(buffer + zip64End) != ZIP64_END_SIGNATURE)
+      return false;
+    numEntries = readLittleEndian64(buffer + zip64End + 32);
+    directorySize = readLittleEndian64(buffer + zip64End + 40);
+    directoryOffset = readLittleEndian64(buffer + zip64End + 48);
+  }
+  if (!isInArchive(directoryOffset, directorySize, size) || numEntries > directorySize / ZIP_CENTRAL_SIZE)
+    return false;
+
+  mMembers.reserve((size_t)numEntries);
+  uint64_t offset = directoryOffset;
+  const uint64_t directoryEnd = directoryOffset + directorySize;
+  for(uint64_t i=0; i<numEntries; i++)
+  {
+    if (!isInArchive(offset, ZIP_CENTRAL_SIZE, directoryEnd) || readLittleEndian32(buffer + offset) != ZIP_CENTRAL_SIGNATURE)
+      return false;
+    const unsigned char * header = buffer + offset;
+    const uint16_t flags = readLittleEndian16(header + 8);
+    const uint16_t method = readLittleEndian16(header + 10);
+    uint64_t compressedSize = readLittleEndian32(header + 20);
+    uint64_t uncompressedSize = readLittleEndian32(header + 24);
+    const uint16_t nameSize = readLittleEndian16(header + 28);
+    const uint16_t extraSize = readLittleEndian16(header + 30);
+    const uint16_t commentSize = readLittleEndian16(header + 32);
+    uint64_t localOffset = readLittleEndian32(header + 42);
+    const uint64_t headerSize = ZIP_CENTRAL_SIZE + nameSize + extraSize + commentSize;
+    if (!isInArchive(offset, headerSize, directoryEnd))
+      return false;
+    offset += headerSize;
+    if (!readZip64Extra(header + ZIP_CENTRAL_SIZE + nameSize, extraSize, uncompressedSize, compressedSize, localOffset))
+      return false;
+
+    ArchiveMember member;
+    member.name.assign((const char *)header + ZIP_CENTRAL_SIZE, nameSize);
+    const bool folder = (!member.name.empty() && (member.name[nameSize - 1] == '/' || member.name[nameSize - 1] == '\\'));
+    if (folder || (flags & ZIP_FLAG_ENCRYPTED) || (method != ZIP_METHOD_STORED && method != ZIP_METHOD_DEFLATED))
+      continue;
+
+    //the data follows the local header, which has its own name and extra field
+    if (!isInArchive(localOffset, ZIP_LOCAL_SIZE, size) || readLittleEndian32(buffer + localOffset) != ZIP_LOCAL_SIGNATURE)
+      continue;
+    member.offset = localOffset + ZIP_LOCAL_SIZE + readLittleEndian16(buffer + localOffset + 26) + readLittleEndian16(buffer + localOffset + 28);
+    member.size = compressedSize;
+    member.uncompressedSize = uncompressedSize;
+    member.method = (method == ZIP_METHOD_STORED ? ARCHIVE_METHOD_STORED : ARCHIVE_METHOD_DEFLATED);
+    if (!isInArchive(member.offset, member.size, size))
+      continue;
+    mMembers.push_back(member);
+  }
+  return true;
+}
+
+bool Archive::readTar()
+{
+  const unsigned char * buffer = mFile.getBuffer();
+  const uint64_t size = mFile.getSize();
+  if (size < TAR_BLOCK_SIZE || !hasTarChecksum(buffer))
+    return false;
+
+  //names of the next member given by a GNU long name or by a pax extended header
+  std::string longName;
+  std::string paxPath;
+
+  uint64_t offset = 0;
+  while(isInArchive(offset, TAR_BLOCK_SIZE, size))
+  {
+    const unsigned char * header = buffer + offset;
+    //the list ends at the first empty block, or at the first invalid header of a damaged archive
+    uint64_t dataSize = 0;
+    if (header[0] == '\0' || !hasTarChecksum(header) || !readTarNumber(header + TAR_SIZE_OFFSET, TAR_SIZE_SIZE, dataSize))
+      break;
+    const uint64_t dataOffset = offset + TAR_BLOCK_SIZE;
+    if (!isInArchive(dataOffset, dataSize, size))
+      break;
+    offset = dataOffset + dataSize;
+    if (dataSize % TAR_BLOCK_SIZE)
+      offset += TAR_BLOCK_SIZE - dataSize % TAR_BLOCK_SIZE;
+
+    const char type = (char)header[TAR_TYPE_OFFSET];
+    if (type == 'L')
+    {
+      longName = readTarString(buffer + dataOffset, (size_t)dataSize);
+      continue;
+    }
+    if (type == 'x')
+    {
+      paxPath.clear();
+      readPaxPath(buffer + dataOffset, dataSize, paxPath);
+      continue;
+    }
+    if (type != '0' && type != '\0' && type != '7')
+    {
+      //folders, links and other special files
+      longName.clear();
+      paxPath.clear();
+      continue;
+    }
+
+    ArchiveMember member;
+    if (!paxPath.empty())
+      member.name = paxPath;
+    else if (!longName.empty())
+      member.name = longName;
+    else
+    {
+      member.name = readTarString(header + TAR_NAME_OFFSET, TAR_NAME_SIZE);
+      if (memcmp(header + TAR_MAGIC_OFFSET, "ustar", 5) == 0 && header[TAR_PREFIX_OFFSET] != '\0')
+        member.name = readTarString(header + TAR_PREFIX_OFFSET, TAR_PREFIX_SIZE) + "/" + member.name;
+    }
+    longName.clear();
+    paxPath.clear();
+    member.offset = dataOffset;
+    member.size = dataSize;
+    member.uncompressedSize = dataSize;
+    member.method = ARCHIVE_METHOD_STORED;
+    mMembers.push_back(member);
+  }
+  return true;
+}
+
+bool Archive::getLinkInfo(size_t iIndex, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, StageTimer * ioTimer)
+{
+  LNK_TRACE_SCOPE("getArchiveLinkInfo");
+
+  oError = LNK_PARSE_OK;
+  if (iIndex >= mMembers.size())
+  {
+    oLinkInfo.clear();
+    oError = LNK_PARSE_ERROR_IO;
+    return false;
+  }
+  const ArchiveMember & member = mMembers[iIndex];
+  const unsigned char * data = mFile.getBuffer() + member.offset;
+
+  if (member.method == ARCHIVE_METHOD_DEFLATED)
+  {
+    mInflater.reset(data, (size_t)member.size);
+    return readLinkInfo(mInflater, oLinkInfo, iLimits, oError, ioTimer);
+  }
+
+  //a member larger than the limit is streamed to check its signature first, like the deflated members
+  if (member.size > iLimits.maxFileSize)
+  {
+    const unsigned long size = (iLimits.maxFileSize + 1 != 0 ? iLimits.maxFileSize + 1 : iLimits.maxFileSize);
+    MemoryReader reader(data, size);
+    return readLinkInfo(reader, oLinkInfo, iLimits, oError, ioTimer);
+  }
+  if (ioTimer)
+    return lnk::getLinkInfo(data, (unsigned long)member.size, oLinkInfo, iLimits, oError, *ioTimer);
+  return lnk::getLinkInfo(data, (unsigned long)member.size, oLinkInfo, iLimits, oError);
+}
+
+bool Archive::readLinkInfo(Reader & ioReader, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, StageTimer * ioTimer)
+{
+  if (ioTimer)
+    return lnk::getLinkInfo(ioReader, oLinkInfo, iLimits, oError, *ioTimer, mWindow);
+  return lnk::getLinkInfo(ioReader, oLinkInfo, iLimits, oError, mWindow);
+}
+
+}; //lnk
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "libLNK.h"
+#include "Inflate.h"
+#include "MemoryBuffer.h"
+#include "filesystemfunc.h"
+
+namespace lnk
+{
+
+  class StageTimer;
+
+  //Storage of the data of a member of an archive
+  enum ARCHIVE_METHOD
+  {
+    ARCHIVE_METHOD_STORED,    //not compressed
+    ARCHIVE_METHOD_DEFLATED,  //compressed with the deflate method of ZIP archives
+  };
+
+  //A file of an archive
+  struct ArchiveMember
+  {
+    std::string name;           //path of the file in the archive. The separators are kept as stored, usually '/'.
+    uint64_t offset;            //offset of the data in the archive
+    uint64_t size;              //size of the data in the archive
+    uint64_t uncompressedSize;  //size of the file
+    ARCHIVE_METHOD method;
+  };
+
+  ///<summary>
+  ///Reads the links of a ZIP or TAR archive without extracting them.
+  ///The archive is mapped in memory: the members are listed from the central directory of ZIP archives or from
+  ///the headers of TAR archives, and the stored members are decoded where they lie in the mapping.
+  ///Deflated members are inflated on demand by a single decompressor reused for all members, so that only the
+  ///beginning of the members which are not links is inflated.
+  ///ZIP64 archives are supported. Directories, encrypted members and other compression methods are not listed.
+  ///</summary>
+  class Archive
+  {
+  public:
+    Archive();
+
+    ///<summary>
+    ///Opens an archive and lists its members. The format is detected from the content of the file.
+    ///</summary>
+    ///<param name="iPath">The path of the archive.</param>
+    ///<return>Returns true if the archive is opened. Returns false if the file cannot be mapped or is not a valid ZIP or TAR archive.<return>
+    bool open(const char * iPath);
+
+    ///<summary>
+    ///Closes the archive. The members are no longer listed.
+    ///</summary>
+    void close();
+
+    const std::vector<ArchiveMember> & getMembers() const;
+
+    ///<summary>
+    ///Decodes a member of the archive. A member which is not a link is rejected with LNK_PARSE_ERROR_SIGNATURE
+    ///after its first bytes are read.
+    ///</summary>
+    ///<param name="iIndex">The index of the member in getMembers().</param>
+    ///<param name="oLinkInfo">The content of the link.</param>
+    ///<param name="iLimits">The limits of the parsing.</param>
+    ///<param name="oError">The reason why the member is rejected or LNK_PARSE_OK.</param>
+    ///<param name="ioTimer">Measures the time spent in each stage. Can be NULL.</param>
+    ///<return>Returns true if the member is a valid link. Returns false otherwise.<return>
+    bool getLinkInfo(size_t iIndex, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, StageTimer * ioTimer);
+
+  private:
+    Archive(const Archive &);
+    Archive & operator = (const Archive &);
+
+    bool readZip();
+    bool readTar();
+    bool readLinkInfo(Reader & ioReader, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, StageTimer * ioTimer);
+
+    filesystem::MappedFile mFile;
+    std::vector<ArchiveMember> mMembers;
+    InflateReader mInflater;
+    MemoryBuffer mWindow;   //sections of the deflated links, reused between members
+  };
+
+}; //lnk
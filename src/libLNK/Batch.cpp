@@ -0,0 +1,334 @@
+#include "Batch.h"
+#include "Threads.h"
+#include "Tracing.h"
+#include "MemoryBuffer.h"
+#include "UringWriter.h"
+#include <string.h> //for memcpy()
+#include <set>
+#include <algorithm>
+#include <stdio.h> //for remove()
+
+#include "filesystemfunc.h"
+
+namespace lnk
+{
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// Defines, Pre-declarations & typedefs
+//----------------------------------------------------------------------------------------------------------------------------------------
+const BatchOptions LNK_DEFAULT_BATCH_OPTIONS = {
+  4,     //numThreads
+  true,  //durable
+  false, //useIoUring
+};
+
+#ifdef LNK_IO_URING_ENABLED
+//Links written by a single io_uring submission and the size of the registered arena holding them
+static const unsigned long URING_MAX_FILES = 256;
+static const unsigned long URING_ARENA_SIZE = 0x100000;
+#endif
+
+//implemented in libLNK.cpp
+void detectTarget(const LinkInfo & iLinkInfo, LNK_TARGET & oTarget);
+
+//Steps of the creation of the links. Each step is done for all links before the next step starts.
+enum BATCH_STEP
+{
+  BATCH_STEP_WRITE,         //serialize each link and write it to a temporary file
+  BATCH_STEP_SERIALIZE,     //serialize each link in memory, written to a temporary file by io_uring
+  BATCH_STEP_SYNC,          //flush the temporary files
+  BATCH_STEP_RENAME,        //rename the temporary files over the links
+  BATCH_STEP_SYNC_FOLDERS,  //flush the folders of the links
+};
+
+//State shared by the threads of a batch. Each link is handled by a single thread at each step.
+struct BATCH_CONTEXT
+{
+  const std::vector<BatchLink> * links;
+  BATCH_STEP step;
+  volatile long next;                 //next item to process, incremented by all threads
+  size_t first;                       //first link of the step
+  size_t last;                        //end of the links of the step
+  std::vector<MemoryBuffer> contents; //serialized links of BATCH_STEP_SERIALIZE, by index from first
+  std::vector<std::string> temps;     //temporary file of each link
+  std::vector<std::string> shortPaths; //short path of each target generated in the order of the links
+  std::vector<char> success;          //status of each link
+  std::vector<std::string> folders;   //distinct folders of the links, sorted
+  std::vector<char> foldersSynced;    //status of each folder
+};
+
+//Returns the path of a temporary file in the folder of a file
+std::string getTemporaryLinkPath(const std::string & iFilePath)
+{
+  std::size_t offset = iFilePath.find_last_of("/\\");
+  std::string folder = (offset == std::string::npos ? std::string() : iFilePath.substr(0, offset+1));
+  return folder + filesystem::getTemporaryFileName();
+}
+
+//Returns the folder of a file. Returns "." for a file of the current folder.
+std::string getFolder(const std::string & iFilePath)
+{
+  std::size_t offset = iFilePath.find_last_of("/\\");
+  if (offset == std::string::npos)
+    return ".";
+  if (offset == 0)
+    return iFilePath.substr(0, 1); //root folder
+  return iFilePath.substr(0, offset);
+}
+
+//Reads the properties of the target of a link. A target which does not exist gets the short path generated
+//for the batch: the targets of a same folder do not all get the first short name of the folder.
+void detectTarget(const BATCH_CONTEXT & iContext, size_t iIndex, LNK_TARGET & oTarget)
+{
+  detectTarget((*iContext.links)[iIndex].info, oTarget);
+  if (!oTarget.isFile && !oTarget.isFolder)
+    oTarget.shortPath = iContext.shortPaths[iIndex];
+}
+
+void runBatchThread(void * iContext)
+{
+  BATCH_CONTEXT & context = *(BATCH_CONTEXT *)iContext;
+  const std::vector<BatchLink> & links = *context.links;
+
+  //reused for all links of the thread
+  MemoryBuffer content;
+  LNK_TARGET target;
+
+  size_t first = context.first;
+  size_t last = context.last;
+  for(size_t i = first + (size_t)atomicIncrement(context.next) - 1; i < last; i = first + (size_t)atomicIncrement(context.next) - 1)
+  {
+    if (context.step == BATCH_STEP_SYNC_FOLDERS)
+    {
+      context.foldersSynced[i] = filesystem::syncFolder(context.folders[i].c_str());
+      continue;
+    }
+    if (!context.success[i])
+      continue;
+
+    const BatchLink & link = links[i];
+    const std::string & temp = context.temps[i];
+    bool success = true;
+    switch(context.step)
+    {
+    case BATCH_STEP_WRITE:
+      detectTarget(context, i, target);
+      context.temps[i] = getTemporaryLinkPath(link.path);
+      success = createLink(link.info, target, content) &&
+                filesystem::writeFile(context.temps[i].c_str(), content.getBuffer(), content.getSize(), false);
+      break;
+    case BATCH_STEP_SERIALIZE:
+      detectTarget(context, i, target);
+      context.temps[i] = getTemporaryLinkPath(link.path);
+      success = createLink(link.info, target, context.contents[i - first]);
+      break;
+    case BATCH_STEP_SYNC:
+      success = filesystem::syncFile(temp.c_str());
+      break;
+    case BATCH_STEP_RENAME:
+      success = filesystem::renameFile(temp.c_str(), link.path.c_str());
+      break;
+    default:
+      break;
+    };
+
+    if (!success)
+    {
+      context.success[i] = false;
+      if (!context.temps[i].empty())
+        remove(context.temps[i].c_str());
+    }
+  }
+}
+
+void runBatchStep(BATCH_CONTEXT & ioContext, BATCH_STEP iStep, size_t iFirst, size_t iLast, unsigned long iNumThreads)
+{
+  ioContext.step = iStep;
+  ioContext.first = iFirst;
+  ioContext.last = iLast;
+  ioContext.next = 0;
+  if (iNumThreads > iLast - iFirst)
+    iNumThreads = (iLast > iFirst ? (unsigned long)(iLast - iFirst) : 1);
+  runThreads(&runBatchThread, &ioContext, iNumThreads);
+}
+
+#ifdef LNK_IO_URING_ENABLED
+//Writes a temporary file with the calling thread
+bool writeTemporaryFile(const std::string & iFilePath, const unsigned char * iContent, unsigned long iSize, bool iSync)
+{
+  bool success = filesystem::writeFile(iFilePath.c_str(), iContent, iSize, false) &&
+                 (!iSync || filesystem::syncFile(iFilePath.c_str()));
+  if (!success)
+    remove(iFilePath.c_str());
+  return success;
+}
+
+//Writes the files of the arena and saves the status of their links.
+//Returns false if io_uring failed: the files of the arena are then written by the calling thread.
+bool submitFiles(BATCH_CONTEXT & ioContext, UringWriter & ioWriter, std::vector<URING_FILE> & ioFiles, std::vector<size_t> & ioIndexes, bool iSync)
+{
+  if (ioFiles.empty())
+    return true;
+  bool submitted = ioWriter.writeFiles(&ioFiles[0], ioFiles.size(), iSync);
+  for(size_t i=0; i<ioFiles.size(); i++)
+  {
+    const URING_FILE & file = ioFiles[i];
+    size_t index = ioIndexes[i];
+    if (!submitted)
+      ioContext.success[index] = writeTemporaryFile(ioContext.temps[index], ioWriter.getArena() + file.offset, file.size, iSync);
+    else if (!file.success)
+    {
+      ioContext.success[index] = false;
+      remove(ioContext.temps[index].c_str());
+    }
+  }
+  ioFiles.clear();
+  ioIndexes.clear();
+  return submitted;
+}
+
+//Serializes the links with the threads and writes them to their temporary files with io_uring.
+//If io_uring fails, the remaining links are written by the threads.
+void writeLinks(BATCH_CONTEXT & ioContext, UringWriter & ioWriter, bool iSync, unsigned long iNumThreads)
+{
+  const std::vector<BatchLink> & links = *ioContext.links;
+  const size_t maxFiles = ioWriter.getMaxFiles();
+  std::vector<URING_FILE> files;
+  std::vector<size_t> indexes; //link of each file
+  files.reserve(maxFiles);
+  indexes.reserve(maxFiles);
+  ioContext.contents.resize(maxFiles);
+
+  bool useIoUring = true;
+  for(size_t first=0; first<links.size(); first+=maxFiles)
+  {
+    if (!useIoUring)
+    {
+      runBatchStep(ioContext, BATCH_STEP_WRITE, first, links.size(), iNumThreads);
+      if (iSync)
+        runBatchStep(ioContext, BATCH_STEP_SYNC, first, links.size(), iNumThreads);
+      return;
+    }
+
+    size_t last = first + maxFiles;
+    if (last > links.size())
+      last = links.size();
+    runBatchStep(ioContext, BATCH_STEP_SERIALIZE, first, last, iNumThreads);
+
+    //copy the links in the arena and submit the arena each time it is full
+    unsigned long arenaSize = 0;
+    for(size_t i=first; i<last; i++)
+    {
+      if (!ioContext.success[i])
+        continue;
+
+      const MemoryBuffer & content = ioContext.contents[i - first];
+      const bool fits = (content.getSize() <= ioWriter.getArenaSize());
+      if (useIoUring && fits && arenaSize + content.getSize() > ioWriter.getArenaSize())
+      {
+        useIoUring = submitFiles(ioContext, ioWriter, files, indexes, iSync);
+        arenaSize = 0;
+      }
+      if (!useIoUring || !fits)
+      {
+        //larger than the arena, or io_uring failed
+        ioContext.success[i] = writeTemporaryFile(ioContext.temps[i], content.getBuffer(), content.getSize(), iSync);
+        continue;
+      }
+
+      memcpy(ioWriter.getArena() + arenaSize, content.getBuffer(), content.getSize());
+      URING_FILE file = {ioContext.temps[i].c_str(), arenaSize, content.getSize(), false};
+      files.push_back(file);
+      indexes.push_back(i);
+      arenaSize += content.getSize();
+    }
+    if (useIoUring)
+      useIoUring = submitFiles(ioContext, ioWriter, files, indexes, iSync);
+  }
+}
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// global functions
+//----------------------------------------------------------------------------------------------------------------------------------------
+bool createLinks(const std::vector<BatchLink> & iLinks, const BatchOptions & iOptions, BatchReport & oReport)
+{
+  LNK_TRACE_SCOPE("createLinks");
+
+  BATCH_CONTEXT context;
+  context.links = &iLinks;
+  context.temps.resize(iLinks.size());
+  context.success.resize(iLinks.size(), true);
+
+  //the short names are assigned in the order of the links, like Windows does when the targets are created in that order
+  filesystem::ShortNameGenerator generator;
+  context.shortPaths.resize(iLinks.size());
+  for(size_t i=0; i<iLinks.size(); i++)
+    context.shortPaths[i] = generator.getShortPath(iLinks[i].info.target);
+
+  unsigned long numThreads = (iOptions.numThreads == 0 ? 1 : iOptions.numThreads);
+
+  //all fsync are grouped after the writes and before the renames
+  bool written = false;
+#ifdef LNK_IO_URING_ENABLED
+  if (iOptions.useIoUring && !iLinks.empty())
+  {
+    //the files are opened, written, flushed and closed by chains of io_uring requests
+    UringWriter writer;
+    if (writer.init(URING_MAX_FILES, URING_ARENA_SIZE))
+    {
+      writeLinks(context, writer, iOptions.durable, numThreads);
+      written = true;
+    }
+  }
+#endif
+  if (!written)
+  {
+    //thread pool
+    runBatchStep(context, BATCH_STEP_WRITE, 0, iLinks.size(), numThreads);
+    if (iOptions.durable)
+      runBatchStep(context, BATCH_STEP_SYNC, 0, iLinks.size(), numThreads);
+  }
+  runBatchStep(context, BATCH_STEP_RENAME, 0, iLinks.size(), numThreads);
+
+  //each folder is flushed once to make the renames durable.
+  //The links of a folder which cannot be flushed are not durable: they are reported as failed.
+  if (iOptions.durable)
+  {
+    std::set<std::string> folders;
+    for(size_t i=0; i<iLinks.size(); i++)
+    {
+      if (context.success[i])
+        folders.insert(getFolder(iLinks[i].path));
+    }
+    context.folders.assign(folders.begin(), folders.end());
+    context.foldersSynced.assign(context.folders.size(), false);
+    if (!context.folders.empty())
+      runBatchStep(context, BATCH_STEP_SYNC_FOLDERS, 0, context.folders.size(), numThreads);
+    for(size_t i=0; i<iLinks.size(); i++)
+    {
+      if (!context.success[i])
+        continue;
+      size_t folder = std::lower_bound(context.folders.begin(), context.folders.end(), getFolder(iLinks[i].path)) - context.folders.begin();
+      context.success[i] = context.foldersSynced[folder];
+    }
+  }
+
+  oReport.numCreated = 0;
+  oReport.numFailed = 0;
+  oReport.failed.clear();
+  for(size_t i=0; i<iLinks.size(); i++)
+  {
+    if (context.success[i])
+      oReport.numCreated++;
+    else
+    {
+      oReport.numFailed++;
+      oReport.failed.push_back(i);
+    }
+  }
+
+  return (oReport.numFailed == 0);
+}
+
+}; //lnk
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "libLNK.h"
+
+namespace lnk
+{
+
+//A link created by createLinks()
+struct BatchLink
+{
+  std::string path;   //path of the link file
+  LinkInfo info;      //properties of the link
+};
+
+//Options of createLinks()
+struct BatchOptions
+{
+  unsigned long numThreads;   //number of threads creating the links, including the calling thread
+  bool durable;               //flush the links and their folders to the storage device before returning
+  bool useIoUring;            //write the links with io_uring when the kernel supports it (Linux only, experimental), otherwise with the threads. Disabled by default.
+};
+extern const BatchOptions LNK_DEFAULT_BATCH_OPTIONS;
+
+//Result of createLinks()
+struct BatchReport
+{
+  unsigned long numCreated;   //links created
+  unsigned long numFailed;    //links which are not created
+  std::vector<size_t> failed; //indexes of the links which are not created, in increasing order
+};
+
+///<summary>
+///Creates many links at once.
+///Each link is written to a temporary file of its folder and renamed over its path once all files are written:
+///readers never see a partially written link and an existing link is replaced atomically.
+///In durable mode, all files are flushed before the first rename and each folder is flushed once after the last rename.
+///The links of a folder which cannot be flushed are reported as failed: they are renamed but not durable.
+///The short names (8.3 format) of the targets which do not exist are generated in the order of the links: targets
+///of a same folder whose names collide get distinct short names.
+///The links are serialized by a pool of threads. They are written by the same threads, or on Linux by chains
+///of io_uring requests (open, write, fsync and close) submitted for hundreds of links at once.
+///</summary>
+///<param name="iLinks">The links to create.</param>
+///<param name="iOptions">The options of the batch.</param>
+///<param name="oReport">The links created and the links which failed.</param>
+///<return>Returns true if all links are created. Returns false otherwise.<return>
+bool createLinks(const std::vector<BatchLink> & iLinks, const BatchOptions & iOptions, BatchReport & oReport);
+
+}; //lnk
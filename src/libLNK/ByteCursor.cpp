@@ -0,0 +1,104 @@
+#include "ByteCursor.h"
+#include "Stats.h"
+
+namespace lnk
+{
+
+  template <class Policy>
+  bool BasicByteCursor<Policy>::readString(unsigned long iMaxLength, std::string & oValue)
+  {
+    const char * value = NULL;
+    unsigned long length = 0;
+    if (!readString(iMaxLength, value, length))
+      return false;
+    oValue.assign(value, length);
+    return true;
+  }
+
+  template <class Policy>
+  bool BasicByteCursor<Policy>::readString(unsigned long iMaxLength, const char *& oValue, unsigned long & oLength)
+  {
+    if (!good())
+      return false;
+
+    //search for the terminating character within bounds
+    unsigned long remaining = getRemaining();
+    const unsigned char * start = getCurrent();
+    const unsigned char * end = (const unsigned char *)memchr(start, '\0', remaining);
+    if (Policy::CHECKED && LNK_UNLIKELY(end == NULL))
+    {
+      fail(LNK_PARSE_ERROR_TRUNCATED);
+      return false;
+    }
+    unsigned long length = (unsigned long)(end - start);
+    if (Policy::CHECKED && LNK_UNLIKELY(length > iMaxLength))
+    {
+      fail(LNK_PARSE_ERROR_STRING_TOO_LONG);
+      return false;
+    }
+
+    oValue = (const char *)start;
+    oLength = length;
+    mOffset += length + 1;
+    return true;
+  }
+
+  template <class Policy>
+  bool BasicByteCursor<Policy>::readUnicodeString(unsigned long iMaxLength, const unsigned char *& oValue, unsigned long & oLength)
+  {
+    if (!good())
+      return false;
+
+    //search for the terminating character within bounds
+    unsigned long numCharacters = getRemaining() / sizeof(uint16_t);
+    const unsigned char * start = getCurrent();
+    unsigned long length = 0;
+    while((!Policy::CHECKED || length < numCharacters) && (start[2*length] | start[2*length+1]) != 0)
+    {
+      length++;
+    }
+    if (Policy::CHECKED && LNK_UNLIKELY(length == numCharacters))
+    {
+      fail(LNK_PARSE_ERROR_TRUNCATED);
+      return false;
+    }
+    if (Policy::CHECKED && LNK_UNLIKELY(length > iMaxLength))
+    {
+      fail(LNK_PARSE_ERROR_STRING_TOO_LONG);
+      return false;
+    }
+
+    oValue = start;
+    oLength = length;
+    mOffset += (length + 1) * sizeof(uint16_t); //including the terminating character
+    return true;
+  }
+
+  template <class Policy>
+  bool BasicByteCursor<Policy>::readUnicodeString(unsigned long iLength, unsigned long iMaxLength, std::string & oValue)
+  {
+    if (Policy::CHECKED && LNK_UNLIKELY(iLength > iMaxLength))
+    {
+      fail(LNK_PARSE_ERROR_STRING_TOO_LONG);
+      return false;
+    }
+    if (Policy::CHECKED && LNK_UNLIKELY(iLength > getRemaining() / sizeof(uint16_t)))
+    {
+      fail(LNK_PARSE_ERROR_TRUNCATED);
+      return false;
+    }
+    const unsigned char * characters = readBytes(iLength * sizeof(uint16_t));
+    if (characters == NULL)
+      return false;
+
+    oValue.resize(iLength);
+    if (iLength > 0)
+      narrowUnicodeString(characters, iLength, &oValue[0]);
+    return true;
+  }
+
+  //both policies are built from the same source
+  template class BasicByteCursor<Untrusted>;
+  template class BasicByteCursor<Trusted>;
+
+}; //lnk
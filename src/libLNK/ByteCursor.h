@@ -0,0 +1,185 @@
+#pragma once
+
+#include "libLNK.h"
+#include "Stats.h"
+#include <string>
+#include <string.h>
+#include <stdint.h>
+
+//Branch prediction hints for the bound checks.
+//The checks are expected to succeed on all valid files.
+#if defined(__GNUC__) || defined(__clang__)
+#define LNK_LIKELY(x)   __builtin_expect(!!(x), 1)
+#define LNK_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define LNK_LIKELY(x)   (x)
+#define LNK_UNLIKELY(x) (x)
+#endif
+
+namespace lnk
+{
+
+  ///<summary>
+  ///Narrows iLength 16 bits characters to 8 bits like all other strings of the library.
+  ///</summary>
+  inline void narrowUnicodeString(const unsigned char * iCharacters, unsigned long iLength, char * oValue)
+  {
+    LNK_STATS_ADD(stringBytesTranscoded, iLength * sizeof(uint16_t));
+    for(unsigned long i=0; i<iLength; i++)
+      oValue[i] = (char)iCharacters[2*i];
+  }
+
+  ///<summary>
+  ///Forward-only reader over a memory buffer.
+  ///With the Untrusted policy, every read is validated against the end of
+  ///the buffer. A failed read sets an error code, leaves the output untouched
+  ///and makes all following reads fail.
+  ///With the Trusted policy, the checks are removed at compile time and
+  ///the cursor never fails.
+  ///</summary>
+  template <class Policy>
+  class BasicByteCursor
+  {
+  public:
+    BasicByteCursor(const unsigned char * iBuffer, unsigned long iSize) :
+      mBuffer(iBuffer),
+      mSize(iSize),
+      mOffset(0),
+      mError(LNK_PARSE_OK)
+    {
+    }
+
+    //----------------
+    // public methods
+    //----------------
+
+    ///<summary>
+    ///Reads a value of type T at the current offset.
+    ///The value is copied which allows reading unaligned or packed structures.
+    ///</summary>
+    template <typename T>
+    inline bool read(T & oValue)
+    {
+      if (LNK_UNLIKELY(!require(sizeof(T))))
+        return false;
+      memcpy(&oValue, &mBuffer[mOffset], sizeof(T));
+      mOffset += sizeof(T);
+      return true;
+    }
+
+    ///<summary>
+    ///Returns the address of the next iSize bytes and moves past them.
+    ///Returns NULL if the buffer does not contains enough bytes.
+    ///</summary>
+    inline const unsigned char * readBytes(unsigned long iSize)
+    {
+      if (LNK_UNLIKELY(!require(iSize)))
+        return NULL;
+      const unsigned char * address = mBuffer + mOffset;
+      mOffset += iSize;
+      return address;
+    }
+
+    inline bool skip(unsigned long iSize)
+    {
+      if (LNK_UNLIKELY(!require(iSize)))
+        return false;
+      mOffset += iSize;
+      return true;
+    }
+
+    ///<summary>
+    ///Moves the cursor to the given absolute offset.
+    ///</summary>
+    inline bool seek(unsigned long iOffset)
+    {
+      if (Policy::CHECKED)
+      {
+        if (LNK_UNLIKELY(mError != LNK_PARSE_OK))
+          return false;
+        if (LNK_UNLIKELY(iOffset > mSize))
+        {
+          mError = LNK_PARSE_ERROR_TRUNCATED;
+          return false;
+        }
+      }
+      mOffset = iOffset;
+      return true;
+    }
+
+    ///<summary>
+    ///Builds a cursor over iSize bytes starting at the absolute offset iOffset.
+    ///Offsets of the returned cursor are relative to iOffset.
+    ///On error, the returned cursor is empty and already failed.
+    ///</summary>
+    inline BasicByteCursor sub(unsigned long iOffset, unsigned long iSize) const
+    {
+      if (Policy::CHECKED && LNK_UNLIKELY(mError != LNK_PARSE_OK || iOffset > mSize || iSize > mSize - iOffset))
+      {
+        BasicByteCursor invalid(NULL, 0);
+        invalid.fail(mError != LNK_PARSE_OK ? mError : LNK_PARSE_ERROR_TRUNCATED);
+        return invalid;
+      }
+      return BasicByteCursor(mBuffer + iOffset, iSize);
+    }
+
+    ///<summary>
+    ///Reads a NULL terminated 8 bits string. The terminating character must
+    ///be found within the buffer and within iMaxLength characters.
+    ///</summary>
+    bool readString(unsigned long iMaxLength, std::string & oValue);
+
+    ///<summary>
+    ///Reads a NULL terminated 8 bits string without copying it.
+    ///oValue points inside the buffer and is not NULL terminated.
+    ///</summary>
+    bool readString(unsigned long iMaxLength, const char *& oValue, unsigned long & oLength);
+
+    ///<summary>
+    ///Reads a NULL terminated 16 bits string without copying it. The terminating character must be found
+    ///within the buffer and within iMaxLength characters.
+    ///oValue points to the first character inside the buffer and oLength is the number of characters.
+    ///</summary>
+    bool readUnicodeString(unsigned long iMaxLength, const unsigned char *& oValue, unsigned long & oLength);
+
+    ///<summary>
+    ///Reads iLength 16 bits characters. Each character is narrowed to 8 bits.
+    ///</summary>
+    bool readUnicodeString(unsigned long iLength, unsigned long iMaxLength, std::string & oValue);
+
+    inline void fail(LNK_PARSE_ERROR iError)
+    {
+      if (Policy::CHECKED && mError == LNK_PARSE_OK)
+        mError = iError;
+    }
+
+    inline bool good() const                          { return !Policy::CHECKED || mError == LNK_PARSE_OK; }
+    inline LNK_PARSE_ERROR getError() const           { return (Policy::CHECKED ? mError : LNK_PARSE_OK); }
+    inline unsigned long getOffset() const            { return mOffset; }
+    inline unsigned long getSize() const              { return mSize; }
+    inline unsigned long getRemaining() const         { return mSize - mOffset; }
+    inline const unsigned char * getBuffer() const    { return mBuffer; }
+    inline const unsigned char * getCurrent() const   { return mBuffer + mOffset; }
+
+  private:
+    inline bool require(unsigned long iSize)
+    {
+      if (!Policy::CHECKED)
+        return true;
+      if (LNK_LIKELY(mError == LNK_PARSE_OK && iSize <= mSize - mOffset))
+        return true;
+      fail(LNK_PARSE_ERROR_TRUNCATED);
+      return false;
+    }
+
+  private:
+    const unsigned char * mBuffer;
+    unsigned long mSize;
+    unsigned long mOffset;
+    LNK_PARSE_ERROR mError;
+  };
+
+  typedef BasicByteCursor<Untrusted> ByteCursor;
+  typedef BasicByteCursor<Trusted> TrustedByteCursor;
+
+}; //lnk
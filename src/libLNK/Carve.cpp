@@ -0,0 +1,193 @@
+#include "Carve.h"
+#include "Reader.h"
+#include "Threads.h"
+#include "Mutex.h"
+#include "Tracing.h"
+#include "MemoryBuffer.h"
+#include <string.h> //for memchr()
+#include <algorithm>
+
+#include "filesystemfunc.h"
+
+//SSE2 is always available on x64 and enabled by /arch:SSE2 on x86
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LNK_SSE2_ENABLED
+#endif
+
+namespace lnk
+{
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// Defines, Pre-declarations & typedefs
+//----------------------------------------------------------------------------------------------------------------------------------------
+const CarveOptions LNK_DEFAULT_CARVE_OPTIONS = {
+  { 0x100000, 256, 0x7FFF, 64 }, //limits, same as LNK_DEFAULT_PARSE_LIMITS
+  4,                             //numThreads
+  0x400000,                      //chunkSize
+};
+
+//HeaderSize of the ShellLinkHeader followed by the LinkCLSID
+static const unsigned char LINK_SIGNATURE[] = {
+  0x4C, 0x00, 0x00, 0x00,
+  0x01, 0x14, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46,
+};
+static const size_t LINK_SIGNATURE_SIZE = sizeof(LINK_SIGNATURE);
+static const size_t LINK_CLSID_OFFSET = 4;
+
+//State shared by the threads of a search. Each chunk is searched by a single thread.
+struct CARVE_CONTEXT
+{
+  const unsigned char * buffer;
+  size_t size;
+  const CarveOptions * options;
+  size_t chunkSize;
+  size_t numChunks;
+  volatile long next;             //next chunk to search, incremented by all threads
+  Mutex lock;                     //protects links
+  std::vector<CarvedLink> links;  //links of all chunks, not ordered
+};
+
+inline bool isBefore(const CarvedLink & iFirst, const CarvedLink & iSecond)
+{
+  return iFirst.offset < iSecond.offset;
+}
+
+//Decodes the link starting at a signature. The size of the link is the number of bytes read by the streaming
+//parser, which stops at the TerminalBlock.
+bool validateLink(const unsigned char * iBuffer, size_t iSize, const ParseLimits & iLimits, LinkInfoEx & ioLinkInfo, MemoryBuffer & ioWindow, unsigned long & oSize)
+{
+  //a link larger than the limit is rejected after maxFileSize+1 bytes
+  const unsigned long maxSize = (iLimits.maxFileSize + 1 != 0 ? iLimits.maxFileSize + 1 : iLimits.maxFileSize);
+  MemoryReader reader(iBuffer, (iSize < maxSize ? (unsigned long)iSize : maxSize));
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  if (!getLinkInfo(reader, ioLinkInfo, iLimits, error, ioWindow))
+    return false;
+  oSize = reader.getOffset();
+  return true;
+}
+
+//Searches the signatures which start in a chunk. The last signature of a chunk may end in the next chunk, and a
+//link may end anywhere after its chunk.
+void carveChunk(const CARVE_CONTEXT & iContext, size_t iChunk, LinkInfoEx & ioLinkInfo, MemoryBuffer & ioWindow, std::vector<CarvedLink> & ioLinks)
+{
+  const size_t start = iChunk * iContext.chunkSize;
+  const size_t end = (iContext.size - start > iContext.chunkSize ? start + iContext.chunkSize : iContext.size);
+  const size_t searchEnd = (iContext.size - end > LINK_SIGNATURE_SIZE - 1 ? end + LINK_SIGNATURE_SIZE - 1 : iContext.size);
+
+  size_t offset = start;
+  while(offset < end)
+  {
+    offset += findLinkSignature(iContext.buffer + offset, searchEnd - offset);
+    if (offset >= end)
+      break;
+
+    CarvedLink link;
+    link.offset = offset;
+    if (validateLink(iContext.buffer + offset, iContext.size - offset, iContext.options->limits, ioLinkInfo, ioWindow, link.size))
+      ioLinks.push_back(link);
+    offset++;
+  }
+}
+
+void runCarveThread(void * iContext)
+{
+  CARVE_CONTEXT & context = *(CARVE_CONTEXT *)iContext;
+
+  //reused for all chunks of the thread
+  LinkInfoEx info;
+  MemoryBuffer window;
+  std::vector<CarvedLink> links;
+
+  for(size_t i = (size_t)atomicIncrement(context.next) - 1; i < context.numChunks; i = (size_t)atomicIncrement(context.next) - 1)
+  {
+    links.clear();
+    carveChunk(context, i, info, window, links);
+    if (links.empty())
+      continue;
+    ScopedLock lock(context.lock);
+    context.links.insert(context.links.end(), links.begin(), links.end());
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// global functions
+//----------------------------------------------------------------------------------------------------------------------------------------
+size_t findLinkSignature(const unsigned char * iBuffer, size_t iSize)
+{
+  if (iSize < LINK_SIGNATURE_SIZE)
+    return iSize;
+  const size_t last = iSize - LINK_SIGNATURE_SIZE; //last offset where a signature fits
+  size_t offset = 0;
+
+#ifdef LNK_SSE2_ENABLED
+  //Compares 3 bytes of the signature at 16 offsets at once: the header size, the first and the last byte of the CLSID.
+  //Few offsets match all 3 bytes, even in data full of 0x4C bytes.
+  const __m128i headerSize = _mm_set1_epi8((char)LINK_SIGNATURE[0]);
+  const __m128i clsidFirst = _mm_set1_epi8((char)LINK_SIGNATURE[LINK_CLSID_OFFSET]);
+  const __m128i clsidLast = _mm_set1_epi8((char)LINK_SIGNATURE[LINK_SIGNATURE_SIZE - 1]);
+  for(; last - offset >= 16; offset += 16)
+  {
+    const unsigned char * block = iBuffer + offset;
+    const __m128i matchHeader = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)block), headerSize);
+    const __m128i matchFirst = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(block + LINK_CLSID_OFFSET)), clsidFirst);
+    const __m128i matchLast = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(block + LINK_SIGNATURE_SIZE - 1)), clsidLast);
+    int mask = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(matchHeader, matchFirst), matchLast));
+    for(size_t i=0; mask != 0; i++, mask >>= 1)
+    {
+      if ((mask & 1) && memcmp(block + i, LINK_SIGNATURE, LINK_SIGNATURE_SIZE) == 0)
+        return offset + i;
+    }
+  }
+#endif
+
+  //remaining offsets, or all offsets without SSE2: memchr() is vectorized by the C runtime
+  while(offset <= last)
+  {
+    const unsigned char * found = (const unsigned char *)memchr(iBuffer + offset, LINK_SIGNATURE[0], last - offset + 1);
+    if (found == NULL)
+      break;
+    offset = found - iBuffer;
+    if (memcmp(found, LINK_SIGNATURE, LINK_SIGNATURE_SIZE) == 0)
+      return offset;
+    offset++;
+  }
+  return iSize;
+}
+
+bool carveLinks(const unsigned char * iBuffer, size_t iSize, const CarveOptions & iOptions, std::vector<CarvedLink> & oLinks)
+{
+  LNK_TRACE_SCOPE("carveLinks");
+
+  oLinks.clear();
+  if (iBuffer == NULL && iSize > 0)
+    return false;
+
+  CARVE_CONTEXT context;
+  context.buffer = iBuffer;
+  context.size = iSize;
+  context.options = &iOptions;
+  context.chunkSize = (iOptions.chunkSize == 0 ? LNK_DEFAULT_CARVE_OPTIONS.chunkSize : iOptions.chunkSize);
+  context.numChunks = iSize / context.chunkSize + (iSize % context.chunkSize ? 1 : 0);
+  context.next = 0;
+
+  unsigned long numThreads = (iOptions.numThreads == 0 ? 1 : iOptions.numThreads);
+  if (numThreads > context.numChunks)
+    numThreads = (context.numChunks > 0 ? (unsigned long)context.numChunks : 1);
+  runThreads(&runCarveThread, &context, numThreads);
+
+  std::sort(context.links.begin(), context.links.end(), isBefore);
+  oLinks.swap(context.links);
+  return true;
+}
+
+bool carveFile(const char * iFilePath, const CarveOptions & iOptions, std::vector<CarvedLink> & oLinks)
+{
+  oLinks.clear();
+  filesystem::MappedFile file;
+  if (!file.open(iFilePath))
+    return false;
+  return carveLinks(file.getBuffer(), file.getSize(), iOptions, oLinks);
+}
+
+}; //lnk
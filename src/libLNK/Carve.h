@@ -0,0 +1,55 @@
+#pragma once
+
+#include "libLNK.h"
+
+namespace lnk
+{
+
+//A link found by carveLinks()
+struct CarvedLink
+{
+  uint64_t offset;      //offset of the first byte of the link in the data
+  unsigned long size;   //size of the link, up to the end of its TerminalBlock
+};
+
+//Options of carveLinks()
+struct CarveOptions
+{
+  ParseLimits limits;         //limits of the parsing of each candidate
+  unsigned long numThreads;   //number of threads searching the data, including the calling thread
+  unsigned long chunkSize;    //number of bytes searched by a thread at a time
+};
+extern const CarveOptions LNK_DEFAULT_CARVE_OPTIONS;
+
+///<summary>
+///Finds the first signature of a link in a buffer: the header size (0x0000004C) followed by the CLSID of links.
+///The buffer is searched 16 bytes at a time with SSE2 when the compiler supports it.
+///</summary>
+///<param name="iBuffer">The buffer to search.</param>
+///<param name="iSize">The size of the buffer in bytes.</param>
+///<return>Returns the offset of the first signature. Returns iSize if the buffer does not contain a signature.<return>
+size_t findLinkSignature(const unsigned char * iBuffer, size_t iSize);
+
+///<summary>
+///Finds the links embedded at any offset of a large buffer (ie a disk image or a memory dump).
+///The buffer is split in chunks searched in parallel. Each signature found is validated by decoding the link with
+///the limits of the options: links which are truncated or invalid are not reported.
+///</summary>
+///<param name="iBuffer">The data to search.</param>
+///<param name="iSize">The size of the data in bytes.</param>
+///<param name="iOptions">The options of the search.</param>
+///<param name="oLinks">The links found, ordered by offset.</param>
+///<return>Returns true if the data is searched. Returns false if iBuffer is NULL.<return>
+bool carveLinks(const unsigned char * iBuffer, size_t iSize, const CarveOptions & iOptions, std::vector<CarvedLink> & oLinks);
+
+///<summary>
+///Finds the links embedded in a file. The file is mapped in memory: files larger than the address space
+///of the process (ie 2GB for 32 bits processes) cannot be searched.
+///</summary>
+///<param name="iFilePath">The path of the file to search.</param>
+///<param name="iOptions">The options of the search.</param>
+///<param name="oLinks">The links found, ordered by offset.</param>
+///<return>Returns true if the file is searched. Returns false if the file cannot be mapped.<return>
+bool carveFile(const char * iFilePath, const CarveOptions & iOptions, std::vector<CarvedLink> & oLinks);
+
+}; //lnk
@@ -0,0 +1,328 @@
+#include "Inflate.h"
+#include <string.h> //for memset()
+
+namespace lnk
+{
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// Defines, Pre-declarations & typedefs
+//----------------------------------------------------------------------------------------------------------------------------------------
+//See RFC 1951 section 3.2.5
+static const unsigned long MAX_CODE_LENGTH = 15;
+static const unsigned long NUM_LENGTH_SYMBOLS = 286;
+static const unsigned long NUM_FIXED_LENGTH_SYMBOLS = 288;
+static const unsigned long NUM_DISTANCE_SYMBOLS = 30;
+static const unsigned long END_OF_BLOCK = 256;
+static const uint16_t LENGTH_BASES[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LENGTH_EXTRA_BITS[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DISTANCE_BASES[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t DISTANCE_EXTRA_BITS[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+static const uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+static const unsigned long WINDOW_MASK = 0x7FFF;
+
+//Builds a canonical Huffman code from the length of the code of each symbol.
+//Returns 0 for a complete code, a positive value for an incomplete code and a negative value for an over-subscribed code.
+int buildHuffman(const uint8_t * iLengths, unsigned long iCount, LNK_HUFFMAN & oCode)
+{
+  memset(oCode.counts, 0, sizeof(oCode.counts));
+  for(unsigned long i=0; i<iCount; i++)
+    oCode.counts[iLengths[i]]++;
+  if (oCode.counts[0] == iCount)
+    return 0; //no codes
+
+  //each length uses twice the codes left by the previous one
+  int left = 1;
+  for(unsigned long length=1; length<=MAX_CODE_LENGTH; length++)
+  {
+    left <<= 1;
+    left -= oCode.counts[length];
+    if (left < 0)
+      return left;
+  }
+
+  //offset of the first symbol of each length
+  uint16_t offsets[MAX_CODE_LENGTH + 1];
+  offsets[1] = 0;
+  for(unsigned long length=1; length<MAX_CODE_LENGTH; length++)
+    offsets[length + 1] = offsets[length] + oCode.counts[length];
+  for(unsigned long i=0; i<iCount; i++)
+  {
+    if (iLengths[i] != 0)
+      oCode.symbols[offsets[iLengths[i]]++] = (uint16_t)i;
+  }
+  return left;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// global functions
+//----------------------------------------------------------------------------------------------------------------------------------------
+InflateReader::InflateReader()
+{
+  //the fixed codes are built once
+  uint8_t lengths[NUM_FIXED_LENGTH_SYMBOLS];
+  unsigned long i = 0;
+  for(; i<144; i++) lengths[i] = 8;
+  for(; i<256; i++) lengths[i] = 9;
+  for(; i<280; i++) lengths[i] = 7;
+  for(; i<NUM_FIXED_LENGTH_SYMBOLS; i++) lengths[i] = 8;
+  buildHuffman(lengths, NUM_FIXED_LENGTH_SYMBOLS, mFixedLengths);
+  for(i=0; i<NUM_DISTANCE_SYMBOLS; i++) lengths[i] = 5;
+  buildHuffman(lengths, NUM_DISTANCE_SYMBOLS, mFixedDistances);
+
+  reset(NULL, 0);
+}
+
+void InflateReader::reset(const unsigned char * iData, size_t iSize)
+{
+  mData = iData;
+  mSize = iSize;
+  mOffset = 0;
+  mBitBuffer = 0;
+  mBitCount = 0;
+  mTruncated = false;
+  mState = STATE_HEADER;
+  mLastBlock = false;
+  mStoredRemaining = 0;
+  mLengths = NULL;
+  mDistances = NULL;
+  mWindowPosition = 0;
+  mTotalOut = 0;
+  mCopyLength = 0;
+  mCopyDistance = 0;
+}
+
+uint32_t InflateReader::getBits(unsigned long iCount)
+{
+  //the bits are read from the least significant bit of each byte
+  while(mBitCount < iCount)
+  {
+    if (mOffset == mSize)
+    {
+      mTruncated = true;
+      return 0;
+    }
+    mBitBuffer |= (uint32_t)mData[mOffset++] << mBitCount;
+    mBitCount += 8;
+  }
+  const uint32_t value = mBitBuffer & ((1u << iCount) - 1);
+  mBitBuffer >>= iCount;
+  mBitCount -= iCount;
+  return value;
+}
+
+int InflateReader::decode(const LNK_HUFFMAN & iCode)
+{
+  //the codes of each length follow the codes of the previous length
+  int code = 0;
+  int first = 0;
+  int index = 0;
+  for(unsigned long length=1; length<=MAX_CODE_LENGTH; length++)
+  {
+    code |= (int)getBits(1);
+    const int count = iCode.counts[length];
+    if (code - first < count)
+      return iCode.symbols[index + code - first];
+    index += count;
+    first = (first + count) << 1;
+    code <<= 1;
+  }
+  return -1; //not a code or truncated
+}
+
+bool InflateReader::readDynamicCodes()
+{
+  const unsigned long numLengths = getBits(5) + 257;
+  const unsigned long numDistances = getBits(5) + 1;
+  const unsigned long numCodeLengths = getBits(4) + 4;
+  if (numLengths > NUM_LENGTH_SYMBOLS || numDistances > NUM_DISTANCE_SYMBOLS)
+    return false;
+
+  //the lengths of the codes are themselves compressed with a complete Huffman code
+  uint8_t lengths[NUM_LENGTH_SYMBOLS + NUM_DISTANCE_SYMBOLS];
+  memset(lengths, 0, sizeof(lengths));
+  for(unsigned long i=0; i<numCodeLengths; i++)
+    lengths[CODE_LENGTH_ORDER[i]] = (uint8_t)getBits(3);
+  LNK_HUFFMAN codeLengths;
+  if (buildHuffman(lengths, 19, codeLengths) != 0)
+    return false;
+
+  unsigned long index = 0;
+  while(index < numLengths + numDistances)
+  {
+    int symbol = decode(codeLengths);
+    if (symbol < 0 || mTruncated)
+      return false;
+    if (symbol < 16)
+    {
+      lengths[index++] = (uint8_t)symbol;
+      continue;
+    }
+
+    //repeated lengths
+    uint8_t length = 0;
+    unsigned long count = 0;
+    if (symbol == 16)
+    {
+      if (index == 0)
+        return false; //no previous length
+      length = lengths[index - 1];
+      count = 3 + getBits(2);
+    }
+    else if (symbol == 17)
+      count = 3 + getBits(3);
+    else
+      count = 11 + getBits(7);
+    if (index + count > numLengths + numDistances)
+      return false;
+    while(count-- > 0)
+      lengths[index++] = length;
+  }
+  if (mTruncated || lengths[END_OF_BLOCK] == 0)
+    return false;
+
+  //incomplete codes are only allowed for a single code of length 1
+  int left = buildHuffman(lengths, numLengths, mDynamicLengths);
+  if (left < 0 || (left > 0 && numLengths - mDynamicLengths.counts[0] != 1))
+    return false;
+  left = buildHuffman(lengths + numLengths, numDistances, mDynamicDistances);
+  if (left < 0 || (left > 0 && numDistances - mDynamicDistances.counts[0] != 1))
+    return false;
+  mLengths = &mDynamicLengths;
+  mDistances = &mDynamicDistances;
+  return true;
+}
+
+bool InflateReader::readBlockHeader()
+{
+  mLastBlock = (getBits(1) != 0);
+  const uint32_t type = getBits(2);
+  switch(type)
+  {
+  case 0: //stored
+    {
+      //the length starts at the next byte
+      mBitBuffer = 0;
+      mBitCount = 0;
+      if (mSize - mOffset < 4)
+        return false;
+      const unsigned long length = mData[mOffset] | (mData[mOffset + 1] << 8);
+      const unsigned long complement = mData[mOffset + 2] | (mData[mOffset + 3] << 8);
+      mOffset += 4;
+      if (length != (~complement & 0xFFFF))
+        return false;
+      mStoredRemaining = length;
+      mState = STATE_STORED;
+    }
+    break;
+  case 1: //fixed codes
+    mLengths = &mFixedLengths;
+    mDistances = &mFixedDistances;
+    mState = STATE_HUFFMAN;
+    break;
+  case 2: //dynamic codes
+    if (!readDynamicCodes())
+      return false;
+    mState = STATE_HUFFMAN;
+    break;
+  default:
+    return false;
+  };
+  return !mTruncated;
+}
+
+inline void InflateReader::writeByte(unsigned char iByte, unsigned char *& ioOutput)
+{
+  mWindow[mWindowPosition] = iByte;
+  mWindowPosition = (mWindowPosition + 1) & WINDOW_MASK;
+  mTotalOut++;
+  *ioOutput++ = iByte;
+}
+
+bool InflateReader::read(void * oBuffer, unsigned long iSize, unsigned long & oRead)
+{
+  unsigned char * output = (unsigned char *)oBuffer;
+  unsigned char * end = output + iSize;
+  while(output < end)
+  {
+    //finish the current back reference first
+    if (mCopyLength > 0)
+    {
+      writeByte(mWindow[(mWindowPosition - mCopyDistance) & WINDOW_MASK], output);
+      mCopyLength--;
+      continue;
+    }
+
+    if (mState == STATE_DONE || mState == STATE_ERROR)
+      break;
+    if (mState == STATE_HEADER)
+    {
+      if (mLastBlock)
+        mState = STATE_DONE;
+      else if (!readBlockHeader())
+        mState = STATE_ERROR;
+      continue;
+    }
+    if (mState == STATE_STORED)
+    {
+      if (mStoredRemaining == 0)
+      {
+        mState = STATE_HEADER;
+        continue;
+      }
+      if (mOffset == mSize)
+      {
+        mState = STATE_ERROR;
+        continue;
+      }
+      writeByte(mData[mOffset++], output);
+      mStoredRemaining--;
+      continue;
+    }
+
+    //compressed block
+    int symbol = decode(*mLengths);
+    if (symbol < 0 || mTruncated)
+    {
+      mState = STATE_ERROR;
+      continue;
+    }
+    if (symbol < (int)END_OF_BLOCK)
+    {
+      writeByte((unsigned char)symbol, output);
+      continue;
+    }
+    if (symbol == (int)END_OF_BLOCK)
+    {
+      mState = STATE_HEADER;
+      continue;
+    }
+
+    //back reference
+    symbol -= END_OF_BLOCK + 1;
+    if (symbol >= 29)
+    {
+      mState = STATE_ERROR;
+      continue;
+    }
+    const unsigned long length = LENGTH_BASES[symbol] + getBits(LENGTH_EXTRA_BITS[symbol]);
+    symbol = decode(*mDistances);
+    if (symbol < 0 || symbol >= (int)NUM_DISTANCE_SYMBOLS || mTruncated)
+    {
+      mState = STATE_ERROR;
+      continue;
+    }
+    const unsigned long distance = DISTANCE_BASES[symbol] + getBits(DISTANCE_EXTRA_BITS[symbol]);
+    if (mTruncated || distance > mTotalOut)
+    {
+      mState = STATE_ERROR;
+      continue;
+    }
+    mCopyLength = length;
+    mCopyDistance = distance;
+  }
+
+  oRead = (unsigned long)(output - (unsigned char *)oBuffer);
+  return mState != STATE_ERROR;
+}
+
+}; //lnk
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Reader.h"
+#include <stdint.h>
+#include <stddef.h>
+
+namespace lnk
+{
+
+  //Canonical Huffman code of a deflate block: number of codes of each length and symbols ordered by code
+  struct LNK_HUFFMAN
+  {
+    uint16_t counts[16];
+    uint16_t symbols[288];
+  };
+
+  ///<summary>
+  ///Decompresses raw deflate data (RFC 1951, the "deflate" method of ZIP archives) held in memory.
+  ///The data is inflated on demand: reading the first bytes of a stream only decodes the blocks which contain them.
+  ///The object can be reset to inflate many streams without allocating memory.
+  ///</summary>
+  class InflateReader : public Reader
+  {
+  public:
+    InflateReader();
+
+    ///<summary>
+    ///Starts inflating new compressed data. The data is not copied and must stay valid while it is read.
+    ///</summary>
+    void reset(const unsigned char * iData, size_t iSize);
+
+    ///<summary>
+    ///Reads the next inflated bytes.
+    ///</summary>
+    ///<return>Returns false if the compressed data is invalid or truncated. Returns true otherwise.<return>
+    virtual bool read(void * oBuffer, unsigned long iSize, unsigned long & oRead);
+
+  private:
+    InflateReader(const InflateReader &);
+    InflateReader & operator = (const InflateReader &);
+
+    enum STATE
+    {
+      STATE_HEADER,   //reading the header of the next block
+      STATE_STORED,   //copying a stored block
+      STATE_HUFFMAN,  //decoding a compressed block
+      STATE_DONE,     //the last block is decoded
+      STATE_ERROR,    //the data is invalid
+    };
+
+    uint32_t getBits(unsigned long iCount);
+    int decode(const LNK_HUFFMAN & iCode);
+    bool readBlockHeader();
+    bool readDynamicCodes();
+    void writeByte(unsigned char iByte, unsigned char *& ioOutput);
+
+    //input
+    const unsigned char * mData;
+    size_t mSize;
+    size_t mOffset;
+    uint32_t mBitBuffer;
+    unsigned long mBitCount;
+    bool mTruncated;
+
+    //blocks
+    STATE mState;
+    bool mLastBlock;
+    unsigned long mStoredRemaining;
+    LNK_HUFFMAN mFixedLengths;
+    LNK_HUFFMAN mFixedDistances;
+    LNK_HUFFMAN mDynamicLengths;
+    LNK_HUFFMAN mDynamicDistances;
+    const LNK_HUFFMAN * mLengths;
+    const LNK_HUFFMAN * mDistances;
+
+    //output: the last 32K bytes are kept for the back references
+    unsigned char mWindow[0x8000];
+    unsigned long mWindowPosition;
+    uint64_t mTotalOut;
+    unsigned long mCopyLength;    //bytes of the current back reference not yet copied
+    unsigned long mCopyDistance;
+  };
+
+}; //lnk
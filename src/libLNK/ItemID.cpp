@@ -1,181 +1,218 @@
 #include "ItemID.h"
+#include "Tracing.h"
 #include <stdint.h>
+#include <string.h> //for memcpy()
 #include <assert.h>
 
 namespace lnk
 {
 
-  MemoryBuffer getLinkTargetIDList(const ItemIDList & iItemIDList)
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // Defines, Pre-declarations & typedefs
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  static const unsigned long MAX_ITEMID_SIZE = 0xFFFF; //the size of an ItemID and the IDListSize are 16 bits values
+  static const uint8_t TERMINAL_ITEMID[] = {0x00, 0x00};
+  static const uint8_t COMPUTER_ITEMID[] = {0x14, 0x00, 0x1f, 0x50, 0xe0, 0x4f, 0xd0, 0x20, 0xea, 0x3a, 0x69, 0x10, 0xa2, 0xd8, 0x08, 0x00, 0x2b, 0x30, 0x30, 0x9d};
+
+  #define LNK_DRIVE_ITEMID(letter) {0x19, 0x00, 0x2f, letter, ':', '\\', 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}
+  static const unsigned long DRIVE_ITEMID_SIZE = 25;
+  static const uint8_t DRIVE_ITEMIDS[26][DRIVE_ITEMID_SIZE] = {
+    LNK_DRIVE_ITEMID('A'), LNK_DRIVE_ITEMID('B'), LNK_DRIVE_ITEMID('C'), LNK_DRIVE_ITEMID('D'), LNK_DRIVE_ITEMID('E'), LNK_DRIVE_ITEMID('F'),
+    LNK_DRIVE_ITEMID('G'), LNK_DRIVE_ITEMID('H'), LNK_DRIVE_ITEMID('I'), LNK_DRIVE_ITEMID('J'), LNK_DRIVE_ITEMID('K'), LNK_DRIVE_ITEMID('L'),
+    LNK_DRIVE_ITEMID('M'), LNK_DRIVE_ITEMID('N'), LNK_DRIVE_ITEMID('O'), LNK_DRIVE_ITEMID('P'), LNK_DRIVE_ITEMID('Q'), LNK_DRIVE_ITEMID('R'),
+    LNK_DRIVE_ITEMID('S'), LNK_DRIVE_ITEMID('T'), LNK_DRIVE_ITEMID('U'), LNK_DRIVE_ITEMID('V'), LNK_DRIVE_ITEMID('W'), LNK_DRIVE_ITEMID('X'),
+    LNK_DRIVE_ITEMID('Y'), LNK_DRIVE_ITEMID('Z'),
+  };
+  #undef LNK_DRIVE_ITEMID
+
+  //header of a file ItemID (ItemIDHeader). The size, the type, the 3rd unknown byte and the attributes are patched.
+  static const uint8_t FILE_ITEMID_HEADER[] = {
+    0x00, 0x00,                                           //size
+    0x32,                                                 //type: 0x31 folder, 0x32 file
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x3A, 0x3E, 0x13, 0x6B, //unknown1: 0x0E folder, 0x13 file
+    0x20, 0x00,                                           //attributes: 0x10 folder, 0x20 file
+  };
+  static const unsigned long FILE_ITEMID_TYPE_OFFSET = 2;
+  static const unsigned long FILE_ITEMID_UNKNOWN_OFFSET = 10;
+  static const unsigned long FILE_ITEMID_ATTRIBUTES_OFFSET = 12;
+
+  //header of a WinXP ItemIDEx. The size and the 2 unknown bytes are patched.
+  static const uint8_t WINXP_ITEMIDEX_HEADER[] = {
+    0x00, 0x00,                                           //size
+    0x03, 0x00, 0x04, 0x00,                               //type: WinXP style
+    0xEF, 0xBE,                                           //always
+    0x3A, 0x3E, 0x13, 0x6B,                               //0x0E folder, 0x13 file
+    0x3A, 0x3E, 0x13, 0x6B,                               //0x0E folder, 0x13 file
+    0x14, 0x00, 0x00, 0x00,
+  };
+  static const unsigned long WINXP_ITEMIDEX_UNKNOWN_OFFSET1 = 10;
+  static const unsigned long WINXP_ITEMIDEX_UNKNOWN_OFFSET2 = 14;
+  static const uint8_t WINXP_ITEMIDEX_FOOTER[] = {0x18, 0x00}; //0x12, 0x14, 0x16, 0x18 or 0x1A then always 0x00
+
+  inline unsigned long getWinXpItemIdExSize(size_t iLongLength)
   {
-    //assert iItemIDList already contains TerminalID
-    assert (iItemIDList.size() != 0);
-    assert (iItemIDList[iItemIDList.size()-1].getSize() == 2);
-
-    //build LinkTargetIDList
-    MemoryBuffer buffer;
+    return (unsigned long)(sizeof(WINXP_ITEMIDEX_HEADER) + (iLongLength+1)*2 + sizeof(WINXP_ITEMIDEX_FOOTER));
+  }
 
-    //compute total size
-    uint16_t IDListSize = 0;
-    for(size_t i=0; i<iItemIDList.size(); i++)
-    {
-      const MemoryBuffer & ItemID = iItemIDList[i];
-      IDListSize += (size_t)ItemID.getSize();
-    }
-    serialize(IDListSize, buffer);
+  inline void writeUInt16(uint16_t iValue, uint8_t * oBuffer)
+  {
+    oBuffer[0] = (uint8_t)(iValue & 0xFF);
+    oBuffer[1] = (uint8_t)(iValue >> 8);
+  }
 
-    //serialize all ItemID
-    for(size_t i=0; i<iItemIDList.size(); i++)
+  //Writes a WinXP ItemIDEx at oBuffer which must be getWinXpItemIdExSize() bytes long
+  void writeWinXpItemIdEx(const char * iLongName, size_t iLongLength, const FILE_ATTRIBUTES & iAttributes, uint8_t * oBuffer)
+  {
+    uint8_t unknown = ( (iAttributes == FA_DIRECTORY) ? 0x0E : 0x13 );
+    memcpy(oBuffer, WINXP_ITEMIDEX_HEADER, sizeof(WINXP_ITEMIDEX_HEADER));
+    writeUInt16((uint16_t)getWinXpItemIdExSize(iLongLength), oBuffer);
+    oBuffer[WINXP_ITEMIDEX_UNKNOWN_OFFSET1] = unknown;
+    oBuffer[WINXP_ITEMIDEX_UNKNOWN_OFFSET2] = unknown;
+
+    //long name, including NULL character
+    uint8_t * name = oBuffer + sizeof(WINXP_ITEMIDEX_HEADER);
+    for(size_t i=0; i<iLongLength; i++)
     {
-      const MemoryBuffer & ItemID = iItemIDList[i];
-      serialize(ItemID.getBuffer(), ItemID.getSize(), buffer);
+      name[i*2] = (uint8_t)iLongName[i]; //no sign extension
+      name[i*2+1] = 0;
     }
+    name[iLongLength*2] = 0;
+    name[iLongLength*2+1] = 0;
 
-    return buffer;
+    memcpy(name + (iLongLength+1)*2, WINXP_ITEMIDEX_FOOTER, sizeof(WINXP_ITEMIDEX_FOOTER));
   }
 
-  MemoryBuffer getTerminalItemId()
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // global functions
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  unsigned long getFileItemIdSize(size_t iShortLength, size_t iLongLength)
   {
-    static const uint16_t terminalId = 0;
-
-    MemoryBuffer buffer;
-    serialize(terminalId, buffer);
-
-    return buffer;
+    //header, short name and its NULL character, padding and ItemIDEx
+    return (unsigned long)(sizeof(FILE_ITEMID_HEADER) + iShortLength + 1 + 1 + getWinXpItemIdExSize(iLongLength));
   }
 
-  MemoryBuffer getComputerItemId()
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // ItemIDListBuilder
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  ItemIDListBuilder::ItemIDListBuilder() :
+  mBuffer(NULL),
+  mCapacity(0),
+  mSize(sizeof(uint16_t)), //IDListSize
+  mOverflow(false)
   {
-    static const uint8_t computer[] = {0x14, 0x00, 0x1f, 0x50, 0xe0, 0x4f, 0xd0, 0x20, 0xea, 0x3a, 0x69, 0x10, 0xa2, 0xd8, 0x08, 0x00, 0x2b, 0x30, 0x30, 0x9d};
-
-    MemoryBuffer buffer;
-    serialize(computer, sizeof(computer), buffer);
-
-    return buffer;
   }
 
-  MemoryBuffer getDriveItemId(char iDriveLetter)
+  ItemIDListBuilder::ItemIDListBuilder(unsigned char * oBuffer, unsigned long iCapacity) :
+  mBuffer(oBuffer),
+  mCapacity(iCapacity),
+  mSize(0),
+  mOverflow(false)
   {
-    static const uint8_t drive[] = {0x19, 0x00, 0x2f, 'C', ':', '\\', 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    reserve(sizeof(uint16_t)); //IDListSize is patched by finish()
+  }
 
-    MemoryBuffer buffer;
-    serialize(drive, sizeof(drive), buffer);
+  //Returns the address of the next iSize bytes of the list, or NULL if the bytes are only measured
+  unsigned char * ItemIDListBuilder::reserve(unsigned long iSize)
+  {
+    if (mBuffer == NULL || mOverflow || mSize + iSize > mCapacity)
+    {
+      mOverflow = mOverflow || (mBuffer != NULL && mSize + iSize > mCapacity);
+      mSize += iSize;
+      return NULL;
+    }
+    unsigned char * offset = mBuffer + mSize;
+    mSize += iSize;
+    return offset;
+  }
 
-    //fix drive letter
-    uint8_t & letter = buffer.getBuffer()[3];
-    letter = (uint8_t)iDriveLetter;
+  bool ItemIDListBuilder::addComputerItemId()
+  {
+    uint8_t * item = reserve(sizeof(COMPUTER_ITEMID));
+    if (item)
+      memcpy(item, COMPUTER_ITEMID, sizeof(COMPUTER_ITEMID));
+    return !mOverflow;
+  }
 
-    return buffer;
+  bool ItemIDListBuilder::addDriveItemId(char iDriveLetter)
+  {
+    uint8_t * item = reserve(DRIVE_ITEMID_SIZE);
+    if (item)
+    {
+      if (iDriveLetter >= 'A' && iDriveLetter <= 'Z')
+        memcpy(item, DRIVE_ITEMIDS[iDriveLetter - 'A'], DRIVE_ITEMID_SIZE);
+      else
+      {
+        //not a drive letter: patch a copy of the template
+        memcpy(item, DRIVE_ITEMIDS[0], DRIVE_ITEMID_SIZE);
+        item[3] = (uint8_t)iDriveLetter;
+      }
+    }
+    return !mOverflow;
   }
 
-  MemoryBuffer getFileItemId(const std::string & iShortName, const std::string & iLongName, const FILE_ATTRIBUTES & iAttributes)
+  bool ItemIDListBuilder::addFileItemId(const char * iShortName, size_t iShortLength, const char * iLongName, size_t iLongLength, const FILE_ATTRIBUTES & iAttributes)
   {
     //validation
     assert( iAttributes == FA_NORMAL ||
             iAttributes == FA_DIRECTORY);
 
-    ItemIDHeader header;
-    header.size = 0;
-    header.type = ( (iAttributes == FA_DIRECTORY) ? 0x31 : 0x32 );
-    header.fileAttributes = ( (iAttributes == FA_DIRECTORY) ? 0x0010 : 0x0020 );
-
-    MemoryBuffer buffer;
-
-    serialize(header.size, buffer);
-    serialize(header.type, buffer);
-    serialize((uint8_t)0x00, buffer); // unknown1
-    serialize((uint8_t)0x00, buffer); // unknown1
-    serialize((uint8_t)0x00, buffer); // unknown1
-    serialize((uint8_t)0x00, buffer); // unknown1
-    serialize((uint8_t)0x00, buffer); // unknown1
-    serialize((uint8_t)0x3A, buffer); // unknown1  0x34
-    serialize((uint8_t)0x3E, buffer); // unknown1  0x3E
-    if (iAttributes == FA_DIRECTORY)
+    if (iShortLength > MAX_ITEMID_SIZE || iLongLength > MAX_ITEMID_SIZE || getFileItemIdSize(iShortLength, iLongLength) > MAX_ITEMID_SIZE)
     {
-      serialize((uint8_t)0x0E, buffer); // unknown1  0xDD
+      mOverflow = true;
+      return false;
     }
-    else
-    {
-      serialize((uint8_t)0x13, buffer); // unknown1  0xDD
-    }
-    serialize((uint8_t)0x6B, buffer); // unknown1  0x60
-    serialize(header.fileAttributes, buffer);
-
-    //shortname
-    serialize((const uint8_t *)iShortName.c_str(), iShortName.size()+1, buffer);
 
-    //padding ?
-    serialize((uint8_t)0x00, buffer);
+    uint8_t * item = reserve(getFileItemIdSize(iShortLength, iLongLength));
+    if (!item)
+      return !mOverflow; //measured only
 
-    //add ItemIDEx
-    MemoryBuffer itemIdExBuffer = getWinXpItemIdEx(iLongName, iAttributes);
-    serialize(itemIdExBuffer.getBuffer(), itemIdExBuffer.getSize(), buffer);
-
-    //fix size
-    uint16_t * size = (uint16_t *)buffer.getBuffer();
-    *size = (uint16_t)buffer.getSize();
-
-    return buffer;
-  }
-
-  MemoryBuffer getWinXpItemIdEx(const std::string & iLongName, const FILE_ATTRIBUTES & iAttributes)
-  {
-    MemoryBuffer buffer;
-
-    ItemIDEx header;
-    header.size = 0;
-    header.type = 0x00040003; //WinXP style
-
-    serialize(header.size, buffer);
-    serialize(header.type, buffer);
-    serialize((uint8_t)0xEF, buffer); //always
-    serialize((uint8_t)0xBE, buffer); //always
-
-    serialize((uint8_t)0x3A, buffer); // 0x77
-    serialize((uint8_t)0x3E, buffer); // 0x35
+    LNK_TRACE_SCOPE("addFileItemId");
 
+    //header
+    memcpy(item, FILE_ITEMID_HEADER, sizeof(FILE_ITEMID_HEADER));
     if (iAttributes == FA_DIRECTORY)
     {
-      serialize((uint8_t)0x0E, buffer); // 0x1C
-    }
-    else
-    {
-      serialize((uint8_t)0x13, buffer); // 0x1C
+      item[FILE_ITEMID_TYPE_OFFSET] = 0x31;
+      item[FILE_ITEMID_UNKNOWN_OFFSET] = 0x0E;
+      writeUInt16(0x0010, item + FILE_ITEMID_ATTRIBUTES_OFFSET);
     }
 
-    serialize((uint8_t)0x6B, buffer); // 0x37
-    serialize((uint8_t)0x3A, buffer); // 0x34
-    serialize((uint8_t)0x3E, buffer); // 0x3E
+    //shortname, NULL character and padding
+    uint8_t * shortName = item + sizeof(FILE_ITEMID_HEADER);
+    memcpy(shortName, iShortName, iShortLength);
+    shortName[iShortLength] = 0;
+    shortName[iShortLength+1] = 0;
 
-    if (iAttributes == FA_DIRECTORY)
-    {
-      serialize((uint8_t)0x0E, buffer); // 0xE6
-    }
-    else
-    {
-      serialize((uint8_t)0x13, buffer); // 0x1C
-    }
+    //ItemIDEx
+    uint8_t * itemEx = shortName + iShortLength + 2;
+    writeWinXpItemIdEx(iLongName, iLongLength, iAttributes, itemEx);
 
-    serialize((uint8_t)0x6B, buffer); // 0x60
-    serialize((uint8_t)0x14, buffer);
-    serialize((uint8_t)0x00, buffer);
-    serialize((uint8_t)0x00, buffer);
-    serialize((uint8_t)0x00, buffer);
-
-    //long name
-    for(size_t i=0; i<=iLongName.size(); i++) //include NULL character
-    {
-      uint16_t c = iLongName[i];
-      serialize(c, buffer);
-    }
+    //fix size
+    writeUInt16((uint16_t)(itemEx + getWinXpItemIdExSize(iLongLength) - item), item);
 
-    serialize((uint8_t)0x18, buffer); //0x12, 0x14, 0x16, 0x18 or 0x1A
-    serialize((uint8_t)0x00, buffer); //always
+    return true;
+  }
 
-    //fix size
-    uint16_t * size = (uint16_t *)buffer.getBuffer();
-    *size = (uint16_t)buffer.getSize();
+  bool ItemIDListBuilder::addItemIds(const unsigned char * iItemIds, unsigned long iSize)
+  {
+    uint8_t * items = reserve(iSize);
+    if (items)
+      memcpy(items, iItemIds, iSize);
+    return !mOverflow;
+  }
 
-    return buffer;
+  unsigned long ItemIDListBuilder::finish()
+  {
+    uint8_t * terminal = reserve(sizeof(TERMINAL_ITEMID));
+    if (terminal)
+      memcpy(terminal, TERMINAL_ITEMID, sizeof(TERMINAL_ITEMID));
+    if (mOverflow || mSize - sizeof(uint16_t) > MAX_ITEMID_SIZE)
+      return 0;
+
+    //fix IDListSize
+    if (mBuffer)
+      writeUInt16((uint16_t)(mSize - sizeof(uint16_t)), mBuffer);
+    return mSize;
   }
 
 }; //lnk
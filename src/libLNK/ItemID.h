@@ -1,8 +1,6 @@
 #pragma once
 
-#include "MemoryBuffer.h"
-#include <string>
-#include <vector>
+#include <stddef.h>
 #include <stdint.h>
 
 namespace lnk
@@ -33,13 +31,38 @@ namespace lnk
     FA_DIRECTORY
   };
 
-  typedef std::vector<MemoryBuffer> ItemIDList;
+  ///<summary>
+  ///Builds a LinkTargetIDList (the IDListSize followed by the ItemIDs and the TerminalID) in one contiguous buffer.
+  ///The constant ItemIDs are copied from precomputed templates. The size of each file ItemID
+  ///and the IDListSize are patched once their content is written.
+  ///A builder created without a buffer only measures the size of the list.
+  ///</summary>
+  class ItemIDListBuilder
+  {
+  public:
+    ItemIDListBuilder();                                            //measures the size of the list
+    ItemIDListBuilder(unsigned char * oBuffer, unsigned long iCapacity); //writes the list in oBuffer
+
+    bool addComputerItemId();
+    bool addDriveItemId(char iDriveLetter); //iDriveLetter must be an uppercase letter
+    bool addFileItemId(const char * iShortName, size_t iShortLength, const char * iLongName, size_t iLongLength, const FILE_ATTRIBUTES & iAttributes);
+    bool addItemIds(const unsigned char * iItemIds, unsigned long iSize); //copies ItemIDs of another list, without its IDListSize and TerminalID
+
+    ///<summary>
+    ///Adds the TerminalID and patches the IDListSize.
+    ///</summary>
+    ///<return>Returns the size of the LinkTargetIDList. Returns 0 if the buffer is too small or if an ItemID or the IDListSize exceeds 0xFFFF bytes.<return>
+    unsigned long finish();
+
+  private:
+    unsigned char * reserve(unsigned long iSize);
+
+    unsigned char * mBuffer;
+    unsigned long mCapacity;
+    unsigned long mSize;
+    bool mOverflow;
+  };
 
-  MemoryBuffer getLinkTargetIDList(const ItemIDList & iItemIDList);
-  MemoryBuffer getTerminalItemId();
-  MemoryBuffer getComputerItemId();
-  MemoryBuffer getDriveItemId(char iDriveLetter);
-  MemoryBuffer getFileItemId(const std::string & iShortName, const std::string & iLongName, const FILE_ATTRIBUTES & iAttributes);
-  MemoryBuffer getWinXpItemIdEx(const std::string & iLongName, const FILE_ATTRIBUTES & iAttributes);
+  unsigned long getFileItemIdSize(size_t iShortLength, size_t iLongLength);
 
 }; //lnk
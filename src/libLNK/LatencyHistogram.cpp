@@ -0,0 +1,152 @@
+#include "LatencyHistogram.h"
+
+namespace lnk
+{
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // Defines, Pre-declarations & typedefs
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  static const unsigned int SUB_BUCKET_BITS = 4;
+  static const uint64_t SUB_BUCKET_COUNT = (1 << SUB_BUCKET_BITS);
+  static const size_t NUM_BUCKETS = (size_t)((64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT);
+
+  //Returns the index of the most significant bit of a non zero value
+  static unsigned int getMostSignificantBit(uint64_t iValue)
+  {
+    unsigned int bit = 0;
+    for(unsigned int shift=32; shift>0; shift/=2)
+    {
+      if (iValue >> shift)
+      {
+        iValue >>= shift;
+        bit += shift;
+      }
+    }
+    return bit;
+  }
+
+  LatencyHistogram::LatencyHistogram() :
+    mBuckets(NUM_BUCKETS, 0),
+    mCount(0),
+    mMin(0),
+    mMax(0),
+    mSum(0)
+  {
+  }
+
+  void LatencyHistogram::clear()
+  {
+    mBuckets.assign(NUM_BUCKETS, 0);
+    mCount = 0;
+    mMin = 0;
+    mMax = 0;
+    mSum = 0;
+  }
+
+  void LatencyHistogram::record(uint64_t iValue)
+  {
+    mBuckets[getBucketIndex(iValue)]++;
+    if (mCount == 0 || iValue < mMin)
+      mMin = iValue;
+    if (iValue > mMax)
+      mMax = iValue;
+    mCount++;
+    mSum += iValue;
+  }
+
+  void LatencyHistogram::add(const LatencyHistogram & iHistogram)
+  {
+    if (iHistogram.mCount == 0)
+      return;
+    for(size_t i=0; i<NUM_BUCKETS; i++)
+      mBuckets[i] += iHistogram.mBuckets[i];
+    if (mCount == 0 || iHistogram.mMin < mMin)
+      mMin = iHistogram.mMin;
+    if (iHistogram.mMax > mMax)
+      mMax = iHistogram.mMax;
+    mCount += iHistogram.mCount;
+    mSum += iHistogram.mSum;
+  }
+
+  uint64_t LatencyHistogram::getCount() const
+  {
+    return mCount;
+  }
+
+  uint64_t LatencyHistogram::getMin() const
+  {
+    return mMin;
+  }
+
+  uint64_t LatencyHistogram::getMax() const
+  {
+    return mMax;
+  }
+
+  double LatencyHistogram::getMean() const
+  {
+    return (mCount > 0 ? (double)mSum / (double)mCount : 0.0);
+  }
+
+  uint64_t LatencyHistogram::getPercentile(double iPercentile) const
+  {
+    if (mCount == 0)
+      return 0;
+    if (iPercentile <= 0.0)
+      return mMin;
+    if (iPercentile >= 100.0)
+      return mMax;
+
+    //rank of the value of the percentile, starting at 1
+    uint64_t rank = (uint64_t)(iPercentile / 100.0 * (double)mCount + 0.999999);
+    if (rank < 1)
+      rank = 1;
+
+    uint64_t total = 0;
+    for(size_t i=0; i<NUM_BUCKETS; i++)
+    {
+      total += mBuckets[i];
+      if (total >= rank)
+      {
+        uint64_t value = getBucketUpperBound(i);
+        return (value < mMax ? value : mMax);
+      }
+    }
+    return mMax;
+  }
+
+  size_t LatencyHistogram::getBucketIndex(uint64_t iValue)
+  {
+    //values smaller than 2*SUB_BUCKET_COUNT have their own bucket
+    if (iValue < SUB_BUCKET_COUNT)
+      return (size_t)iValue;
+
+    unsigned int exponent = getMostSignificantBit(iValue);
+    unsigned int shift = exponent - SUB_BUCKET_BITS;
+    size_t block = exponent - SUB_BUCKET_BITS + 1;
+    size_t subBucket = (size_t)((iValue >> shift) & (SUB_BUCKET_COUNT - 1));
+    return (size_t)(block * SUB_BUCKET_COUNT + subBucket);
+  }
+
+  uint64_t LatencyHistogram::getBucketLowerBound(size_t iIndex)
+  {
+    if (iIndex < 2*SUB_BUCKET_COUNT)
+      return iIndex;
+
+    size_t block = (size_t)(iIndex / SUB_BUCKET_COUNT);
+    size_t subBucket = (size_t)(iIndex % SUB_BUCKET_COUNT);
+    unsigned int shift = (unsigned int)(block - 1);
+    return (SUB_BUCKET_COUNT + subBucket) << shift;
+  }
+
+  uint64_t LatencyHistogram::getBucketUpperBound(size_t iIndex)
+  {
+    if (iIndex < 2*SUB_BUCKET_COUNT)
+      return iIndex;
+
+    size_t block = (size_t)(iIndex / SUB_BUCKET_COUNT);
+    unsigned int shift = (unsigned int)(block - 1);
+    return getBucketLowerBound(iIndex) + (((uint64_t)1 << shift) - 1);
+  }
+
+}; //lnk
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace lnk
+{
+
+  ///<summary>
+  ///Histogram of latencies with log-linear buckets (HDR style).
+  ///Each power of 2 is divided in 16 linear buckets: values are recorded
+  ///with a relative error of at most 6.25% over the whole uint64_t range.
+  ///Recording a value does not allocate memory.
+  ///</summary>
+  class LatencyHistogram
+  {
+  public:
+    LatencyHistogram();
+
+    void clear();
+    void record(uint64_t iValue);
+    void add(const LatencyHistogram & iHistogram);
+
+    uint64_t getCount() const;
+    uint64_t getMin() const;
+    uint64_t getMax() const;
+    double getMean() const;
+
+    ///<summary>
+    ///Returns the value below which a percentage of the recorded values fall.
+    ///The value is the upper bound of the bucket of the percentile, limited to the maximum recorded value.
+    ///</summary>
+    ///<param name="iPercentile">The percentile in the range [0, 100].</param>
+    ///<return>Returns the value of the percentile. Returns 0 if the histogram is empty.<return>
+    uint64_t getPercentile(double iPercentile) const;
+
+    static size_t getBucketIndex(uint64_t iValue);
+    static uint64_t getBucketLowerBound(size_t iIndex);
+    static uint64_t getBucketUpperBound(size_t iIndex);
+
+  private:
+    std::vector<uint64_t> mBuckets;
+    uint64_t mCount;
+    uint64_t mMin;
+    uint64_t mMax;
+    uint64_t mSum;
+  };
+
+}; //lnk
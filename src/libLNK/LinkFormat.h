@@ -0,0 +1,187 @@
+#pragma once
+
+#include "libLNK.h"
+#include <string.h> //for memcpy()
+
+//Layout of the sections of a link, shared by the decoder, createLink() and LinkTemplate.
+
+namespace lnk
+{
+
+//http://www.stdlib.com/art6-Link-File-Format-lnk.html
+//http://www.wotsit.org/list.asp?search=lnk
+
+#pragma pack(push)
+#pragma pack(1)
+
+//Link flags
+struct LinkFlags //32 bits
+{
+  bool HasLinkTargetIDList      :1;
+  bool HasLinkInfo              :1;
+  bool HasName                  :1;
+  bool HasRelativePath          :1;
+  bool HasWorkingDir            :1;
+  bool HasArguments             :1;
+  bool HasIconLocation          :1;
+  bool reserved1                :1;
+  bool reserved2                :8;
+  bool reserved3                :8;
+  bool reserved4                :8;
+};
+
+//Target flags
+struct FileAttributesFlags //32 bits
+{
+  bool isReadOnly      :1; //FILE_ATTRIBUTE_READONLY
+  bool isHidden        :1; //FILE_ATTRIBUTE_HIDDEN
+  bool isSystemFile    :1; //FILE_ATTRIBUTE_SYSTEM
+  bool isVolumeLabel   :1; //Reserved1, MUST be zero.
+  bool isDirectory     :1; //FILE_ATTRIBUTE_DIRECTORY
+  bool isArchive       :1; //FILE_ATTRIBUTE_ARCHIVE
+  bool isEncrypted     :1; //Reserved2, MUST be zero.
+  bool isNormal        :1; //FILE_ATTRIBUTE_NORMAL
+  bool isTemporary     :1; //FILE_ATTRIBUTE_TEMPORARY
+  bool isSparseFile    :1; //FILE_ATTRIBUTE_SPARSE_FILE
+  bool hasReparsePoint :1; //FILE_ATTRIBUTE_REPARSE_POINT
+  bool isCompressed    :1; //FILE_ATTRIBUTE_COMPRESSED
+  bool isOffline       :1; //FILE_ATTRIBUTE_OFFLINE
+  bool reserved1       :3; //FILE_ATTRIBUTE_NOT_CONTENT_INDEXED
+  bool reserved2       :8; //FILE_ATTRIBUTE_ENCRYPTED
+  bool reserved3       :8;
+};
+
+typedef uint8_t LNK_CLSID[16];
+static const LNK_CLSID DEFAULT_LINKCLSID = { 0x01, 0x14, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46};
+struct ShellLinkHeader
+{
+  uint32_t HeaderSize;
+  LNK_CLSID LinkCLSID;
+  LinkFlags linkFlags; 
+  FileAttributesFlags FileAttributes;
+  unsigned __int64 CreationTime;
+  unsigned __int64 AccessTime;
+  unsigned __int64 WriteTime;
+  unsigned long FileSize;
+  unsigned long IconIndex;
+  unsigned long ShowCommand;
+  LNK_HOTKEY HotKey;
+  uint16_t Reserved1;
+  uint32_t Reserved2;
+  uint32_t Reserved3;
+};
+
+static const unsigned long LNK_LOCATION_UNKNOWN = 0;
+static const unsigned long LNK_LOCATION_LOCAL = 1;
+static const unsigned long LNK_LOCATION_NETWORK = 2;
+//File Location Info 
+//This section is always present, but if bit 1 is not set in the flags value,
+//then the length of this section will be zero.
+//The header of this section is described below. 
+//1 dword This length value includes all the assorted pathnames and other data structures. All offsets are relative to the start of this section.  
+//1 dword The offset at which the basic file info structure ends. Should be 1C. 
+//1 dword File available on local volume (0) or network share(1) 
+//1 dword Offset to the local volume table. 
+//1 dword Offset to the base path on the local volume. 
+//1 dword Offset to the network volume table. 
+//1 dword Offset to the final part of the pathname. 
+struct LNK_FILE_LOCATION_INFO
+{
+  unsigned long length;
+  unsigned long endOffset;
+  unsigned long location;
+  unsigned long localVolumeTableOffset;
+  unsigned long basePathOffset;
+  unsigned long networkVolumeTableOffset;
+  unsigned long finalPathOffset;
+};
+static const unsigned long LNK_FILE_LOCATION_INFO_SIZE = sizeof(LNK_FILE_LOCATION_INFO);
+
+
+//Type of volumes
+//Code Description 
+//0 Unknown 
+//1 No root directory 
+//2 Removable (Floppy, Zip ...) 
+//3 Fixed (Hard disk) 
+//4 Remote (Network drive) 
+//5 CD-ROM 
+//6 Ram drive 
+//See LNK_VOLUME_TYPE_* constants in libLNK.h
+
+//The local volume table
+//1 dword Length of this structure including the volume label string. 
+//1 dword Type of volume (code below) 
+//1 dword Volume serial number 
+//1 dword Offset of the volume name (Always 0x10) 
+//ASCIZ Volume label 
+struct LNK_LOCAL_VOLUME_TABLE
+{
+  unsigned long length;
+  unsigned long volumeType;
+  unsigned long volumeSerialNumber;
+  unsigned long volumeNameOffset;
+  char volumeLabel;
+};
+static const unsigned long LNK_LOCAL_VOLUME_TABLE_SIZE = sizeof(LNK_LOCAL_VOLUME_TABLE);
+
+
+//The network volume table
+//1 dword Length of this structure 
+//1 dword Flags. 0x01 if deviceNameOffset is valid, 0x02 if networkProviderType is valid.
+//1 dword Offset of network share name (Always 0x14) 
+//1 dword Offset of the device name (ie "Z:") or 0 
+//1 dword Network provider type. Usually 0x20000 (WNNC_NET_LANMAN)
+//ASCIZ Network share name 
+static const unsigned long LNK_NETWORK_VALID_DEVICE   = 0x01;
+static const unsigned long LNK_NETWORK_VALID_NET_TYPE = 0x02;
+static const unsigned long LNK_NETWORK_PROVIDER_LANMAN = 0x00020000; //WNNC_NET_LANMAN
+struct LNK_NETWORK_VOLUME_TABLE
+{
+  unsigned long length;
+  unsigned long flags;
+  unsigned long networkShareNameOffset;
+  unsigned long deviceNameOffset;
+  unsigned long networkProviderType;
+  char networkShareName;
+};
+static const unsigned long LNK_NETWORK_VOLUME_TABLE_SIZE = sizeof(LNK_NETWORK_VOLUME_TABLE);
+
+//itemId structure used in LinkTargetIDList part of a link
+struct LNK_ITEMID
+{
+  uint16_t size;
+  uint8_t type;
+  uint8_t unknown1[5];
+  uint32_t unknown2;
+  uint16_t fileAttributes;
+  const char * name83;
+  unsigned char unknown07;          
+  unsigned char unknown08;          
+  unsigned char unknown09[7];       
+  unsigned char unknown10;          
+  unsigned char unknown11;          
+  unsigned char unknown12;          
+  unsigned char unknown13;          
+  unsigned char unknown14;          
+  unsigned char unknown15;          
+  unsigned char unknown16;          
+  unsigned char unknown17;          
+  unsigned char unknown18[4];       
+  const char * nameUnicode;
+  unsigned char unknown19;          
+  unsigned char unknown20;          
+};
+extern const LNK_ITEMID LNK_ITEMIDFolderDefault;
+extern const LNK_ITEMID LNK_ITEMIDFileDefault;
+
+#pragma pack(pop)
+
+inline uint16_t readUInt16(const unsigned char * iBuffer, unsigned long iOffset)
+{
+  uint16_t value = 0;
+  memcpy(&value, &iBuffer[iOffset], sizeof(value));
+  return value;
+}
+
+}; //lnk
@@ -0,0 +1,233 @@
+#include "LinkTemplate.h"
+#include "ItemID.h"
+#include "LinkFormat.h"
+#include "Tracing.h"
+#include <string.h> //for memcpy()
+
+#include "filesystemfunc.h"
+
+namespace lnk
+{
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// Defines, Pre-declarations & typedefs
+//----------------------------------------------------------------------------------------------------------------------------------------
+//implemented in libLNK.cpp
+void detectTarget(const LinkInfo & iLinkInfo, LNK_TARGET & oTarget);
+unsigned long getStringUnicodeSize(const std::string & iValue);
+void writeStringUnicode(const std::string & iValue, unsigned char *& ioOutput);
+
+inline void copyBytes(const unsigned char * iData, unsigned long iSize, unsigned char *& ioOutput)
+{
+  memcpy(ioOutput, iData, iSize);
+  ioOutput += iSize;
+}
+
+//Finds the last element of a path which must not end with a separator
+bool getLastPathElement(const std::string & iPath, filesystem::PathElement & oElement)
+{
+  filesystem::PathTokenizer tokenizer(iPath);
+  bool found = false;
+  filesystem::PathElement element;
+  while(tokenizer.next(element))
+  {
+    oElement = element;
+    found = true;
+  }
+  return found && oElement.value + oElement.length == iPath.c_str() + iPath.size();
+}
+
+//Size of a string in the StringData section, including its CountCharacters
+unsigned long getStringDataSize(const unsigned char * iString)
+{
+  return sizeof(uint16_t) + readUInt16(iString, 0)*sizeof(uint16_t);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// global functions
+//----------------------------------------------------------------------------------------------------------------------------------------
+LinkTemplate::LinkTemplate() :
+mHasIdList(false),
+mLastItemIdOffset(0),
+mLastItemIdSize(0),
+mLinkInfoOffset(0),
+mIsNetwork(false),
+mNameOffset(0),
+mNameLength(0),
+mArgumentsOffset(0),
+mArgumentsSize(0)
+{
+}
+
+bool LinkTemplate::compile(const LinkInfo & iLinkInfo, const LNK_TARGET & iTarget)
+{
+  LNK_TRACE_SCOPE("compileLinkTemplate");
+
+  if (!createLink(iLinkInfo, iTarget, mPrototype) || !findVariableFields(iLinkInfo, iTarget))
+  {
+    mPrototype.clear();
+    return false;
+  }
+  return true;
+}
+
+bool LinkTemplate::findVariableFields(const LinkInfo & iLinkInfo, const LNK_TARGET & iTarget)
+{
+  const unsigned char * prototype = mPrototype.getBuffer();
+  ShellLinkHeader header;
+  memcpy(&header, prototype, sizeof(header));
+  const LinkFlags & flags = header.linkFlags;
+
+  //the ItemID of the target is the last one of the LinkTargetIDList
+  unsigned long offset = sizeof(ShellLinkHeader);
+  mHasIdList = flags.HasLinkTargetIDList;
+  if (mHasIdList)
+  {
+    filesystem::PathElement shortName;
+    filesystem::PathElement longName;
+    if (!getLastPathElement(iTarget.shortPath, shortName) || !getLastPathElement(iLinkInfo.target, longName))
+      return false;
+    mFolder = iLinkInfo.target.substr(0, longName.value - iLinkInfo.target.c_str());
+    const unsigned long idListEnd = offset + sizeof(uint16_t) + readUInt16(prototype, offset);
+    mLastItemIdSize = getFileItemIdSize(shortName.length, longName.length);
+    mLastItemIdOffset = idListEnd - sizeof(uint16_t) - mLastItemIdSize; //before the TerminalID
+    if (readUInt16(prototype, mLastItemIdOffset) != mLastItemIdSize)
+      return false;
+    offset = idListEnd;
+  }
+
+  //the name of the target is the last element of the base path of a local target or of the final path of a network target
+  mLinkInfoOffset = offset;
+  LNK_FILE_LOCATION_INFO fileInfo;
+  memcpy(&fileInfo, prototype + mLinkInfoOffset, sizeof(fileInfo));
+  mIsNetwork = (fileInfo.location == LNK_LOCATION_NETWORK);
+  const unsigned long pathOffset = (mIsNetwork ? fileInfo.finalPathOffset : fileInfo.basePathOffset);
+  const std::string path = (const char *)(prototype + mLinkInfoOffset + pathOffset);
+  filesystem::PathElement name;
+  if (!getLastPathElement(path, name))
+    return false;
+  mNameOffset = mLinkInfoOffset + pathOffset + (unsigned long)(name.value - path.c_str());
+  mNameLength = (unsigned long)name.length;
+  offset += fileInfo.length;
+
+  //the arguments follow the description and the working directory
+  if (flags.HasName)
+    offset += getStringDataSize(prototype + offset);
+  if (flags.HasWorkingDir)
+    offset += getStringDataSize(prototype + offset);
+  mArgumentsOffset = offset;
+  mArgumentsSize = (flags.HasArguments ? getStringDataSize(prototype + offset) : 0);
+
+  return true;
+}
+
+bool LinkTemplate::compile(const LinkInfo & iLinkInfo)
+{
+  LNK_TARGET target;
+  detectTarget(iLinkInfo, target);
+  return compile(iLinkInfo, target);
+}
+
+bool LinkTemplate::isCompiled() const
+{
+  return mPrototype.getSize() > 0;
+}
+
+bool LinkTemplate::instantiate(const std::string & iArguments, MemoryBuffer & oBuffer) const
+{
+  return instantiate(iArguments, NULL, 0, NULL, 0, oBuffer);
+}
+
+bool LinkTemplate::instantiate(const std::string & iArguments, const std::string & iFileName, const std::string & iShortFileName, MemoryBuffer & oBuffer) const
+{
+  if (iFileName.empty() || iFileName.find_first_of("\\/") != std::string::npos)
+    return false;
+  if (!iShortFileName.empty())
+    return instantiate(iArguments, iFileName.c_str(), iFileName.size(), iShortFileName.c_str(), iShortFileName.size(), oBuffer);
+
+  //same estimation as getShortPathFormEstimation() for the first name of a folder
+  if (filesystem::isShortName(iFileName.c_str(), iFileName.size()))
+    return instantiate(iArguments, iFileName.c_str(), iFileName.size(), iFileName.c_str(), iFileName.size(), oBuffer);
+  const std::string shortFileName = filesystem::buildShortName(iFileName.c_str(), iFileName.size(), 1);
+  return instantiate(iArguments, iFileName.c_str(), iFileName.size(), shortFileName.c_str(), shortFileName.size(), oBuffer);
+}
+
+bool LinkTemplate::instantiate(const std::string & iArguments, const std::string & iFileName, filesystem::ShortNameGenerator & ioGenerator, MemoryBuffer & oBuffer) const
+{
+  if (iFileName.empty() || iFileName.find_first_of("\\/") != std::string::npos)
+    return false;
+  const std::string shortFileName = ioGenerator.getShortName(mFolder, iFileName);
+  return instantiate(iArguments, iFileName.c_str(), iFileName.size(), shortFileName.c_str(), shortFileName.size(), oBuffer);
+}
+
+bool LinkTemplate::instantiate(const std::string & iArguments, const char * iFileName, size_t iFileNameLength, const char * iShortFileName, size_t iShortFileNameLength, MemoryBuffer & oBuffer) const
+{
+  LNK_TRACE_SCOPE("instantiateLinkTemplate");
+
+  //the link must be readable with the default limits, like the links of createLink()
+  if (!isCompiled() || iArguments.size() > LNK_DEFAULT_PARSE_LIMITS.maxStringLength)
+    return false;
+  const unsigned char * prototype = mPrototype.getBuffer();
+  const unsigned long prototypeSize = mPrototype.getSize();
+
+  //compute the size of the link to allocate the buffer once
+  const bool rename = (iFileName != NULL);
+  const unsigned long nameLength = (rename ? (unsigned long)iFileNameLength : mNameLength);
+  const unsigned long itemIdSize = (!mHasIdList ? 0 : rename ? getFileItemIdSize(iShortFileNameLength, iFileNameLength) : mLastItemIdSize);
+  const unsigned long argumentsSize = (iArguments.empty() ? 0 : getStringUnicodeSize(iArguments));
+  const unsigned long idListSize = (!mHasIdList ? 0 : readUInt16(prototype, sizeof(ShellLinkHeader)) - mLastItemIdSize + itemIdSize);
+  const unsigned long size = prototypeSize - mLastItemIdSize + itemIdSize - mNameLength + nameLength - mArgumentsSize + argumentsSize;
+  if (!oBuffer.allocate(size))
+    return false;
+  unsigned char * output = oBuffer.getBuffer();
+
+  //header
+  ShellLinkHeader header;
+  memcpy(&header, prototype, sizeof(header));
+  header.linkFlags.HasArguments = !iArguments.empty();
+  copyBytes((const unsigned char *)&header, sizeof(header), output);
+
+  //LinkTargetIDList
+  if (mHasIdList)
+  {
+    const unsigned long itemIdsOffset = sizeof(ShellLinkHeader) + sizeof(uint16_t);
+    ItemIDListBuilder builder(output, sizeof(uint16_t) + idListSize);
+    builder.addItemIds(prototype + itemIdsOffset, mLastItemIdOffset - itemIdsOffset);
+    if (rename)
+      builder.addFileItemId(iShortFileName, iShortFileNameLength, iFileName, iFileNameLength, FA_NORMAL);
+    else
+      builder.addItemIds(prototype + mLastItemIdOffset, mLastItemIdSize);
+    const unsigned long written = builder.finish();
+    if (written == 0)
+      return false; //the file name does not fit in an ItemID
+    output += written;
+  }
+
+  //LinkInfo: the length and the offsets which follow the name are patched
+  LNK_FILE_LOCATION_INFO fileInfo;
+  memcpy(&fileInfo, prototype + mLinkInfoOffset, sizeof(fileInfo));
+  const unsigned long delta = nameLength - mNameLength;
+  fileInfo.length += delta;
+  if (!mIsNetwork)
+    fileInfo.finalPathOffset += delta;
+  copyBytes((const unsigned char *)&fileInfo, sizeof(fileInfo), output);
+  const unsigned long volumesOffset = mLinkInfoOffset + sizeof(fileInfo);
+  copyBytes(prototype + volumesOffset, mNameOffset - volumesOffset, output);
+  copyBytes((const unsigned char *)(rename ? iFileName : (const char *)prototype + mNameOffset), nameLength, output);
+
+  //end of the LinkInfo, description and working directory
+  const unsigned long nameEnd = mNameOffset + mNameLength;
+  copyBytes(prototype + nameEnd, mArgumentsOffset - nameEnd, output);
+
+  //arguments
+  if (!iArguments.empty())
+    writeStringUnicode(iArguments, output);
+
+  //icon location and the terminal block
+  const unsigned long argumentsEnd = mArgumentsOffset + mArgumentsSize;
+  copyBytes(prototype + argumentsEnd, prototypeSize - argumentsEnd, output);
+
+  return output == oBuffer.getBuffer() + size;
+}
+
+}; //lnk
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "libLNK.h"
+#include "MemoryBuffer.h"
+
+namespace filesystem
+{
+  class ShortNameGenerator;
+}; //filesystem
+
+namespace lnk
+{
+
+  ///<summary>
+  ///Creates many links which only differ by their arguments or by the name of their target.
+  ///A prototype link is serialized once by compile(). Each link is then created by copying the constant
+  ///sections of the prototype (header, ItemIDs of the folders, volume tables and strings) and by writing
+  ///the variable fields: the arguments, the last ItemID, the name in the LinkInfo and the sizes and offsets which follow them.
+  ///The links are byte for byte identical to the links created by createLink().
+  ///The file size and the attributes of the target are the ones of the prototype.
+  ///</summary>
+  class LinkTemplate
+  {
+  public:
+    LinkTemplate();
+
+    ///<summary>
+    ///Serializes the prototype of the links.
+    ///The target must end with a file or a folder name (ie not the root of a network share).
+    ///</summary>
+    ///<param name="iLinkInfo">The properties of the prototype.</param>
+    ///<param name="iTarget">The properties of the target of the prototype.</param>
+    ///<return>Returns true if the template is compiled. Returns false otherwise.<return>
+    bool compile(const LinkInfo & iLinkInfo, const LNK_TARGET & iTarget);
+    bool compile(const LinkInfo & iLinkInfo); //reads the properties of the target from the file system
+
+    bool isCompiled() const;
+
+    ///<summary>
+    ///Creates a link with the target of the prototype and new arguments.
+    ///</summary>
+    ///<param name="iArguments">The arguments of the link. An empty string creates a link without arguments.</param>
+    ///<param name="oBuffer">The content of the link file.</param>
+    ///<return>Returns true if the link is created. Returns false otherwise.<return>
+    bool instantiate(const std::string & iArguments, MemoryBuffer & oBuffer) const;
+
+    ///<summary>
+    ///Creates a link with new arguments to a file or a folder of the folder of the prototype's target.
+    ///</summary>
+    ///<param name="iArguments">The arguments of the link. An empty string creates a link without arguments.</param>
+    ///<param name="iFileName">The name of the target, replacing the last element of the prototype's target and network path.</param>
+    ///<param name="iShortFileName">The short name (8.3 format) of the target. An empty string estimates the short name.</param>
+    ///<param name="oBuffer">The content of the link file.</param>
+    ///<return>Returns true if the link is created. Returns false otherwise.<return>
+    bool instantiate(const std::string & iArguments, const std::string & iFileName, const std::string & iShortFileName, MemoryBuffer & oBuffer) const;
+
+    ///<summary>
+    ///Creates a link with new arguments to a file or a folder of the folder of the prototype's target.
+    ///The short name of the target is given by a generator which remembers the short names of the previous links:
+    ///names which collide get distinct short names, like Windows does when the targets are created in the same order.
+    ///</summary>
+    ///<param name="iArguments">The arguments of the link. An empty string creates a link without arguments.</param>
+    ///<param name="iFileName">The name of the target, replacing the last element of the prototype's target and network path.</param>
+    ///<param name="ioGenerator">The generator of the short names of the folder of the prototype's target.</param>
+    ///<param name="oBuffer">The content of the link file.</param>
+    ///<return>Returns true if the link is created. Returns false otherwise.<return>
+    bool instantiate(const std::string & iArguments, const std::string & iFileName, filesystem::ShortNameGenerator & ioGenerator, MemoryBuffer & oBuffer) const;
+
+  private:
+    bool findVariableFields(const LinkInfo & iLinkInfo, const LNK_TARGET & iTarget);
+    bool instantiate(const std::string & iArguments, const char * iFileName, size_t iFileNameLength, const char * iShortFileName, size_t iShortFileNameLength, MemoryBuffer & oBuffer) const;
+
+    MemoryBuffer mPrototype;          //the prototype serialized by createLink()
+    bool mHasIdList;
+    unsigned long mLastItemIdOffset;  //offset of the ItemID of the target
+    unsigned long mLastItemIdSize;
+    std::string mFolder;              //long path of the folder of the target
+    unsigned long mLinkInfoOffset;
+    bool mIsNetwork;                  //the name is in the final path of a network target, otherwise in the base path
+    unsigned long mNameOffset;        //offset of the name of the target in the LinkInfo
+    unsigned long mNameLength;
+    unsigned long mArgumentsOffset;   //offset of the arguments, or of the next string if the prototype has no arguments
+    unsigned long mArgumentsSize;
+  };
+
+}; //lnk
@@ -1,5 +1,6 @@
 #include "MemoryBuffer.h"
 #include "filesystemfunc.h"
+#include "Stats.h"
 
 namespace lnk
 {
@@ -11,20 +12,23 @@ namespace lnk
 
   MemoryBuffer::MemoryBuffer(void) : 
   mBuffer(NULL),
-  mSize(0)
+  mSize(0),
+  mCapacity(0)
   {
   }
 
   MemoryBuffer::MemoryBuffer(unsigned long iSize) : 
   mBuffer(NULL),
-  mSize(0)
+  mSize(0),
+  mCapacity(0)
   {
     allocate(iSize);
   }
 
   MemoryBuffer::MemoryBuffer(const MemoryBuffer & iValue) : 
   mBuffer(NULL),
-  mSize(0)
+  mSize(0),
+  mCapacity(0)
   {
     (*this) = iValue;
   }
@@ -46,6 +50,7 @@ namespace lnk
     }
     mBuffer = NULL;
     mSize = 0;
+    mCapacity = 0;
   }
 
   unsigned char * MemoryBuffer::getBuffer()
@@ -60,11 +65,20 @@ namespace lnk
 
   bool MemoryBuffer::allocate(unsigned long iSize)
   {
+    //reuse the current buffer if it is large enough
+    if (mBuffer && iSize <= mCapacity)
+    {
+      mSize = iSize;
+      return true;
+    }
+
     clear();
+    LNK_STATS_ADD(allocations, 1);
     mBuffer = new unsigned char[iSize];
     if (mBuffer)
     {
       mSize = iSize;
+      mCapacity = iSize;
       return true;
     }
     return false;
@@ -72,6 +86,14 @@ namespace lnk
 
   bool MemoryBuffer::reallocate(unsigned long iSize)
   {
+    //keep the current buffer if it is large enough
+    if (mBuffer && iSize <= mCapacity)
+    {
+      mSize = iSize;
+      return true;
+    }
+
+    LNK_STATS_ADD(allocations, 1);
     unsigned char * newBuffer = new unsigned char[iSize];
     if (newBuffer)
     {
@@ -85,6 +107,7 @@ namespace lnk
       clear();
       mBuffer = newBuffer;
       mSize = iSize;
+      mCapacity = iSize;
       return true;
     }
     return false;
@@ -97,15 +120,15 @@ namespace lnk
 
   bool MemoryBuffer::loadFile(const char * iFilePath)
   {
-    //get size of file
-    unsigned long size = filesystem::getFileSize(iFilePath);
-
     FILE * f = fopen(iFilePath, "rb");
     if (f)
     {
+      //get size of the opened file
+      unsigned long size = filesystem::getFileSize(f);
       if (allocate(size))
       {
         fread(mBuffer, 1, size, f);
+        LNK_STATS_ADD(bytesRead, size);
 
         fclose(f);
         return true;
@@ -117,7 +140,7 @@ namespace lnk
 
   const MemoryBuffer & MemoryBuffer::operator = (const MemoryBuffer & iValue)
   {
-    if (allocate(iValue.mSize))
+    if (this != &iValue && allocate(iValue.mSize))
       memcpy(mBuffer, iValue.mBuffer, mSize);
     return (*this);
   }
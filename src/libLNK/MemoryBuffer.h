@@ -14,11 +14,11 @@ public:
   //----------------
   // public methods
   //----------------
-  void clear();
+  void clear();   //releases the memory
   unsigned char * getBuffer();
   const unsigned char * getBuffer() const;
-  bool allocate(unsigned long iSize);
-  bool reallocate(unsigned long iSize);
+  bool allocate(unsigned long iSize); //content is undefined. The memory is reused if the buffer was larger.
+  bool reallocate(unsigned long iSize); //content is kept. The memory is reused if the buffer was larger.
   unsigned long getSize() const;
   bool loadFile(const char * iFilePath);
 
@@ -27,6 +27,7 @@ public:
 private:
   unsigned char* mBuffer;
   unsigned long mSize;
+  unsigned long mCapacity;
 };
 
 template <typename T>
@@ -0,0 +1,85 @@
+#pragma once
+
+#ifdef WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h> //for CRITICAL_SECTION
+#else
+#include <pthread.h>
+#endif
+
+namespace lnk
+{
+
+  ///<summary>
+  ///A non recursive mutex for the internal state shared by all threads.
+  ///</summary>
+  class Mutex
+  {
+  public:
+    Mutex()
+    {
+#ifdef WIN32
+      InitializeCriticalSection(&mLock);
+#else
+      pthread_mutex_init(&mLock, NULL);
+#endif
+    }
+
+    ~Mutex()
+    {
+#ifdef WIN32
+      DeleteCriticalSection(&mLock);
+#else
+      pthread_mutex_destroy(&mLock);
+#endif
+    }
+
+    void lock()
+    {
+#ifdef WIN32
+      EnterCriticalSection(&mLock);
+#else
+      pthread_mutex_lock(&mLock);
+#endif
+    }
+
+    void unlock()
+    {
+#ifdef WIN32
+      LeaveCriticalSection(&mLock);
+#else
+      pthread_mutex_unlock(&mLock);
+#endif
+    }
+
+  private:
+    //non copyable
+    Mutex(const Mutex &);
+    Mutex & operator = (const Mutex &);
+
+#ifdef WIN32
+    CRITICAL_SECTION mLock;
+#else
+    pthread_mutex_t mLock;
+#endif
+  };
+
+  ///<summary>
+  ///Locks a mutex for the lifetime of the object.
+  ///</summary>
+  class ScopedLock
+  {
+  public:
+    ScopedLock(Mutex & iMutex) : mMutex(iMutex) { mMutex.lock(); }
+    ~ScopedLock() { mMutex.unlock(); }
+
+  private:
+    ScopedLock(const ScopedLock &);
+    ScopedLock & operator = (const ScopedLock &);
+
+    Mutex & mMutex;
+  };
+
+}; //lnk
@@ -0,0 +1,74 @@
+#include "Reader.h"
+#include <string.h> //for memcpy()
+
+namespace lnk
+{
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// Defines, Pre-declarations & typedefs
+//----------------------------------------------------------------------------------------------------------------------------------------
+static const unsigned long SKIP_CHUNK_SIZE = 4096;
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// global functions
+//----------------------------------------------------------------------------------------------------------------------------------------
+bool Reader::skip(unsigned long iSize, unsigned long & oSkipped)
+{
+  unsigned char chunk[SKIP_CHUNK_SIZE];
+  oSkipped = 0;
+  while(oSkipped < iSize)
+  {
+    const unsigned long size = (iSize - oSkipped < SKIP_CHUNK_SIZE ? iSize - oSkipped : SKIP_CHUNK_SIZE);
+    unsigned long read = 0;
+    if (!this->read(chunk, size, read))
+      return false;
+    oSkipped += read;
+    if (read < size)
+      break; //end of the stream
+  }
+  return true;
+}
+
+FileReader::FileReader(FILE * iFile) :
+mFile(iFile)
+{
+}
+
+bool FileReader::read(void * oBuffer, unsigned long iSize, unsigned long & oRead)
+{
+  oRead = 0;
+  if (mFile == NULL)
+    return false;
+  oRead = (unsigned long)fread(oBuffer, 1, iSize, mFile);
+  return (oRead == iSize || !ferror(mFile));
+}
+
+MemoryReader::MemoryReader(const unsigned char * iBuffer, unsigned long iSize) :
+mBuffer(iBuffer),
+mSize(iSize),
+mOffset(0)
+{
+}
+
+bool MemoryReader::read(void * oBuffer, unsigned long iSize, unsigned long & oRead)
+{
+  oRead = (iSize < mSize - mOffset ? iSize : mSize - mOffset);
+  if (oRead > 0)
+    memcpy(oBuffer, mBuffer + mOffset, oRead);
+  mOffset += oRead;
+  return true;
+}
+
+bool MemoryReader::skip(unsigned long iSize, unsigned long & oSkipped)
+{
+  oSkipped = (iSize < mSize - mOffset ? iSize : mSize - mOffset);
+  mOffset += oSkipped;
+  return true;
+}
+
+unsigned long MemoryReader::getOffset() const
+{
+  return mOffset;
+}
+
+}; //lnk
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdio.h>
+
+namespace lnk
+{
+
+  ///<summary>
+  ///A forward-only source of bytes: a file, a pipe, a socket or a decompressor.
+  ///The stream is never rewound: getLinkInfo(Reader &...) reads a link once, from its first to its last byte.
+  ///</summary>
+  class Reader
+  {
+  public:
+    virtual ~Reader() {}
+
+    ///<summary>
+    ///Reads the next bytes of the stream. Blocks until iSize bytes are read or the stream ends.
+    ///</summary>
+    ///<param name="oBuffer">The buffer which receives the bytes.</param>
+    ///<param name="iSize">The number of bytes to read.</param>
+    ///<param name="oRead">The number of bytes read. Smaller than iSize only at the end of the stream.</param>
+    ///<return>Returns false if the stream cannot be read. Returns true otherwise.<return>
+    virtual bool read(void * oBuffer, unsigned long iSize, unsigned long & oRead) = 0;
+
+    ///<summary>
+    ///Moves past the next bytes of the stream.
+    ///The default implementation reads and drops the bytes.
+    ///</summary>
+    ///<param name="iSize">The number of bytes to skip.</param>
+    ///<param name="oSkipped">The number of bytes skipped. Smaller than iSize only at the end of the stream.</param>
+    ///<return>Returns false if the stream cannot be read. Returns true otherwise.<return>
+    virtual bool skip(unsigned long iSize, unsigned long & oSkipped);
+  };
+
+  ///<summary>
+  ///Reads a stream opened by the caller (ie stdin or popen()). The stream is not closed.
+  ///Note: on Windows, stdin must be switched to binary mode with _setmode() first.
+  ///</summary>
+  class FileReader : public Reader
+  {
+  public:
+    FileReader(FILE * iFile);
+
+    virtual bool read(void * oBuffer, unsigned long iSize, unsigned long & oRead);
+
+  private:
+    FILE * mFile;
+  };
+
+  ///<summary>
+  ///Reads a buffer of memory. The buffer is not copied and must stay valid while it is read.
+  ///</summary>
+  class MemoryReader : public Reader
+  {
+  public:
+    MemoryReader(const unsigned char * iBuffer, unsigned long iSize);
+
+    virtual bool read(void * oBuffer, unsigned long iSize, unsigned long & oRead);
+    virtual bool skip(unsigned long iSize, unsigned long & oSkipped);
+
+    unsigned long getOffset() const;
+
+  private:
+    const unsigned char * mBuffer;
+    unsigned long mSize;
+    unsigned long mOffset;
+  };
+
+}; //lnk
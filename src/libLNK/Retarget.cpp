@@ -0,0 +1,301 @@
+#include "Retarget.h"
+#include "Threads.h"
+#include "Tracing.h"
+#include "MemoryBuffer.h"
+#include "StageTimer.h"
+#include <algorithm>
+#include <ctype.h> //for toupper()
+
+#include "filesystemfunc.h"
+#include "stringfunc.h"
+
+namespace lnk
+{
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// Defines, Pre-declarations & typedefs
+//----------------------------------------------------------------------------------------------------------------------------------------
+const RetargetOptions LNK_DEFAULT_RETARGET_OPTIONS = {
+  4,     //numThreads
+  false, //dryRun
+};
+
+//implemented in libLNK.cpp
+bool loadLinkFile(const char * iFilePath, const ParseLimits & iLimits, MemoryBuffer & oFileContent, LNK_PARSE_ERROR & oError, StageTimer * ioTimer);
+
+//State shared by the threads of a rewrite. Each link is handled by a single thread.
+struct RETARGET_CONTEXT
+{
+  const std::vector<std::string> * files;
+  const RetargetRules * rules;
+  const RetargetOptions * options;
+  volatile long next;                   //next link to process, incremented by all threads
+  std::vector<RetargetChange> results;  //result of each link
+};
+
+inline bool isSeparator(char c)
+{
+  return c == '\\' || c == '/';
+}
+
+//Character of a path as stored in the trie
+inline char normalize(char c)
+{
+  return (isSeparator(c) ? '\\' : (char)toupper((unsigned char)c));
+}
+
+//Removes the separators at the end of a prefix
+std::string trimSeparators(const std::string & iPrefix)
+{
+  size_t length = iPrefix.size();
+  while(length > 0 && isSeparator(iPrefix[length-1]))
+    length--;
+  return iPrefix.substr(0, length);
+}
+
+//Drive (ie "C:\...") or UNC (ie "\\server\...") path
+inline bool isAbsolutePath(const std::string & iPath)
+{
+  return iPath.size() >= 2 && (iPath[1] == ':' || (isSeparator(iPath[0]) && isSeparator(iPath[1])));
+}
+
+//Rewrites a field of a link and adds it to the changes
+void rewriteField(const RetargetRules & iRules, LNK_LINK_FIELD iField, const std::string & iValue, std::string & oValue, LinkChanges & ioChanges, RetargetChange & ioResult)
+{
+  if (!iRules.rewrite(iValue, oValue) || oValue == iValue)
+    return;
+  ioChanges.fields |= iField;
+  RetargetValue value;
+  value.field = iField;
+  value.oldValue = iValue;
+  value.newValue = oValue;
+  ioResult.values.push_back(value);
+}
+
+void runRetargetThread(void * iContext)
+{
+  RETARGET_CONTEXT & context = *(RETARGET_CONTEXT *)iContext;
+  const std::vector<std::string> & files = *context.files;
+  const RetargetRules & rules = *context.rules;
+
+  //reused for all links of the thread
+  MemoryBuffer content;
+  LinkInfoEx info;
+  LinkChanges changes;
+
+  for(size_t i = (size_t)atomicIncrement(context.next) - 1; i < files.size(); i = (size_t)atomicIncrement(context.next) - 1)
+  {
+    RetargetChange & result = context.results[i];
+    result.success = false;
+
+    //the size of the file is checked before it is loaded
+    LNK_PARSE_ERROR error = LNK_PARSE_OK;
+    if (!loadLinkFile(files[i].c_str(), LNK_DEFAULT_PARSE_LIMITS, content, error, NULL) ||
+        !getLinkInfo(content.getBuffer(), content.getSize(), info, LNK_DEFAULT_PARSE_LIMITS, error))
+      continue;
+
+    changes.fields = 0;
+    changes.values = info;
+    changes.relativePath = info.relativePath;
+    changes.shortPath = "";
+    if (isAbsolutePath(info.target))
+      rewriteField(rules, LNK_FIELD_TARGET, info.target, changes.values.target, changes, result);
+    if (info.hasNetworkShare)
+      rewriteField(rules, LNK_FIELD_NETWORK_PATH, info.networkPath, changes.values.networkPath, changes, result);
+    rewriteField(rules, LNK_FIELD_RELATIVE_PATH, info.relativePath, changes.relativePath, changes, result);
+    rewriteField(rules, LNK_FIELD_WORKING_DIRECTORY, info.workingDirectory, changes.values.workingDirectory, changes, result);
+    rewriteField(rules, LNK_FIELD_ICON, info.customIcon.filename, changes.values.customIcon.filename, changes, result);
+    if (changes.fields == 0)
+    {
+      result.success = true; //not changed
+      continue;
+    }
+
+    unsigned long firstChange = 0;
+    result.success = patchLink(content, changes, firstChange) &&
+                     (context.options->dryRun || filesystem::writeFile(files[i].c_str(), content.getBuffer(), content.getSize(), true));
+  }
+}
+
+//Quotes a value of a CSV file
+std::string toCsvValue(const std::string & iValue)
+{
+  std::string value = "\"";
+  for(size_t i=0; i<iValue.size(); i++)
+  {
+    if (iValue[i] == '"')
+      value += '"';
+    value += iValue[i];
+  }
+  value += '"';
+  return value;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// global functions
+//----------------------------------------------------------------------------------------------------------------------------------------
+RetargetRules::RetargetRules()
+{
+  NODE root = {'\0', 0, 0, -1};
+  mNodes.push_back(root);
+}
+
+unsigned long RetargetRules::findChild(unsigned long iNode, char iCharacter) const
+{
+  for(unsigned long child = mNodes[iNode].firstChild; child != 0; child = mNodes[child].nextSibling)
+  {
+    if (mNodes[child].character == iCharacter)
+      return child;
+  }
+  return 0;
+}
+
+bool RetargetRules::addRule(const std::string & iOldPrefix, const std::string & iNewPrefix)
+{
+  const std::string oldPrefix = trimSeparators(iOldPrefix);
+  if (oldPrefix.empty())
+    return false;
+
+  unsigned long node = 0;
+  for(size_t i=0; i<oldPrefix.size(); i++)
+  {
+    char c = normalize(oldPrefix[i]);
+    unsigned long child = findChild(node, c);
+    if (child == 0)
+    {
+      NODE added = {c, 0, mNodes[node].firstChild, -1};
+      child = (unsigned long)mNodes.size();
+      mNodes.push_back(added);
+      mNodes[node].firstChild = child;
+    }
+    node = child;
+  }
+  if (mNodes[node].rule != -1)
+    return false;
+
+  mNodes[node].rule = (long)mNewPrefixes.size();
+  mNewPrefixes.push_back(trimSeparators(iNewPrefix));
+  return true;
+}
+
+bool RetargetRules::rewrite(const std::string & iPath, std::string & oPath) const
+{
+  //find the longest prefix which ends at the end of a path element
+  long rule = -1;
+  size_t length = 0;
+  unsigned long node = 0;
+  for(size_t i=0; i<iPath.size(); i++)
+  {
+    node = findChild(node, normalize(iPath[i]));
+    if (node == 0)
+      break;
+    if (mNodes[node].rule != -1 && (i+1 == iPath.size() || isSeparator(iPath[i+1])))
+    {
+      rule = mNodes[node].rule;
+      length = i+1;
+    }
+  }
+  if (rule == -1)
+    return false;
+
+  oPath = mNewPrefixes[rule] + iPath.substr(length);
+  return true;
+}
+
+size_t RetargetRules::count() const
+{
+  return mNewPrefixes.size();
+}
+
+bool retargetLinks(const std::vector<std::string> & iFiles, const RetargetRules & iRules, const RetargetOptions & iOptions, RetargetReport & oReport)
+{
+  LNK_TRACE_SCOPE("retargetLinks");
+
+  oReport.numLinks = (unsigned long)iFiles.size();
+  oReport.numChanged = 0;
+  oReport.numFailed = 0;
+  oReport.changes.clear();
+
+  RETARGET_CONTEXT context;
+  context.files = &iFiles;
+  context.rules = &iRules;
+  context.options = &iOptions;
+  context.next = 0;
+  context.results.resize(iFiles.size());
+
+  unsigned long numThreads = (iOptions.numThreads > 0 ? iOptions.numThreads : 1);
+  if (numThreads > iFiles.size())
+    numThreads = (iFiles.empty() ? 1 : (unsigned long)iFiles.size());
+  runThreads(&runRetargetThread, &context, numThreads);
+
+  //keep the changed and the failed links
+  for(size_t i=0; i<iFiles.size(); i++)
+  {
+    RetargetChange & result = context.results[i];
+    if (result.success && result.values.empty())
+      continue;
+    if (result.success)
+      oReport.numChanged++;
+    else
+      oReport.numFailed++;
+    result.path = iFiles[i];
+    oReport.changes.push_back(RetargetChange());
+    std::swap(oReport.changes.back(), result);
+  }
+
+  return oReport.numFailed == 0;
+}
+
+bool retargetFolder(const char * iFolder, bool iRecursive, const RetargetRules & iRules, const RetargetOptions & iOptions, RetargetReport & oReport)
+{
+  std::vector<std::string> files;
+  if (!filesystem::findFiles(iFolder, iRecursive, files))
+    return false;
+
+  //only rewrite links
+  std::vector<std::string> links;
+  links.reserve(files.size());
+  for(size_t i=0; i<files.size(); i++)
+  {
+    if (stringfunc::lowercase(filesystem::getFileExtention(files[i])) == "lnk")
+      links.push_back(files[i]);
+  }
+
+  std::sort(links.begin(), links.end());
+  return retargetLinks(links, iRules, iOptions, oReport);
+}
+
+bool saveRetargetReport(const RetargetReport & iReport, const char * iFilePath)
+{
+  std::string csv = "path,field,old value,new value,status\n";
+  for(size_t i=0; i<iReport.changes.size(); i++)
+  {
+    const RetargetChange & change = iReport.changes[i];
+    const char * status = (change.success ? "ok" : "failed");
+    if (change.values.empty())
+      csv += toCsvValue(change.path) + ",,,," + status + "\n";
+    for(size_t j=0; j<change.values.size(); j++)
+    {
+      const RetargetValue & value = change.values[j];
+      csv += toCsvValue(change.path) + "," + getLinkFieldName(value.field) + "," + toCsvValue(value.oldValue) + "," + toCsvValue(value.newValue) + "," + status + "\n";
+    }
+  }
+  return filesystem::writeFile(iFilePath, csv.c_str(), csv.size(), false);
+}
+
+const char * getLinkFieldName(const LNK_LINK_FIELD & iField)
+{
+  switch(iField)
+  {
+  case LNK_FIELD_TARGET:            return "target";
+  case LNK_FIELD_ARGUMENTS:         return "arguments";
+  case LNK_FIELD_WORKING_DIRECTORY: return "workingDirectory";
+  case LNK_FIELD_DESCRIPTION:       return "description";
+  case LNK_FIELD_ICON:              return "icon";
+  case LNK_FIELD_NETWORK_PATH:      return "networkPath";
+  case LNK_FIELD_RELATIVE_PATH:     return "relativePath";
+  default:                          return "unknown";
+  };
+}
+
+}; //lnk
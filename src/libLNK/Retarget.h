@@ -0,0 +1,111 @@
+#pragma once
+
+#include "libLNK.h"
+
+namespace lnk
+{
+
+  ///<summary>
+  ///A set of rules which replace the beginning of paths, stored in a trie of the characters of the old prefixes.
+  ///Paths are compared like Windows does: the case of the letters is ignored and '/' matches '\'.
+  ///A prefix only matches whole path elements: "\\server\share" matches "\\SERVER\Share\file.txt" but not "\\server\shared".
+  ///When many prefixes match a path, the longest one is used.
+  ///</summary>
+  class RetargetRules
+  {
+  public:
+    RetargetRules();
+
+    ///<summary>
+    ///Adds a rule. The prefixes may be drive paths (ie "Z:\Projects") or UNC paths (ie "\\server\share").
+    ///</summary>
+    ///<param name="iOldPrefix">The beginning of the paths to replace.</param>
+    ///<param name="iNewPrefix">The replacement of the old prefix.</param>
+    ///<return>Returns true if the rule is added. Returns false if the old prefix is empty or already has a rule.<return>
+    bool addRule(const std::string & iOldPrefix, const std::string & iNewPrefix);
+
+    ///<summary>
+    ///Replaces the beginning of a path by the new prefix of the longest matching rule.
+    ///</summary>
+    ///<param name="iPath">The path to rewrite.</param>
+    ///<param name="oPath">The rewritten path. Unchanged if no rule matches.</param>
+    ///<return>Returns true if a rule matches the path. Returns false otherwise.<return>
+    bool rewrite(const std::string & iPath, std::string & oPath) const;
+
+    size_t count() const;
+
+  private:
+    struct NODE
+    {
+      char character;           //uppercase character of the prefixes, '\' for all separators
+      unsigned long firstChild; //0 if the node has no children
+      unsigned long nextSibling;//0 if the node is the last child of its parent
+      long rule;                //index of the rule ending at this node, -1 if none
+    };
+    unsigned long findChild(unsigned long iNode, char iCharacter) const;
+
+    std::vector<NODE> mNodes;             //the root is the first node
+    std::vector<std::string> mNewPrefixes;
+  };
+
+  //Options of retargetLinks()
+  struct RetargetOptions
+  {
+    unsigned long numThreads;   //number of threads patching the links, including the calling thread
+    bool dryRun;                //report the changes without modifying the links
+  };
+  extern const RetargetOptions LNK_DEFAULT_RETARGET_OPTIONS;
+
+  //A field of a link rewritten by retargetLinks()
+  struct RetargetValue
+  {
+    LNK_LINK_FIELD field;
+    std::string oldValue;
+    std::string newValue;
+  };
+
+  //A link which matches the rules of retargetLinks()
+  struct RetargetChange
+  {
+    std::string path;                   //path of the link
+    std::vector<RetargetValue> values;  //fields rewritten. Empty if the link cannot be read.
+    bool success;                       //false if the link cannot be read or patched
+  };
+
+  //Result of retargetLinks()
+  struct RetargetReport
+  {
+    unsigned long numLinks;             //links read
+    unsigned long numChanged;           //links patched, or which would be patched in dry run mode
+    unsigned long numFailed;            //links which cannot be read or patched
+    std::vector<RetargetChange> changes;//changed and failed links, in the order of the files
+  };
+
+  ///<summary>
+  ///Rewrites the paths of many links with a set of rules.
+  ///The target (LinkTargetIDList and base path), the network path (network volume table), the relative path,
+  ///the working directory and the icon location of each link are rewritten with patchLink(): all other bytes are kept.
+  ///The links are read and patched by a pool of threads. Each patched link replaces its file atomically.
+  ///</summary>
+  ///<param name="iFiles">The links to rewrite.</param>
+  ///<param name="iRules">The rules to apply.</param>
+  ///<param name="iOptions">The options of the rewrite.</param>
+  ///<param name="oReport">The links changed and the links which failed.</param>
+  ///<return>Returns true if no link failed. Returns false otherwise.<return>
+  bool retargetLinks(const std::vector<std::string> & iFiles, const RetargetRules & iRules, const RetargetOptions & iOptions, RetargetReport & oReport);
+
+  ///<summary>
+  ///Same as retargetLinks() for all links (*.lnk) of a folder.
+  ///</summary>
+  bool retargetFolder(const char * iFolder, bool iRecursive, const RetargetRules & iRules, const RetargetOptions & iOptions, RetargetReport & oReport);
+
+  ///<summary>
+  ///Saves the changes of a report to a CSV file with one line per rewritten field:
+  ///path, field, old value, new value and status ("ok" or "failed").
+  ///</summary>
+  ///<return>Returns true if the file is written. Returns false otherwise.<return>
+  bool saveRetargetReport(const RetargetReport & iReport, const char * iFilePath);
+
+  const char * getLinkFieldName(const LNK_LINK_FIELD & iField);
+
+}; //lnk
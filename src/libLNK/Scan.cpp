@@ -0,0 +1,182 @@
+#include "Scan.h"
+#include "StageTimer.h"
+#include "MemoryBuffer.h"
+#include "Archive.h"
+#include <algorithm>
+
+#include "filesystemfunc.h"
+#include "stringfunc.h"
+
+namespace lnk
+{
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// Defines, Pre-declarations & typedefs
+//----------------------------------------------------------------------------------------------------------------------------------------
+const ScanOptions LNK_DEFAULT_SCAN_OPTIONS = {
+  { 0x100000, 256, 0x7FFF, 64 }, //limits, same as LNK_DEFAULT_PARSE_LIMITS
+  10,                            //numSlowest
+};
+
+//Orders the slowest files first
+inline bool isSlower(const SlowFile & iFirst, const SlowFile & iSecond)
+{
+  return iFirst.total > iSecond.total;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+// global functions
+//----------------------------------------------------------------------------------------------------------------------------------------
+const char * getStageName(const LNK_STAGE & iStage)
+{
+  switch(iStage)
+  {
+  case LNK_STAGE_OPEN:      return "open";
+  case LNK_STAGE_READ:      return "read";
+  case LNK_STAGE_HEADER:    return "header";
+  case LNK_STAGE_IDLIST:    return "idlist";
+  case LNK_STAGE_LINKINFO:  return "linkinfo";
+  case LNK_STAGE_STRINGS:   return "strings";
+  case LNK_STAGE_EXTRADATA: return "extradata";
+  default:                  return "unknown";
+  };
+}
+
+///<summary>
+///Keeps a file in the list of the slowest files if it is slower than the fastest file of the list.
+///The list is a heap with the fastest file on top so that a file is inserted in O(log N).
+///</summary>
+void addSlowFile(const char * iFilePath, const StageTimer & iTimer, uint64_t iTotal, unsigned long iMaxFiles, std::vector<SlowFile> & ioHeap)
+{
+  if (iMaxFiles == 0)
+    return;
+  if (ioHeap.size() == iMaxFiles)
+  {
+    if (iTotal <= ioHeap.front().total)
+      return; //faster than all kept files
+    std::pop_heap(ioHeap.begin(), ioHeap.end(), isSlower);
+    ioHeap.pop_back();
+  }
+
+  SlowFile file;
+  file.path = iFilePath;
+  file.total = iTotal;
+  for(int i=0; i<LNK_STAGE_COUNT; i++)
+    file.stages[i] = iTimer.getDuration((LNK_STAGE)i);
+  ioHeap.push_back(file);
+  std::push_heap(ioHeap.begin(), ioHeap.end(), isSlower);
+}
+
+//Clears a report before a scan.
+void startReport(const ScanOptions & iOptions, ScanReport & oReport)
+{
+  oReport.numFiles = 0;
+  oReport.numRejected = 0;
+  oReport.total.clear();
+  for(int i=0; i<LNK_STAGE_COUNT; i++)
+    oReport.stages[i].clear();
+  oReport.slowest.clear();
+  oReport.slowest.reserve(iOptions.numSlowest);
+}
+
+//Records the latencies of a parsed file in a report.
+void recordFile(const char * iFilePath, bool iSuccess, StageTimer & ioTimer, const ScanOptions & iOptions, ScanReport & ioReport)
+{
+  uint64_t total = ioTimer.finish();
+
+  ioReport.numFiles++;
+  if (!iSuccess)
+    ioReport.numRejected++;
+  ioReport.total.record(total);
+  for(int j=0; j<LNK_STAGE_COUNT; j++)
+  {
+    if (ioTimer.isReached((LNK_STAGE)j))
+      ioReport.stages[j].record(ioTimer.getDuration((LNK_STAGE)j));
+  }
+  addSlowFile(iFilePath, ioTimer, total, iOptions.numSlowest, ioReport.slowest);
+}
+
+bool scanFiles(const std::vector<std::string> & iFiles, const ScanOptions & iOptions, ScanCallback iCallback, void * iUserData, ScanReport & oReport)
+{
+  LNK_TRACE_SCOPE("scanFiles");
+
+  startReport(iOptions, oReport);
+
+  //reused for all files to stop allocating memory once the largest file is parsed
+  LinkInfoEx info;
+  MemoryBuffer fileContent;
+
+  bool completed = true;
+  for(size_t i=0; i<iFiles.size() && completed; i++)
+  {
+    const char * path = iFiles[i].c_str();
+
+    LNK_PARSE_ERROR error = LNK_PARSE_OK;
+    StageTimer timer;
+    bool success = getLinkInfo(path, info, iOptions.limits, error, timer, fileContent);
+    recordFile(path, success, timer, iOptions, oReport);
+
+    if (iCallback)
+      completed = iCallback(path, info, error, iUserData);
+  }
+
+  std::sort(oReport.slowest.begin(), oReport.slowest.end(), isSlower);
+  return completed;
+}
+
+bool scanFolder(const char * iFolder, bool iRecursive, const ScanOptions & iOptions, ScanCallback iCallback, void * iUserData, ScanReport & oReport)
+{
+  std::vector<std::string> files;
+  if (!filesystem::findFiles(iFolder, iRecursive, files))
+    return false;
+
+  //only scan links
+  std::vector<std::string> links;
+  links.reserve(files.size());
+  for(size_t i=0; i<files.size(); i++)
+  {
+    if (stringfunc::lowercase(filesystem::getFileExtention(files[i])) == "lnk")
+      links.push_back(files[i]);
+  }
+
+  std::sort(links.begin(), links.end());
+  return scanFiles(links, iOptions, iCallback, iUserData, oReport);
+}
+
+bool scanArchive(const char * iArchivePath, const ScanOptions & iOptions, ScanCallback iCallback, void * iUserData, ScanReport & oReport)
+{
+  LNK_TRACE_SCOPE("scanArchive");
+
+  startReport(iOptions, oReport);
+
+  Archive archive;
+  if (!archive.open(iArchivePath))
+    return false;
+
+  //reused for all members like scanFiles() does
+  LinkInfoEx info;
+  std::string path;
+  const std::string archivePath = std::string(iArchivePath) + filesystem::getPathSeparator();
+
+  bool completed = true;
+  const std::vector<ArchiveMember> & members = archive.getMembers();
+  for(size_t i=0; i<members.size() && completed; i++)
+  {
+    LNK_PARSE_ERROR error = LNK_PARSE_OK;
+    StageTimer timer;
+    bool success = archive.getLinkInfo(i, info, iOptions.limits, error, &timer);
+    if (error == LNK_PARSE_ERROR_SIGNATURE)
+      continue; //not a link
+
+    path = archivePath + members[i].name;
+    recordFile(path.c_str(), success, timer, iOptions, oReport);
+
+    if (iCallback)
+      completed = iCallback(path.c_str(), info, error, iUserData);
+  }
+
+  std::sort(oReport.slowest.begin(), oReport.slowest.end(), isSlower);
+  return completed;
+}
+
+}; //lnk
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "libLNK.h"
+#include "LatencyHistogram.h"
+
+namespace lnk
+{
+
+//Stages of the parsing of a link file
+enum LNK_STAGE
+{
+  LNK_STAGE_OPEN = 0,   //opening the file
+  LNK_STAGE_READ,       //reading the file in memory
+  LNK_STAGE_HEADER,     //signature and ShellLinkHeader
+  LNK_STAGE_IDLIST,     //LinkTargetIDList
+  LNK_STAGE_LINKINFO,   //LinkInfo (file location info)
+  LNK_STAGE_STRINGS,    //StringData: description, relative path, working directory, arguments and icon location
+  LNK_STAGE_EXTRADATA,  //ExtraData blocks
+  LNK_STAGE_COUNT,
+};
+
+//Options of scanFiles(), scanFolder() and scanArchive()
+struct ScanOptions
+{
+  ParseLimits limits;         //limits of the parsing of each file
+  unsigned long numSlowest;   //number of files kept in ScanReport::slowest
+};
+extern const ScanOptions LNK_DEFAULT_SCAN_OPTIONS;
+
+//A file of the slowest files of a scan
+struct SlowFile
+{
+  std::string path;
+  uint64_t total;                     //in nanoseconds
+  uint64_t stages[LNK_STAGE_COUNT];   //in nanoseconds, index is a LNK_STAGE
+};
+
+//Latencies of a scan. All durations are in nanoseconds.
+struct ScanReport
+{
+  unsigned long numFiles;     //files scanned
+  unsigned long numRejected;  //files which are not valid links or cannot be read
+  LatencyHistogram total;     //duration of each file
+  LatencyHistogram stages[LNK_STAGE_COUNT];   //duration of each stage, index is a LNK_STAGE. Stages not reached by a file are not recorded.
+  std::vector<SlowFile> slowest;  //slowest files, the slowest first
+};
+
+///<summary>
+///Called by scanFiles(), scanFolder() and scanArchive() after each file is parsed.
+///</summary>
+///<param name="iFilePath">The path of the file.</param>
+///<param name="iLinkInfo">The content of the link. Only valid if iError is LNK_PARSE_OK.</param>
+///<param name="iError">The reason why the file is rejected or LNK_PARSE_OK.</param>
+///<param name="iUserData">The user data given to the scan.</param>
+///<return>Returns true to continue the scan. Returns false to stop the scan.<return>
+typedef bool (*ScanCallback)(const char * iFilePath, const LinkInfoEx & iLinkInfo, const LNK_PARSE_ERROR & iError, void * iUserData);
+
+const char * getStageName(const LNK_STAGE & iStage);
+
+///<summary>
+///Parses a list of files and measures the latency of each stage of the parsing.
+///</summary>
+///<param name="iFiles">The paths of the files to parse.</param>
+///<param name="iOptions">The options of the scan.</param>
+///<param name="iCallback">The function called after each file. Can be NULL.</param>
+///<param name="iUserData">The user data given to iCallback.</param>
+///<param name="oReport">The latencies of the scan.</param>
+///<return>Returns true if all files are scanned. Returns false if the scan is stopped by iCallback.<return>
+bool scanFiles(const std::vector<std::string> & iFiles, const ScanOptions & iOptions, ScanCallback iCallback, void * iUserData, ScanReport & oReport);
+
+///<summary>
+///Parses the links (*.lnk files) of a folder and measures the latency of each stage of the parsing.
+///</summary>
+///<param name="iFolder">The path of the folder to scan.</param>
+///<param name="iRecursive">Also scan the links of the sub folders.</param>
+///<param name="iOptions">The options of the scan.</param>
+///<param name="iCallback">The function called after each file. Can be NULL.</param>
+///<param name="iUserData">The user data given to iCallback.</param>
+///<param name="oReport">The latencies of the scan.</param>
+///<return>Returns true if all links are scanned. Returns false if the folder cannot be searched or if the scan is stopped by iCallback.<return>
+bool scanFolder(const char * iFolder, bool iRecursive, const ScanOptions & iOptions, ScanCallback iCallback, void * iUserData, ScanReport & oReport);
+
+///<summary>
+///Parses the links of a ZIP or TAR archive without extracting them and measures the latency of each stage of the parsing.
+///All members are probed: the members which do not have the signature of a link are skipped and are not reported.
+///The path given to iCallback is the path of the archive followed by the name of the member.
+///</summary>
+///<param name="iArchivePath">The path of the archive to scan.</param>
+///<param name="iOptions">The options of the scan.</param>
+///<param name="iCallback">The function called after each link. Can be NULL.</param>
+///<param name="iUserData">The user data given to iCallback.</param>
+///<param name="oReport">The latencies of the scan.</param>
+///<return>Returns true if all links are scanned. Returns false if the archive cannot be read or if the scan is stopped by iCallback.<return>
+bool scanArchive(const char * iArchivePath, const ScanOptions & iOptions, ScanCallback iCallback, void * iUserData, ScanReport & oReport);
+
+}; //lnk
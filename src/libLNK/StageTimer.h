@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Scan.h"
+#include "Tracing.h"
+#include "nativefunc.h"
+#include <string.h>
+
+//Enters a stage of the parsing: measured when a timer is given to the decoder
+//and traced when tracing hooks are installed. Requires LNK_TRACE_STAGES() in the function.
+#define LNK_STAGE_ENTER(timer, stage) { if (timer) (timer)->enter(stage); LNK_TRACE_STAGE(stage); }
+
+namespace lnk
+{
+
+  ///<summary>
+  ///Measures the time spent in each stage of the parsing of a file.
+  ///The time elapsed is attributed to the current stage until the next stage is entered.
+  ///</summary>
+  class StageTimer
+  {
+  public:
+    StageTimer()
+    {
+      memset(mDurations, 0, sizeof(mDurations));
+      memset(mReached, 0, sizeof(mReached));
+      mStage = LNK_STAGE_COUNT;
+      mStart = nativefunc::getHighResolutionTime();
+      mLast = mStart;
+    }
+
+    void enter(LNK_STAGE iStage)
+    {
+      uint64_t now = nativefunc::getHighResolutionTime();
+      if (mStage != LNK_STAGE_COUNT)
+        mDurations[mStage] += now - mLast;
+      mStage = iStage;
+      mReached[iStage] = true;
+      mLast = now;
+    }
+
+    ///<summary>
+    ///Closes the current stage.
+    ///</summary>
+    ///<return>Returns the time elapsed since the timer was created.<return>
+    uint64_t finish()
+    {
+      uint64_t now = nativefunc::getHighResolutionTime();
+      if (mStage != LNK_STAGE_COUNT)
+        mDurations[mStage] += now - mLast;
+      mStage = LNK_STAGE_COUNT;
+      mLast = now;
+      return now - mStart;
+    }
+
+    uint64_t getDuration(LNK_STAGE iStage) const { return mDurations[iStage]; }
+    bool isReached(LNK_STAGE iStage) const { return mReached[iStage]; }
+
+  private:
+    uint64_t mDurations[LNK_STAGE_COUNT];
+    bool mReached[LNK_STAGE_COUNT];
+    LNK_STAGE mStage;
+    uint64_t mStart;
+    uint64_t mLast;
+  };
+
+  class MemoryBuffer;
+  class Reader;
+
+  ///<summary>
+  ///Loads and decodes a link file while measuring the time spent in each stage.
+  ///The file is loaded in ioFileContent which can be reused between calls.
+  ///</summary>
+  bool getLinkInfo(const char * iFilePath, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, StageTimer & ioTimer, MemoryBuffer & ioFileContent);
+
+  ///<summary>
+  ///Decodes a link held in memory while measuring the time spent in each stage.
+  ///</summary>
+  bool getLinkInfo(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, StageTimer & ioTimer);
+
+  ///<summary>
+  ///Reads and decodes a link from a stream while measuring the time spent in each stage.
+  ///The sections of the link are kept in ioWindow which can be reused between calls.
+  ///</summary>
+  bool getLinkInfo(Reader & ioReader, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, StageTimer & ioTimer, MemoryBuffer & ioWindow);
+
+}; //lnk
@@ -0,0 +1,139 @@
+#include "Stats.h"
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+#include "Mutex.h"
+
+namespace lnk
+{
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // Defines, Pre-declarations & typedefs
+  //----------------------------------------------------------------------------------------------------------------------------------------
+
+  //Stats only contains uint64_t counters and can be aggregated as an array
+  static const size_t NUM_COUNTERS = sizeof(Stats) / sizeof(uint64_t);
+
+  void retireThreadStats(void * iStats);
+
+#ifdef WIN32
+  inline void WINAPI onThreadExit(void * iStats)
+  {
+    retireThreadStats(iStats);
+  }
+#else
+  inline void onThreadExit(void * iStats)
+  {
+    retireThreadStats(iStats);
+  }
+#endif
+
+  //Counters of the running threads which have used the library, and the total of the threads which have exited.
+  //The counters of a thread are released by a callback of the thread local storage when the thread exits.
+  struct StatsRegistry
+  {
+    StatsRegistry()
+    {
+      memset(&retired, 0, sizeof(retired));
+#ifdef WIN32
+      key = FlsAlloc(&onThreadExit);
+      hasKey = (key != FLS_OUT_OF_INDEXES);
+#else
+      hasKey = (pthread_key_create(&key, &onThreadExit) == 0);
+#endif
+    }
+
+    Mutex lock;
+    std::vector<Stats*> threads;
+    Stats retired;
+#ifdef WIN32
+    DWORD key;
+#else
+    pthread_key_t key;
+#endif
+    bool hasKey;
+  };
+
+  //never destroyed: the callback may run for threads which exit after the static destructors
+  static StatsRegistry & gRegistry = *new StatsRegistry;
+
+  LNK_THREAD_LOCAL Stats * gThreadStats = NULL;
+
+  //Adds the counters of an exiting thread to the retired total and releases them
+  void retireThreadStats(void * iStats)
+  {
+    Stats * stats = (Stats *)iStats;
+    if (stats == NULL)
+      return;
+    if (gThreadStats == stats)
+      gThreadStats = NULL;
+
+    {
+      ScopedLock lock(gRegistry.lock);
+      std::vector<Stats*>::iterator it = std::find(gRegistry.threads.begin(), gRegistry.threads.end(), stats);
+      if (it != gRegistry.threads.end())
+        gRegistry.threads.erase(it);
+
+      uint64_t * total = (uint64_t *)&gRegistry.retired;
+      const uint64_t * counters = (const uint64_t *)stats;
+      for(size_t i=0; i<NUM_COUNTERS; i++)
+        total[i] += counters[i];
+    }
+
+    delete stats;
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // global functions
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  Stats * registerThreadStats()
+  {
+    Stats * stats = new Stats;
+    memset(stats, 0, sizeof(Stats));
+
+    ScopedLock lock(gRegistry.lock);
+    gRegistry.threads.push_back(stats);
+
+    //without the callback, the counters are kept until the end of the process
+    if (gRegistry.hasKey)
+    {
+#ifdef WIN32
+      FlsSetValue(gRegistry.key, stats);
+#else
+      pthread_setspecific(gRegistry.key, stats);
+#endif
+    }
+
+    return stats;
+  }
+
+  size_t getNumThreadStats()
+  {
+    ScopedLock lock(gRegistry.lock);
+    return gRegistry.threads.size();
+  }
+
+  bool getStats(Stats & oStats)
+  {
+    memset(&oStats, 0, sizeof(oStats));
+
+#ifdef LNK_STATS_ENABLED
+    uint64_t * total = (uint64_t *)&oStats;
+
+    ScopedLock lock(gRegistry.lock);
+    memcpy(total, &gRegistry.retired, sizeof(Stats));
+    for(size_t i=0; i<gRegistry.threads.size(); i++)
+    {
+      const uint64_t * counters = (const uint64_t *)gRegistry.threads[i];
+      for(size_t j=0; j<NUM_COUNTERS; j++)
+        total[j] += loadStat(counters[j]);
+    }
+
+    return true;
+#else
+    return false;
+#endif
+  }
+
+}; //lnk
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "libLNK.h"
+#include <stdint.h>
+#include <stddef.h>
+
+//Statistics are collected when the library is built with LNK_STATS_ENABLED.
+//Otherwise, LNK_STATS_ADD() expands to nothing and getStats() returns false.
+#ifdef LNK_STATS_ENABLED
+#define LNK_STATS_ADD(field, value) lnk::addStat(lnk::getThreadStats().field, (value))
+#else
+#define LNK_STATS_ADD(field, value)
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h> //for _InterlockedCompareExchange64()
+#pragma intrinsic(_InterlockedCompareExchange64)
+#define LNK_THREAD_LOCAL __declspec(thread)
+#else
+#define LNK_THREAD_LOCAL __thread
+#endif
+
+namespace lnk
+{
+
+  //Counters of the calling thread. NULL until the thread updates a counter.
+  extern LNK_THREAD_LOCAL Stats * gThreadStats;
+
+  ///<summary>
+  ///Allocates and registers the counters of the calling thread.
+  ///When the thread exits, the counters are added to the total of the exited threads and released.
+  ///</summary>
+  ///<return>Returns the counters of the calling thread.<return>
+  Stats * registerThreadStats();
+
+  ///<summary>
+  ///Returns the number of running threads whose counters are registered.
+  ///</summary>
+  size_t getNumThreadStats();
+
+  ///<summary>
+  ///Returns the counters of the calling thread.
+  ///</summary>
+  inline Stats & getThreadStats()
+  {
+    if (gThreadStats == NULL)
+      gThreadStats = registerThreadStats();
+    return *gThreadStats;
+  }
+
+  //Each counter is written by its own thread only and read by getStats().
+  //A relaxed store is enough: no lock prefix is required on the hot path of 64 bits processors.
+  //32 bits processors cannot read or write 64 bits at once: the accesses of MSVC use cmpxchg8b.
+  inline void addStat(uint64_t & ioCounter, uint64_t iValue)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(&ioCounter, __atomic_load_n(&ioCounter, __ATOMIC_RELAXED) + iValue, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER) && !defined(_M_X64)
+    //only this thread writes the counter: the comparison always succeeds
+    volatile __int64 * counter = (volatile __int64 *)&ioCounter;
+    const __int64 value = *counter;
+    _InterlockedCompareExchange64(counter, value + (__int64)iValue, value);
+#else
+    volatile uint64_t & counter = ioCounter;
+    counter = counter + iValue;
+#endif
+  }
+
+  inline uint64_t loadStat(const uint64_t & iCounter)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(&iCounter, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER) && !defined(_M_X64)
+    //exchanges 0 with 0: the counter is read at once without being modified
+    return (uint64_t)_InterlockedCompareExchange64((volatile __int64 *)&iCounter, 0, 0);
+#else
+    const volatile uint64_t & counter = iCounter;
+    return counter;
+#endif
+  }
+
+  ///<summary>
+  ///Returns the index of an ExtraData signature in Stats::extraDataBlocks.
+  ///</summary>
+  ///<return>Returns LNK_EXTRADATA_NUM_SIGNATURES for unknown signatures.<return>
+  inline uint32_t getExtraDataIndex(uint32_t iSignature)
+  {
+    uint32_t index = iSignature - LNK_EXTRADATA_FIRST_SIGNATURE;
+    return (index < LNK_EXTRADATA_NUM_SIGNATURES ? index : LNK_EXTRADATA_NUM_SIGNATURES);
+  }
+
+}; //lnk
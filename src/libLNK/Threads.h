@@ -0,0 +1,93 @@
+#pragma once
+
+#ifdef WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#include <process.h> //for _beginthreadex()
+#else
+#include <pthread.h>
+#endif
+#include <vector>
+
+namespace lnk
+{
+
+  ///<summary>
+  ///Increments a value shared by many threads.
+  ///</summary>
+  ///<return>Returns the incremented value.<return>
+  inline long atomicIncrement(volatile long & ioValue)
+  {
+#ifdef WIN32
+    return InterlockedIncrement(&ioValue);
+#else
+    return __sync_add_and_fetch(&ioValue, 1);
+#endif
+  }
+
+  typedef void (*ThreadFunction)(void * iUserData);
+
+  struct THREAD_START
+  {
+    ThreadFunction function;
+    void * userData;
+  };
+
+#ifdef WIN32
+  inline unsigned __stdcall threadEntry(void * iStart)
+  {
+    const THREAD_START * start = (const THREAD_START *)iStart;
+    start->function(start->userData);
+    return 0;
+  }
+#else
+  inline void * threadEntry(void * iStart)
+  {
+    const THREAD_START * start = (const THREAD_START *)iStart;
+    start->function(start->userData);
+    return NULL;
+  }
+#endif
+
+  ///<summary>
+  ///Runs a function on many threads at the same time and waits for all of them.
+  ///The calling thread runs the function too. If a thread cannot be started, the other threads do its share of the work.
+  ///</summary>
+  ///<param name="iFunction">The function to run.</param>
+  ///<param name="iUserData">The user data given to each call of iFunction.</param>
+  ///<param name="iNumThreads">The number of threads running iFunction, including the calling thread.</param>
+  inline void runThreads(ThreadFunction iFunction, void * iUserData, unsigned long iNumThreads)
+  {
+    THREAD_START start = {iFunction, iUserData};
+    unsigned long numStarted = 0;
+
+#ifdef WIN32
+    std::vector<HANDLE> threads(iNumThreads > 1 ? iNumThreads-1 : 0);
+    for(size_t i=0; i<threads.size(); i++)
+    {
+      threads[numStarted] = (HANDLE)_beginthreadex(NULL, 0, &threadEntry, &start, 0, NULL);
+      if (threads[numStarted] != 0)
+        numStarted++;
+    }
+    iFunction(iUserData);
+    for(unsigned long i=0; i<numStarted; i++)
+    {
+      WaitForSingleObject(threads[i], INFINITE);
+      CloseHandle(threads[i]);
+    }
+#else
+    std::vector<pthread_t> threads(iNumThreads > 1 ? iNumThreads-1 : 0);
+    for(size_t i=0; i<threads.size(); i++)
+    {
+      if (pthread_create(&threads[numStarted], NULL, &threadEntry, &start) == 0)
+        numStarted++;
+    }
+    iFunction(iUserData);
+    for(unsigned long i=0; i<numStarted; i++)
+      pthread_join(threads[i], NULL);
+#endif
+  }
+
+}; //lnk
@@ -0,0 +1,154 @@
+#include "Tracing.h"
+#include <stdio.h>
+#include <vector>
+
+#include "nativefunc.h"
+#include "Mutex.h"
+
+namespace lnk
+{
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // Defines, Pre-declarations & typedefs
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  volatile bool gTraceEnabled = false;
+  TraceHooks gTraceHooks = {NULL, NULL, NULL};
+
+  //A begin ('B') or end ('E') event of a stage
+  struct TRACE_EVENT
+  {
+    const char * name;
+    char phase;
+    uint32_t threadId;
+    uint64_t time; //in nanoseconds
+  };
+
+  struct TraceRecorder::Events
+  {
+    Mutex lock;
+    std::vector<TRACE_EVENT> events;
+    uint64_t start;
+  };
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // global functions
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  bool setTraceHooks(const TraceHooks & iHooks)
+  {
+#ifdef LNK_TRACE_ENABLED
+    if (iHooks.begin == NULL || iHooks.end == NULL)
+      return false;
+    gTraceEnabled = false;
+    gTraceHooks = iHooks;
+    gTraceEnabled = true;
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void clearTraceHooks()
+  {
+    gTraceEnabled = false;
+    gTraceHooks.begin = NULL;
+    gTraceHooks.end = NULL;
+    gTraceHooks.userData = NULL;
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // TraceRecorder
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  TraceRecorder::TraceRecorder() :
+    mEvents(new Events)
+  {
+    mEvents->start = nativefunc::getHighResolutionTime();
+  }
+
+  TraceRecorder::~TraceRecorder()
+  {
+    stop();
+    delete mEvents;
+  }
+
+  bool TraceRecorder::start()
+  {
+    TraceHooks hooks;
+    hooks.begin = &onBegin;
+    hooks.end = &onEnd;
+    hooks.userData = mEvents;
+    return setTraceHooks(hooks);
+  }
+
+  void TraceRecorder::stop()
+  {
+    if (gTraceHooks.userData == mEvents)
+      clearTraceHooks();
+  }
+
+  void TraceRecorder::clear()
+  {
+    ScopedLock lock(mEvents->lock);
+    mEvents->events.clear();
+    mEvents->start = nativefunc::getHighResolutionTime();
+  }
+
+  size_t TraceRecorder::getNumEvents() const
+  {
+    ScopedLock lock(mEvents->lock);
+    return mEvents->events.size();
+  }
+
+  bool TraceRecorder::save(const char * iFilePath) const
+  {
+    FILE * f = fopen(iFilePath, "w");
+    if (!f)
+      return false;
+
+    ScopedLock lock(mEvents->lock);
+    const std::vector<TRACE_EVENT> & events = mEvents->events;
+    fprintf(f, "{\"traceEvents\":[\n");
+    for(size_t i=0; i<events.size(); i++)
+    {
+      const TRACE_EVENT & e = events[i];
+      uint64_t time = e.time - mEvents->start;
+
+      //timestamps are in microseconds
+      fprintf(f, "{\"name\":\"%s\",\"cat\":\"libLNK\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":%u}%s\n",
+        e.name,
+        e.phase,
+        (unsigned long long)(time / 1000),
+        (unsigned int)(time % 1000),
+        (unsigned int)e.threadId,
+        (i+1<events.size() ? "," : ""));
+    }
+    fprintf(f, "],\n\"displayTimeUnit\":\"ns\"}\n");
+
+    bool success = (ferror(f) == 0);
+    fclose(f);
+    return success;
+  }
+
+  void TraceRecorder::onBegin(const char * iName, void * iUserData)
+  {
+    record(iName, 'B', iUserData);
+  }
+
+  void TraceRecorder::onEnd(const char * iName, void * iUserData)
+  {
+    record(iName, 'E', iUserData);
+  }
+
+  void TraceRecorder::record(const char * iName, char iPhase, void * iUserData)
+  {
+    TRACE_EVENT e;
+    e.name = iName;
+    e.phase = iPhase;
+    e.threadId = nativefunc::getCurrentThreadId();
+    e.time = nativefunc::getHighResolutionTime();
+
+    Events * events = (Events *)iUserData;
+    ScopedLock lock(events->lock);
+    events->events.push_back(e);
+  }
+
+}; //lnk
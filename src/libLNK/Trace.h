@@ -0,0 +1,81 @@
+#pragma once
+
+#include "libLNK.h"
+
+namespace lnk
+{
+
+///<summary>
+///Called when a stage of the parser or of the writer begins or ends.
+///Stages are properly nested on each thread.
+///</summary>
+///<param name="iName">The name of the stage. Names are string literals which stay valid for the lifetime of the process.</param>
+///<param name="iUserData">The user data of the hooks.</param>
+typedef void (*TraceCallback)(const char * iName, void * iUserData);
+
+//Callbacks of the tracing of the library
+struct TraceHooks
+{
+  TraceCallback begin;
+  TraceCallback end;
+  void * userData;
+};
+
+///<summary>
+///Installs tracing hooks. The hooks are called by all threads.
+///The hooks must be installed or removed while no other thread is using the library.
+///</summary>
+///<param name="iHooks">The hooks to install. Both callbacks are required.</param>
+///<return>Returns true if the hooks are installed. Returns false if a callback is missing or if tracing is compiled out.<return>
+bool setTraceHooks(const TraceHooks & iHooks);
+
+///<summary>
+///Removes the tracing hooks.
+///</summary>
+void clearTraceHooks();
+
+///<summary>
+///Records the stages of the library as a Chrome trace (chrome://tracing, Perfetto).
+///Events of all threads are recorded between start() and stop().
+///</summary>
+class TraceRecorder
+{
+public:
+  TraceRecorder();
+  virtual ~TraceRecorder();
+
+  ///<summary>
+  ///Installs the hooks of the recorder.
+  ///</summary>
+  ///<return>Returns true if recording. Returns false if tracing is compiled out.<return>
+  bool start();
+
+  ///<summary>
+  ///Removes the hooks of the recorder. Recorded events are kept.
+  ///</summary>
+  void stop();
+
+  void clear();
+  size_t getNumEvents() const;
+
+  ///<summary>
+  ///Saves the recorded events in the Chrome trace event format (JSON).
+  ///</summary>
+  ///<param name="iFilePath">The path of the JSON file.</param>
+  ///<return>Returns true if the file is saved. Returns false otherwise.<return>
+  bool save(const char * iFilePath) const;
+
+private:
+  //non copyable
+  TraceRecorder(const TraceRecorder &);
+  TraceRecorder & operator = (const TraceRecorder &);
+
+  static void onBegin(const char * iName, void * iUserData);
+  static void onEnd(const char * iName, void * iUserData);
+  static void record(const char * iName, char iPhase, void * iUserData);
+
+  struct Events;
+  Events * mEvents;
+};
+
+}; //lnk
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Trace.h"
+#include "Scan.h"
+
+//Tracing hooks are compiled when the library is built with LNK_TRACE_ENABLED.
+//Each hook is then a single branch on gTraceEnabled which is not taken
+//unless setTraceHooks() is called. Otherwise, the macros expand to nothing.
+#ifdef LNK_TRACE_ENABLED
+#define LNK_TRACE_SCOPE(name) lnk::TraceScope traceScope(name)
+#define LNK_TRACE_STAGES() lnk::TraceStages traceStages
+#define LNK_TRACE_STAGE(stage) traceStages.enter(stage)
+#else
+#define LNK_TRACE_SCOPE(name)
+#define LNK_TRACE_STAGES()
+#define LNK_TRACE_STAGE(stage)
+#endif
+
+namespace lnk
+{
+
+  //true when hooks are installed
+  extern volatile bool gTraceEnabled;
+  extern TraceHooks gTraceHooks;
+
+  ///<summary>
+  ///Traces a scope: the stage begins with the object and ends with it.
+  ///</summary>
+  class TraceScope
+  {
+  public:
+    TraceScope(const char * iName) : mName(NULL)
+    {
+      if (gTraceEnabled)
+      {
+        mName = iName;
+        gTraceHooks.begin(mName, gTraceHooks.userData);
+      }
+    }
+
+    ~TraceScope()
+    {
+      if (mName)
+        gTraceHooks.end(mName, gTraceHooks.userData);
+    }
+
+  private:
+    const char * mName;
+  };
+
+  ///<summary>
+  ///Traces consecutive stages (LNK_STAGE) of a function.
+  ///Entering a stage ends the previous one. The last stage ends with the object.
+  ///</summary>
+  class TraceStages
+  {
+  public:
+    TraceStages() : mName(NULL)
+    {
+    }
+
+    ~TraceStages()
+    {
+      if (mName)
+        gTraceHooks.end(mName, gTraceHooks.userData);
+    }
+
+    void enter(LNK_STAGE iStage)
+    {
+      if (mName)
+      {
+        gTraceHooks.end(mName, gTraceHooks.userData);
+        mName = NULL;
+      }
+      if (gTraceEnabled)
+      {
+        mName = getStageName(iStage);
+        gTraceHooks.begin(mName, gTraceHooks.userData);
+      }
+    }
+
+  private:
+    const char * mName;
+  };
+
+}; //lnk
@@ -0,0 +1,322 @@
+#include "UringWriter.h"
+
+#ifdef LNK_IO_URING_ENABLED
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+namespace lnk
+{
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // Defines, Pre-declarations & typedefs
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  //requests of the chain of a file, saved in the user data of each request
+  enum URING_OP
+  {
+    URING_OP_OPEN = 0,
+    URING_OP_WRITE,
+    URING_OP_FSYNC,
+    URING_OP_CLOSE,
+    URING_OP_COUNT,
+  };
+
+  //the system calls are used directly: liburing is not required
+  inline int io_uring_setup(unsigned int iEntries, io_uring_params * ioParams)
+  {
+    return (int)syscall(__NR_io_uring_setup, iEntries, ioParams);
+  }
+
+  inline int io_uring_enter(int iRing, unsigned int iNumSubmit, unsigned int iMinComplete, unsigned int iFlags)
+  {
+    return (int)syscall(__NR_io_uring_enter, iRing, iNumSubmit, iMinComplete, iFlags, NULL, 0);
+  }
+
+  inline int io_uring_register(int iRing, unsigned int iOpcode, const void * iArgs, unsigned int iNumArgs)
+  {
+    return (int)syscall(__NR_io_uring_register, iRing, iOpcode, iArgs, iNumArgs);
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // UringWriter
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  UringWriter::UringWriter() :
+  mRing(-1),
+  mMaxFiles(0),
+  mArena(NULL),
+  mArenaSize(0),
+  mSqRing(MAP_FAILED),
+  mSqRingSize(0),
+  mSqes((io_uring_sqe *)MAP_FAILED),
+  mSqesSize(0),
+  mSqHead(NULL),
+  mSqTail(NULL),
+  mSqMask(0),
+  mSqPending(0),
+  mCqRing(MAP_FAILED),
+  mCqRingSize(0),
+  mCqes(NULL),
+  mCqHead(NULL),
+  mCqTail(NULL),
+  mCqMask(0)
+  {
+  }
+
+  UringWriter::~UringWriter()
+  {
+    close();
+  }
+
+  void UringWriter::close()
+  {
+    if (mSqes != MAP_FAILED)
+      munmap(mSqes, mSqesSize);
+    if (mCqRing != MAP_FAILED && mCqRing != mSqRing)
+      munmap(mCqRing, mCqRingSize);
+    if (mSqRing != MAP_FAILED)
+      munmap(mSqRing, mSqRingSize);
+    if (mRing != -1)
+      ::close(mRing); //also releases the registered arena and files
+    free(mArena);
+
+    mSqes = (io_uring_sqe *)MAP_FAILED;
+    mCqRing = MAP_FAILED;
+    mSqRing = MAP_FAILED;
+    mRing = -1;
+    mArena = NULL;
+    mArenaSize = 0;
+    mMaxFiles = 0;
+  }
+
+  bool UringWriter::init(unsigned long iMaxFiles, unsigned long iArenaSize)
+  {
+    close();
+    if (iMaxFiles == 0 || iArenaSize == 0)
+      return false;
+
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    mRing = io_uring_setup((unsigned int)(iMaxFiles * URING_OP_COUNT), &params);
+    if (mRing == -1)
+      return false; //not supported by the kernel or not allowed
+
+    //files are opened in the table of registered files (direct descriptors) which requires Linux 5.15.
+    //IORING_FEAT_CQE_SKIP is the first feature flag published after that version.
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0 || (params.features & IORING_FEAT_CQE_SKIP) == 0)
+    {
+      close();
+      return false;
+    }
+
+    //map the rings
+    mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (mCqRingSize > mSqRingSize)
+      mSqRingSize = mCqRingSize;
+    mSqRing = mmap(NULL, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQ_RING);
+    mCqRing = mSqRing;
+    mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    mSqes = (io_uring_sqe *)mmap(NULL, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQES);
+    if (mSqRing == MAP_FAILED || mSqes == MAP_FAILED)
+    {
+      close();
+      return false;
+    }
+
+    unsigned char * sq = (unsigned char *)mSqRing;
+    mSqHead = (unsigned int *)(sq + params.sq_off.head);
+    mSqTail = (unsigned int *)(sq + params.sq_off.tail);
+    mSqMask = *(unsigned int *)(sq + params.sq_off.ring_mask);
+    unsigned int * array = (unsigned int *)(sq + params.sq_off.array);
+    for(unsigned int i=0; i<params.sq_entries; i++)
+      array[i] = i; //each slot of the ring uses the sqe of the same index
+    mSqPending = 0;
+
+    unsigned char * cq = (unsigned char *)mCqRing;
+    mCqHead = (unsigned int *)(cq + params.cq_off.head);
+    mCqTail = (unsigned int *)(cq + params.cq_off.tail);
+    mCqMask = *(unsigned int *)(cq + params.cq_off.ring_mask);
+    mCqes = (io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    //register the arena once: the content of the files is written without mapping the pages at each request
+    mArena = (unsigned char *)malloc(iArenaSize);
+    if (mArena == NULL)
+    {
+      close();
+      return false;
+    }
+    mArenaSize = iArenaSize;
+    struct iovec arena = {mArena, iArenaSize};
+    if (io_uring_register(mRing, IORING_REGISTER_BUFFERS, &arena, 1) != 0)
+    {
+      close();
+      return false;
+    }
+
+    //an empty table of files, one slot per file of a submission
+    std::vector<int> files(iMaxFiles, -1);
+    if (io_uring_register(mRing, IORING_REGISTER_FILES, &files[0], (unsigned int)iMaxFiles) != 0)
+    {
+      close();
+      return false;
+    }
+
+    mMaxFiles = iMaxFiles;
+    return true;
+  }
+
+  io_uring_sqe * UringWriter::getSqe()
+  {
+    unsigned int tail = *mSqTail + mSqPending;
+    io_uring_sqe * sqe = &mSqes[tail & mSqMask];
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    mSqPending++;
+    return sqe;
+  }
+
+  bool UringWriter::submitAndWait(unsigned int iNumSubmit, unsigned int iNumWait)
+  {
+    //publish the sqes to the kernel
+    __atomic_store_n(mSqTail, *mSqTail + mSqPending, __ATOMIC_RELEASE);
+    mSqPending = 0;
+
+    while(iNumSubmit > 0 || iNumWait > 0)
+    {
+      int result = io_uring_enter(mRing, iNumSubmit, iNumWait, IORING_ENTER_GETEVENTS);
+      if (result < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        return false;
+      }
+      iNumSubmit -= (unsigned int)result;
+      iNumWait = 0;
+    }
+    return true;
+  }
+
+  bool UringWriter::drain(URING_FILE * ioFiles, size_t iCount, unsigned int iFirstRequest, unsigned int iNumCompleted)
+  {
+    for(size_t i=0; i<iCount; i++)
+      ioFiles[i].success = false;
+
+    //withdraw the requests which were not consumed by the kernel
+    unsigned int head = __atomic_load_n(mSqHead, __ATOMIC_ACQUIRE);
+    __atomic_store_n(mSqTail, head, __ATOMIC_RELEASE);
+    mSqPending = 0;
+
+    //the requests already submitted may still write the files
+    const unsigned int numSubmitted = head - iFirstRequest;
+    unsigned int numCompleted = iNumCompleted;
+    while(numCompleted < numSubmitted)
+    {
+      unsigned int cqHead = *mCqHead;
+      unsigned int cqTail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+      if (cqHead != cqTail)
+      {
+        numCompleted += cqTail - cqHead;
+        __atomic_store_n(mCqHead, cqTail, __ATOMIC_RELEASE);
+        continue;
+      }
+      if (io_uring_enter(mRing, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+      {
+        //closing the ring cancels the remaining requests. The writer cannot be used anymore.
+        ::close(mRing);
+        mRing = -1;
+        return false;
+      }
+    }
+    return false;
+  }
+
+  bool UringWriter::writeFiles(URING_FILE * ioFiles, size_t iCount, bool iSync)
+  {
+    if (mRing == -1 || iCount > mMaxFiles)
+      return false;
+    const unsigned int firstRequest = *mSqTail;
+
+    //one chain per file. Hard links keep the order of the requests of a chain
+    //and still close the file when a previous request fails.
+    unsigned int numRequests = 0;
+    for(size_t i=0; i<iCount; i++)
+    {
+      const URING_FILE & file = ioFiles[i];
+      unsigned int slot = (unsigned int)i;
+
+      io_uring_sqe * sqe = getSqe();
+      sqe->opcode = IORING_OP_OPENAT;
+      sqe->fd = AT_FDCWD;
+      sqe->addr = (uint64_t)(uintptr_t)file.path;
+      sqe->len = 0666; //mode
+      sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC; //direct descriptors are not inherited: O_CLOEXEC is not allowed
+      sqe->file_index = slot + 1;
+      sqe->flags = IOSQE_IO_HARDLINK;
+      sqe->user_data = i * URING_OP_COUNT + URING_OP_OPEN;
+
+      sqe = getSqe();
+      sqe->opcode = IORING_OP_WRITE_FIXED;
+      sqe->fd = (int)slot;
+      sqe->addr = (uint64_t)(uintptr_t)(mArena + file.offset);
+      sqe->len = file.size;
+      sqe->off = 0;
+      sqe->buf_index = 0;
+      sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+      sqe->user_data = i * URING_OP_COUNT + URING_OP_WRITE;
+
+      if (iSync)
+      {
+        sqe = getSqe();
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fd = (int)slot;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+        sqe->user_data = i * URING_OP_COUNT + URING_OP_FSYNC;
+      }
+
+      sqe = getSqe();
+      sqe->opcode = IORING_OP_CLOSE;
+      sqe->file_index = slot + 1;
+      sqe->user_data = i * URING_OP_COUNT + URING_OP_CLOSE;
+
+      numRequests += (iSync ? 4 : 3);
+      ioFiles[i].success = true;
+    }
+
+    if (!submitAndWait(numRequests, numRequests))
+      return drain(ioFiles, iCount, firstRequest, 0);
+
+    //reap the completions
+    unsigned int numCompleted = 0;
+    while(numCompleted < numRequests)
+    {
+      unsigned int head = *mCqHead;
+      unsigned int tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+      if (head == tail)
+      {
+        if (!submitAndWait(0, 1))
+          return drain(ioFiles, iCount, firstRequest, numCompleted);
+        continue;
+      }
+      for(; head != tail; head++, numCompleted++)
+      {
+        const io_uring_cqe & cqe = mCqes[head & mCqMask];
+        URING_FILE & file = ioFiles[cqe.user_data / URING_OP_COUNT];
+        bool success = (cqe.user_data % URING_OP_COUNT == URING_OP_WRITE ? cqe.res == (int)file.size : cqe.res >= 0);
+        file.success = file.success && success;
+      }
+      __atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+    }
+
+    return true;
+  }
+
+}; //lnk
+
+#endif //LNK_IO_URING_ENABLED
@@ -0,0 +1,93 @@
+#pragma once
+
+#ifdef LNK_IO_URING_ENABLED
+
+#include <stddef.h>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace lnk
+{
+
+  //A file written by UringWriter. The content is in the arena of the writer.
+  struct URING_FILE
+  {
+    const char * path;      //path of the file, created or truncated
+    unsigned long offset;   //offset of the content in the arena
+    unsigned long size;     //size of the content
+    bool success;           //set by UringWriter::writeFiles()
+  };
+
+  ///<summary>
+  ///Writes many small files with io_uring (Linux only).
+  ///Each file is written by a chain of linked requests: open, write, optional fsync and close.
+  ///The chains of up to getMaxFiles() files are submitted with a single system call.
+  ///The content of the files is written from an arena registered once with the kernel.
+  ///</summary>
+  class UringWriter
+  {
+  public:
+    UringWriter();
+    ~UringWriter();
+
+    ///<summary>
+    ///Creates the ring and registers the arena.
+    ///</summary>
+    ///<param name="iMaxFiles">The maximum number of files of a submission.</param>
+    ///<param name="iArenaSize">The size of the arena in bytes.</param>
+    ///<return>Returns true if io_uring is available. Returns false otherwise.<return>
+    bool init(unsigned long iMaxFiles, unsigned long iArenaSize);
+
+    unsigned char * getArena() { return mArena; }
+    unsigned long getArenaSize() const { return mArenaSize; }
+    unsigned long getMaxFiles() const { return mMaxFiles; }
+
+    ///<summary>
+    ///Writes files whose content is in the arena.
+    ///</summary>
+    ///<param name="ioFiles">The files to write, at most getMaxFiles(). The success of each file is set.</param>
+    ///<param name="iCount">The number of files.</param>
+    ///<param name="iSync">True to flush each file before closing it.</param>
+    ///<return>Returns false if the requests cannot be submitted or waited for: no file is written successfully and
+    ///the requests already submitted are completed, or cancelled if the ring had to be closed. Returns true otherwise.<return>
+    bool writeFiles(URING_FILE * ioFiles, size_t iCount, bool iSync);
+
+  private:
+    //non copyable
+    UringWriter(const UringWriter &);
+    UringWriter & operator = (const UringWriter &);
+
+    void close();
+    io_uring_sqe * getSqe();
+    bool submitAndWait(unsigned int iNumSubmit, unsigned int iNumWait);
+    bool drain(URING_FILE * ioFiles, size_t iCount, unsigned int iFirstRequest, unsigned int iNumCompleted);
+
+    int mRing;
+    unsigned long mMaxFiles;
+    unsigned char * mArena;
+    unsigned long mArenaSize;
+
+    //submission queue
+    void * mSqRing;
+    size_t mSqRingSize;
+    io_uring_sqe * mSqes;
+    size_t mSqesSize;
+    unsigned int * mSqHead;
+    unsigned int * mSqTail;
+    unsigned int mSqMask;
+    unsigned int mSqPending;   //sqes filled but not submitted
+
+    //completion queue
+    void * mCqRing;
+    size_t mCqRingSize;
+    io_uring_cqe * mCqes;
+    unsigned int * mCqHead;
+    unsigned int * mCqTail;
+    unsigned int mCqMask;
+  };
+
+}; //lnk
+
+#endif //LNK_IO_URING_ENABLED
@@ -1,6 +1,7 @@
 #include "libLNK.h"
 #include <assert.h>
 #include <memory.h>
+#include <stddef.h>
 #include <windows.h>
 #include <direct.h>
 #include "..\..\version_info.h"
@@ -8,7 +9,13 @@
 #include "filesystemfunc.h"
 
 #include "MemoryBuffer.h"
+#include "Reader.h"
 #include "ItemID.h"
+#include "ByteCursor.h"
+#include "LinkFormat.h"
+#include "Stats.h"
+#include "StageTimer.h"
+#include "Tracing.h"
 
 namespace lnk
 {
@@ -18,194 +25,21 @@ namespace lnk
 //----------------------------------------------------------------------------------------------------------------------------------------
 typedef std::vector<std::string> StringList;
 
-//----------------------------------------------------------------------------------------------------------------------------------------
-// Structures
-//----------------------------------------------------------------------------------------------------------------------------------------
-//http://www.stdlib.com/art6-Link-File-Format-lnk.html
-//http://www.wotsit.org/list.asp?search=lnk
-
-#pragma pack(push)
-#pragma pack(1)
-
-//Link flags
-struct LinkFlags //32 bits
-{
-  bool HasLinkTargetIDList      :1;
-  bool HasLinkInfo              :1;
-  bool HasName                  :1;
-  bool HasRelativePath          :1;
-  bool HasWorkingDir            :1;
-  bool HasArguments             :1;
-  bool HasIconLocation          :1;
-  bool reserved1                :1;
-  bool reserved2                :8;
-  bool reserved3                :8;
-  bool reserved4                :8;
-};
-
-//Target flags
-struct FileAttributesFlags //32 bits
-{
-  bool isReadOnly      :1; //FILE_ATTRIBUTE_READONLY
-  bool isHidden        :1; //FILE_ATTRIBUTE_HIDDEN
-  bool isSystemFile    :1; //FILE_ATTRIBUTE_SYSTEM
-  bool isVolumeLabel   :1; //Reserved1, MUST be zero.
-  bool isDirectory     :1; //FILE_ATTRIBUTE_DIRECTORY
-  bool isArchive       :1; //FILE_ATTRIBUTE_ARCHIVE
-  bool isEncrypted     :1; //Reserved2, MUST be zero.
-  bool isNormal        :1; //FILE_ATTRIBUTE_NORMAL
-  bool isTemporary     :1; //FILE_ATTRIBUTE_TEMPORARY
-  bool isSparseFile    :1; //FILE_ATTRIBUTE_SPARSE_FILE
-  bool hasReparsePoint :1; //FILE_ATTRIBUTE_REPARSE_POINT
-  bool isCompressed    :1; //FILE_ATTRIBUTE_COMPRESSED
-  bool isOffline       :1; //FILE_ATTRIBUTE_OFFLINE
-  bool reserved1       :3; //FILE_ATTRIBUTE_NOT_CONTENT_INDEXED
-  bool reserved2       :8; //FILE_ATTRIBUTE_ENCRYPTED
-  bool reserved3       :8;
-};
-
-typedef uint8_t LNK_CLSID[16];
-static const LNK_CLSID DEFAULT_LINKCLSID = { 0x01, 0x14, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46};
-struct ShellLinkHeader
-{
-  uint32_t HeaderSize;
-  LNK_CLSID LinkCLSID;
-  LinkFlags linkFlags; 
-  FileAttributesFlags FileAttributes;
-  unsigned __int64 CreationTime;
-  unsigned __int64 AccessTime;
-  unsigned __int64 WriteTime;
-  unsigned long FileSize;
-  unsigned long IconIndex;
-  unsigned long ShowCommand;
-  LNK_HOTKEY HotKey;
-  uint16_t Reserved1;
-  uint32_t Reserved2;
-  uint32_t Reserved3;
-};
-
-static const unsigned long LNK_LOCATION_UNKNOWN = 0;
-static const unsigned long LNK_LOCATION_LOCAL = 1;
-static const unsigned long LNK_LOCATION_NETWORK = 2;
-//File Location Info 
-//This section is always present, but if bit 1 is not set in the flags value,
-//then the length of this section will be zero.
-//The header of this section is described below. 
-//1 dword This length value includes all the assorted pathnames and other data structures. All offsets are relative to the start of this section.  
-//1 dword The offset at which the basic file info structure ends. Should be 1C. 
-//1 dword File available on local volume (0) or network share(1) 
-//1 dword Offset to the local volume table. 
-//1 dword Offset to the base path on the local volume. 
-//1 dword Offset to the network volume table. 
-//1 dword Offset to the final part of the pathname. 
-struct LNK_FILE_LOCATION_INFO
-{
-  unsigned long length;
-  unsigned long endOffset;
-  unsigned long location;
-  unsigned long localVolumeTableOffset;
-  unsigned long basePathOffset;
-  unsigned long networkVolumeTableOffset;
-  unsigned long finalPathOffset;
-};
-static const unsigned long LNK_FILE_LOCATION_INFO_SIZE = sizeof(LNK_FILE_LOCATION_INFO);
-
-
-//Type of volumes
-//Code Description 
-//0 Unknown 
-//1 No root directory 
-//2 Removable (Floppy, Zip ...) 
-//3 Fixed (Hard disk) 
-//4 Remote (Network drive) 
-//5 CD-ROM 
-//6 Ram drive 
-static const unsigned long LNK_VOLUME_TYPE_UNKNOWN           = 0;
-static const unsigned long LNK_VOLUME_TYPE_NO_ROOT_DIRECTORY = 1;
-static const unsigned long LNK_VOLUME_TYPE_REMOVABLE         = 2;
-static const unsigned long LNK_VOLUME_TYPE_FIXED             = 3;
-static const unsigned long LNK_VOLUME_TYPE_REMOTE            = 4;
-static const unsigned long LNK_VOLUME_TYPE_CDROM             = 5;
-static const unsigned long LNK_VOLUME_TYPE_RAMDRIVE          = 6;
-
-//The local volume table
-//1 dword Length of this structure including the volume label string. 
-//1 dword Type of volume (code below) 
-//1 dword Volume serial number 
-//1 dword Offset of the volume name (Always 0x10) 
-//ASCIZ Volume label 
-struct LNK_LOCAL_VOLUME_TABLE
-{
-  unsigned long length;
-  unsigned long volumeType;
-  unsigned long volumeSerialNumber;
-  unsigned long volumeNameOffset;
-  char volumeLabel;
-};
-static const unsigned long LNK_LOCAL_VOLUME_TABLE_SIZE = sizeof(LNK_LOCAL_VOLUME_TABLE);
-
-
-//The network volume table
-//1 dword Length of this structure 
-//1 dword Always 02 
-//1 dword Offset of network share name (Always 0x14) 
-//1 dword Reserved 0 
-//1 dword Always 0x20000 
-//ASCIZ Network share name 
-struct LNK_NETWORK_VOLUME_TABLE
-{
-  unsigned long length;
-  unsigned long reserved1;
-  unsigned long networkShareNameOffset;
-  unsigned long reserved2;
-  unsigned long reserved3;
-  char networkShareName;
-};
-static const unsigned long LNK_NETWORK_VOLUME_TABLE_SIZE = sizeof(LNK_NETWORK_VOLUME_TABLE);
-
-//itemId structure used in LinkTargetIDList part of a link
-struct LNK_ITEMID
-{
-  uint16_t size;
-  uint8_t type;
-  uint8_t unknown1[5];
-  uint32_t unknown2;
-  uint16_t fileAttributes;
-  const char * name83;
-  unsigned char unknown07;          
-  unsigned char unknown08;          
-  unsigned char unknown09[7];       
-  unsigned char unknown10;          
-  unsigned char unknown11;          
-  unsigned char unknown12;          
-  unsigned char unknown13;          
-  unsigned char unknown14;          
-  unsigned char unknown15;          
-  unsigned char unknown16;          
-  unsigned char unknown17;          
-  unsigned char unknown18[4];       
-  const char * nameUnicode;
-  unsigned char unknown19;          
-  unsigned char unknown20;          
-};
-extern const LNK_ITEMID LNK_ITEMIDFolderDefault;
-extern const LNK_ITEMID LNK_ITEMIDFileDefault;
-
-#pragma pack(pop)
-
 //----------------------------------------------------------------------------------------------------------------------------------------
 // global classes & functions
 //----------------------------------------------------------------------------------------------------------------------------------------
 std::string toTimeString(const unsigned __int64 & iTime)
 {
   //time stamps
+  //The conversion only uses the caller's stack: SystemTimeToTzSpecificLocalTime() reads the
+  //time zone of the system for each call and applies the daylight saving bias of the time stamp.
   const FILETIME * utcFileTime = (const FILETIME *)&iTime;
-  FILETIME localFileTime = {0};
-  FileTimeToLocalFileTime(utcFileTime, &localFileTime);
+  SYSTEMTIME utcSystemTime = {0};
+  FileTimeToSystemTime(utcFileTime, &utcSystemTime);
   SYSTEMTIME localSystemTime = {0};
-  FileTimeToSystemTime(&localFileTime, &localSystemTime);
+  SystemTimeToTzSpecificLocalTime(NULL, &utcSystemTime, &localSystemTime);
 
-  char buffer[1024];
+  char buffer[64];
   sprintf(buffer, "%04d-%02d-%02d %02d:%02d:%02d.%03d",
     localSystemTime.wYear,
     localSystemTime.wMonth,
@@ -221,130 +55,263 @@ std::string toTimeString(const unsigned __int64 & iTime)
 
 static const LNK_HOTKEY LNK_NO_HOTKEY = {LNK_HK_NONE, LNK_HK_MOD_NONE};
 
-template <typename T>
-inline const T & readData(const unsigned char * iBuffer, unsigned long & ioOffset)
+void LinkInfo::clear()
 {
-  const T & value = *(   (T*)(&iBuffer[ioOffset])  );
-  ioOffset += sizeof(T);
-  return value;
+  target.clear();
+  networkPath.clear();
+  arguments.clear();
+  description.clear();
+  workingDirectory.clear();
+  customIcon.filename.clear();
+  customIcon.index = 0;
+  hotKey = LNK_NO_HOTKEY;
 }
 
-void readString(const unsigned char * iBuffer, unsigned long & ioOffset, std::string & oValue)
+void LinkInfoEx::clear()
 {
-  oValue = "";
-  const unsigned short & length = readData<unsigned short>(iBuffer, ioOffset);
-  for(unsigned short i=0; i<length; i++)
-  {
-    const unsigned short & tmp = readData<unsigned short>(iBuffer, ioOffset);
-    char c = (char)tmp;
-    oValue += c;
-  }
+  LinkInfo::clear();
+  linkFlags = 0;
+  fileAttributes = 0;
+  creationTime = 0;
+  accessTime = 0;
+  writeTime = 0;
+  fileSize = 0;
+  showCommand = 0;
+  basePath.clear();
+  finalPath.clear();
+  relativePath.clear();
+  hasVolume = false;
+  volume.driveType = LNK_VOLUME_TYPE_UNKNOWN;
+  volume.serialNumber = 0;
+  volume.label.clear();
+  hasNetworkShare = false;
+  networkShare.flags = 0;
+  networkShare.providerType = 0;
+  networkShare.shareName.clear();
+  networkShare.deviceName.clear();
 }
 
-std::string readUnicodeString(FILE * iFile)
+const ParseLimits LNK_DEFAULT_PARSE_LIMITS = {
+  0x100000, //maxFileSize
+  256,      //maxItemIds
+  0x7FFF,   //maxStringLength
+  64,       //maxExtraDataBlocks
+};
+
+inline bool reject(const LNK_PARSE_ERROR & iReason, LNK_PARSE_ERROR & oError)
 {
-  std::string value;
+  LNK_STATS_ADD(rejections[iReason], 1);
+  oError = iReason;
+  return false;
+}
 
-  unsigned short length = 0;
-  fread(&length, 1, sizeof(length), iFile);
-  
-  for(unsigned short i=0; i<length; i++)
-  {
-    unsigned short tmp = 0;
-    fread(&tmp, 1, sizeof(tmp), iFile);
+template <class Policy>
+bool readString(BasicByteCursor<Policy> & ioCursor, const ParseLimits & iLimits, std::string & oValue)
+{
+  uint16_t length = 0;
+  if (!ioCursor.read(length))
+    return false;
+  return ioCursor.readUnicodeString(length, iLimits.maxStringLength, oValue);
+}
 
-    char c = (char)tmp;
-    value += c;
+template <class Policy>
+bool skipString(BasicByteCursor<Policy> & ioCursor, const ParseLimits & iLimits)
+{
+  uint16_t length = 0;
+  if (!ioCursor.read(length))
+    return false;
+  if (Policy::CHECKED && length > iLimits.maxStringLength)
+  {
+    ioCursor.fail(LNK_PARSE_ERROR_STRING_TOO_LONG);
+    return false;
   }
+  return ioCursor.skip(length * sizeof(uint16_t));
+}
 
-  return value;
+unsigned long getStringUnicodeSize(const std::string & iValue)
+{
+  return (unsigned long)(sizeof(uint16_t) + iValue.size()*sizeof(uint16_t));
+}
+
+void writeBytes(const void * iData, unsigned long iSize, unsigned char *& ioOutput)
+{
+  memcpy(ioOutput, iData, iSize);
+  ioOutput += iSize;
 }
 
-void saveStringUnicode(FILE * iFile, const std::string & iValue)
+void writeStringUnicode(const std::string & iValue, unsigned char *& ioOutput)
 {
-  unsigned short length = (unsigned short)iValue.size();
-  fwrite(&length, 1, sizeof(length), iFile);
+  uint16_t length = (uint16_t)iValue.size();
+  writeBytes(&length, sizeof(length), ioOutput);
 
-  for(unsigned short i=0; i<length; i++)
+  for(uint16_t i=0; i<length; i++)
   {
-    unsigned short c = iValue[i];
-    fwrite(&c, 1, sizeof(c), iFile);
+    //characters are widened from 8 bits, without sign extension
+    ioOutput[0] = (unsigned char)iValue[i];
+    ioOutput[1] = 0;
+    ioOutput += sizeof(uint16_t);
   }
 }
 
-void saveString(FILE * iFile, const std::string & iValue)
+void writeString(const std::string & iValue, unsigned char *& ioOutput)
 {
-  size_t length = iValue.size();
-  const char * text = iValue.c_str();
-  fwrite(text, 1, length, iFile);
-
-  static const char NULLCHARACTER = '\0';
-  fwrite(&NULLCHARACTER, 1, sizeof(NULLCHARACTER), iFile);
+  writeBytes(iValue.c_str(), (unsigned long)iValue.size() + 1, ioOutput); //include NULL character
 }
 
-bool deserialize(const MemoryBuffer & iBuffer, LNK_ITEMID & oValue, std::string & oName83, std::string & oNameLong)
+//A component of the target path found in the LinkTargetIDList
+struct PATH_COMPONENT
 {
-  unsigned long offset = 0;
-  const unsigned char * buffer = iBuffer.getBuffer();
-
-  oValue.size = readData<unsigned short>(buffer, offset);
-  oValue.type = readData<unsigned char>(buffer, offset);
-  oValue.unknown1[0] = readData<unsigned char>(buffer, offset);
-  oValue.unknown1[1] = readData<unsigned char>(buffer, offset);
-  oValue.unknown1[2] = readData<unsigned char>(buffer, offset);
-  oValue.unknown1[3] = readData<unsigned char>(buffer, offset);
-  oValue.unknown1[4] = readData<unsigned char>(buffer, offset);
-  oValue.unknown2 = readData<unsigned long>(buffer, offset);
-  oValue.fileAttributes = readData<unsigned short>(buffer, offset);
+  const unsigned char * value;
+  unsigned long length;   //number of characters
+  bool unicode;           //16 bits name of a folder or a file, otherwise the 8 bits name of a drive
+};
 
-  //name83
-  oValue.name83 = NULL;
+///<summary>
+///Collects the components of the target path found in the LinkTargetIDList.
+///The path is written with a single allocation once the length of all
+///components and separators is known.
+///</summary>
+class TargetPathBuilder
+{
+public:
+  TargetPathBuilder(std::string & ioPath) :
+    mPath(ioPath),
+    mCount(0)
   {
-    char c = readData<unsigned char>(buffer, offset);
-    while (c != '\0')
-    {
-      oName83 += c;
-      c = readData<unsigned char>(buffer, offset);
-    }
   }
 
-  //search for location of nameUnicode
-  //nameUnicode is located at the end of the ItemID
-  //following a NULL unicode character.
-  const unsigned short * nameUnicodeAddress = (const unsigned short *)(&buffer[iBuffer.getSize()-2]); //last uint16_t of the ItemID
-  nameUnicodeAddress--; //NULL terminating character;
-  nameUnicodeAddress--; //last string character;
-  while(*nameUnicodeAddress != 0x0000)
+  void setDrive(const char * iValue, unsigned long iLength)
   {
-    nameUnicodeAddress--; //rewind until the beginning of the 
+    //a drive replaces the previous components
+    mPath.clear();
+    mCount = 0;
+    add((const unsigned char *)iValue, iLength, false);
   }
-  nameUnicodeAddress++; //move to first string character
-  
-  //move buffer up to nameUnicodeAddress
-  while(nameUnicodeAddress != (const unsigned short *)(&buffer[offset]))
+
+  void addName(const unsigned char * iValue, unsigned long iLength)
   {
-    unsigned char c = readData<unsigned char>(buffer, offset);
+    if (mCount == MAX_COMPONENTS)
+      flush();
+    add(iValue, iLength, true);
   }
 
-  //nameUnicode
-  oValue.nameUnicode = NULL;
+  ///<summary>
+  ///Appends the collected components to the path.
+  ///A name is prefixed by ".\" if the path is empty or by a separator if the path does not end with one.
+  ///</summary>
+  void flush()
   {
-    unsigned short unicodec = readData<unsigned short>(buffer, offset);
-    char c = (char)unicodec;
-    while (c != '\0')
+    if (mCount == 0)
+      return;
+
+    //measure, with the last character written: a separator is not repeated after an empty name
+    size_t length = mPath.size();
+    char last = (length > 0 ? mPath[length - 1] : '\0');
+    for(unsigned long i=0; i<mCount; i++)
+    {
+      const PATH_COMPONENT & component = mComponents[i];
+      if (component.unicode && last != '\\')
+      {
+        length += (length == 0 ? 2 : 1);
+        last = '\\';
+      }
+      length += component.length;
+      if (component.length > 0)
+        last = (char)component.value[component.unicode ? 2*(component.length - 1) : component.length - 1];
+    }
+
+    //write
+    size_t offset = mPath.size();
+    if (length > offset)
     {
-      oNameLong += c;
-      unicodec = readData<unsigned short>(buffer, offset);
-      c = (char)unicodec;
+      mPath.resize(length);
+      char * output = &mPath[0];
+      for(unsigned long i=0; i<mCount; i++)
+      {
+        const PATH_COMPONENT & component = mComponents[i];
+        if (component.unicode)
+        {
+          if (offset == 0)
+          {
+            output[offset++] = '.';
+            output[offset++] = '\\';
+          }
+          else if (output[offset - 1] != '\\')
+            output[offset++] = '\\';
+          narrowUnicodeString(component.value, component.length, output + offset);
+        }
+        else
+          memcpy(output + offset, component.value, component.length);
+        offset += component.length;
+      }
+      assert(offset == length);
     }
+    mCount = 0;
   }
 
-  oValue.unknown19 = readData<unsigned char>(buffer, offset);
-  oValue.unknown20 = readData<unsigned char>(buffer, offset);
-  
-  bool success = (offset == iBuffer.getSize());
-  assert( success == true );
-  return success;
+private:
+  void add(const unsigned char * iValue, unsigned long iLength, bool iUnicode)
+  {
+    PATH_COMPONENT & component = mComponents[mCount++];
+    component.value = iValue;
+    component.length = iLength;
+    component.unicode = iUnicode;
+  }
+
+  static const unsigned long MAX_COMPONENTS = 64;
+  std::string & mPath;
+  PATH_COMPONENT mComponents[MAX_COMPONENTS];
+  unsigned long mCount;
+};
+
+template <class Policy>
+bool deserialize(const unsigned char * iItemID, const uint16_t & iSize, const ParseLimits & iLimits, LNK_ITEMID & oValue, const unsigned char *& oNameLong, unsigned long & oNameLongLength, LNK_PARSE_ERROR & oError)
+{
+  BasicByteCursor<Policy> cursor(iItemID, iSize);
+
+  cursor.read(oValue.size);
+  cursor.read(oValue.type);
+  cursor.read(oValue.unknown1);
+  cursor.read(oValue.unknown2);
+  cursor.read(oValue.fileAttributes);
+
+  //name83
+  const char * name83 = "";
+  unsigned long name83Length = 0;
+  oValue.name83 = NULL;
+  cursor.readString(iLimits.maxStringLength, name83, name83Length);
+
+  //search for location of nameUnicode
+  //nameUnicode is located at the end of the ItemID
+  //following a NULL unicode character.
+  //The search never goes before the end of name83.
+  static const unsigned long UNICODE_SEARCH_START = 3*sizeof(uint16_t); //last uint16_t, NULL terminating character and last string character
+  if (Policy::CHECKED && (!cursor.good() || iSize < cursor.getOffset() + UNICODE_SEARCH_START))
+    return reject(LNK_PARSE_ERROR_INVALID_STRUCTURE, oError);
+  unsigned long nameUnicodeOffset = iSize - UNICODE_SEARCH_START;
+  while(readUInt16(iItemID, nameUnicodeOffset) != 0x0000)
+  {
+    if (Policy::CHECKED && nameUnicodeOffset < cursor.getOffset() + sizeof(uint16_t))
+      return reject(LNK_PARSE_ERROR_INVALID_STRUCTURE, oError);
+    nameUnicodeOffset -= sizeof(uint16_t); //rewind until the beginning of the string
+  }
+  nameUnicodeOffset += sizeof(uint16_t); //move to first string character
+  cursor.seek(nameUnicodeOffset);
+
+  //nameUnicode, read in place
+  oValue.nameUnicode = NULL;
+  cursor.readUnicodeString(iLimits.maxStringLength, oNameLong, oNameLongLength);
+
+  cursor.read(oValue.unknown19);
+  cursor.read(oValue.unknown20);
+
+  if (cursor.getError() == LNK_PARSE_ERROR_TRUNCATED)
+    return reject(LNK_PARSE_ERROR_INVALID_STRUCTURE, oError); //the ItemID content is larger than its size
+  if (!cursor.good())
+    return reject(cursor.getError(), oError);
+  if (Policy::CHECKED && cursor.getOffset() != iSize)
+    return reject(LNK_PARSE_ERROR_INVALID_STRUCTURE, oError);
+  return true;
 }
 
 
@@ -357,24 +324,41 @@ const char * getVersionString()
   return PRODUCT_VERSION;
 }
 
-bool isLink(const unsigned char * iBuffer, const unsigned long & iSize);
+const char * getParseErrorDescription(const LNK_PARSE_ERROR & iError)
+{
+  switch(iError)
+  {
+  case LNK_PARSE_OK:                        return "success";
+  case LNK_PARSE_ERROR_IO:                  return "unable to read file";
+  case LNK_PARSE_ERROR_SIGNATURE:           return "invalid link signature";
+  case LNK_PARSE_ERROR_TRUNCATED:           return "truncated file";
+  case LNK_PARSE_ERROR_INVALID_STRUCTURE:   return "invalid structure size or offset";
+  case LNK_PARSE_ERROR_FILE_TOO_LARGE:      return "file size limit exceeded";
+  case LNK_PARSE_ERROR_TOO_MANY_ITEMIDS:    return "ItemID limit exceeded";
+  case LNK_PARSE_ERROR_STRING_TOO_LONG:     return "string length limit exceeded";
+  case LNK_PARSE_ERROR_TOO_MANY_EXTRADATA:  return "ExtraData block limit exceeded";
+  default:                                  return "unknown error";
+  };
+}
 
 bool isLink(const MemoryBuffer & iFileContent)
 {
   return isLink(iFileContent.getBuffer(), iFileContent.getSize());
 }
 
-bool isLink(const unsigned char * iBuffer, const unsigned long & iSize)
+inline bool hasLinkSignature(const unsigned char * iBuffer, const unsigned long & iSize)
 {
   if (iSize > sizeof(ShellLinkHeader))
   {
-    unsigned long offset = 0;
-    const ShellLinkHeader & header = readData<const ShellLinkHeader>(iBuffer, offset);
+    ByteCursor cursor(iBuffer, iSize);
 
-    if (header.HeaderSize != sizeof(ShellLinkHeader))
+    uint32_t headerSize = 0;
+    cursor.read(headerSize);
+    if (headerSize != sizeof(ShellLinkHeader))
       return false;
 
-    bool guidSuccess = (memcmp(header.LinkCLSID, DEFAULT_LINKCLSID, sizeof(LNK_CLSID)) == 0);
+    const unsigned char * linkCLSID = cursor.readBytes(sizeof(LNK_CLSID));
+    bool guidSuccess = (memcmp(linkCLSID, DEFAULT_LINKCLSID, sizeof(LNK_CLSID)) == 0);
     if (!guidSuccess)
       return false;
 
@@ -383,6 +367,12 @@ bool isLink(const unsigned char * iBuffer, const unsigned long & iSize)
   return false;
 }
 
+bool isLink(const unsigned char * iBuffer, const unsigned long & iSize)
+{
+  LNK_STATS_ADD(filesProbed, 1);
+  return hasLinkSignature(iBuffer, iSize);
+}
+
 bool isLink(const char * iFilePath)
 {
   MemoryBuffer fileContent;
@@ -399,222 +389,700 @@ bool isLink(const char * iFilePath)
   return false;
 }
 
-bool getLinkInfo(const char * iFilePath, LinkInfo & oLinkInfo)
+bool loadLinkFile(const char * iFilePath, const ParseLimits & iLimits, MemoryBuffer & oFileContent, LNK_PARSE_ERROR & oError, StageTimer * ioTimer)
 {
-  MemoryBuffer fileContent;
-  bool loadSuccess = fileContent.loadFile(iFilePath);
-  if (loadSuccess)
+  LNK_TRACE_SCOPE("loadLinkFile");
+  LNK_TRACE_STAGES();
+
+  if (iFilePath == NULL || iFilePath[0] == '\0')
+    return reject(LNK_PARSE_ERROR_IO, oError);
+
+  LNK_STAGE_ENTER(ioTimer, LNK_STAGE_OPEN);
+  FILE * f = fopen(iFilePath, "rb");
+  if (!f)
+    return reject(LNK_PARSE_ERROR_IO, oError);
+
+  //check the size before allocating
+  LNK_STAGE_ENTER(ioTimer, LNK_STAGE_READ);
+  uint32_t size = filesystem::getFileSize(f);
+  if (size > iLimits.maxFileSize)
   {
+    fclose(f);
+    return reject(LNK_PARSE_ERROR_FILE_TOO_LARGE, oError);
+  }
+
+  bool success = oFileContent.allocate(size) && (fread(oFileContent.getBuffer(), 1, size, f) == size);
+  fclose(f);
+  if (!success)
+    return reject(LNK_PARSE_ERROR_IO, oError);
+  LNK_STATS_ADD(bytesRead, size);
+  return true;
+}
+
+inline void countExtraDataBlock(uint32_t iSignature)
+{
+#ifdef LNK_STATS_ENABLED
+  uint32_t signatureIndex = getExtraDataIndex(iSignature);
+  if (signatureIndex < LNK_EXTRADATA_NUM_SIGNATURES)
+    LNK_STATS_ADD(extraDataBlocks[signatureIndex], 1);
+  else
+    LNK_STATS_ADD(unknownExtraDataBlocks, 1);
+#endif
+}
+
+///<summary>
+///Decodes a link file from memory.
+///All checks of the Untrusted policy are removed at compile time by the Trusted policy.
+///When oExtraDataOffset is not NULL, the decoding stops before the ExtraData blocks and their offset is returned.
+///</summary>
+template <class Policy>
+bool decodeLinkInfo(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfo & oLinkInfo, LinkInfoEx * oLinkInfoEx, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, StageTimer * ioTimer, unsigned long * oExtraDataOffset)
+{
+  typedef BasicByteCursor<Policy> Cursor;
+
+  LNK_TRACE_SCOPE("decodeLinkInfo");
+  LNK_TRACE_STAGES();
+  LNK_STAGE_ENTER(ioTimer, LNK_STAGE_HEADER);
+  oError = LNK_PARSE_OK;
+  LNK_STATS_ADD(filesParsed, 1);
+  LNK_STATS_ADD(bytesParsed, iSize);
+
+  if (Policy::CHECKED)
+  {
+    if (iSize > iLimits.maxFileSize)
+      return reject(LNK_PARSE_ERROR_FILE_TOO_LARGE, oError);
+
     //validate signature
-    bool link = isLink(fileContent);
-    if (link)
-    {
-      unsigned long offset = 0;
-      const unsigned char * content = fileContent.getBuffer();
-      
-      const ShellLinkHeader & header = readData<const ShellLinkHeader>(content, offset);
+    bool link = hasLinkSignature(iBuffer, iSize);
+    if (!link)
+      return reject(LNK_PARSE_ERROR_SIGNATURE, oError);
+  }
+
+  //reset the output but keep the capacity of its strings
+  if (oLinkInfoEx)
+    oLinkInfoEx->clear();
+  else
+    oLinkInfo.clear();
+
+  Cursor cursor(iBuffer, iSize);
 
-      oLinkInfo.customIcon.index = header.IconIndex;
-      oLinkInfo.hotKey = header.HotKey;
+  ShellLinkHeader header;
+  cursor.read(header);
 
-      if (header.linkFlags.HasLinkTargetIDList)
+  oLinkInfo.customIcon.index = header.IconIndex;
+  oLinkInfo.hotKey = header.HotKey;
+
+  if (oLinkInfoEx)
+  {
+    memcpy(&oLinkInfoEx->linkFlags, &header.linkFlags, sizeof(oLinkInfoEx->linkFlags));
+    memcpy(&oLinkInfoEx->fileAttributes, &header.FileAttributes, sizeof(oLinkInfoEx->fileAttributes));
+    oLinkInfoEx->creationTime = header.CreationTime;
+    oLinkInfoEx->accessTime = header.AccessTime;
+    oLinkInfoEx->writeTime = header.WriteTime;
+    oLinkInfoEx->fileSize = header.FileSize;
+    oLinkInfoEx->showCommand = header.ShowCommand;
+  }
+
+  LNK_STAGE_ENTER(ioTimer, LNK_STAGE_IDLIST);
+  if (header.linkFlags.HasLinkTargetIDList)
+  {
+    //Shell Item Id List 
+    //Note: This section exists only if the first bit for link flags is set the header section.
+    //      If that bit is not set then this section does not exists.
+    //      The first word contains the size of the list in bytes.
+    //      Each item (except the last) in the list contains its size in a word fallowed by the content.
+    //      The size includes and the space used to store it. The last item has the size 0.
+    //      These items are used to store various informations.
+    //      For more info read the SHITEMID documentation. 
+    uint16_t IDListSize = 0;
+    cursor.read(IDListSize);
+    Cursor IDList = cursor.sub(cursor.getOffset(), IDListSize);
+    cursor.skip(IDListSize);
+    if (!cursor.good())
+      return reject(cursor.getError(), oError);
+
+    TargetPathBuilder path(oLinkInfo.target);
+    unsigned long numItemIds = 0;
+    uint16_t ItemIDSize = 0xFFFF;
+    while (ItemIDSize != 0)
+    {
+      const unsigned char * ItemID = IDList.getCurrent();
+      if (!IDList.read(ItemIDSize))
+        return reject(LNK_PARSE_ERROR_INVALID_STRUCTURE, oError); //no TerminalID within IDListSize
+
+      bool isTerminalID = (ItemIDSize == 0);
+      if (!isTerminalID)
       {
-        //Shell Item Id List 
-        //Note: This section exists only if the first bit for link flags is set the header section.
-        //      If that bit is not set then this section does not exists.
-        //      The first word contains the size of the list in bytes.
-        //      Each item (except the last) in the list contains its size in a word fallowed by the content.
-        //      The size includes and the space used to store it. The last item has the size 0.
-        //      These items are used to store various informations.
-        //      For more info read the SHITEMID documentation. 
-        const uint16_t & IDListSize = readData<unsigned short>(content, offset);
-        uint16_t ItemIDSize = 0xFFFF;
-        while (ItemIDSize != 0)
+        //item is valid (last item has a size of 0)
+        numItemIds++;
+        if (Policy::CHECKED && numItemIds > iLimits.maxItemIds)
+          return reject(LNK_PARSE_ERROR_TOO_MANY_ITEMIDS, oError);
+
+        //move past itemId's content
+        static const uint16_t MIN_ITEMID_SIZE = sizeof(ItemIDSize) + sizeof(uint8_t); //size and type
+        if ((Policy::CHECKED && ItemIDSize < MIN_ITEMID_SIZE) || !IDList.skip(ItemIDSize - sizeof(ItemIDSize)))
+          return reject(LNK_PARSE_ERROR_INVALID_STRUCTURE, oError);
+
+        //check itemId's content
+        const uint8_t & type = ItemID[2];
+        LNK_STATS_ADD(itemIds[type], 1);
+        switch(type)
         {
-          ItemIDSize = readData<unsigned short>(content, offset);
-          bool isTerminalID = (ItemIDSize == 0);
-          if (!isTerminalID)
+        case 0x1f: //computer data. ignore
+          break;
+        case 0x2f: //drive data.
           {
-            //item is valid (last item has a size of 0)
-
-            //read itemId's content
-            MemoryBuffer ItemID;
-            serialize(ItemIDSize, ItemID);
-            while (ItemID.getSize() < ItemIDSize)
-            {
-              const unsigned char & c = readData<unsigned char>(content, offset);
-              serialize(c, ItemID);
-            }
-
-            //check itemId's content
-            const uint8_t & type = ItemID.getBuffer()[2];
-            switch(type)
-            {
-            case 0x1f: //computer data. ignore
-              break;
-            case 0x2f: //drive data.
-              oLinkInfo.target = (char*)&ItemID.getBuffer()[3];
-              break;
-            case 0x31: //folder data
-            case 0x32: //file data
-              {
-                std::string name83;
-                std::string nameLong;
-                LNK_ITEMID itemId = {0};
-                bool success = deserialize(ItemID, itemId, name83, nameLong);
-                assert( success == true );
-                
-                if (oLinkInfo.target.size() == 0)
-                {
-                  oLinkInfo.target += ".\\";
-                }
-                else
-                {
-                  //since we are adding a folder of file name,
-                  //make sure the path is ending with a separator
-                  const char & lastCharacter = oLinkInfo.target[oLinkInfo.target.size() - 1];
-                  if (lastCharacter != '\\')
-                    oLinkInfo.target += '\\';
-                }
-                oLinkInfo.target += nameLong;
-              }
-            };
+            Cursor drive(ItemID, ItemIDSize);
+            drive.skip(3);
+            const char * name = "";
+            unsigned long nameLength = 0;
+            if (!drive.readString(iLimits.maxStringLength, name, nameLength))
+              return reject(drive.getError() == LNK_PARSE_ERROR_TRUNCATED ? LNK_PARSE_ERROR_INVALID_STRUCTURE : drive.getError(), oError);
+            path.setDrive(name, nameLength);
           }
+          break;
+        case 0x31: //folder data
+        case 0x32: //file data
+          {
+            const unsigned char * nameLong = NULL;
+            unsigned long nameLongLength = 0;
+            LNK_ITEMID itemId = {0};
+            bool success = deserialize<Policy>(ItemID, ItemIDSize, iLimits, itemId, nameLong, nameLongLength, oError);
+            if (!success)
+              return false;
+            path.addName(nameLong, nameLongLength);
+          }
+        };
+      }
+    }
+
+    //the target is written once all names are known
+    path.flush();
+  }
+
+  LNK_STAGE_ENTER(ioTimer, LNK_STAGE_LINKINFO);
+  {
+    //File location info
+    unsigned long fileInfoOffset = cursor.getOffset();
+    LNK_FILE_LOCATION_INFO fileInfo = {0};
+    if (!cursor.read(fileInfo))
+      return reject(cursor.getError(), oError);
+    if (Policy::CHECKED && fileInfo.length > cursor.getSize() - fileInfoOffset)
+      return reject(LNK_PARSE_ERROR_TRUNCATED, oError);
+    if (Policy::CHECKED && fileInfo.endOffset > LNK_FILE_LOCATION_INFO_SIZE + fileInfo.length)
+      return reject(LNK_PARSE_ERROR_INVALID_STRUCTURE, oError);
+    cursor.seek(fileInfoOffset + LNK_FILE_LOCATION_INFO_SIZE + fileInfo.length - fileInfo.endOffset);
+    if (!cursor.good())
+      return reject(cursor.getError(), oError);
+
+    if (fileInfo.length > 0)
+    {
+      //all offsets are relative to the start of the section
+      Cursor section = cursor.sub(fileInfoOffset, fileInfo.length);
+
+      //strings are read in place, without copies
+      const char * basePath = "";
+      unsigned long basePathLength = 0;
+      if (fileInfo.basePathOffset && section.seek(fileInfo.basePathOffset))
+        section.readString(iLimits.maxStringLength, basePath, basePathLength);
+      const char * finalPath = "";
+      unsigned long finalPathLength = 0;
+      if (fileInfo.finalPathOffset && section.seek(fileInfo.finalPathOffset))
+        section.readString(iLimits.maxStringLength, finalPath, finalPathLength);
+
+      if (oLinkInfoEx)
+      {
+        oLinkInfoEx->basePath.assign(basePath, basePathLength);
+        oLinkInfoEx->finalPath.assign(finalPath, finalPathLength);
+      }
+
+      //concat paths
+      if (oLinkInfo.target.size() == 0)
+      {
+        //target was not resolved using LinkTargetIDList, resolve using base and final paths
+        if (basePathLength > 0)
+          oLinkInfo.target.assign(basePath, basePathLength);
+        if (finalPathLength > 0)
+        {
+          if (oLinkInfo.target.size() > 0)
+            oLinkInfo.target += '\\';
+          oLinkInfo.target.append(finalPath, finalPathLength);
         }
       }
 
+      if (fileInfo.localVolumeTableOffset > 0 && fileInfo.location == LNK_LOCATION_LOCAL)
       {
-        //File location info
-        const LNK_FILE_LOCATION_INFO & fileInfo = readData<LNK_FILE_LOCATION_INFO>(content, offset);
-        offset += (fileInfo.length - fileInfo.endOffset);
+        LNK_LOCAL_VOLUME_TABLE volumeTable = {0};
+        const char * volumeName = "";
+        unsigned long volumeNameLength = 0;
+        if (section.seek(fileInfo.localVolumeTableOffset) && section.read(volumeTable))
+        {
+          if (Policy::CHECKED && volumeTable.length < LNK_LOCAL_VOLUME_TABLE_SIZE)
+            return reject(LNK_PARSE_ERROR_INVALID_STRUCTURE, oError);
+          section.seek(fileInfo.localVolumeTableOffset + offsetof(LNK_LOCAL_VOLUME_TABLE, volumeLabel));
+          section.readString(iLimits.maxStringLength, volumeName, volumeNameLength);
+        }
 
-        const unsigned char * baseFileLocationAddress = (unsigned char*)(&fileInfo);
-        if (fileInfo.length > 0)
+        if (oLinkInfoEx)
         {
-          std::string basePath = "";
-          if (fileInfo.basePathOffset)
-            basePath = (const char *)&baseFileLocationAddress[fileInfo.basePathOffset];
-          std::string finalPath = "";
-          if (fileInfo.finalPathOffset)
-            finalPath = (const char *)&baseFileLocationAddress[fileInfo.finalPathOffset];
-
-          //concat paths
-          if (oLinkInfo.target.size() == 0)
+          oLinkInfoEx->hasVolume = true;
+          oLinkInfoEx->volume.driveType = volumeTable.volumeType;
+          oLinkInfoEx->volume.serialNumber = volumeTable.volumeSerialNumber;
+          oLinkInfoEx->volume.label.assign(volumeName, volumeNameLength);
+        }
+      }
+      if (fileInfo.networkVolumeTableOffset > 0 && fileInfo.location == LNK_LOCATION_NETWORK)
+      {
+        LNK_NETWORK_VOLUME_TABLE volumeTable = {0};
+        const char * volumeName = "";
+        unsigned long volumeNameLength = 0;
+        const char * deviceName = "";
+        unsigned long deviceNameLength = 0;
+        if (section.seek(fileInfo.networkVolumeTableOffset) && section.read(volumeTable))
+        {
+          if (Policy::CHECKED && volumeTable.length < LNK_NETWORK_VOLUME_TABLE_SIZE)
+            return reject(LNK_PARSE_ERROR_INVALID_STRUCTURE, oError);
+          section.seek(fileInfo.networkVolumeTableOffset + offsetof(LNK_NETWORK_VOLUME_TABLE, networkShareName));
+          section.readString(iLimits.maxStringLength, volumeName, volumeNameLength);
+          if ((volumeTable.flags & LNK_NETWORK_VALID_DEVICE) && volumeTable.deviceNameOffset > 0)
           {
-            //target was not resolved using LinkTargetIDList, resolve using base and final paths
-            if (basePath.size() > 0)
-              oLinkInfo.target = basePath;
-            if (finalPath.size() > 0)
-            {
-              if (oLinkInfo.target.size() == 0)
-                oLinkInfo.target = finalPath;
-              else
-              {
-                oLinkInfo.target += '\\';
-                oLinkInfo.target += finalPath;
-              }
-            }
+            section.seek(fileInfo.networkVolumeTableOffset + volumeTable.deviceNameOffset);
+            section.readString(iLimits.maxStringLength, deviceName, deviceNameLength);
           }
+        }
 
-          if (fileInfo.localVolumeTableOffset > 0 && fileInfo.location == LNK_LOCATION_LOCAL)
-          {
-            unsigned long tmpOffset = fileInfo.localVolumeTableOffset;
-            const LNK_LOCAL_VOLUME_TABLE & volumeTable = readData<LNK_LOCAL_VOLUME_TABLE>(baseFileLocationAddress, tmpOffset);
-            const char * volumeName = &volumeTable.volumeLabel;
-            assert( volumeTable.length >= LNK_LOCAL_VOLUME_TABLE_SIZE );
-          }
-          if (fileInfo.networkVolumeTableOffset > 0 && fileInfo.location == LNK_LOCATION_NETWORK)
-          {
-            unsigned long tmpOffset = fileInfo.networkVolumeTableOffset;
-            const LNK_NETWORK_VOLUME_TABLE & volumeTable = readData<LNK_NETWORK_VOLUME_TABLE>(baseFileLocationAddress, tmpOffset);
-            const char * volumeName = &volumeTable.networkShareName;
-            assert( volumeTable.length >= LNK_NETWORK_VOLUME_TABLE_SIZE );
-
-            //build network path
-            oLinkInfo.networkPath = volumeName;
-            oLinkInfo.networkPath += '\\';
-            oLinkInfo.networkPath += finalPath;
-          }
+        //build network path
+        oLinkInfo.networkPath.assign(volumeName, volumeNameLength);
+        oLinkInfo.networkPath += '\\';
+        oLinkInfo.networkPath.append(finalPath, finalPathLength);
+
+        if (oLinkInfoEx)
+        {
+          oLinkInfoEx->hasNetworkShare = true;
+          oLinkInfoEx->networkShare.flags = volumeTable.flags;
+          oLinkInfoEx->networkShare.providerType = ((volumeTable.flags & LNK_NETWORK_VALID_NET_TYPE) ? volumeTable.networkProviderType : 0);
+          oLinkInfoEx->networkShare.shareName.assign(volumeName, volumeNameLength);
+          oLinkInfoEx->networkShare.deviceName.assign(deviceName, deviceNameLength);
         }
       }
-      
-      //Description
-      //This section is present if bit 2 is set in the flags value in the header.
-      //The first word value indicates the length of the string.
-      //Following the length value is a string of ASCII characters.
-      //It is a description of the item.
-      if (header.linkFlags.HasName)
-        readString(content, offset, oLinkInfo.description);
-      
-      //Relative path string
-      //This section is present if bit 3 is set in the flags value in the header.
-      //The first word value indicates the length of the string.
-      //Following the length value is a string of ASCII characters.
-      //It is a relative path to the target.
-      std::string relativePath;
-      if (header.linkFlags.HasRelativePath)
-        readString(content, offset, relativePath);
-
-      //Working directory
-      //This section is present if bit 4 is set in the flags value in the header.
-      //The first word value indicates the length of the string.
-      //Following the length value is a string of ASCII characters.
-      //It is the working directory as specified in the link properties.
-      if (header.linkFlags.HasWorkingDir)
-        readString(content, offset, oLinkInfo.workingDirectory);
-
-      //Command line arguments
-      //This section is present if bit 5 is set in the flags value in the header.
-      //The first word value indicates the length of the string.
-      //Following the length value is a string of ASCII characters.
-      //The command line string includes everything except the program name.
-      if (header.linkFlags.HasArguments)
-        readString(content, offset, oLinkInfo.arguments);
-
-      //Icon filename
-      //This section is present if bit 6 is set in the flags value in the header.
-      //The first word value indicates the length of the string.
-      //Following the length value is a string of ASCII characters.
-      //This the name of the file containing the icon.
-      if (header.linkFlags.HasIconLocation)
-        readString(content, offset, oLinkInfo.customIcon.filename);
-
-      //Additonal Info Usualy consists of a dword with the value 0.
-      const unsigned long & additionnalInfo = readData<unsigned long>(content, offset);
 
-      return true;
+      //an offset pointing outside of the section
+      if (section.getError() == LNK_PARSE_ERROR_TRUNCATED)
+        return reject(LNK_PARSE_ERROR_INVALID_STRUCTURE, oError);
+      if (!section.good())
+        return reject(section.getError(), oError);
     }
   }
+  
+  LNK_STAGE_ENTER(ioTimer, LNK_STAGE_STRINGS);
+
+  //Description
+  //This section is present if bit 2 is set in the flags value in the header.
+  //The first word value indicates the length of the string.
+  //Following the length value is a string of ASCII characters.
+  //It is a description of the item.
+  if (header.linkFlags.HasName)
+    readString(cursor, iLimits, oLinkInfo.description);
+  
+  //Relative path string
+  //This section is present if bit 3 is set in the flags value in the header.
+  //The first word value indicates the length of the string.
+  //Following the length value is a string of ASCII characters.
+  //It is a relative path to the target.
+  if (header.linkFlags.HasRelativePath)
+  {
+    if (oLinkInfoEx)
+      readString(cursor, iLimits, oLinkInfoEx->relativePath);
+    else
+      skipString(cursor, iLimits);
+  }
+
+  //Working directory
+  //This section is present if bit 4 is set in the flags value in the header.
+  //The first word value indicates the length of the string.
+  //Following the length value is a string of ASCII characters.
+  //It is the working directory as specified in the link properties.
+  if (header.linkFlags.HasWorkingDir)
+    readString(cursor, iLimits, oLinkInfo.workingDirectory);
+
+  //Command line arguments
+  //This section is present if bit 5 is set in the flags value in the header.
+  //The first word value indicates the length of the string.
+  //Following the length value is a string of ASCII characters.
+  //The command line string includes everything except the program name.
+  if (header.linkFlags.HasArguments)
+    readString(cursor, iLimits, oLinkInfo.arguments);
+
+  //Icon filename
+  //This section is present if bit 6 is set in the flags value in the header.
+  //The first word value indicates the length of the string.
+  //Following the length value is a string of ASCII characters.
+  //This the name of the file containing the icon.
+  if (header.linkFlags.HasIconLocation)
+    readString(cursor, iLimits, oLinkInfo.customIcon.filename);
+
+  if (!cursor.good())
+    return reject(cursor.getError(), oError);
+
+  //a stream skips the ExtraData blocks itself, without keeping them in memory
+  if (oExtraDataOffset)
+  {
+    *oExtraDataOffset = cursor.getOffset();
+    return true;
+  }
+
+  LNK_STAGE_ENTER(ioTimer, LNK_STAGE_EXTRADATA);
+
+  //Additonal Info (ExtraData)
+  //A list of blocks which ends with a block smaller than 4 bytes.
+  //Usualy consists of a dword with the value 0.
+  //Only the size and the signature of the blocks are decoded.
+  unsigned long numExtraDataBlocks = 0;
+  while (cursor.getRemaining() >= sizeof(uint32_t))
+  {
+    uint32_t blockSize = 0;
+    cursor.read(blockSize);
+    if (blockSize < sizeof(blockSize))
+      break; //TerminalBlock
+
+    numExtraDataBlocks++;
+    if (Policy::CHECKED && numExtraDataBlocks > iLimits.maxExtraDataBlocks)
+      return reject(LNK_PARSE_ERROR_TOO_MANY_EXTRADATA, oError);
+
+    uint32_t blockSignature = 0;
+    static const uint32_t MIN_EXTRADATA_BLOCK_SIZE = sizeof(blockSize) + sizeof(blockSignature);
+    if (Policy::CHECKED && blockSize < MIN_EXTRADATA_BLOCK_SIZE)
+      return reject(LNK_PARSE_ERROR_INVALID_STRUCTURE, oError);
+    if (!cursor.read(blockSignature) || !cursor.skip(blockSize - MIN_EXTRADATA_BLOCK_SIZE))
+      return reject(cursor.getError(), oError);
+
+    countExtraDataBlock(blockSignature);
+  }
+
+  return true;
+}
+
+template <class Policy>
+bool getLinkInfo(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfo & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError)
+{
+  return decodeLinkInfo<Policy>(iBuffer, iSize, oLinkInfo, NULL, iLimits, oError, NULL, NULL);
+}
+
+template <class Policy>
+bool getLinkInfo(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError)
+{
+  return decodeLinkInfo<Policy>(iBuffer, iSize, oLinkInfo, &oLinkInfo, iLimits, oError, NULL, NULL);
+}
+
+template bool getLinkInfo<Untrusted>(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfo & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError);
+template bool getLinkInfo<Untrusted>(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError);
+template bool getLinkInfo<Trusted>(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfo & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError);
+template bool getLinkInfo<Trusted>(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError);
+
+bool getLinkInfo(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfo & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError)
+{
+  return decodeLinkInfo<Untrusted>(iBuffer, iSize, oLinkInfo, NULL, iLimits, oError, NULL, NULL);
+}
+
+bool getLinkInfo(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError)
+{
+  return decodeLinkInfo<Untrusted>(iBuffer, iSize, oLinkInfo, &oLinkInfo, iLimits, oError, NULL, NULL);
+}
+
+bool getLinkInfo(const char * iFilePath, LinkInfo & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError)
+{
+  MemoryBuffer fileContent;
+  bool loadSuccess = loadLinkFile(iFilePath, iLimits, fileContent, oError, NULL);
+  if (loadSuccess)
+  {
+    return decodeLinkInfo<Untrusted>(fileContent.getBuffer(), fileContent.getSize(), oLinkInfo, NULL, iLimits, oError, NULL, NULL);
+  }
+  oLinkInfo.clear();
   return false;
 }
 
-MemoryBuffer createLinkTargetIDList(const char * iFilePath, const LinkInfo & iLinkInfo)
+bool getLinkInfo(const char * iFilePath, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError)
 {
-  MemoryBuffer LinkTargetIDList;
+  MemoryBuffer fileContent;
+  bool loadSuccess = loadLinkFile(iFilePath, iLimits, fileContent, oError, NULL);
+  if (loadSuccess)
+  {
+    return decodeLinkInfo<Untrusted>(fileContent.getBuffer(), fileContent.getSize(), oLinkInfo, &oLinkInfo, iLimits, oError, NULL, NULL);
+  }
+  oLinkInfo.clear();
+  return false;
+}
 
-  //convert the long path name to short path name
-  std::string shortPath = filesystem::getShortPathForm(iLinkInfo.target.c_str());
-  if (shortPath.empty())
-    return LinkTargetIDList;
+bool getLinkInfo(const char * iFilePath, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, StageTimer & ioTimer, MemoryBuffer & ioFileContent)
+{
+  bool loadSuccess = loadLinkFile(iFilePath, iLimits, ioFileContent, oError, &ioTimer);
+  if (loadSuccess)
+  {
+    return decodeLinkInfo<Untrusted>(ioFileContent.getBuffer(), ioFileContent.getSize(), oLinkInfo, &oLinkInfo, iLimits, oError, &ioTimer, NULL);
+  }
+  oLinkInfo.clear();
+  return false;
+}
+
+bool getLinkInfo(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, StageTimer & ioTimer)
+{
+  return decodeLinkInfo<Untrusted>(iBuffer, iSize, oLinkInfo, &oLinkInfo, iLimits, oError, &ioTimer, NULL);
+}
+
+bool getLinkInfo(const char * iFilePath, LinkInfo & oLinkInfo)
+{
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  return getLinkInfo(iFilePath, oLinkInfo, LNK_DEFAULT_PARSE_LIMITS, error);
+}
+
+bool getLinkInfo(const char * iFilePath, LinkInfoEx & oLinkInfo)
+{
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  return getLinkInfo(iFilePath, oLinkInfo, LNK_DEFAULT_PARSE_LIMITS, error);
+}
+
+//A link read from a Reader.
+//The sections decoded by decodeLinkInfo() are kept in a window. The ExtraData blocks are skipped.
+struct LNK_STREAM
+{
+  Reader * reader;
+  MemoryBuffer * window;  //bytes of the stream from windowOffset
+  uint64_t windowOffset;  //offset in the stream of the first byte of the window
+  uint64_t maxSize;       //ParseLimits::maxFileSize
+};
+static const unsigned long LNK_STREAM_WINDOW_SIZE = 512; //holds the sections of most links
+
+inline uint64_t getStreamEnd(const LNK_STREAM & iStream)
+{
+  return iStream.windowOffset + iStream.window->getSize();
+}
+
+//Reads the stream into the window up to the offset iEnd, or up to the end of the stream.
+//Fails if the stream is larger than ParseLimits::maxFileSize.
+bool fillStream(LNK_STREAM & ioStream, uint64_t iEnd, LNK_PARSE_ERROR & oError)
+{
+  const uint64_t end = (iEnd < ioStream.maxSize + 1 ? iEnd : ioStream.maxSize + 1);
+  const uint64_t streamEnd = getStreamEnd(ioStream);
+  if (end <= streamEnd)
+    return true;
+
+  //grow the window by half of its size at least to limit the copies
+  MemoryBuffer & window = *ioStream.window;
+  const unsigned long oldSize = window.getSize();
+  const unsigned long size = (unsigned long)(end - streamEnd);
+  unsigned long capacity = oldSize + (size > oldSize/2 ? size : oldSize/2);
+  if (capacity < LNK_STREAM_WINDOW_SIZE)
+    capacity = LNK_STREAM_WINDOW_SIZE;
+  unsigned long read = 0;
+  if (!window.reallocate(capacity) || !ioStream.reader->read(window.getBuffer() + oldSize, size, read))
+    return reject(LNK_PARSE_ERROR_IO, oError);
+  window.reallocate(oldSize + read); //keeps the memory
+  LNK_STATS_ADD(bytesRead, read);
+
+  if (getStreamEnd(ioStream) > ioStream.maxSize)
+    return reject(LNK_PARSE_ERROR_FILE_TOO_LARGE, oError);
+  return true;
+}
+
+//Drops the bytes of the stream before the offset iOffset, or up to the end of the stream.
+//Fails if the stream is larger than ParseLimits::maxFileSize.
+bool skipStream(LNK_STREAM & ioStream, uint64_t iOffset, LNK_PARSE_ERROR & oError)
+{
+  const uint64_t offset = (iOffset < ioStream.maxSize + 1 ? iOffset : ioStream.maxSize + 1);
+  const uint64_t streamEnd = getStreamEnd(ioStream);
+  MemoryBuffer & window = *ioStream.window;
+  if (offset < streamEnd)
+  {
+    //keep the end of the window
+    const unsigned long size = (unsigned long)(streamEnd - offset);
+    memmove(window.getBuffer(), window.getBuffer() + window.getSize() - size, size);
+    window.reallocate(size);
+    ioStream.windowOffset = offset;
+    return true;
+  }
+
+  unsigned long skipped = 0;
+  if (offset > streamEnd && !ioStream.reader->skip((unsigned long)(offset - streamEnd), skipped))
+    return reject(LNK_PARSE_ERROR_IO, oError);
+  LNK_STATS_ADD(bytesRead, skipped);
+  if (window.getSize() > 0)
+    window.reallocate(0);
+  ioStream.windowOffset = streamEnd + skipped;
+
+  if (getStreamEnd(ioStream) > ioStream.maxSize)
+    return reject(LNK_PARSE_ERROR_FILE_TOO_LARGE, oError);
+  return true;
+}
+
+//Reads all sections decoded by decodeLinkInfo() into the window: header, LinkTargetIDList, LinkInfo and strings.
+//The sizes of the sections are read the same way decodeLinkInfo() does. When the stream ends early, the window
+//is left incomplete for decodeLinkInfo() to reject it.
+bool fillLinkSections(LNK_STREAM & ioStream, LNK_PARSE_ERROR & oError)
+{
+  //header. hasLinkSignature() requires a byte after it.
+  if (!fillStream(ioStream, sizeof(ShellLinkHeader) + 1, oError))
+    return false;
+  const MemoryBuffer & window = *ioStream.window;
+  if (!hasLinkSignature(window.getBuffer(), window.getSize()))
+    return true;
+  ShellLinkHeader header;
+  memcpy(&header, window.getBuffer(), sizeof(header));
+  uint64_t offset = sizeof(ShellLinkHeader);
+
+  if (header.linkFlags.HasLinkTargetIDList)
+  {
+    if (!fillStream(ioStream, offset + sizeof(uint16_t), oError))
+      return false;
+    if (getStreamEnd(ioStream) < offset + sizeof(uint16_t))
+      return true;
+    offset += sizeof(uint16_t) + readUInt16(window.getBuffer(), (unsigned long)offset);
+  }
+
+  //LinkInfo
+  if (!fillStream(ioStream, offset + LNK_FILE_LOCATION_INFO_SIZE, oError))
+    return false;
+  if (getStreamEnd(ioStream) < offset + LNK_FILE_LOCATION_INFO_SIZE)
+    return true;
+  LNK_FILE_LOCATION_INFO fileInfo;
+  memcpy(&fileInfo, window.getBuffer() + offset, sizeof(fileInfo));
+  if (!fillStream(ioStream, offset + fileInfo.length, oError))
+    return false;
+  if (getStreamEnd(ioStream) < offset + fileInfo.length || fileInfo.endOffset > LNK_FILE_LOCATION_INFO_SIZE + fileInfo.length)
+    return true;
+  offset += LNK_FILE_LOCATION_INFO_SIZE + fileInfo.length - fileInfo.endOffset;
+
+  //strings
+  const bool strings[] = {
+    header.linkFlags.HasName != 0,
+    header.linkFlags.HasRelativePath != 0,
+    header.linkFlags.HasWorkingDir != 0,
+    header.linkFlags.HasArguments != 0,
+    header.linkFlags.HasIconLocation != 0,
+  };
+  for(size_t i=0; i<sizeof(strings)/sizeof(strings[0]); i++)
+  {
+    if (!strings[i])
+      continue;
+    if (!fillStream(ioStream, offset + sizeof(uint16_t), oError))
+      return false;
+    if (getStreamEnd(ioStream) < offset + sizeof(uint16_t))
+      return true;
+    offset += sizeof(uint16_t) + readUInt16(window.getBuffer(), (unsigned long)offset)*sizeof(uint16_t);
+  }
+  return fillStream(ioStream, offset, oError);
+}
+
+//Skips the ExtraData blocks of a stream. Only the size and the signature of each block are read.
+bool skipExtraData(LNK_STREAM & ioStream, uint64_t iOffset, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError)
+{
+  uint64_t offset = iOffset;
+  unsigned long numExtraDataBlocks = 0;
+  static const unsigned long MIN_EXTRADATA_BLOCK_SIZE = 2*sizeof(uint32_t); //size and signature
+  while(true)
+  {
+    if (!skipStream(ioStream, offset, oError) || !fillStream(ioStream, offset + sizeof(uint32_t), oError))
+      return false;
+    if (getStreamEnd(ioStream) < offset + sizeof(uint32_t))
+      return true; //end of the stream
+
+    uint32_t blockSize = 0;
+    memcpy(&blockSize, ioStream.window->getBuffer(), sizeof(blockSize));
+    if (blockSize < sizeof(blockSize))
+      return true; //TerminalBlock
+
+    numExtraDataBlocks++;
+    if (numExtraDataBlocks > iLimits.maxExtraDataBlocks)
+      return reject(LNK_PARSE_ERROR_TOO_MANY_EXTRADATA, oError);
+    if (blockSize < MIN_EXTRADATA_BLOCK_SIZE)
+      return reject(LNK_PARSE_ERROR_INVALID_STRUCTURE, oError);
+    if (!fillStream(ioStream, offset + MIN_EXTRADATA_BLOCK_SIZE, oError))
+      return false;
+    if (getStreamEnd(ioStream) < offset + MIN_EXTRADATA_BLOCK_SIZE)
+      return reject(LNK_PARSE_ERROR_TRUNCATED, oError);
+
+    uint32_t blockSignature = 0;
+    memcpy(&blockSignature, ioStream.window->getBuffer() + sizeof(blockSize), sizeof(blockSignature));
+    countExtraDataBlock(blockSignature);
+
+    offset += blockSize;
+    if (!skipStream(ioStream, offset, oError))
+      return false;
+    if (getStreamEnd(ioStream) < offset)
+      return reject(LNK_PARSE_ERROR_TRUNCATED, oError);
+  }
+}
+
+bool readLinkInfo(Reader & ioReader, LinkInfo & oLinkInfo, LinkInfoEx * oLinkInfoEx, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, StageTimer * ioTimer, MemoryBuffer & ioWindow)
+{
+  LNK_TRACE_SCOPE("readLinkInfo");
+
+  if (ioWindow.getSize() > 0)
+    ioWindow.reallocate(0);
+  LNK_STREAM stream = {&ioReader, &ioWindow, 0, iLimits.maxFileSize};
+  {
+    LNK_TRACE_STAGES();
+    LNK_STAGE_ENTER(ioTimer, LNK_STAGE_READ);
+    if (!fillLinkSections(stream, oError))
+    {
+      oLinkInfo.clear();
+      return false;
+    }
+  }
+
+  unsigned long extraDataOffset = 0;
+  if (!decodeLinkInfo<Untrusted>(ioWindow.getBuffer(), ioWindow.getSize(), oLinkInfo, oLinkInfoEx, iLimits, oError, ioTimer, &extraDataOffset))
+    return false;
+
+  LNK_TRACE_STAGES();
+  LNK_STAGE_ENTER(ioTimer, LNK_STAGE_EXTRADATA);
+  return skipExtraData(stream, extraDataOffset, iLimits, oError);
+}
+
+bool getLinkInfo(Reader & ioReader, LinkInfo & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError)
+{
+  MemoryBuffer window;
+  return readLinkInfo(ioReader, oLinkInfo, NULL, iLimits, oError, NULL, window);
+}
+
+bool getLinkInfo(Reader & ioReader, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError)
+{
+  MemoryBuffer window;
+  return readLinkInfo(ioReader, oLinkInfo, &oLinkInfo, iLimits, oError, NULL, window);
+}
+
+bool getLinkInfo(Reader & ioReader, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, MemoryBuffer & ioWindow)
+{
+  return readLinkInfo(ioReader, oLinkInfo, &oLinkInfo, iLimits, oError, NULL, ioWindow);
+}
+
+bool getLinkInfo(Reader & ioReader, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, StageTimer & ioTimer, MemoryBuffer & ioWindow)
+{
+  return readLinkInfo(ioReader, oLinkInfo, &oLinkInfo, iLimits, oError, &ioTimer, ioWindow);
+}
+
+//Adds the ItemIDs of the target to a LinkTargetIDList.
+//Returns false if the target can not be described by a LinkTargetIDList.
+bool buildLinkTargetIDList(const LinkInfo & iLinkInfo, const std::string & iShortPath, ItemIDListBuilder & ioBuilder)
+{
+  //the short path name must start with a drive letter
+  const std::string & shortPath = iShortPath;
+  if (shortPath.size() < 2 || shortPath[1] != ':')
+    return false;
 
   char driveLetter = shortPath[0];
   driveLetter = toupper(driveLetter);
-  
-  ItemIDList itemIDList;
-  itemIDList.push_back( getComputerItemId() );
-  itemIDList.push_back( getDriveItemId(driveLetter) );
 
   //split path
-  StringList shortPathParts;
-  filesystem::splitPath(shortPath.c_str(), shortPathParts);
-  if (shortPathParts.size() <= 2)
-    return LinkTargetIDList; //short path needs at least a drive/folder/filename structure
-  StringList longPathParts;
-  filesystem::splitPath(iLinkInfo.target.c_str(), longPathParts);
-  if (longPathParts.size() <= 2)
-    return LinkTargetIDList; //short path needs at least a drive/folder/filename structure
-  if (shortPathParts.size() != longPathParts.size())
-    return LinkTargetIDList; //both long and short paths needs to be the same size
+  filesystem::PathTokenizer shortPathParts(shortPath);
+  size_t numFileSystemObjects = shortPathParts.count();
+  if (numFileSystemObjects <= 2)
+    return false; //short path needs at least a drive/folder/filename structure
+  filesystem::PathTokenizer longPathParts(iLinkInfo.target);
+  size_t numLongPathParts = longPathParts.count();
+  if (numLongPathParts <= 2)
+    return false; //short path needs at least a drive/folder/filename structure
+  if (numFileSystemObjects != numLongPathParts)
+    return false; //both long and short paths needs to be the same size
 
   //shortPathParts[0]	C:
   //shortPathParts[1]	PROGRA~1
@@ -626,42 +1094,84 @@ MemoryBuffer createLinkTargetIDList(const char * iFilePath, const LinkInfo & iLi
   //longPathParts[2]	7-Zip
   //longPathParts[3]	History.txt
 
-  //setup folder/filename data
-  size_t numFileSystemObjects = shortPathParts.size();
+  ioBuilder.addComputerItemId();
+  ioBuilder.addDriveItemId(driveLetter);
+
+  //skip the drive
+  filesystem::PathElement shortPart;
+  filesystem::PathElement longPart;
+  shortPathParts.next(shortPart);
+  longPathParts.next(longPart);
+
+  //folder/filename ItemIDs are written from the path elements
   for(size_t i=1; i<numFileSystemObjects; i++)
   {
-    std::string & shortItem = shortPathParts[i];
-    std::string &  longItem =  longPathParts[i];
+    shortPathParts.next(shortPart);
+    longPathParts.next(longPart);
     FILE_ATTRIBUTES attr = ( (i+1<numFileSystemObjects) ? FA_DIRECTORY : FA_NORMAL );
-
-    MemoryBuffer ItemID = getFileItemId(shortItem, longItem, attr);
-    itemIDList.push_back( ItemID );
+    ioBuilder.addFileItemId(shortPart.value, shortPart.length, longPart.value, longPart.length, attr);
   }
 
-  //add TerminalID
-  itemIDList.push_back( getTerminalItemId() );
-
-  LinkTargetIDList = getLinkTargetIDList(itemIDList);
+  return true;
+}
 
-  return LinkTargetIDList;
+//Splits a UNC path (ie \\server\share\folder\file.txt) in a share name (\\server\share) and a final path (folder\file.txt)
+bool splitNetworkPath(const std::string & iNetworkPath, std::string & oShareName, std::string & oFinalPath)
+{
+  if (iNetworkPath.size() < 3 || iNetworkPath[0] != '\\' || iNetworkPath[1] != '\\')
+    return false;
+  size_t serverEnd = iNetworkPath.find('\\', 2);
+  if (serverEnd == std::string::npos || serverEnd == 2 || serverEnd + 1 == iNetworkPath.size())
+    return false; //no server or no share name
+  size_t shareEnd = iNetworkPath.find('\\', serverEnd + 1);
+  if (shareEnd == serverEnd + 1)
+    return false; //empty share name
+
+  if (shareEnd == std::string::npos)
+  {
+    oShareName = iNetworkPath;
+    oFinalPath = "";
+  }
+  else
+  {
+    oShareName = iNetworkPath.substr(0, shareEnd);
+    oFinalPath = iNetworkPath.substr(shareEnd + 1);
+  }
+  return true;
 }
 
-bool createLink(const char * iFilePath, const LinkInfo & iLinkInfo)
+bool createLink(const LinkInfo & iLinkInfo, const LNK_TARGET & iTarget, MemoryBuffer & oBuffer)
 {
+  LNK_TRACE_SCOPE("createLink");
+
+  //the link must be readable with the default limits. The length of a StringData is also limited to 16 bits.
+  const unsigned long maxLength = LNK_DEFAULT_PARSE_LIMITS.maxStringLength;
+  if (iLinkInfo.target.size() > maxLength ||
+      iLinkInfo.networkPath.size() > maxLength ||
+      iLinkInfo.description.size() > maxLength ||
+      iLinkInfo.workingDirectory.size() > maxLength ||
+      iLinkInfo.arguments.size() > maxLength ||
+      iLinkInfo.customIcon.filename.size() > maxLength)
+    return false;
+
+  //detect network target
+  std::string shareName;
+  std::string finalPath;
+  std::string deviceName;
+  bool isNetworkTarget = splitNetworkPath(iLinkInfo.networkPath, shareName, finalPath);
+  if (isNetworkTarget && iLinkInfo.target.size() >= 2 && iLinkInfo.target[1] == ':')
+    deviceName = iLinkInfo.target.substr(0, 2); //mapped drive
+
   //building header
   ShellLinkHeader header = {0};
   header.HeaderSize = sizeof(ShellLinkHeader);
   memcpy(header.LinkCLSID, DEFAULT_LINKCLSID, sizeof(LNK_CLSID));
   
-  //detect target
-  bool isTargetFolder = filesystem::folderExists(iLinkInfo.target.c_str());
-  bool isTargetFile = filesystem::fileExists(iLinkInfo.target.c_str());
-
   //building LinkFlags
   {
     LinkFlags & flags = header.linkFlags;
     flags.HasLinkTargetIDList = 1;
-    flags.HasLinkInfo = isTargetFile || isTargetFolder;
+    flags.HasLinkInfo = iTarget.isFile || iTarget.isFolder || isNetworkTarget;
     flags.HasName = iLinkInfo.description.size() > 0;
     flags.HasRelativePath = 0;
     flags.HasWorkingDir = iLinkInfo.workingDirectory.size() > 0;
@@ -680,7 +1190,7 @@ bool createLink(const char * iFilePath, const LinkInfo & iLinkInfo)
     flags.isHidden = 0;
     flags.isSystemFile = 0;
     flags.isVolumeLabel = 0;
-    flags.isDirectory = isTargetFolder;
+    flags.isDirectory = iTarget.isFolder;
     flags.isArchive = 1;
     flags.isEncrypted = 0;
     flags.isNormal = 0;
@@ -697,7 +1207,7 @@ bool createLink(const char * iFilePath, const LinkInfo & iLinkInfo)
   header.CreationTime = 0;
   header.AccessTime = 0;
   header.WriteTime = 0;
-  header.FileSize = (isTargetFile ? filesystem::getFileSize(iLinkInfo.target.c_str()) : 0);
+  header.FileSize = (iTarget.isFile ? iTarget.fileSize : 0);
   header.IconIndex = (iLinkInfo.customIcon.filename.size() > 0 ? iLinkInfo.customIcon.index : 0);
   header.ShowCommand = 1;
   header.HotKey = iLinkInfo.hotKey;
@@ -705,80 +1215,549 @@ bool createLink(const char * iFilePath, const LinkInfo & iLinkInfo)
   header.Reserved2 = 0;
   header.Reserved3 = 0;
 
-  //LinkTargetIDList
-  MemoryBuffer LinkTargetIDList = createLinkTargetIDList(iFilePath, iLinkInfo);
-  if (LinkTargetIDList.getSize() == 0)
-    return false; //unable to build LinkTargetIDList
+  //LinkTargetIDList is measured first and then written in place in the output buffer
+  ItemIDListBuilder measure;
+  unsigned long LinkTargetIDListSize = 0;
+  if (buildLinkTargetIDList(iLinkInfo, iTarget.shortPath, measure))
+    LinkTargetIDListSize = measure.finish();
+  if (LinkTargetIDListSize == 0)
+  {
+    if (!isNetworkTarget)
+      return false; //unable to build LinkTargetIDList
+
+    //network targets are resolved using the network volume table
+    header.linkFlags.HasLinkTargetIDList = 0;
+  }
 
   //File location info
   LNK_FILE_LOCATION_INFO fileInfo = {0};
-  fileInfo.length = LNK_FILE_LOCATION_INFO_SIZE + LNK_LOCAL_VOLUME_TABLE_SIZE + iLinkInfo.target.size() + 2;
-  fileInfo.endOffset = LNK_FILE_LOCATION_INFO_SIZE;
-  fileInfo.location = LNK_LOCATION_LOCAL;
-  fileInfo.localVolumeTableOffset = LNK_FILE_LOCATION_INFO_SIZE;
-  fileInfo.basePathOffset = LNK_FILE_LOCATION_INFO_SIZE + LNK_LOCAL_VOLUME_TABLE_SIZE;
-  fileInfo.networkVolumeTableOffset = 0;
-  fileInfo.finalPathOffset = fileInfo.length - 1;
-
   LNK_LOCAL_VOLUME_TABLE volumeTable = {0};
-  volumeTable.length = LNK_LOCAL_VOLUME_TABLE_SIZE;
-  volumeTable.volumeType = LNK_VOLUME_TYPE_FIXED;
-  volumeTable.volumeSerialNumber = 0;
-  volumeTable.volumeNameOffset = LNK_LOCAL_VOLUME_TABLE_SIZE - 1;
-  volumeTable.volumeLabel = '\0';
-
-  //Save data to a file
-  FILE * f = fopen(iFilePath, "wb");
-  if (f)
+  LNK_NETWORK_VOLUME_TABLE networkTable = {0};
+  if (isNetworkTarget)
   {
-    size_t tmp = 0;
+    networkTable.length = LNK_NETWORK_VOLUME_TABLE_SIZE + shareName.size() + (deviceName.empty() ? 0 : deviceName.size() + 1);
+    networkTable.flags = LNK_NETWORK_VALID_NET_TYPE | (deviceName.empty() ? 0 : LNK_NETWORK_VALID_DEVICE);
+    networkTable.networkShareNameOffset = offsetof(LNK_NETWORK_VOLUME_TABLE, networkShareName);
+    networkTable.deviceNameOffset = (deviceName.empty() ? 0 : LNK_NETWORK_VOLUME_TABLE_SIZE + shareName.size());
+    networkTable.networkProviderType = LNK_NETWORK_PROVIDER_LANMAN;
+
+    fileInfo.length = LNK_FILE_LOCATION_INFO_SIZE + networkTable.length + finalPath.size() + 1;
+    fileInfo.endOffset = LNK_FILE_LOCATION_INFO_SIZE;
+    fileInfo.location = LNK_LOCATION_NETWORK;
+    fileInfo.localVolumeTableOffset = 0;
+    fileInfo.basePathOffset = 0;
+    fileInfo.networkVolumeTableOffset = LNK_FILE_LOCATION_INFO_SIZE;
+    fileInfo.finalPathOffset = LNK_FILE_LOCATION_INFO_SIZE + networkTable.length;
+  }
+  else
+  {
+    fileInfo.length = LNK_FILE_LOCATION_INFO_SIZE + LNK_LOCAL_VOLUME_TABLE_SIZE + iLinkInfo.target.size() + 2;
+    fileInfo.endOffset = LNK_FILE_LOCATION_INFO_SIZE;
+    fileInfo.location = LNK_LOCATION_LOCAL;
+    fileInfo.localVolumeTableOffset = LNK_FILE_LOCATION_INFO_SIZE;
+    fileInfo.basePathOffset = LNK_FILE_LOCATION_INFO_SIZE + LNK_LOCAL_VOLUME_TABLE_SIZE;
+    fileInfo.networkVolumeTableOffset = 0;
+    fileInfo.finalPathOffset = fileInfo.length - 1;
+
+    volumeTable.length = LNK_LOCAL_VOLUME_TABLE_SIZE;
+    volumeTable.volumeType = LNK_VOLUME_TYPE_FIXED;
+    volumeTable.volumeSerialNumber = 0;
+    volumeTable.volumeNameOffset = LNK_LOCAL_VOLUME_TABLE_SIZE - 1;
+    volumeTable.volumeLabel = '\0';
+  }
 
-    //Save header
-    tmp = sizeof(header);
-    fwrite(&header, 1, tmp, f);
+  const LinkFlags & flags = header.linkFlags;
 
-    //LinkTargetIDList
-    tmp = LinkTargetIDList.getSize();
-    fwrite(LinkTargetIDList.getBuffer(), 1, tmp, f);
+  //compute the size of the link to allocate the buffer once
+  unsigned long size = sizeof(header) + LinkTargetIDListSize + fileInfo.length;
+  if (flags.HasName)
+    size += getStringUnicodeSize(iLinkInfo.description);
+  if (flags.HasWorkingDir)
+    size += getStringUnicodeSize(iLinkInfo.workingDirectory);
+  if (flags.HasArguments)
+    size += getStringUnicodeSize(iLinkInfo.arguments);
+  if (flags.HasIconLocation)
+    size += getStringUnicodeSize(iLinkInfo.customIcon.filename);
+  size += sizeof(uint32_t); //Additonal Info
 
-    //File location info & volume table
-    tmp = sizeof(fileInfo);
-    fwrite(&fileInfo, 1, tmp, f);
-    tmp = sizeof(volumeTable);
-    fwrite(&volumeTable, 1, tmp, f);
-    saveString(f, iLinkInfo.target); //basic path
-    saveString(f, ""); //final path
+  if (!oBuffer.allocate(size))
+    return false;
+  unsigned char * output = oBuffer.getBuffer();
 
-    LinkFlags & flags = header.linkFlags;
+  //Save header
+  writeBytes(&header, sizeof(header), output);
+
+  //LinkTargetIDList
+  if (flags.HasLinkTargetIDList)
+  {
+    LNK_TRACE_SCOPE("createLinkTargetIDList");
+    ItemIDListBuilder builder(output, LinkTargetIDListSize);
+    buildLinkTargetIDList(iLinkInfo, iTarget.shortPath, builder);
+    output += builder.finish();
+  }
+
+  //File location info & volume table
+  writeBytes(&fileInfo, sizeof(fileInfo), output);
+  if (isNetworkTarget)
+  {
+    writeBytes(&networkTable, offsetof(LNK_NETWORK_VOLUME_TABLE, networkShareName), output);
+    writeString(shareName, output);
+    if (!deviceName.empty())
+      writeString(deviceName, output);
+    writeString(finalPath, output); //final path
+  }
+  else
+  {
+    writeBytes(&volumeTable, sizeof(volumeTable), output);
+    writeString(iLinkInfo.target, output); //basic path
+    writeString("", output); //final path
+  }
+
+  {
+    LNK_TRACE_SCOPE("writeStrings");
 
     //Description
     if (flags.HasName)
-      saveStringUnicode(f, iLinkInfo.description);
+      writeStringUnicode(iLinkInfo.description, output);
 
     //Relative path string
     //(never)
 
     //Working directory
     if (flags.HasWorkingDir)
-      saveStringUnicode(f, iLinkInfo.workingDirectory);
+      writeStringUnicode(iLinkInfo.workingDirectory, output);
 
     //Command line arguments
     if (flags.HasArguments)
-      saveStringUnicode(f, iLinkInfo.arguments);
+      writeStringUnicode(iLinkInfo.arguments, output);
 
     //Icon filename
     if (flags.HasIconLocation)
-      saveStringUnicode(f, iLinkInfo.customIcon.filename);
-    
-    //Additonal Info Usualy consists of a dword with the value 0. 
-    const unsigned long additionnalInfo = 0;
-    fwrite(&additionnalInfo, 1, sizeof(additionnalInfo), f);
+      writeStringUnicode(iLinkInfo.customIcon.filename, output);
+  }
+  
+  //Additonal Info Usualy consists of a dword with the value 0. 
+  const uint32_t additionnalInfo = 0;
+  writeBytes(&additionnalInfo, sizeof(additionnalInfo), output);
 
-    fclose(f);
-    return true;
+  assert(output == oBuffer.getBuffer() + oBuffer.getSize());
+  return true;
+}
+
+bool createLink(const char * iFilePath, const LinkInfo & iLinkInfo)
+{
+  return createLink(iFilePath, iLinkInfo, false);
+}
+
+void detectTarget(const LinkInfo & iLinkInfo, LNK_TARGET & oTarget)
+{
+  LNK_TRACE_SCOPE("detectTarget");
+  oTarget.isFolder = filesystem::folderExists(iLinkInfo.target.c_str());
+  oTarget.isFile = filesystem::fileExists(iLinkInfo.target.c_str());
+  oTarget.fileSize = (oTarget.isFile ? filesystem::getFileSize(iLinkInfo.target.c_str()) : 0);
+
+  //convert the long path name to short path name
+  oTarget.shortPath = filesystem::getShortPathForm(iLinkInfo.target.c_str());
+}
+
+bool createLink(const char * iFilePath, const LinkInfo & iLinkInfo, bool iAtomic)
+{
+  LNK_TRACE_SCOPE("createLinkFile");
+
+  //detect target
+  LNK_TARGET target;
+  detectTarget(iLinkInfo, target);
+
+  MemoryBuffer content;
+  if (!createLink(iLinkInfo, target, content))
+    return false;
+
+  //Save data to a file. The link is already serialized in a single buffer: it is written without stdio buffering.
+  {
+    LNK_TRACE_SCOPE("writeFile");
+    return filesystem::writeFile(iFilePath, content.getBuffer(), content.getSize(), iAtomic);
   }
+}
 
-  return false;
+//Strings of the StringData section, in the order of the file
+enum LNK_STRING_DATA
+{
+  LNK_STRING_NAME,
+  LNK_STRING_RELATIVE_PATH,
+  LNK_STRING_WORKING_DIR,
+  LNK_STRING_ARGUMENTS,
+  LNK_STRING_ICON_LOCATION,
+  LNK_STRING_COUNT,
+};
+
+//Location of the sections of a link.
+//A missing section has a size of 0 and the offset at which it would be inserted.
+struct LNK_SECTIONS
+{
+  unsigned long idListOffset;
+  unsigned long idListSize;                     //including the IDListSize
+  unsigned long linkInfoOffset;
+  unsigned long linkInfoSize;
+  unsigned long location;                       //LNK_LOCATION_* of the LinkInfo
+  unsigned long stringOffsets[LNK_STRING_COUNT];
+  unsigned long stringSizes[LNK_STRING_COUNT];  //including the CountCharacters
+};
+
+//Replacement of the bytes of a section
+struct LNK_EDIT
+{
+  unsigned long offset;
+  unsigned long size;
+  std::string data;
+};
+
+//Finds the sections of a link the same way decodeLinkInfo() does
+bool findLinkSections(const unsigned char * iBuffer, const unsigned long & iSize, const ShellLinkHeader & iHeader, LNK_SECTIONS & oSections)
+{
+  ByteCursor cursor(iBuffer, iSize);
+  cursor.skip(sizeof(ShellLinkHeader));
+
+  oSections.idListOffset = cursor.getOffset();
+  oSections.idListSize = 0;
+  if (iHeader.linkFlags.HasLinkTargetIDList)
+  {
+    uint16_t IDListSize = 0;
+    cursor.read(IDListSize);
+    cursor.skip(IDListSize);
+    oSections.idListSize = sizeof(IDListSize) + IDListSize;
+  }
+
+  oSections.linkInfoOffset = cursor.getOffset();
+  LNK_FILE_LOCATION_INFO fileInfo = {0};
+  if (!cursor.read(fileInfo) || fileInfo.endOffset > LNK_FILE_LOCATION_INFO_SIZE + fileInfo.length)
+    return false;
+  cursor.seek(oSections.linkInfoOffset + LNK_FILE_LOCATION_INFO_SIZE + fileInfo.length - fileInfo.endOffset);
+  oSections.linkInfoSize = cursor.getOffset() - oSections.linkInfoOffset;
+  oSections.location = (fileInfo.length > 0 ? fileInfo.location : LNK_LOCATION_UNKNOWN);
+
+  const bool present[LNK_STRING_COUNT] = {
+    iHeader.linkFlags.HasName,
+    iHeader.linkFlags.HasRelativePath,
+    iHeader.linkFlags.HasWorkingDir,
+    iHeader.linkFlags.HasArguments,
+    iHeader.linkFlags.HasIconLocation,
+  };
+  for(int i=0; i<LNK_STRING_COUNT; i++)
+  {
+    oSections.stringOffsets[i] = cursor.getOffset();
+    oSections.stringSizes[i] = 0;
+    if (present[i])
+    {
+      uint16_t length = 0;
+      cursor.read(length);
+      cursor.skip(length * sizeof(uint16_t));
+      oSections.stringSizes[i] = cursor.getOffset() - oSections.stringOffsets[i];
+    }
+  }
+  return cursor.good();
+}
+
+//Encodes a string of the StringData section. An empty string is encoded as a missing string.
+void encodeStringData(const std::string & iValue, std::string & oData)
+{
+  oData.clear();
+  if (iValue.empty())
+    return;
+  oData.resize(getStringUnicodeSize(iValue));
+  unsigned char * output = (unsigned char *)&oData[0];
+  writeStringUnicode(iValue, output);
+}
+
+//Builds the LinkInfo of a local target. The volume table of the current LinkInfo is kept.
+bool buildLocalLinkInfo(const unsigned char * iLinkInfo, const unsigned long & iSize, const std::string & iTarget, std::string & oData)
+{
+  ByteCursor cursor(iLinkInfo, iSize);
+  LNK_FILE_LOCATION_INFO fileInfo = {0};
+  LNK_LOCAL_VOLUME_TABLE volumeTable = {0};
+  if (!cursor.read(fileInfo) || fileInfo.location != LNK_LOCATION_LOCAL || fileInfo.endOffset != LNK_FILE_LOCATION_INFO_SIZE)
+    return false; //only the paths of a local target are replaced
+  const unsigned long volumeTableOffset = fileInfo.localVolumeTableOffset;
+  if (!cursor.seek(volumeTableOffset) || !cursor.read(volumeTable) ||
+      volumeTable.length < LNK_LOCAL_VOLUME_TABLE_SIZE || volumeTable.length > iSize - volumeTableOffset)
+    return false;
+
+  fileInfo.length = LNK_FILE_LOCATION_INFO_SIZE + volumeTable.length + iTarget.size() + 2;
+  fileInfo.localVolumeTableOffset = LNK_FILE_LOCATION_INFO_SIZE;
+  fileInfo.basePathOffset = LNK_FILE_LOCATION_INFO_SIZE + volumeTable.length;
+  fileInfo.networkVolumeTableOffset = 0;
+  fileInfo.finalPathOffset = fileInfo.length - 1;
+
+  oData.resize(fileInfo.length);
+  unsigned char * output = (unsigned char *)&oData[0];
+  writeBytes(&fileInfo, sizeof(fileInfo), output);
+  writeBytes(iLinkInfo + volumeTableOffset, volumeTable.length, output);
+  writeString(iTarget, output); //basic path
+  writeString("", output); //final path
+  return true;
+}
+
+//Reads the network volume table of a LinkInfo. Only the tables with 8 bits names are supported.
+bool readNetworkVolumeTable(const unsigned char * iLinkInfo, const unsigned long & iSize, LNK_FILE_LOCATION_INFO & oFileInfo, LNK_NETWORK_VOLUME_TABLE & oVolumeTable, std::string & oDeviceName)
+{
+  ByteCursor cursor(iLinkInfo, iSize);
+  if (!cursor.read(oFileInfo) || oFileInfo.location != LNK_LOCATION_NETWORK || oFileInfo.endOffset != LNK_FILE_LOCATION_INFO_SIZE)
+    return false;
+  const unsigned long volumeTableOffset = oFileInfo.networkVolumeTableOffset;
+  if (!cursor.seek(volumeTableOffset) || !cursor.read(oVolumeTable) ||
+      oVolumeTable.length < LNK_NETWORK_VOLUME_TABLE_SIZE || oVolumeTable.length > iSize - volumeTableOffset ||
+      oVolumeTable.networkShareNameOffset != offsetof(LNK_NETWORK_VOLUME_TABLE, networkShareName))
+    return false;
+
+  oDeviceName = "";
+  if ((oVolumeTable.flags & LNK_NETWORK_VALID_DEVICE) && oVolumeTable.deviceNameOffset > 0)
+  {
+    ByteCursor volumeTable = cursor.sub(volumeTableOffset, oVolumeTable.length);
+    volumeTable.seek(oVolumeTable.deviceNameOffset);
+    if (!volumeTable.readString(LNK_DEFAULT_PARSE_LIMITS.maxStringLength, oDeviceName))
+      return false;
+  }
+  return true;
+}
+
+//Builds the LinkInfo of a network target. The device name and the provider of the current LinkInfo are kept.
+bool buildNetworkLinkInfo(const unsigned char * iLinkInfo, const unsigned long & iSize, const std::string & iNetworkPath, std::string & oData)
+{
+  LNK_FILE_LOCATION_INFO fileInfo = {0};
+  LNK_NETWORK_VOLUME_TABLE networkTable = {0};
+  std::string deviceName;
+  std::string shareName;
+  std::string finalPath;
+  if (!readNetworkVolumeTable(iLinkInfo, iSize, fileInfo, networkTable, deviceName) || !splitNetworkPath(iNetworkPath, shareName, finalPath))
+    return false;
+
+  networkTable.length = LNK_NETWORK_VOLUME_TABLE_SIZE + shareName.size() + (deviceName.empty() ? 0 : deviceName.size() + 1);
+  networkTable.deviceNameOffset = (deviceName.empty() ? 0 : LNK_NETWORK_VOLUME_TABLE_SIZE + shareName.size());
+
+  fileInfo.length = LNK_FILE_LOCATION_INFO_SIZE + networkTable.length + finalPath.size() + 1;
+  fileInfo.localVolumeTableOffset = 0;
+  fileInfo.basePathOffset = 0;
+  fileInfo.networkVolumeTableOffset = LNK_FILE_LOCATION_INFO_SIZE;
+  fileInfo.finalPathOffset = LNK_FILE_LOCATION_INFO_SIZE + networkTable.length;
+
+  oData.resize(fileInfo.length);
+  unsigned char * output = (unsigned char *)&oData[0];
+  writeBytes(&fileInfo, sizeof(fileInfo), output);
+  writeBytes(&networkTable, offsetof(LNK_NETWORK_VOLUME_TABLE, networkShareName), output);
+  writeString(shareName, output);
+  if (!deviceName.empty())
+    writeString(deviceName, output);
+  writeString(finalPath, output); //final path
+  return true;
+}
+
+//Adds the replacement of the bytes of a section, unless they are identical
+void addEdit(const unsigned char * iBuffer, unsigned long iOffset, unsigned long iSize, std::vector<LNK_EDIT> & ioEdits)
+{
+  LNK_EDIT & edit = ioEdits.back();
+  edit.offset = iOffset;
+  edit.size = iSize;
+  if (edit.data.size() == iSize && (iSize == 0 || memcmp(edit.data.c_str(), iBuffer + iOffset, iSize) == 0))
+    ioEdits.pop_back();
+}
+
+bool patchLink(MemoryBuffer & ioContent, const LinkChanges & iChanges, unsigned long & oFirstChange)
+{
+  LNK_TRACE_SCOPE("patchLink");
+
+  const unsigned char * buffer = ioContent.getBuffer();
+  const unsigned long size = ioContent.getSize();
+  if (!hasLinkSignature(buffer, size))
+    return false;
+
+  ShellLinkHeader header;
+  memcpy(&header, buffer, sizeof(header));
+  if (!header.linkFlags.reserved1)
+    return false; //IsUnicode: the strings of other links are not read as they are written
+  LNK_SECTIONS sections;
+  if (!findLinkSections(buffer, size, header, sections))
+    return false;
+
+  //the patched link must be readable with the default limits
+  const unsigned long maxLength = LNK_DEFAULT_PARSE_LIMITS.maxStringLength;
+
+  //edits are listed by increasing offset
+  ShellLinkHeader newHeader = header;
+  std::vector<LNK_EDIT> edits;
+  bool isUncTarget = false; //the network volume table is rebuilt from the target
+  if (iChanges.fields & LNK_FIELD_TARGET)
+  {
+    const LinkInfo & info = iChanges.values;
+    if (info.target.size() > maxLength)
+      return false;
+    std::string shortPath = (iChanges.shortPath.empty() ? filesystem::getShortPathForm(info.target.c_str()) : iChanges.shortPath);
+
+    //LinkTargetIDList
+    ItemIDListBuilder measure;
+    unsigned long idListSize = 0;
+    if (buildLinkTargetIDList(info, shortPath, measure))
+      idListSize = measure.finish();
+    edits.push_back(LNK_EDIT());
+    if (idListSize > 0)
+    {
+      edits.back().data.resize(idListSize);
+      ItemIDListBuilder builder((unsigned char *)&edits.back().data[0], idListSize);
+      buildLinkTargetIDList(info, shortPath, builder);
+      builder.finish();
+    }
+    else if (info.target.size() < 2 || info.target[0] != '\\' || info.target[1] != '\\' || sections.location != LNK_LOCATION_NETWORK)
+      return false; //unable to build LinkTargetIDList
+    addEdit(buffer, sections.idListOffset, sections.idListSize, edits);
+    newHeader.linkFlags.HasLinkTargetIDList = (idListSize > 0); //UNC targets are resolved using the network volume table
+
+    //LinkInfo
+    if (sections.location == LNK_LOCATION_LOCAL)
+    {
+      edits.push_back(LNK_EDIT());
+      if (!buildLocalLinkInfo(buffer + sections.linkInfoOffset, sections.linkInfoSize, info.target, edits.back().data))
+        return false;
+      addEdit(buffer, sections.linkInfoOffset, sections.linkInfoSize, edits);
+    }
+    else if (sections.location == LNK_LOCATION_NETWORK && idListSize == 0)
+    {
+      //UNC target: the share name and the final path are the new target
+      edits.push_back(LNK_EDIT());
+      if (!buildNetworkLinkInfo(buffer + sections.linkInfoOffset, sections.linkInfoSize, info.target, edits.back().data))
+        return false;
+      addEdit(buffer, sections.linkInfoOffset, sections.linkInfoSize, edits);
+      isUncTarget = true;
+    }
+    else if (sections.location == LNK_LOCATION_NETWORK)
+    {
+      //the target of a network link must stay on its mapped drive
+      LNK_FILE_LOCATION_INFO fileInfo = {0};
+      LNK_NETWORK_VOLUME_TABLE networkTable = {0};
+      std::string deviceName;
+      if (!readNetworkVolumeTable(buffer + sections.linkInfoOffset, sections.linkInfoSize, fileInfo, networkTable, deviceName) ||
+          deviceName.size() != 2 || toupper(deviceName[0]) != toupper(info.target[0]) || deviceName[1] != ':')
+        return false;
+    }
+    else if (sections.location != LNK_LOCATION_UNKNOWN)
+      return false;
+  }
+  if (iChanges.fields & LNK_FIELD_NETWORK_PATH)
+  {
+    if (iChanges.values.networkPath.size() > maxLength)
+      return false;
+    if (isUncTarget)
+    {
+      if (iChanges.values.networkPath != iChanges.values.target)
+        return false; //the network path of a UNC target is the target
+    }
+    else if (sections.location == LNK_LOCATION_NETWORK)
+    {
+      edits.push_back(LNK_EDIT());
+      if (!buildNetworkLinkInfo(buffer + sections.linkInfoOffset, sections.linkInfoSize, iChanges.values.networkPath, edits.back().data))
+        return false;
+      addEdit(buffer, sections.linkInfoOffset, sections.linkInfoSize, edits);
+    }
+    else if (!iChanges.values.networkPath.empty())
+      return false; //the link has no network volume table
+  }
+
+  //strings
+  struct STRING_CHANGE
+  {
+    uint32_t field;
+    LNK_STRING_DATA string;
+    const std::string * value;
+  };
+  const STRING_CHANGE strings[] = {
+    { LNK_FIELD_DESCRIPTION,       LNK_STRING_NAME,          &iChanges.values.description },
+    { LNK_FIELD_RELATIVE_PATH,     LNK_STRING_RELATIVE_PATH, &iChanges.relativePath },
+    { LNK_FIELD_WORKING_DIRECTORY, LNK_STRING_WORKING_DIR,   &iChanges.values.workingDirectory },
+    { LNK_FIELD_ARGUMENTS,         LNK_STRING_ARGUMENTS,     &iChanges.values.arguments },
+    { LNK_FIELD_ICON,              LNK_STRING_ICON_LOCATION, &iChanges.values.customIcon.filename },
+  };
+  for(size_t i=0; i<sizeof(strings)/sizeof(strings[0]); i++)
+  {
+    const STRING_CHANGE & change = strings[i];
+    if ((iChanges.fields & change.field) == 0)
+      continue;
+    if (change.value->size() > maxLength)
+      return false;
+    edits.push_back(LNK_EDIT());
+    encodeStringData(*change.value, edits.back().data);
+    addEdit(buffer, sections.stringOffsets[change.string], sections.stringSizes[change.string], edits);
+  }
+  if (iChanges.fields & LNK_FIELD_DESCRIPTION)
+    newHeader.linkFlags.HasName = !iChanges.values.description.empty();
+  if (iChanges.fields & LNK_FIELD_RELATIVE_PATH)
+    newHeader.linkFlags.HasRelativePath = !iChanges.relativePath.empty();
+  if (iChanges.fields & LNK_FIELD_WORKING_DIRECTORY)
+    newHeader.linkFlags.HasWorkingDir = !iChanges.values.workingDirectory.empty();
+  if (iChanges.fields & LNK_FIELD_ARGUMENTS)
+    newHeader.linkFlags.HasArguments = !iChanges.values.arguments.empty();
+  if (iChanges.fields & LNK_FIELD_ICON)
+  {
+    newHeader.linkFlags.HasIconLocation = !iChanges.values.customIcon.filename.empty();
+    newHeader.IconIndex = (newHeader.linkFlags.HasIconLocation ? iChanges.values.customIcon.index : 0);
+  }
+
+  //the buffer grows once to hold the largest intermediate content, in the order the edits are applied
+  unsigned long newSize = size;
+  unsigned long capacity = size;
+  for(size_t i=edits.size(); i>0; i--)
+  {
+    newSize = newSize - edits[i-1].size + edits[i-1].data.size();
+    capacity = (newSize > capacity ? newSize : capacity);
+  }
+  if (!ioContent.reallocate(capacity))
+    return false;
+  unsigned char * output = ioContent.getBuffer();
+
+  //the last sections are replaced first: only the bytes after each section are moved
+  unsigned long currentSize = size;
+  for(size_t i=edits.size(); i>0; i--)
+  {
+    const LNK_EDIT & edit = edits[i-1];
+    const unsigned long end = edit.offset + edit.size;
+    memmove(output + edit.offset + edit.data.size(), output + end, currentSize - end);
+    memcpy(output + edit.offset, edit.data.c_str(), edit.data.size());
+    currentSize = currentSize - edit.size + edit.data.size();
+  }
+  assert(currentSize == newSize);
+  ioContent.reallocate(newSize);
+
+  //header
+  oFirstChange = (edits.empty() ? newSize : edits.front().offset);
+  const unsigned char * newHeaderBytes = (const unsigned char *)&newHeader;
+  for(unsigned long i=0; i<sizeof(newHeader); i++)
+  {
+    if (output[i] != newHeaderBytes[i])
+    {
+      oFirstChange = i;
+      break;
+    }
+  }
+  memcpy(output, &newHeader, sizeof(newHeader));
+  return true;
+}
+
+bool patchLink(const char * iFilePath, const LinkChanges & iChanges)
+{
+  LNK_TRACE_SCOPE("patchLinkFile");
+
+  MemoryBuffer content;
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  if (!loadLinkFile(iFilePath, LNK_DEFAULT_PARSE_LIMITS, content, error, NULL))
+    return false;
+  const unsigned long size = content.getSize();
+  unsigned long firstChange = 0;
+  if (!patchLink(content, iChanges, firstChange))
+    return false;
+  if (firstChange == content.getSize() && content.getSize() == size)
+    return true; //nothing changed
+
+  //the patched link replaces the file atomically: a failed write never leaves a partially patched link
+  {
+    LNK_TRACE_SCOPE("writeFile");
+    return filesystem::writeFile(iFilePath, content.getBuffer(), content.getSize(), true);
+  }
 }
 
 std::string toString(const LNK_HOTKEY & iHotKey)
@@ -822,16 +1801,42 @@ std::string toString(const LNK_HOTKEY & iHotKey)
   return value;
 }
 
+void printHexData(const unsigned char * iData, unsigned long iSize)
+{
+  printf("data=");
+  for(unsigned long i=0; i<iSize; i++)
+  {
+    printf("%02x", iData[i]);
+    if (i+1<iSize)
+      printf(" ");
+  }
+  printf("\n");
+}
+
+std::string readStringAt(const ByteCursor & iSection, unsigned long iOffset)
+{
+  //each string is read with its own cursor so that
+  //an invalid offset does not prevent printing the others
+  std::string value;
+  ByteCursor cursor = iSection.sub(iOffset, iSection.getSize() - iOffset);
+  cursor.readString(LNK_DEFAULT_PARSE_LIMITS.maxStringLength, value);
+  return value;
+}
+
 bool printLinkInfo(const char * iFilePath)
 {
-  FILE * f = fopen(iFilePath, "rb");
-  if (f)
+  MemoryBuffer fileContent;
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  bool loadSuccess = loadLinkFile(iFilePath, LNK_DEFAULT_PARSE_LIMITS, fileContent, error, NULL);
+  if (loadSuccess)
   {
     printf("Link file: %s\n", iFilePath);
 
+    ByteCursor cursor(fileContent.getBuffer(), fileContent.getSize());
+
     //read & print header
     ShellLinkHeader header = {0};
-    fread(&header, 1, sizeof(header), f);
+    cursor.read(header);
     //signature
     printf("HeaderSize: %d\n", header.HeaderSize);
     //LinkCLSID
@@ -909,54 +1914,42 @@ bool printLinkInfo(const char * iFilePath)
     if (header.linkFlags.HasLinkTargetIDList)
     {
       unsigned short listSize = 0;
-      fread(&listSize, 1, sizeof(listSize), f);
+      cursor.read(listSize);
       printf("LinkTargetIDList size=0x%02x (%02d)\n", listSize, listSize);
 
       unsigned short itemIdSize = 0xFFFF;
       unsigned char sequenceNumber = 0;
-      while (itemIdSize != 0)
+      while (itemIdSize != 0 && cursor.read(itemIdSize))
       {
-        fread(&itemIdSize, 1, sizeof(itemIdSize), f);
         if (itemIdSize > 0)
         {
           sequenceNumber++;
 
           //item is valid (last item has a size of 0)
           printf("itemId %d size=0x%02x (%02d)\n", sequenceNumber, itemIdSize, itemIdSize);
-          printf("data=");
 
-          unsigned short remainingDataSize = itemIdSize - sizeof(itemIdSize);
-          while (remainingDataSize)
-          {
-            unsigned char c = 0;
-            fread(&c, 1, sizeof(c), f);
-            printf("%02x", c);
-            remainingDataSize--;
-            if (remainingDataSize)
-              printf(" ");
-          }
-          printf("\n");
+          //print what is available and stop on an item smaller than its size field or past the end of the file
+          unsigned long dataSize = (itemIdSize > sizeof(itemIdSize) ? itemIdSize - sizeof(itemIdSize) : 0);
+          if (dataSize > cursor.getRemaining())
+            dataSize = cursor.getRemaining();
+          printHexData(cursor.readBytes(dataSize), dataSize);
+          if (dataSize != itemIdSize - sizeof(itemIdSize))
+            break;
         }
       }
     }
 
     //File location info
     {
-      long fileOffset = ftell(f);
-
-      //read file location info size
-      unsigned long fileInfoDataSize = 0;
-      fread(&fileInfoDataSize, 1, sizeof(fileInfoDataSize), f);
-
-      //rewind back to before the fileInfoDataSize
-      fseek(f, fileOffset, SEEK_SET);
-
       //read the whole LNK_FILE_LOCATION_INFO data
-      MemoryBuffer fileInfoData;
-      fileInfoData.allocate(fileInfoDataSize);
-      fread(fileInfoData.getBuffer(), 1, fileInfoData.getSize(), f);
+      unsigned long fileInfoOffset = cursor.getOffset();
+      LNK_FILE_LOCATION_INFO fileInfoData = {0};
+      cursor.read(fileInfoData);
+      ByteCursor section = cursor.sub(fileInfoOffset, fileInfoData.length);
+      cursor.seek(fileInfoOffset);
+      cursor.skip(fileInfoData.length);
 
-      const LNK_FILE_LOCATION_INFO * fileInfo = (const LNK_FILE_LOCATION_INFO *)fileInfoData.getBuffer();
+      const LNK_FILE_LOCATION_INFO * fileInfo = &fileInfoData;
 
       printf("file location info: length                    = 0x%04x (%d)\n", fileInfo->length, fileInfo->length );
       printf("                    endOffset                 = 0x%04x (%d)\n", fileInfo->endOffset, fileInfo->endOffset );
@@ -966,45 +1959,46 @@ bool printLinkInfo(const char * iFilePath)
       printf("                    networkVolumeTableOffset  = 0x%04x (%d)\n", fileInfo->networkVolumeTableOffset, fileInfo->networkVolumeTableOffset );
       printf("                    finalPathOffset           = 0x%04x (%d)\n", fileInfo->finalPathOffset, fileInfo->finalPathOffset );
 
-      const unsigned char * baseFileLocationAddress = fileInfoData.getBuffer();;
       if (fileInfo->length > 0)
       {
-        const char * basePath = "";
+        std::string basePath = "";
         if (fileInfo->basePathOffset)
-          basePath = (const char *)&baseFileLocationAddress[fileInfo->basePathOffset];
-        const char * finalPath = "";
+          basePath = readStringAt(section, fileInfo->basePathOffset);
+        std::string finalPath = "";
         if (fileInfo->finalPathOffset)
-          finalPath = (const char *)&baseFileLocationAddress[fileInfo->finalPathOffset];
+          finalPath = readStringAt(section, fileInfo->finalPathOffset);
 
-        printf("                    basePath                  = \"%s\" \n", basePath);
-        printf("                    finalPath                 = \"%s\" \n", finalPath);
+        printf("                    basePath                  = \"%s\" \n", basePath.c_str());
+        printf("                    finalPath                 = \"%s\" \n", finalPath.c_str());
 
-        if (fileInfo->localVolumeTableOffset > 0 && fileInfo->location == LNK_LOCATION_LOCAL)
+        LNK_LOCAL_VOLUME_TABLE localVolumeTable = {0};
+        ByteCursor localVolume = section.sub(fileInfo->localVolumeTableOffset, sizeof(localVolumeTable));
+        if (fileInfo->localVolumeTableOffset > 0 && fileInfo->location == LNK_LOCATION_LOCAL && localVolume.read(localVolumeTable))
         {
-          const LNK_LOCAL_VOLUME_TABLE * volumeTable = (LNK_LOCAL_VOLUME_TABLE *)&baseFileLocationAddress[fileInfo->localVolumeTableOffset];
-          const char * volumeName = &volumeTable->volumeLabel;
-          assert( volumeTable->length >= LNK_LOCAL_VOLUME_TABLE_SIZE );
+          const LNK_LOCAL_VOLUME_TABLE * volumeTable = &localVolumeTable;
+          std::string volumeName = readStringAt(section, fileInfo->localVolumeTableOffset + offsetof(LNK_LOCAL_VOLUME_TABLE, volumeLabel));
 
           printf("                    LNK_LOCAL_VOLUME_TABLE:\n");
           printf("                           length             = 0x%04x (%d)\n", volumeTable->length ,volumeTable->length );
           printf("                           volumeType         = 0x%04x (%d)\n", volumeTable->volumeType, volumeTable->volumeType );
           printf("                           volumeSerialNumber = 0x%04x (%d)\n", volumeTable->volumeSerialNumber, volumeTable->volumeSerialNumber );
           printf("                           volumeNameOffset   = 0x%04x (%d)\n", volumeTable->volumeNameOffset, volumeTable->volumeNameOffset );
-          printf("                           volumeLabel        = \"%s\" \n", volumeName);
+          printf("                           volumeLabel        = \"%s\" \n", volumeName.c_str());
         }
-        if (fileInfo->networkVolumeTableOffset > 0 && fileInfo->location == LNK_LOCATION_NETWORK)
+        LNK_NETWORK_VOLUME_TABLE networkVolumeTable = {0};
+        ByteCursor networkVolume = section.sub(fileInfo->networkVolumeTableOffset, sizeof(networkVolumeTable));
+        if (fileInfo->networkVolumeTableOffset > 0 && fileInfo->location == LNK_LOCATION_NETWORK && networkVolume.read(networkVolumeTable))
         {
-          const LNK_NETWORK_VOLUME_TABLE * volumeTable = (LNK_NETWORK_VOLUME_TABLE *)&baseFileLocationAddress[fileInfo->networkVolumeTableOffset];
-          const char * volumeName = &volumeTable->networkShareName;
-          assert( volumeTable->length >= LNK_NETWORK_VOLUME_TABLE_SIZE );
+          const LNK_NETWORK_VOLUME_TABLE * volumeTable = &networkVolumeTable;
+          std::string volumeName = readStringAt(section, fileInfo->networkVolumeTableOffset + offsetof(LNK_NETWORK_VOLUME_TABLE, networkShareName));
 
           printf("                    LNK_NETWORK_VOLUME_TABLE:\n");
           printf("                           length                 = 0x%04x (%d)\n", volumeTable->length ,volumeTable->length );
-          printf("                           reserved1              = 0x%04x (%d)\n", volumeTable->reserved1, volumeTable->reserved1 );
+          printf("                           flags                  = 0x%04x (%d)\n", volumeTable->flags, volumeTable->flags );
           printf("                           networkShareNameOffset = 0x%04x (%d)\n", volumeTable->networkShareNameOffset, volumeTable->networkShareNameOffset );
-          printf("                           reserved2              = 0x%04x (%d)\n", volumeTable->reserved2, volumeTable->reserved2 );
-          printf("                           reserved3              = 0x%04x (%d)\n", volumeTable->reserved3, volumeTable->reserved3 );
-          printf("                           networkShareName       = \"%s\" \n", volumeName);
+          printf("                           deviceNameOffset       = 0x%04x (%d)\n", volumeTable->deviceNameOffset, volumeTable->deviceNameOffset );
+          printf("                           networkProviderType    = 0x%04x (%d)\n", volumeTable->networkProviderType, volumeTable->networkProviderType );
+          printf("                           networkShareName       = \"%s\" \n", volumeName.c_str());
         }
       }
     }
@@ -1012,73 +2006,60 @@ bool printLinkInfo(const char * iFilePath)
     //Description
     if (header.linkFlags.HasName)
     {
-      std::string value = readUnicodeString(f);
+      std::string value;
+      readString(cursor, LNK_DEFAULT_PARSE_LIMITS, value);
       printf("Description = \"%s\" \n", value.c_str() );
     }
 
     //Relative path string
     if (header.linkFlags.HasRelativePath)
     {
-      std::string value = readUnicodeString(f);
+      std::string value;
+      readString(cursor, LNK_DEFAULT_PARSE_LIMITS, value);
       printf("Relative path string = \"%s\" \n", value.c_str() );
     }
 
     //Working directory
     if (header.linkFlags.HasWorkingDir)
     {
-      std::string value = readUnicodeString(f);
+      std::string value;
+      readString(cursor, LNK_DEFAULT_PARSE_LIMITS, value);
       printf("Working directory = \"%s\" \n", value.c_str() );
     }
 
     //Command line arguments
     if (header.linkFlags.HasArguments)
     {
-      std::string value = readUnicodeString(f);
+      std::string value;
+      readString(cursor, LNK_DEFAULT_PARSE_LIMITS, value);
       printf("Command line arguments = \"%s\" \n", value.c_str() );
     }
 
     //Icon filename
     if (header.linkFlags.HasIconLocation)
     {
-      std::string value = readUnicodeString(f);
+      std::string value;
+      readString(cursor, LNK_DEFAULT_PARSE_LIMITS, value);
       printf("Icon filename = \"%s\" \n", value.c_str() );
     }
 
     //Additonal Info Usualy consists of a dword with the value 0. 
-    unsigned long additionalInfoBlockSize = 0;
-    fread(&additionalInfoBlockSize, 1, sizeof(additionalInfoBlockSize), f);
+    //The list ends with a block smaller than 4 bytes or at the end of the file.
+    uint32_t additionalInfoBlockSize = 0;
     unsigned long blockNumber = 0;
-    while (additionalInfoBlockSize > 0)
+    while (cursor.read(additionalInfoBlockSize) && additionalInfoBlockSize >= sizeof(additionalInfoBlockSize))
     {
       blockNumber++;
 
-      //rewind for reading block size
-      long seekOffset = sizeof(additionalInfoBlockSize);
-      seekOffset *= -1;
-      fseek(f, seekOffset, SEEK_CUR);
-
-      //read additionnal info block
-      MemoryBuffer block(additionalInfoBlockSize);
-      fread(block.getBuffer(), 1, block.getSize(), f);
-
       printf("Additionnal information block #%d size=0x%02x (%02d) \n", blockNumber, additionalInfoBlockSize, additionalInfoBlockSize);
-      printf("data=");
 
-      const unsigned char * content = block.getBuffer();
-      for(unsigned long i=sizeof(additionalInfoBlockSize); i<block.getSize(); i++)
-      {
-        const unsigned char & c = content[i];
-        printf("%02x", c);
-        if (i+1<block.getSize())
-          printf(" ");
-      }
-      printf("\n");
-
-      //read next additional block size
-      fread(&additionalInfoBlockSize, 1, sizeof(additionalInfoBlockSize), f);
+      //print what is available of the block
+      unsigned long dataSize = additionalInfoBlockSize - sizeof(additionalInfoBlockSize);
+      if (dataSize > cursor.getRemaining())
+        dataSize = cursor.getRemaining();
+      printHexData(cursor.readBytes(dataSize), dataSize);
     }
 
-    fclose(f);
     return true;
   }
 
@@ -90,13 +90,187 @@ struct LinkInfo
   std::string workingDirectory;
   LNK_ICON customIcon;
   LNK_HOTKEY hotKey;
+
+  ///<summary>
+  ///Resets all fields. The strings keep their capacity so that an object
+  ///reused for parsing many files stops allocating memory.
+  ///</summary>
+  void clear();
+};
+
+class MemoryBuffer;
+class Reader;
+
+//Properties of the target of a link that createLink() reads from the file system
+struct LNK_TARGET
+{
+  bool isFile;
+  bool isFolder;
+  unsigned long fileSize;
+  std::string shortPath;      //8.3 form of LinkInfo::target (ie "C:\\PROGRA~1\\7-Zip\\History.txt")
+};
+
+//Fields of a link changed by patchLink()
+enum LNK_LINK_FIELD
+{
+  LNK_FIELD_TARGET            = 0x01,
+  LNK_FIELD_ARGUMENTS         = 0x02,
+  LNK_FIELD_WORKING_DIRECTORY = 0x04,
+  LNK_FIELD_DESCRIPTION       = 0x08,
+  LNK_FIELD_ICON              = 0x10, //filename and index of the icon
+  LNK_FIELD_NETWORK_PATH      = 0x20, //share name and final path of the network volume table
+  LNK_FIELD_RELATIVE_PATH     = 0x40,
+};
+
+//Changes applied by patchLink(). All other bytes of the link are kept.
+//Changing the target rebuilds the LinkTargetIDList and the paths of a local LinkInfo. The volume table,
+//the header (file size, attributes and times) and the ExtraData blocks are not modified.
+//A network link can be moved to another share with the network path. Its target must stay on
+//the same mapped drive, or be a UNC path which removes the LinkTargetIDList and replaces the share name and
+//the final path of the network volume table. The network path of a UNC target, if changed, must be the target.
+//Strings longer than LNK_DEFAULT_PARSE_LIMITS.maxStringLength are rejected: the link stays readable with the default limits.
+//Links without the IsUnicode flag are rejected: their StringData are not decoded by getLinkInfo().
+struct LinkChanges
+{
+  uint32_t fields;            //LNK_FIELD_* flags of the fields to change
+  LinkInfo values;            //new values of the fields. An empty string removes the field.
+  std::string relativePath;   //new value of LNK_FIELD_RELATIVE_PATH
+  std::string shortPath;      //8.3 form of values.target. When empty, it is read from the file system.
+};
+
+//Type of volumes
+static const unsigned long LNK_VOLUME_TYPE_UNKNOWN           = 0;
+static const unsigned long LNK_VOLUME_TYPE_NO_ROOT_DIRECTORY = 1;
+static const unsigned long LNK_VOLUME_TYPE_REMOVABLE         = 2;
+static const unsigned long LNK_VOLUME_TYPE_FIXED             = 3;
+static const unsigned long LNK_VOLUME_TYPE_REMOTE            = 4;
+static const unsigned long LNK_VOLUME_TYPE_CDROM             = 5;
+static const unsigned long LNK_VOLUME_TYPE_RAMDRIVE          = 6;
+
+//Local volume on which the target is located (VolumeID)
+struct LNK_VOLUME
+{
+  unsigned long driveType;    //LNK_VOLUME_TYPE_*
+  unsigned long serialNumber;
+  std::string label;
+};
+
+//Network share on which the target is located (CommonNetworkRelativeLink)
+struct LNK_NETWORK_SHARE
+{
+  unsigned long flags;
+  unsigned long providerType;
+  std::string shareName;
+  std::string deviceName;     //mapped drive (ie "Z:"), if any
+};
+
+//All fields decoded from a link file.
+//Times are raw FILETIME values (100-nanosecond intervals since January 1, 1601 UTC).
+struct LinkInfoEx : public LinkInfo
+{
+  uint32_t linkFlags;
+  uint32_t fileAttributes;
+  uint64_t creationTime;
+  uint64_t accessTime;
+  uint64_t writeTime;
+  uint32_t fileSize;
+  uint32_t showCommand;
+  std::string basePath;
+  std::string finalPath;
+  std::string relativePath;
+  bool hasVolume;
+  LNK_VOLUME volume;
+  bool hasNetworkShare;
+  LNK_NETWORK_SHARE networkShare;
+
+  ///<summary>
+  ///Resets all fields. The strings keep their capacity.
+  ///</summary>
+  void clear();
+};
+
+//Reasons for rejecting a file
+enum LNK_PARSE_ERROR
+{
+  LNK_PARSE_OK = 0,
+  LNK_PARSE_ERROR_IO,                 //the file cannot be read
+  LNK_PARSE_ERROR_SIGNATURE,          //invalid header size or CLSID
+  LNK_PARSE_ERROR_TRUNCATED,          //a structure ends past the end of the file
+  LNK_PARSE_ERROR_INVALID_STRUCTURE,  //a size or an offset is inconsistent
+  LNK_PARSE_ERROR_FILE_TOO_LARGE,     //ParseLimits::maxFileSize exceeded
+  LNK_PARSE_ERROR_TOO_MANY_ITEMIDS,   //ParseLimits::maxItemIds exceeded
+  LNK_PARSE_ERROR_STRING_TOO_LONG,    //ParseLimits::maxStringLength exceeded
+  LNK_PARSE_ERROR_TOO_MANY_EXTRADATA, //ParseLimits::maxExtraDataBlocks exceeded
+  LNK_PARSE_ERROR_COUNT,
+};
+
+//Upper bounds on the work done while parsing a single file
+struct ParseLimits
+{
+  unsigned long maxFileSize;        //in bytes
+  unsigned long maxItemIds;         //number of ItemID in the LinkTargetIDList
+  unsigned long maxStringLength;    //in characters
+  unsigned long maxExtraDataBlocks; //number of ExtraData blocks
+};
+extern const ParseLimits LNK_DEFAULT_PARSE_LIMITS;
+
+//Checking policies of the decoder.
+//Untrusted validates every read and enforces ParseLimits. Use it for files from unknown origin.
+//Trusted removes all checks at compile time. Use it only for buffers produced by createLink().
+struct Untrusted { static const bool CHECKED = true;  };
+struct Trusted   { static const bool CHECKED = false; };
+
+//ExtraData blocks are counted by signature, from 0xA0000001 (EnvironmentVariableDataBlock)
+//to 0xA000000C (VistaAndAboveIDListDataBlock). See MS-SHLLINK section 2.5.
+static const uint32_t LNK_EXTRADATA_FIRST_SIGNATURE = 0xA0000001;
+static const uint32_t LNK_EXTRADATA_NUM_SIGNATURES  = 12;
+
+//Counters of the work done by the library.
+//Counters are cumulative since the process started. Compute the difference
+//between two snapshots to get the activity of a period of time.
+struct Stats
+{
+  uint64_t filesProbed;           //calls to isLink()
+  uint64_t filesParsed;           //calls to getLinkInfo()
+  uint64_t bytesRead;             //bytes read from files
+  uint64_t bytesParsed;           //bytes of the buffers given to the decoder
+  uint64_t itemIds[256];          //ItemIDs decoded, by type (third byte of the ItemID)
+  uint64_t stringBytesTranscoded; //bytes of UTF-16 strings narrowed to 8 bits
+  uint64_t extraDataBlocks[LNK_EXTRADATA_NUM_SIGNATURES]; //ExtraData blocks seen, index is signature - LNK_EXTRADATA_FIRST_SIGNATURE
+  uint64_t unknownExtraDataBlocks;  //ExtraData blocks with any other signature
+  uint64_t allocations;           //buffers allocated by the library (MemoryBuffer)
+  uint64_t rejections[LNK_PARSE_ERROR_COUNT]; //files rejected, by reason. rejections[LNK_PARSE_OK] is always 0.
 };
 
+//All functions are reentrant and may be called from multiple threads at the same time
+//as long as each thread uses its own output objects (LinkInfo, MemoryBuffer, ...).
+//The parser clears the output LinkInfo before decoding: an object can be reused for many files.
+//setTraceHooks() and clearTraceHooks() must not be called while other threads use the library.
 const char * getVersionString();
+const char * getParseErrorDescription(const LNK_PARSE_ERROR & iError);
 bool isLink(const char * iFilePath);
+bool isLink(const unsigned char * iBuffer, const unsigned long & iSize);
 bool getLinkInfo(const char * iFilePath, LinkInfo & oLinkInfo);
+bool getLinkInfo(const char * iFilePath, LinkInfoEx & oLinkInfo);
+bool getLinkInfo(const char * iFilePath, LinkInfo & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError);
+bool getLinkInfo(const char * iFilePath, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError);
+bool getLinkInfo(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfo & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError);
+bool getLinkInfo(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError);
+template <class Policy> bool getLinkInfo(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfo & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError);
+template <class Policy> bool getLinkInfo(const unsigned char * iBuffer, const unsigned long & iSize, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError);
+//Decodes a link from a stream which cannot seek (see Reader.h). The stream is read up to the TerminalBlock.
+//Only the sections before the ExtraData blocks are kept in memory, in ioWindow which is reused between links.
+bool getLinkInfo(Reader & ioReader, LinkInfo & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError);
+bool getLinkInfo(Reader & ioReader, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError);
+bool getLinkInfo(Reader & ioReader, LinkInfoEx & oLinkInfo, const ParseLimits & iLimits, LNK_PARSE_ERROR & oError, MemoryBuffer & ioWindow);
+//createLink() rejects strings longer than LNK_DEFAULT_PARSE_LIMITS.maxStringLength: the link stays readable with the default limits.
 bool createLink(const char * iFilePath, const LinkInfo & iLinkInfo);
+bool createLink(const char * iFilePath, const LinkInfo & iLinkInfo, bool iAtomic); //iAtomic replaces an existing file atomically
+bool createLink(const LinkInfo & iLinkInfo, const LNK_TARGET & iTarget, MemoryBuffer & oBuffer);
+bool patchLink(const char * iFilePath, const LinkChanges & iChanges); //replaces the file atomically
+bool patchLink(MemoryBuffer & ioContent, const LinkChanges & iChanges, unsigned long & oFirstChange); //oFirstChange is the offset of the first modified byte
 bool printLinkInfo(const char * iFilePath);
 std::string getLinkCommand(const char * iFilePath);
+bool getStats(Stats & oStats);
 
 }; //lnk
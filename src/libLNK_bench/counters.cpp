@@ -0,0 +1,131 @@
+#include "counters.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+#ifdef WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h> //for GetProcessIoCounters()
+#include <io.h>      //for _dup()
+#include <fcntl.h>
+#else
+#include <unistd.h>  //for dup()
+#include <fcntl.h>
+#endif
+
+//the replacement operators must match the exception specification of the compiler
+#if __cplusplus >= 201103L
+#define BENCH_THROW_BAD_ALLOC
+#define BENCH_THROW_NOTHING noexcept
+#else
+#define BENCH_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define BENCH_THROW_NOTHING throw()
+#endif
+
+//the benchmark is single threaded
+static uint64_t gAllocationCount = 0;
+
+void * countedAllocation(size_t iSize)
+{
+  gAllocationCount++;
+  void * address = malloc(iSize > 0 ? iSize : 1);
+  if (address == NULL)
+    throw std::bad_alloc();
+  return address;
+}
+
+void * operator new(size_t iSize) BENCH_THROW_BAD_ALLOC
+{
+  return countedAllocation(iSize);
+}
+
+void * operator new[](size_t iSize) BENCH_THROW_BAD_ALLOC
+{
+  return countedAllocation(iSize);
+}
+
+void operator delete(void * iAddress) BENCH_THROW_NOTHING
+{
+  free(iAddress);
+}
+
+void operator delete[](void * iAddress) BENCH_THROW_NOTHING
+{
+  free(iAddress);
+}
+
+namespace bench
+{
+
+  uint64_t getAllocationCount()
+  {
+    return gAllocationCount;
+  }
+
+  bool getSyscallCount(uint64_t & oCount)
+  {
+    oCount = 0;
+#ifdef WIN32
+    IO_COUNTERS counters = {0};
+    if (!GetProcessIoCounters(GetCurrentProcess(), &counters))
+      return false;
+    oCount = counters.ReadOperationCount + counters.WriteOperationCount + counters.OtherOperationCount;
+    return true;
+#else
+    FILE * f = fopen("/proc/self/io", "r");
+    if (!f)
+      return false;
+    char line[256];
+    unsigned long long value = 0;
+    while (fgets(line, sizeof(line), f))
+    {
+      if (sscanf(line, "syscr: %llu", &value) == 1 || sscanf(line, "syscw: %llu", &value) == 1)
+        oCount += value;
+    }
+    fclose(f);
+    return true;
+#endif
+  }
+
+  static int gStdoutCopy = -1;
+
+  bool silenceStdout()
+  {
+    fflush(stdout);
+#ifdef WIN32
+    int nullDevice = _open("NUL", _O_WRONLY);
+    if (nullDevice < 0)
+      return false;
+    gStdoutCopy = _dup(_fileno(stdout));
+    _dup2(nullDevice, _fileno(stdout));
+    _close(nullDevice);
+#else
+    int nullDevice = open("/dev/null", O_WRONLY);
+    if (nullDevice < 0)
+      return false;
+    gStdoutCopy = dup(fileno(stdout));
+    dup2(nullDevice, fileno(stdout));
+    close(nullDevice);
+#endif
+    return true;
+  }
+
+  void restoreStdout()
+  {
+    if (gStdoutCopy < 0)
+      return;
+    fflush(stdout);
+#ifdef WIN32
+    _dup2(gStdoutCopy, _fileno(stdout));
+    _close(gStdoutCopy);
+#else
+    dup2(gStdoutCopy, fileno(stdout));
+    close(gStdoutCopy);
+#endif
+    gStdoutCopy = -1;
+  }
+
+}; //bench
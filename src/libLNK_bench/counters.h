@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace bench
+{
+
+  ///<summary>
+  ///Returns the number of dynamic allocations done by the process since it started.
+  ///Allocations are counted by replacing the global operator new.
+  ///</summary>
+  ///<return>Returns the number of calls to operator new and operator new[].<return>
+  uint64_t getAllocationCount();
+
+  ///<summary>
+  ///Returns the number of I/O system calls done by the process since it started.
+  ///On Windows, the value is the number of I/O operations (GetProcessIoCounters).
+  ///On Linux, the value is the number of read and write system calls (/proc/self/io).
+  ///</summary>
+  ///<param name="oCount">The number of system calls.</param>
+  ///<return>Returns true if the platform supports the counter. Returns false otherwise.<return>
+  bool getSyscallCount(uint64_t & oCount);
+
+  ///<summary>
+  ///Redirects the standard output to the null device.
+  ///Used to measure functions which are printing to the console.
+  ///</summary>
+  ///<return>Returns true when the standard output is redirected. Returns false otherwise.<return>
+  bool silenceStdout();
+
+  ///<summary>
+  ///Restores the standard output redirected by silenceStdout().
+  ///</summary>
+  void restoreStdout();
+
+}; //bench
@@ -0,0 +1,408 @@
+// main.cpp : Benchmarks of the public API of libLNK.
+//            Measures each function on a corpus of files and writes
+//            the results to a machine-readable JSON file.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "libLNK.h"
+#include "MemoryBuffer.h"
+#include "Trace.h"
+#include "nativefunc.h"
+#include "filesystemfunc.h"
+#include "stringfunc.h"
+#include "counters.h"
+
+struct CORPUS
+{
+  std::string name;
+  std::vector<std::string> files;
+  std::vector<lnk::MemoryBuffer> contents;
+  std::vector<lnk::LinkInfo> infos;
+  uint64_t bytes;
+};
+
+struct RESULT
+{
+  std::string name;
+  std::string corpus;
+  uint64_t operations;
+  uint64_t failures;
+  uint64_t bytes;
+  uint64_t nanoseconds;
+  uint64_t allocations;
+  uint64_t syscalls;
+  bool hasSyscalls;
+};
+
+struct OPTIONS
+{
+  std::string fixtures;
+  std::string output;
+  std::string trace;
+  unsigned long iterations;
+  unsigned long numSynthetic;
+};
+
+//Runs a single operation on the file at index iIndex of the corpus.
+typedef bool (*OPERATION)(const CORPUS & iCorpus, size_t iIndex, const std::string & iOutputPath);
+
+bool benchIsLink(const CORPUS & iCorpus, size_t iIndex, const std::string & /*iOutputPath*/)
+{
+  return lnk::isLink(iCorpus.files[iIndex].c_str());
+}
+
+bool benchGetLinkInfo(const CORPUS & iCorpus, size_t iIndex, const std::string & /*iOutputPath*/)
+{
+  lnk::LinkInfo info;
+  return lnk::getLinkInfo(iCorpus.files[iIndex].c_str(), info);
+}
+
+bool benchGetLinkInfoMemory(const CORPUS & iCorpus, size_t iIndex, const std::string & /*iOutputPath*/)
+{
+  const lnk::MemoryBuffer & content = iCorpus.contents[iIndex];
+  lnk::LinkInfo info;
+  lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+  return lnk::getLinkInfo(content.getBuffer(), content.getSize(), info, lnk::LNK_DEFAULT_PARSE_LIMITS, error);
+}
+
+bool benchGetLinkInfoReuse(const CORPUS & iCorpus, size_t iIndex, const std::string & /*iOutputPath*/)
+{
+  //the same objects are reused for all files, like a scanning loop
+  static lnk::MemoryBuffer content;
+  static lnk::LinkInfo info;
+  lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+  return content.loadFile(iCorpus.files[iIndex].c_str()) &&
+         lnk::getLinkInfo(content.getBuffer(), content.getSize(), info, lnk::LNK_DEFAULT_PARSE_LIMITS, error);
+}
+
+bool benchPrintLinkInfo(const CORPUS & iCorpus, size_t iIndex, const std::string & /*iOutputPath*/)
+{
+  return lnk::printLinkInfo(iCorpus.files[iIndex].c_str());
+}
+
+bool benchGetLinkCommand(const CORPUS & iCorpus, size_t iIndex, const std::string & /*iOutputPath*/)
+{
+  std::string command = lnk::getLinkCommand(iCorpus.files[iIndex].c_str());
+  return !command.empty();
+}
+
+bool benchCreateLink(const CORPUS & iCorpus, size_t iIndex, const std::string & iOutputPath)
+{
+  return lnk::createLink(iOutputPath.c_str(), iCorpus.infos[iIndex]);
+}
+
+struct BENCHMARK
+{
+  const char * name;
+  OPERATION operation;
+  bool silent; //the operation prints to the standard output
+};
+
+static const BENCHMARK BENCHMARKS[] = {
+  {"isLink",              &benchIsLink,             false},
+  {"getLinkInfo",         &benchGetLinkInfo,        false},
+  {"getLinkInfo.memory",  &benchGetLinkInfoMemory,  false},
+  {"getLinkInfo.reuse",   &benchGetLinkInfoReuse,   false},
+  {"printLinkInfo",       &benchPrintLinkInfo,      true },
+  {"getLinkCommand",      &benchGetLinkCommand,     false},
+  {"createLink",          &benchCreateLink,         false},
+};
+static const size_t NUM_BENCHMARKS = sizeof(BENCHMARKS)/sizeof(BENCHMARKS[0]);
+
+bool loadCorpus(CORPUS & ioCorpus)
+{
+  ioCorpus.bytes = 0;
+  ioCorpus.contents.resize(ioCorpus.files.size());
+  ioCorpus.infos.resize(ioCorpus.files.size());
+  for(size_t i=0; i<ioCorpus.files.size(); i++)
+  {
+    if (!ioCorpus.contents[i].loadFile(ioCorpus.files[i].c_str()))
+      return false;
+    ioCorpus.bytes += ioCorpus.contents[i].getSize();
+    lnk::getLinkInfo(ioCorpus.files[i].c_str(), ioCorpus.infos[i]);
+  }
+  return true;
+}
+
+bool buildFixturesCorpus(const std::string & iFolder, CORPUS & oCorpus)
+{
+  oCorpus.name = "fixtures";
+
+  std::vector<std::string> files;
+  if (!filesystem::findFiles(iFolder.c_str(), false, files))
+    return false;
+
+  //only keep the testWin7* and testWinXp* links
+  for(size_t i=0; i<files.size(); i++)
+  {
+    std::string filename = filesystem::getFilename(files[i].c_str());
+    std::string extension = filesystem::getFileExtention(files[i]);
+    bool isTestLink = (filename.find("testWin7") == 0 || filename.find("testWinXp") == 0);
+    if (isTestLink && extension == "lnk")
+      oCorpus.files.push_back(files[i]);
+  }
+
+  return !oCorpus.files.empty() && loadCorpus(oCorpus);
+}
+
+bool buildSyntheticCorpus(unsigned long iSize, CORPUS & oCorpus)
+{
+  oCorpus.name = "synthetic";
+
+  //links with various path depths and string lengths, all created with createLink()
+  const std::string basePath = filesystem::getTemporaryFilePath();
+  for(unsigned long i=0; i<iSize; i++)
+  {
+    std::string id = stringfunc::toString(i);
+
+    lnk::LinkInfo info;
+    info.target = "C:\\libLNK_bench";
+    for(unsigned long depth=0; depth<(i%8); depth++)
+      info.target += "\\Folder " + stringfunc::toString(depth);
+    info.target += "\\File name number " + id + ".txt";
+    info.arguments = (i%2 == 0 ? "" : "/argument " + id);
+    info.description = std::string(i%64, 'd');
+    info.workingDirectory = (i%3 == 0 ? "" : "C:\\libLNK_bench");
+    info.customIcon.filename = (i%4 == 0 ? "" : "%SystemRoot%\\system32\\SHELL32.dll");
+    info.customIcon.index = (int)(i%4);
+    info.hotKey = lnk::LNK_NO_HOTKEY;
+
+    std::string path = basePath + "." + id + ".lnk";
+    if (!lnk::createLink(path.c_str(), info))
+      return false;
+    oCorpus.files.push_back(path);
+  }
+
+  return loadCorpus(oCorpus);
+}
+
+void deleteCorpus(const CORPUS & iCorpus)
+{
+  for(size_t i=0; i<iCorpus.files.size(); i++)
+    remove(iCorpus.files[i].c_str());
+}
+
+RESULT run(const BENCHMARK & iBenchmark, const CORPUS & iCorpus, const OPTIONS & iOptions, const std::string & iOutputPath)
+{
+  RESULT result;
+  result.name = iBenchmark.name;
+  result.corpus = iCorpus.name;
+  result.operations = 0;
+  result.failures = 0;
+  result.bytes = 0;
+
+  if (iBenchmark.silent)
+    bench::silenceStdout();
+
+  //warm up file system caches
+  for(size_t i=0; i<iCorpus.files.size(); i++)
+    iBenchmark.operation(iCorpus, i, iOutputPath);
+
+  uint64_t syscallsStart = 0;
+  result.hasSyscalls = bench::getSyscallCount(syscallsStart);
+  uint64_t allocationsStart = bench::getAllocationCount();
+  uint64_t timeStart = nativefunc::getHighResolutionTime();
+
+  for(unsigned long iteration=0; iteration<iOptions.iterations; iteration++)
+  {
+    for(size_t i=0; i<iCorpus.files.size(); i++)
+    {
+      bool success = iBenchmark.operation(iCorpus, i, iOutputPath);
+      if (!success)
+        result.failures++;
+      result.operations++;
+      result.bytes += iCorpus.contents[i].getSize();
+    }
+  }
+
+  uint64_t timeEnd = nativefunc::getHighResolutionTime();
+  uint64_t allocationsEnd = bench::getAllocationCount();
+  uint64_t syscallsEnd = 0;
+  bench::getSyscallCount(syscallsEnd);
+
+  if (iBenchmark.silent)
+    bench::restoreStdout();
+
+  result.nanoseconds = timeEnd - timeStart;
+  result.allocations = allocationsEnd - allocationsStart;
+  result.syscalls = syscallsEnd - syscallsStart;
+  return result;
+}
+
+//Records a Chrome trace of a single pass of each benchmark over each corpus.
+bool saveTrace(const std::vector<CORPUS> & iCorpora, const std::string & iOutputPath, const std::string & iTracePath)
+{
+  lnk::TraceRecorder recorder;
+  if (!recorder.start())
+  {
+    printf("Tracing is compiled out of libLNK\n");
+    return false;
+  }
+
+  for(size_t c=0; c<iCorpora.size(); c++)
+  {
+    for(size_t b=0; b<NUM_BENCHMARKS; b++)
+    {
+      const BENCHMARK & benchmark = BENCHMARKS[b];
+      if (benchmark.silent)
+        bench::silenceStdout();
+      for(size_t i=0; i<iCorpora[c].files.size(); i++)
+        benchmark.operation(iCorpora[c], i, iOutputPath);
+      if (benchmark.silent)
+        bench::restoreStdout();
+    }
+  }
+
+  recorder.stop();
+  return recorder.save(iTracePath.c_str());
+}
+
+double perOperation(uint64_t iValue, const RESULT & iResult)
+{
+  return (iResult.operations > 0 ? (double)iValue / (double)iResult.operations : 0.0);
+}
+
+double perSecond(double iValue, const RESULT & iResult)
+{
+  return (iResult.nanoseconds > 0 ? iValue * 1e9 / (double)iResult.nanoseconds : 0.0);
+}
+
+bool saveReport(const std::string & iPath, const OPTIONS & iOptions, const std::vector<RESULT> & iResults)
+{
+  FILE * f = fopen(iPath.c_str(), "w");
+  if (!f)
+    return false;
+
+  fprintf(f, "{\n");
+  fprintf(f, "  \"version\": \"%s\",\n", lnk::getVersionString());
+  fprintf(f, "  \"iterations\": %lu,\n", iOptions.iterations);
+  fprintf(f, "  \"benchmarks\": [\n");
+  for(size_t i=0; i<iResults.size(); i++)
+  {
+    const RESULT & r = iResults[i];
+    fprintf(f, "    {\n");
+    fprintf(f, "      \"name\": \"%s\",\n", r.name.c_str());
+    fprintf(f, "      \"corpus\": \"%s\",\n", r.corpus.c_str());
+    fprintf(f, "      \"operations\": %llu,\n", (unsigned long long)r.operations);
+    fprintf(f, "      \"failures\": %llu,\n", (unsigned long long)r.failures);
+    fprintf(f, "      \"bytes\": %llu,\n", (unsigned long long)r.bytes);
+    fprintf(f, "      \"elapsedNs\": %llu,\n", (unsigned long long)r.nanoseconds);
+    fprintf(f, "      \"nsPerOp\": %.1f,\n", perOperation(r.nanoseconds, r));
+    fprintf(f, "      \"filesPerSecond\": %.1f,\n", perSecond((double)r.operations, r));
+    fprintf(f, "      \"mbPerSecond\": %.3f,\n", perSecond((double)r.bytes, r) / (1024.0*1024.0));
+    fprintf(f, "      \"allocationsPerOp\": %.2f,\n", perOperation(r.allocations, r));
+    if (r.hasSyscalls)
+      fprintf(f, "      \"syscallsPerOp\": %.2f\n", perOperation(r.syscalls, r));
+    else
+      fprintf(f, "      \"syscallsPerOp\": null\n");
+    fprintf(f, "    }%s\n", (i+1<iResults.size() ? "," : ""));
+  }
+  fprintf(f, "  ]\n");
+  fprintf(f, "}\n");
+
+  fclose(f);
+  return true;
+}
+
+void printUsage()
+{
+  printf("Usage: libLNK_bench [options]\n");
+  printf("Measures the public API of libLNK and writes the results to a JSON file.\n");
+  printf("\n");
+  printf("Options:\n");
+  printf("  --fixtures DIR     Folder of the testWin7* and testWinXp* links. Default is ./tests.\n");
+  printf("  --synthetic N      Number of links of the synthetic corpus. Default is 100.\n");
+  printf("  --iterations N     Number of runs over each corpus. Default is 20.\n");
+  printf("  --output FILE      Path of the JSON report. Default is libLNK_bench.json.\n");
+  printf("  --trace FILE       Also record a Chrome trace of a single run of each benchmark.\n");
+}
+
+int main(int argc, char **argv)
+{
+  OPTIONS options;
+  options.fixtures = "./tests";
+  options.output = "libLNK_bench.json";
+  options.iterations = 20;
+  options.numSynthetic = 100;
+
+  for(int i=1; i<argc; i++)
+  {
+    std::string arg = argv[i];
+    bool hasValue = (i+1 < argc);
+    if (arg == "--fixtures" && hasValue)
+      options.fixtures = argv[++i];
+    else if (arg == "--synthetic" && hasValue)
+      options.numSynthetic = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--iterations" && hasValue)
+      options.iterations = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--output" && hasValue)
+      options.output = argv[++i];
+    else if (arg == "--trace" && hasValue)
+      options.trace = argv[++i];
+    else
+    {
+      printUsage();
+      return (arg == "--help" || arg == "-h" ? 0 : 1);
+    }
+  }
+  if (options.iterations == 0)
+    options.iterations = 1;
+
+  std::vector<CORPUS> corpora(2);
+  if (!buildFixturesCorpus(options.fixtures, corpora[0]))
+  {
+    printf("Unable to load fixtures from '%s'\n", options.fixtures.c_str());
+    return 1;
+  }
+  if (!buildSyntheticCorpus(options.numSynthetic, corpora[1]))
+  {
+    printf("Unable to create the synthetic corpus\n");
+    deleteCorpus(corpora[1]);
+    return 1;
+  }
+
+  const std::string outputPath = filesystem::getTemporaryFilePath() + ".lnk";
+
+  std::vector<RESULT> results;
+  printf("%-20s %-10s %12s %12s %10s %10s %10s %8s\n", "benchmark", "corpus", "ns/op", "files/s", "MB/s", "allocs/op", "sysc/op", "failures");
+  for(size_t c=0; c<corpora.size(); c++)
+  {
+    for(size_t b=0; b<NUM_BENCHMARKS; b++)
+    {
+      RESULT r = run(BENCHMARKS[b], corpora[c], options, outputPath);
+      results.push_back(r);
+      printf("%-20s %-10s %12.1f %12.1f %10.3f %10.2f %10.2f %8llu\n",
+        r.name.c_str(),
+        r.corpus.c_str(),
+        perOperation(r.nanoseconds, r),
+        perSecond((double)r.operations, r),
+        perSecond((double)r.bytes, r) / (1024.0*1024.0),
+        perOperation(r.allocations, r),
+        perOperation(r.syscalls, r),
+        (unsigned long long)r.failures);
+    }
+  }
+
+  if (!options.trace.empty())
+  {
+    if (saveTrace(corpora, outputPath, options.trace))
+      printf("Trace saved to '%s'\n", options.trace.c_str());
+    else
+      printf("Unable to save trace to '%s'\n", options.trace.c_str());
+  }
+
+  remove(outputPath.c_str());
+  deleteCorpus(corpora[1]);
+
+  if (!saveReport(options.output, options, results))
+  {
+    printf("Unable to save report to '%s'\n", options.output.c_str());
+    return 1;
+  }
+  printf("Report saved to '%s'\n", options.output.c_str());
+  return 0;
+}
@@ -0,0 +1,338 @@
+#include "generator.h"
+
+#include <string.h>
+#include <vector>
+
+#include "filesystemfunc.h"
+#include "stringfunc.h"
+
+namespace corpus
+{
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // Defines, Pre-declarations & typedefs
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  static const char * WORDS[] = {
+    "Documents", "Projects", "Reports", "Photos", "Archive", "Budget", "Invoices", "Music", "Backup", "Drafts",
+    "Meeting notes", "Q3", "2017", "final", "v2", "old", "Shared", "Setup", "Tools", "Data",
+    "Clients", "Templates", "Scans", "Work", "Personal", "Program Files", "Source", "Build", "Release", "Temp",
+  };
+  static const size_t NUM_WORDS = sizeof(WORDS)/sizeof(WORDS[0]);
+
+  //accented names are limited to Latin-1 since the library handles 8 bits strings
+  static const char * ACCENTED_WORDS[] = {
+    "Caf\xe9", "R\xe9sum\xe9", "Na\xefve", "\xc9t\xe9", "Stra\xdf" "e", "Se\xf1or", "Fa\xe7" "ade", "M\xfcller", "\xc5ngstr\xf6m", "Ann\xe9" "e",
+    "D\xe9p\xf4t", "Bj\xf6rk", "S\xe3o Paulo", "Gar\xe7on", "Z\xfcrich", "Pr\xe9sentation", "R\xe9union", "Cr\xe8me", "\xd8resund", "Ni\xf1o",
+  };
+  static const size_t NUM_ACCENTED_WORDS = sizeof(ACCENTED_WORDS)/sizeof(ACCENTED_WORDS[0]);
+
+  static const char * SEPARATORS[] = { " ", "_", "-", "." };
+  static const size_t NUM_SEPARATORS = sizeof(SEPARATORS)/sizeof(SEPARATORS[0]);
+
+  static const char * EXTENSIONS[] = { "txt", "docx", "xlsx", "pdf", "exe", "jpg", "png", "zip", "html", "bat", "msi", "mp3" };
+  static const size_t NUM_EXTENSIONS = sizeof(EXTENSIONS)/sizeof(EXTENSIONS[0]);
+
+  static const char * ICONS[] = {
+    "%SystemRoot%\\system32\\SHELL32.dll",
+    "%SystemRoot%\\system32\\imageres.dll",
+    "C:\\Windows\\explorer.exe",
+    "%ProgramFiles%\\Internet Explorer\\iexplore.exe",
+  };
+  static const size_t NUM_ICONS = sizeof(ICONS)/sizeof(ICONS[0]);
+
+  static const char LOCAL_DRIVES[] = "CDEF";
+  static const char NETWORK_DRIVES[] = "HMNPSZ";
+
+  //ExtraData blocks (MS-SHLLINK 2.5)
+  static const uint32_t ENVIRONMENT_VARIABLE_DATABLOCK = 0xA0000001;
+  static const uint32_t TRACKER_DATABLOCK              = 0xA0000003;
+  static const uint32_t CONSOLE_FE_DATABLOCK           = 0xA0000004;
+  static const uint32_t SPECIAL_FOLDER_DATABLOCK       = 0xA0000005;
+  static const uint32_t KNOWN_FOLDER_DATABLOCK         = 0xA000000B;
+  static const size_t ENVIRONMENT_VARIABLE_PATH_SIZE = 260; //in characters
+
+  //LinkFlags of the ShellLinkHeader
+  static const size_t LINK_FLAGS_OFFSET = 20;
+  static const uint32_t HAS_EXP_STRING = 0x00000200;
+
+  const GENERATOR_OPTIONS DEFAULT_GENERATOR_OPTIONS = {
+    1,                    //seed
+    DISTRIBUTION_SKEWED,  //distribution
+    12,                   //maxDepth
+    64,                   //maxNameLength
+    1024,                 //maxStringLength
+    20,                   //accentedPercent
+    10,                   //networkPercent
+    30,                   //extraDataPercent
+  };
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // Random
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  Random::Random(uint64_t iSeed)
+  {
+    //splitmix64 spreads close seeds over the whole state
+    uint64_t z = iSeed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    mState = (z != 0 ? z : 0x9E3779B97F4A7C15ULL); //the state must not be zero
+  }
+
+  uint32_t Random::next()
+  {
+    mState ^= mState >> 12;
+    mState ^= mState << 25;
+    mState ^= mState >> 27;
+    return (uint32_t)((mState * 0x2545F4914F6CDD1DULL) >> 32);
+  }
+
+  uint32_t Random::next(uint32_t iCount)
+  {
+    if (iCount == 0)
+      return 0;
+    return (uint32_t)(((uint64_t)next() * iCount) >> 32);
+  }
+
+  double Random::nextDouble()
+  {
+    return (double)next() / 4294967296.0;
+  }
+
+  bool Random::chance(uint32_t iPercent)
+  {
+    return next(100) < iPercent;
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // global functions
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  unsigned long sample(Random & ioRandom, DISTRIBUTION iDistribution, unsigned long iMin, unsigned long iMax)
+  {
+    if (iMax <= iMin)
+      return iMin;
+    double value = ioRandom.nextDouble();
+    if (iDistribution == DISTRIBUTION_SKEWED)
+      value = value * value * value; //most values are close to iMin
+    return iMin + (unsigned long)(value * (double)(iMax - iMin + 1));
+  }
+
+  std::string generateText(Random & ioRandom, unsigned long iLength, bool iAccented)
+  {
+    std::string text;
+    while(text.size() < iLength)
+    {
+      if (!text.empty())
+        text += SEPARATORS[ioRandom.next((uint32_t)NUM_SEPARATORS)];
+      if (iAccented && ioRandom.chance(50))
+        text += ACCENTED_WORDS[ioRandom.next((uint32_t)NUM_ACCENTED_WORDS)];
+      else
+        text += WORDS[ioRandom.next((uint32_t)NUM_WORDS)];
+    }
+    text.resize(iLength);
+    return text;
+  }
+
+  std::string generateName(Random & ioRandom, const GENERATOR_OPTIONS & iOptions)
+  {
+    unsigned long length = sample(ioRandom, iOptions.distribution, 1, iOptions.maxNameLength);
+    bool accented = ioRandom.chance(iOptions.accentedPercent);
+    std::string name = generateText(ioRandom, length, accented);
+
+    //Windows does not allow names ending with a space or a dot
+    char & last = name[name.size() - 1];
+    if (last == ' ' || last == '.')
+      last = '_';
+    return name;
+  }
+
+  void generateLinkInfo(const GENERATOR_OPTIONS & iOptions, Random & ioRandom, lnk::LinkInfo & oLinkInfo, lnk::LNK_TARGET & oTarget)
+  {
+    bool isNetworkTarget = ioRandom.chance(iOptions.networkPercent);
+
+    //path with at least a drive/folder/filename structure
+    std::string drive;
+    if (isNetworkTarget)
+      drive += NETWORK_DRIVES[ioRandom.next((uint32_t)sizeof(NETWORK_DRIVES) - 1)];
+    else
+      drive += LOCAL_DRIVES[ioRandom.next((uint32_t)sizeof(LOCAL_DRIVES) - 1)];
+    drive += ':';
+
+    std::string folder;
+    unsigned long depth = sample(ioRandom, iOptions.distribution, 1, iOptions.maxDepth);
+    for(unsigned long i=0; i<depth; i++)
+    {
+      folder += '\\';
+      folder += generateName(ioRandom, iOptions);
+    }
+
+    oTarget.isFolder = ioRandom.chance(10);
+    oTarget.isFile = !oTarget.isFolder;
+    oTarget.fileSize = (oTarget.isFile ? sample(ioRandom, iOptions.distribution, 0, 0x7FFFFFFF) : 0);
+
+    std::string filename = generateName(ioRandom, iOptions);
+    if (oTarget.isFile)
+    {
+      filename += '.';
+      filename += EXTENSIONS[ioRandom.next((uint32_t)NUM_EXTENSIONS)];
+    }
+
+    oLinkInfo.target = drive + folder + '\\' + filename;
+    oTarget.shortPath = filesystem::getShortPathFormEstimation(oLinkInfo.target);
+
+    oLinkInfo.networkPath = "";
+    if (isNetworkTarget)
+    {
+      //mapped drive
+      oLinkInfo.networkPath = "\\\\server";
+      oLinkInfo.networkPath += stringfunc::toString(ioRandom.next(100));
+      oLinkInfo.networkPath += "\\share";
+      oLinkInfo.networkPath += stringfunc::toString(ioRandom.next(10));
+      oLinkInfo.networkPath += folder + '\\' + filename;
+    }
+
+    oLinkInfo.arguments = "";
+    if (ioRandom.chance(40))
+      oLinkInfo.arguments = generateText(ioRandom, sample(ioRandom, iOptions.distribution, 1, iOptions.maxStringLength), false);
+
+    oLinkInfo.description = "";
+    if (ioRandom.chance(50))
+      oLinkInfo.description = generateText(ioRandom, sample(ioRandom, iOptions.distribution, 1, iOptions.maxStringLength), ioRandom.chance(iOptions.accentedPercent));
+
+    oLinkInfo.workingDirectory = "";
+    if (ioRandom.chance(60))
+      oLinkInfo.workingDirectory = drive + folder;
+
+    oLinkInfo.customIcon.filename = "";
+    oLinkInfo.customIcon.index = 0;
+    if (ioRandom.chance(40))
+    {
+      oLinkInfo.customIcon.filename = ICONS[ioRandom.next((uint32_t)NUM_ICONS)];
+      oLinkInfo.customIcon.index = ioRandom.next(300);
+    }
+
+    oLinkInfo.hotKey = lnk::LNK_NO_HOTKEY;
+    if (ioRandom.chance(5))
+    {
+      oLinkInfo.hotKey.keyCode = (uint8_t)(lnk::LNK_HK_A + ioRandom.next(26));
+      oLinkInfo.hotKey.modifiers = (uint8_t)(lnk::LNK_HK_MOD_CONTROL | lnk::LNK_HK_MOD_ALT);
+    }
+  }
+
+  void appendBlock(uint32_t iSignature, const unsigned char * iData, size_t iSize, std::vector<unsigned char> & ioBlocks)
+  {
+    uint32_t header[2];
+    header[0] = (uint32_t)(sizeof(header) + iSize); //BlockSize
+    header[1] = iSignature;
+    const unsigned char * headerBytes = (const unsigned char *)header;
+    ioBlocks.insert(ioBlocks.end(), headerBytes, headerBytes + sizeof(header));
+    ioBlocks.insert(ioBlocks.end(), iData, iData + iSize);
+  }
+
+  void appendRandomBytes(Random & ioRandom, size_t iSize, std::vector<unsigned char> & ioData)
+  {
+    for(size_t i=0; i<iSize; i++)
+      ioData.push_back((unsigned char)ioRandom.next(256));
+  }
+
+  bool appendExtraData(Random & ioRandom, const lnk::LinkInfo & iLinkInfo, lnk::MemoryBuffer & ioContent)
+  {
+    bool hasExpString = false;
+    std::vector<unsigned char> blocks;
+
+    unsigned long numBlocks = 1 + ioRandom.next(3);
+    for(unsigned long i=0; i<numBlocks; i++)
+    {
+      std::vector<unsigned char> data;
+      switch(ioRandom.next(5))
+      {
+      case 0:
+        {
+          //TargetAnsi and TargetUnicode
+          std::string target = iLinkInfo.target.substr(0, ENVIRONMENT_VARIABLE_PATH_SIZE - 1);
+          data.resize(ENVIRONMENT_VARIABLE_PATH_SIZE*3, 0);
+          memcpy(&data[0], target.c_str(), target.size());
+          for(size_t j=0; j<target.size(); j++)
+            data[ENVIRONMENT_VARIABLE_PATH_SIZE + 2*j] = (unsigned char)target[j];
+          appendBlock(ENVIRONMENT_VARIABLE_DATABLOCK, &data[0], data.size(), blocks);
+          hasExpString = true;
+        }
+        break;
+      case 1:
+        {
+          //Length, Version, MachineID, Droid and DroidBirth
+          static const uint32_t TRACKER_LENGTH = 0x58;
+          static const uint32_t TRACKER_VERSION = 0;
+          data.insert(data.end(), (const unsigned char *)&TRACKER_LENGTH, (const unsigned char *)&TRACKER_LENGTH + sizeof(TRACKER_LENGTH));
+          data.insert(data.end(), (const unsigned char *)&TRACKER_VERSION, (const unsigned char *)&TRACKER_VERSION + sizeof(TRACKER_VERSION));
+          std::string machine = "pc-" + stringfunc::toString(ioRandom.next(10000));
+          machine.resize(16, '\0');
+          data.insert(data.end(), machine.begin(), machine.end());
+          appendRandomBytes(ioRandom, 64, data);
+          appendBlock(TRACKER_DATABLOCK, &data[0], data.size(), blocks);
+        }
+        break;
+      case 2:
+        {
+          //CodePage
+          static const uint32_t CODE_PAGES[] = { 437, 850, 1252, 65001 };
+          uint32_t codePage = CODE_PAGES[ioRandom.next((uint32_t)(sizeof(CODE_PAGES)/sizeof(CODE_PAGES[0])))];
+          data.insert(data.end(), (const unsigned char *)&codePage, (const unsigned char *)&codePage + sizeof(codePage));
+          appendBlock(CONSOLE_FE_DATABLOCK, &data[0], data.size(), blocks);
+        }
+        break;
+      case 3:
+        {
+          //SpecialFolderID and Offset
+          appendRandomBytes(ioRandom, 8, data);
+          appendBlock(SPECIAL_FOLDER_DATABLOCK, &data[0], data.size(), blocks);
+        }
+        break;
+      default:
+        {
+          //KnownFolderID and Offset
+          appendRandomBytes(ioRandom, 20, data);
+          appendBlock(KNOWN_FOLDER_DATABLOCK, &data[0], data.size(), blocks);
+        }
+        break;
+      };
+    }
+
+    //insert the blocks before the TerminalBlock which ends the link
+    static const unsigned long TERMINAL_BLOCK_SIZE = sizeof(uint32_t);
+    unsigned long oldSize = ioContent.getSize();
+    unsigned long newSize = oldSize + (unsigned long)blocks.size();
+    if (oldSize < TERMINAL_BLOCK_SIZE || !ioContent.reallocate(newSize))
+      return false;
+    unsigned char * content = ioContent.getBuffer();
+    memcpy(&content[oldSize - TERMINAL_BLOCK_SIZE], &blocks[0], blocks.size());
+    memset(&content[newSize - TERMINAL_BLOCK_SIZE], 0, TERMINAL_BLOCK_SIZE);
+
+    if (hasExpString)
+    {
+      uint32_t flags = 0;
+      memcpy(&flags, &content[LINK_FLAGS_OFFSET], sizeof(flags));
+      flags |= HAS_EXP_STRING;
+      memcpy(&content[LINK_FLAGS_OFFSET], &flags, sizeof(flags));
+    }
+    return true;
+  }
+
+  bool generateLink(const GENERATOR_OPTIONS & iOptions, unsigned long iIndex, lnk::MemoryBuffer & oContent)
+  {
+    //each link has its own sequence which makes it independent of the other links
+    Random random(((uint64_t)iOptions.seed << 32) | iIndex);
+
+    lnk::LinkInfo info;
+    lnk::LNK_TARGET target;
+    generateLinkInfo(iOptions, random, info, target);
+
+    if (!lnk::createLink(info, target, oContent))
+      return false;
+
+    if (random.chance(iOptions.extraDataPercent))
+      return appendExtraData(random, info, oContent);
+    return true;
+  }
+
+}; //corpus
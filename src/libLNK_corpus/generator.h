@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#include "libLNK.h"
+#include "MemoryBuffer.h"
+
+namespace corpus
+{
+
+  ///<summary>
+  ///Deterministic pseudo-random number generator (xorshift64*).
+  ///The same seed always produces the same sequence on every platform.
+  ///</summary>
+  class Random
+  {
+  public:
+    Random(uint64_t iSeed);
+
+    ///<summary>
+    ///Returns the next 32 bits value of the sequence.
+    ///</summary>
+    uint32_t next();
+
+    ///<summary>
+    ///Returns a value in the range [0, iCount[. Returns 0 if iCount is 0.
+    ///</summary>
+    uint32_t next(uint32_t iCount);
+
+    ///<summary>
+    ///Returns a value in the range [0.0, 1.0[.
+    ///</summary>
+    double nextDouble();
+
+    ///<summary>
+    ///Returns true iPercent times out of 100.
+    ///</summary>
+    bool chance(uint32_t iPercent);
+
+  private:
+    uint64_t mState;
+  };
+
+  //Distribution of path depths and string lengths
+  enum DISTRIBUTION
+  {
+    DISTRIBUTION_UNIFORM, //all values are equally likely
+    DISTRIBUTION_SKEWED,  //mostly short values with a long tail, like real file systems
+  };
+
+  struct GENERATOR_OPTIONS
+  {
+    unsigned long seed;
+    DISTRIBUTION distribution;
+    unsigned long maxDepth;         //number of folders between the drive and the file
+    unsigned long maxNameLength;    //in characters, for each folder and file name
+    unsigned long maxStringLength;  //in characters, for arguments and description
+    unsigned long accentedPercent;  //names with accented (Latin-1) characters
+    unsigned long networkPercent;   //targets located on a mapped network drive
+    unsigned long extraDataPercent; //links with ExtraData blocks
+  };
+  extern const GENERATOR_OPTIONS DEFAULT_GENERATOR_OPTIONS;
+
+  ///<summary>
+  ///Generates the properties of a random link and of its target.
+  ///</summary>
+  ///<param name="iOptions">The generator options.</param>
+  ///<param name="ioRandom">The random number generator.</param>
+  ///<param name="oLinkInfo">The properties of the link.</param>
+  ///<param name="oTarget">The properties of the target of the link.</param>
+  void generateLinkInfo(const GENERATOR_OPTIONS & iOptions, Random & ioRandom, lnk::LinkInfo & oLinkInfo, lnk::LNK_TARGET & oTarget);
+
+  ///<summary>
+  ///Generates the content of a random link in memory.
+  ///The link at a given index only depends on the index and the options.
+  ///</summary>
+  ///<param name="iOptions">The generator options.</param>
+  ///<param name="iIndex">The index of the link in the corpus.</param>
+  ///<param name="oContent">The binary content of the link.</param>
+  ///<return>Returns true if the link is generated. Returns false otherwise.<return>
+  bool generateLink(const GENERATOR_OPTIONS & iOptions, unsigned long iIndex, lnk::MemoryBuffer & oContent);
+
+}; //corpus
@@ -0,0 +1,225 @@
+// main.cpp : Generates a synthetic corpus of links for load testing.
+//            Links are built in memory and written to a folder tree
+//            or to a single tar archive. The same seed always produces
+//            the same corpus.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#include "generator.h"
+#include "tarwriter.h"
+#include "nativefunc.h"
+#include "filesystemfunc.h"
+#include "stringfunc.h"
+
+struct OPTIONS
+{
+  corpus::GENERATOR_OPTIONS generator;
+  unsigned long count;
+  unsigned long filesPerFolder;
+  std::string outputFolder;
+  std::string packFile;
+};
+
+void printUsage()
+{
+  const corpus::GENERATOR_OPTIONS & defaults = corpus::DEFAULT_GENERATOR_OPTIONS;
+  printf("Usage: libLNK_corpus [options] (--output DIR | --pack FILE)\n");
+  printf("Generates a synthetic corpus of links for load testing.\n");
+  printf("\n");
+  printf("Options:\n");
+  printf("  --output DIR            Write the links to a folder tree in DIR.\n");
+  printf("  --pack FILE             Write the links to a single tar archive.\n");
+  printf("  --count N               Number of links. Default is 1000.\n");
+  printf("  --seed N                Seed of the corpus. Default is %lu.\n", defaults.seed);
+  printf("  --distribution NAME     Distribution of path depths and string lengths: uniform or skewed. Default is skewed.\n");
+  printf("  --max-depth N           Maximum number of folders in a target path. Default is %lu.\n", defaults.maxDepth);
+  printf("  --max-name N            Maximum length of a folder or file name. Default is %lu.\n", defaults.maxNameLength);
+  printf("  --max-string N          Maximum length of the arguments and description. Default is %lu.\n", defaults.maxStringLength);
+  printf("  --accented N            Percentage of names with accented characters. Default is %lu.\n", defaults.accentedPercent);
+  printf("  --network N             Percentage of targets on a mapped network drive. Default is %lu.\n", defaults.networkPercent);
+  printf("  --extradata N           Percentage of links with ExtraData blocks. Default is %lu.\n", defaults.extraDataPercent);
+  printf("  --files-per-folder N    Number of links in each folder of the tree. Default is 1000.\n");
+}
+
+//Returns the path of a link relative to the root of the corpus: NNN/NNN/linkN.lnk
+std::string getRelativePath(unsigned long iIndex, unsigned long iFilesPerFolder, char iSeparator)
+{
+  char path[64];
+  sprintf(path, "%03lu%c%03lu%clink%lu.lnk",
+    iIndex / iFilesPerFolder / iFilesPerFolder, iSeparator,
+    (iIndex / iFilesPerFolder) % iFilesPerFolder, iSeparator,
+    iIndex);
+  return std::string(path);
+}
+
+bool saveFile(const std::string & iPath, const lnk::MemoryBuffer & iContent)
+{
+  FILE * f = fopen(iPath.c_str(), "wb");
+  if (!f)
+    return false;
+  size_t written = fwrite(iContent.getBuffer(), 1, iContent.getSize(), f);
+  fclose(f);
+  return (written == iContent.getSize());
+}
+
+int main(int argc, char **argv)
+{
+  OPTIONS options;
+  options.generator = corpus::DEFAULT_GENERATOR_OPTIONS;
+  options.count = 1000;
+  options.filesPerFolder = 1000;
+
+  for(int i=1; i<argc; i++)
+  {
+    std::string arg = argv[i];
+    bool hasValue = (i+1 < argc);
+    if (arg == "--help" || arg == "-h")
+    {
+      printUsage();
+      return 0;
+    }
+    else if (arg == "--output" && hasValue)
+      options.outputFolder = argv[++i];
+    else if (arg == "--pack" && hasValue)
+      options.packFile = argv[++i];
+    else if (arg == "--count" && hasValue)
+      options.count = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--seed" && hasValue)
+      options.generator.seed = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--distribution" && hasValue)
+    {
+      std::string name = argv[++i];
+      if (name == "uniform")
+        options.generator.distribution = corpus::DISTRIBUTION_UNIFORM;
+      else if (name == "skewed")
+        options.generator.distribution = corpus::DISTRIBUTION_SKEWED;
+      else
+      {
+        printf("Unknown distribution: %s\n", name.c_str());
+        return 1;
+      }
+    }
+    else if (arg == "--max-depth" && hasValue)
+      options.generator.maxDepth = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--max-name" && hasValue)
+      options.generator.maxNameLength = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--max-string" && hasValue)
+      options.generator.maxStringLength = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--accented" && hasValue)
+      options.generator.accentedPercent = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--network" && hasValue)
+      options.generator.networkPercent = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--extradata" && hasValue)
+      options.generator.extraDataPercent = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--files-per-folder" && hasValue)
+      options.filesPerFolder = strtoul(argv[++i], NULL, 10);
+    else
+    {
+      printf("Unknown option: %s\n", arg.c_str());
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (options.outputFolder.empty() == options.packFile.empty())
+  {
+    printf("One of --output or --pack must be specified.\n");
+    printUsage();
+    return 1;
+  }
+
+  //keep every string below the default parse limits
+  if (options.generator.maxDepth < 1)
+    options.generator.maxDepth = 1;
+  if (options.generator.maxNameLength < 1)
+    options.generator.maxNameLength = 1;
+  if (options.generator.maxNameLength > 255)
+    options.generator.maxNameLength = 255;
+  if (options.generator.maxDepth * (options.generator.maxNameLength + 1) > lnk::LNK_DEFAULT_PARSE_LIMITS.maxStringLength / 2)
+    options.generator.maxDepth = lnk::LNK_DEFAULT_PARSE_LIMITS.maxStringLength / 2 / (options.generator.maxNameLength + 1);
+  if (options.generator.maxStringLength > lnk::LNK_DEFAULT_PARSE_LIMITS.maxStringLength)
+    options.generator.maxStringLength = lnk::LNK_DEFAULT_PARSE_LIMITS.maxStringLength;
+  if (options.filesPerFolder < 1)
+    options.filesPerFolder = 1;
+
+  corpus::TarWriter pack;
+  if (!options.packFile.empty() && !pack.open(options.packFile.c_str()))
+  {
+    printf("Unable to create file '%s'\n", options.packFile.c_str());
+    return 1;
+  }
+  if (!options.outputFolder.empty() && !filesystem::createFolder(options.outputFolder.c_str()))
+  {
+    printf("Unable to create folder '%s'\n", options.outputFolder.c_str());
+    return 1;
+  }
+
+  const char separator = filesystem::getPathSeparator();
+  std::string lastFolder;
+  uint64_t bytes = 0;
+  uint64_t start = nativefunc::getHighResolutionTime();
+
+  for(unsigned long i=0; i<options.count; i++)
+  {
+    lnk::MemoryBuffer content;
+    if (!corpus::generateLink(options.generator, i, content))
+    {
+      printf("Unable to generate link %lu\n", i);
+      return 1;
+    }
+    bytes += content.getSize();
+
+    if (!options.packFile.empty())
+    {
+      //tar archives always use '/' as separator
+      std::string name = getRelativePath(i, options.filesPerFolder, '/');
+      if (!pack.add(name, content.getBuffer(), content.getSize()))
+      {
+        printf("Unable to write link %lu to '%s'\n", i, options.packFile.c_str());
+        return 1;
+      }
+    }
+    else
+    {
+      std::string path = options.outputFolder + separator + getRelativePath(i, options.filesPerFolder, separator);
+
+      //create the folders of the tree once
+      std::string folder = filesystem::getParentPath(path);
+      if (folder != lastFolder)
+      {
+        std::string parent = filesystem::getParentPath(folder);
+        if (!filesystem::createFolder(parent.c_str()) || !filesystem::createFolder(folder.c_str()))
+        {
+          printf("Unable to create folder '%s'\n", folder.c_str());
+          return 1;
+        }
+        lastFolder = folder;
+      }
+
+      if (!saveFile(path, content))
+      {
+        printf("Unable to write file '%s'\n", path.c_str());
+        return 1;
+      }
+    }
+
+    if ((i+1) % 100000 == 0)
+      printf("%lu links...\n", i+1);
+  }
+
+  if (!options.packFile.empty() && !pack.close())
+  {
+    printf("Unable to write file '%s'\n", options.packFile.c_str());
+    return 1;
+  }
+
+  uint64_t elapsed = nativefunc::getHighResolutionTime() - start;
+  double seconds = (double)elapsed / 1e9;
+  printf("%lu links, %llu bytes, seed %lu, in %.2f seconds (%.0f links/s)\n",
+    options.count, (unsigned long long)bytes, options.generator.seed, seconds, (seconds > 0.0 ? (double)options.count / seconds : 0.0));
+
+  return 0;
+}
@@ -0,0 +1,128 @@
+#include "tarwriter.h"
+
+#include <string.h>
+
+namespace corpus
+{
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // Defines, Pre-declarations & typedefs
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  static const size_t TAR_BLOCK_SIZE = 512;
+
+  //POSIX ustar header
+  struct TAR_HEADER
+  {
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char checksum[8];
+    char typeflag;
+    char linkname[100];
+    char magic[6];
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];
+    char padding[12];
+  };
+
+  //writes iValue as a NULL terminated octal number of iSize characters
+  void writeOctal(uint64_t iValue, char * oField, size_t iSize)
+  {
+    oField[iSize - 1] = '\0';
+    for(size_t i=iSize-1; i>0; i--)
+    {
+      oField[i-1] = (char)('0' + (iValue & 7));
+      iValue >>= 3;
+    }
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  // TarWriter
+  //----------------------------------------------------------------------------------------------------------------------------------------
+  TarWriter::TarWriter() :
+  mFile(NULL)
+  {
+  }
+
+  TarWriter::~TarWriter()
+  {
+    close();
+  }
+
+  bool TarWriter::open(const char * iPath)
+  {
+    close();
+    mFile = fopen(iPath, "wb");
+    return (mFile != NULL);
+  }
+
+  bool TarWriter::add(const std::string & iName, const unsigned char * iData, unsigned long iSize)
+  {
+    if (mFile == NULL)
+      return false;
+
+    TAR_HEADER header;
+    memset(&header, 0, sizeof(header));
+
+    //long names are split between prefix and name at a separator
+    if (iName.size() <= sizeof(header.name))
+    {
+      memcpy(header.name, iName.c_str(), iName.size());
+    }
+    else
+    {
+      size_t separator = iName.rfind('/', sizeof(header.prefix));
+      if (separator == std::string::npos || iName.size() - separator - 1 > sizeof(header.name))
+        return false; //name too long
+      memcpy(header.prefix, iName.c_str(), separator);
+      memcpy(header.name, iName.c_str() + separator + 1, iName.size() - separator - 1);
+    }
+
+    writeOctal(0644, header.mode, sizeof(header.mode));
+    writeOctal(0, header.uid, sizeof(header.uid));
+    writeOctal(0, header.gid, sizeof(header.gid));
+    writeOctal(iSize, header.size, sizeof(header.size));
+    writeOctal(0, header.mtime, sizeof(header.mtime)); //reproducible archives
+    header.typeflag = '0'; //regular file
+    memcpy(header.magic, "ustar", 6);
+    memcpy(header.version, "00", 2);
+
+    //the checksum is computed with the checksum field filled with spaces
+    memset(header.checksum, ' ', sizeof(header.checksum));
+    const unsigned char * bytes = (const unsigned char *)&header;
+    unsigned long checksum = 0;
+    for(size_t i=0; i<sizeof(header); i++)
+      checksum += bytes[i];
+    writeOctal(checksum, header.checksum, 7);
+
+    static const unsigned char PADDING[TAR_BLOCK_SIZE] = {0};
+    size_t paddingSize = (TAR_BLOCK_SIZE - (iSize % TAR_BLOCK_SIZE)) % TAR_BLOCK_SIZE;
+
+    bool success = true;
+    success = success && (fwrite(&header, 1, sizeof(header), mFile) == sizeof(header));
+    success = success && (fwrite(iData, 1, iSize, mFile) == iSize);
+    success = success && (fwrite(PADDING, 1, paddingSize, mFile) == paddingSize);
+    return success;
+  }
+
+  bool TarWriter::close()
+  {
+    if (mFile == NULL)
+      return false;
+
+    //the archive ends with two empty blocks
+    static const unsigned char END_OF_ARCHIVE[2*TAR_BLOCK_SIZE] = {0};
+    bool success = (fwrite(END_OF_ARCHIVE, 1, sizeof(END_OF_ARCHIVE), mFile) == sizeof(END_OF_ARCHIVE));
+    success = (fclose(mFile) == 0) && success;
+    mFile = NULL;
+    return success;
+  }
+
+}; //corpus
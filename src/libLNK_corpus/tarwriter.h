@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+
+namespace corpus
+{
+
+  ///<summary>
+  ///Writes files to a single archive in the POSIX ustar format.
+  ///The archive can be extracted with any tar implementation.
+  ///</summary>
+  class TarWriter
+  {
+  public:
+    TarWriter();
+    virtual ~TarWriter();
+
+    ///<summary>
+    ///Creates an empty archive. An existing file is overwritten.
+    ///</summary>
+    ///<param name="iPath">The path of the archive.</param>
+    ///<return>Returns true if the archive is created. Returns false otherwise.<return>
+    bool open(const char * iPath);
+
+    ///<summary>
+    ///Adds a file to the archive.
+    ///</summary>
+    ///<param name="iName">The path of the file in the archive, using '/' as separator. Limited to 255 characters.</param>
+    ///<param name="iData">The content of the file.</param>
+    ///<param name="iSize">The size of the content in bytes.</param>
+    ///<return>Returns true if the file is added. Returns false otherwise.<return>
+    bool add(const std::string & iName, const unsigned char * iData, unsigned long iSize);
+
+    ///<summary>
+    ///Ends and closes the archive.
+    ///</summary>
+    ///<return>Returns true if the archive is complete. Returns false otherwise.<return>
+    bool close();
+
+  private:
+    TarWriter(const TarWriter &);
+    TarWriter & operator = (const TarWriter &);
+
+    FILE * mFile;
+  };
+
+}; //corpus
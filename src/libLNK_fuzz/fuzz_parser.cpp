@@ -0,0 +1,36 @@
+// fuzz_parser.cpp : libFuzzer/AFL entry point for the buffer and stream parsers.
+//
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "libLNK.h"
+#include "Reader.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * iData, size_t iSize)
+{
+  //inputs larger than the default limits are rejected before parsing
+  if (iSize > lnk::LNK_DEFAULT_PARSE_LIMITS.maxFileSize)
+    return 0;
+  const unsigned long size = (unsigned long)iSize;
+
+  lnk::isLink(iData, size);
+
+  lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+  lnk::LinkInfo info;
+  lnk::getLinkInfo(iData, size, info, lnk::LNK_DEFAULT_PARSE_LIMITS, error);
+
+  lnk::LinkInfoEx infoEx;
+  bool success = lnk::getLinkInfo(iData, size, infoEx, lnk::LNK_DEFAULT_PARSE_LIMITS, error);
+
+  //the streaming parser must decode the input like the buffer parser
+  lnk::MemoryReader reader(iData, size);
+  lnk::LinkInfoEx streamInfo;
+  lnk::LNK_PARSE_ERROR streamError = lnk::LNK_PARSE_OK;
+  bool streamSuccess = lnk::getLinkInfo(reader, streamInfo, lnk::LNK_DEFAULT_PARSE_LIMITS, streamError);
+  if (streamSuccess != success || streamError != error || (success && streamInfo.target != infoEx.target))
+    abort();
+
+  return 0;
+}
@@ -0,0 +1,198 @@
+// main.cpp : Standalone driver of the fuzzing harness.
+//            Runs each input through LLVMFuzzerTestOneInput() and reports its cost
+//            per input byte. Compatible with AFL (afl-fuzz ... -- libLNK_fuzz @@).
+//            Not used when the harness is linked with libFuzzer.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "MemoryBuffer.h"
+#include "nativefunc.h"
+#include "filesystemfunc.h"
+#include "stringfunc.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * iData, size_t iSize);
+
+struct INPUT_COST
+{
+  std::string path;
+  unsigned long size;
+  uint64_t nanoseconds; //per run
+};
+
+bool isSlower(const INPUT_COST & iLeft, const INPUT_COST & iRight)
+{
+  return iLeft.nanoseconds > iRight.nanoseconds;
+}
+
+double getNanosecondsPerByte(const INPUT_COST & iCost)
+{
+  return (double)iCost.nanoseconds / (double)(iCost.size > 0 ? iCost.size : 1);
+}
+
+void printUsage()
+{
+  printf("Usage: libLNK_fuzz [options] FILE...\n");
+  printf("Runs each file through the parser and reports its cost per input byte.\n");
+  printf("Reads a single input from stdin when no file is specified.\n");
+  printf("\n");
+  printf("Options:\n");
+  printf("  --iterations N       Number of runs of each input. Default is 100.\n");
+  printf("  --max-ns N           Fail if an input takes more than N nanoseconds per run. Default is 0 (disabled).\n");
+  printf("  --slowest N          Number of slowest inputs to report. Default is 10.\n");
+  printf("  --save-slowest DIR   Copy the slowest inputs to DIR as regression fixtures.\n");
+}
+
+bool readStdin(lnk::MemoryBuffer & oBuffer)
+{
+  std::vector<unsigned char> content;
+  unsigned char chunk[4096];
+  size_t read = 0;
+  while((read = fread(chunk, 1, sizeof(chunk), stdin)) > 0)
+    content.insert(content.end(), chunk, chunk + read);
+
+  if (!oBuffer.allocate((unsigned long)content.size()))
+    return false;
+  if (!content.empty())
+    memcpy(oBuffer.getBuffer(), &content[0], content.size());
+  return true;
+}
+
+bool saveFile(const std::string & iPath, const lnk::MemoryBuffer & iContent)
+{
+  FILE * f = fopen(iPath.c_str(), "wb");
+  if (!f)
+    return false;
+  size_t written = fwrite(iContent.getBuffer(), 1, iContent.getSize(), f);
+  fclose(f);
+  return (written == iContent.getSize());
+}
+
+uint64_t measure(const lnk::MemoryBuffer & iContent, unsigned long iIterations)
+{
+  uint64_t start = nativefunc::getHighResolutionTime();
+  for(unsigned long i=0; i<iIterations; i++)
+  {
+    LLVMFuzzerTestOneInput(iContent.getBuffer(), iContent.getSize());
+  }
+  uint64_t end = nativefunc::getHighResolutionTime();
+  return (end - start) / iIterations;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long iterations = 100;
+  uint64_t maxNanoseconds = 0;
+  unsigned long numSlowest = 10;
+  std::string saveDirectory;
+  std::vector<std::string> files;
+
+  for(int i=1; i<argc; i++)
+  {
+    std::string arg = argv[i];
+    bool hasValue = (i+1 < argc);
+    if (arg == "--help" || arg == "-h")
+    {
+      printUsage();
+      return 0;
+    }
+    else if (arg == "--iterations" && hasValue)
+      iterations = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--max-ns" && hasValue)
+      maxNanoseconds = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--slowest" && hasValue)
+      numSlowest = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--save-slowest" && hasValue)
+      saveDirectory = argv[++i];
+    else if (arg.size() > 2 && arg[0] == '-' && arg[1] == '-')
+    {
+      printf("Unknown option: %s\n", arg.c_str());
+      printUsage();
+      return 1;
+    }
+    else
+      files.push_back(arg);
+  }
+  if (iterations == 0)
+    iterations = 1;
+
+  std::vector<INPUT_COST> costs;
+  if (files.empty())
+  {
+    lnk::MemoryBuffer content;
+    if (!readStdin(content))
+      return 1;
+    LLVMFuzzerTestOneInput(content.getBuffer(), content.getSize());
+    return 0;
+  }
+
+  for(size_t i=0; i<files.size(); i++)
+  {
+    lnk::MemoryBuffer content;
+    if (!content.loadFile(files[i].c_str()))
+    {
+      printf("Unable to read file '%s'\n", files[i].c_str());
+      return 1;
+    }
+
+    INPUT_COST cost;
+    cost.path = files[i];
+    cost.size = content.getSize();
+    cost.nanoseconds = measure(content, iterations);
+    costs.push_back(cost);
+  }
+
+  //report slowest inputs first
+  std::sort(costs.begin(), costs.end(), isSlower);
+  if (numSlowest > costs.size())
+    numSlowest = (unsigned long)costs.size();
+
+  printf("%lu inputs, %lu iterations each\n", (unsigned long)costs.size(), iterations);
+  printf("Slowest inputs:\n");
+  for(unsigned long i=0; i<numSlowest; i++)
+  {
+    const INPUT_COST & cost = costs[i];
+    printf("  %10llu ns %8lu bytes %10.2f ns/byte  %s\n", (unsigned long long)cost.nanoseconds, cost.size, getNanosecondsPerByte(cost), cost.path.c_str());
+  }
+
+  double maxNanosecondsPerByte = 0.0;
+  for(size_t i=0; i<costs.size(); i++)
+    maxNanosecondsPerByte = std::max(maxNanosecondsPerByte, getNanosecondsPerByte(costs[i]));
+  printf("Max cost: %.2f ns/byte\n", maxNanosecondsPerByte);
+
+  if (!saveDirectory.empty())
+  {
+    for(unsigned long i=0; i<numSlowest; i++)
+    {
+      lnk::MemoryBuffer content;
+      content.loadFile(costs[i].path.c_str());
+
+      std::string path = saveDirectory;
+      path += filesystem::getPathSeparator();
+      path += "slowest";
+      path += stringfunc::toString(i+1);
+      path += ".lnk";
+      if (!saveFile(path, content))
+      {
+        printf("Unable to save file '%s'\n", path.c_str());
+        return 1;
+      }
+    }
+  }
+
+  int result = 0;
+  for(size_t i=0; i<costs.size() && maxNanoseconds > 0; i++)
+  {
+    if (costs[i].nanoseconds > maxNanoseconds)
+    {
+      printf("FAILED: '%s' takes %llu ns which is more than %llu ns\n", costs[i].path.c_str(), (unsigned long long)costs[i].nanoseconds, (unsigned long long)maxNanoseconds);
+      result = 1;
+    }
+  }
+  return result;
+}
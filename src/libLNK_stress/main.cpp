@@ -0,0 +1,301 @@
+// main.cpp : Stress test of the thread safety of libLNK.
+//            Parses and creates links from many threads at the same time
+//            and compares each result with the result of a single thread.
+//            Build with -DLIBLNK_TSAN=ON to run under ThreadSanitizer.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "libLNK.h"
+#include "MemoryBuffer.h"
+#include "Scan.h"
+#include "nativefunc.h"
+#include "filesystemfunc.h"
+#include "stringfunc.h"
+
+#ifdef WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#include <process.h> //for _beginthreadex()
+#else
+#include <pthread.h>
+#endif
+
+struct OPTIONS
+{
+  std::string fixtures;
+  unsigned long numThreads;
+  unsigned long iterations;
+};
+
+//Expected results of a file, computed by a single thread
+struct REFERENCE
+{
+  std::string path;
+  lnk::MemoryBuffer content;
+  bool success;
+  lnk::LNK_PARSE_ERROR error;
+  lnk::LinkInfoEx info;
+  std::string command;
+  bool created;             //createLink() succeeded on the decoded properties
+  lnk::MemoryBuffer link;   //output of createLink()
+};
+
+struct THREAD_CONTEXT
+{
+  const OPTIONS * options;
+  const std::vector<REFERENCE> * references;
+  unsigned long index;
+  unsigned long failures;
+  std::string firstFailure;
+};
+
+void printUsage()
+{
+  printf("Usage: libLNK_stress [options]\n");
+  printf("Parses and creates links from many threads and validates each result.\n");
+  printf("\n");
+  printf("Options:\n");
+  printf("  --fixtures DIR     Folder of the links to parse, searched recursively. Default is ./tests.\n");
+  printf("  --threads N        Number of threads. Default is 8.\n");
+  printf("  --iterations N     Number of runs over the links by each thread. Default is 50.\n");
+}
+
+bool isSameLinkInfo(const lnk::LinkInfoEx & iExpected, const lnk::LinkInfoEx & iActual)
+{
+  return iExpected.target == iActual.target &&
+         iExpected.networkPath == iActual.networkPath &&
+         iExpected.arguments == iActual.arguments &&
+         iExpected.description == iActual.description &&
+         iExpected.workingDirectory == iActual.workingDirectory &&
+         iExpected.customIcon.filename == iActual.customIcon.filename &&
+         iExpected.customIcon.index == iActual.customIcon.index &&
+         iExpected.basePath == iActual.basePath &&
+         iExpected.finalPath == iActual.finalPath &&
+         iExpected.relativePath == iActual.relativePath &&
+         iExpected.fileSize == iActual.fileSize &&
+         iExpected.volume.label == iActual.volume.label &&
+         iExpected.networkShare.shareName == iActual.networkShare.shareName;
+}
+
+bool isSameBuffer(const lnk::MemoryBuffer & iExpected, const lnk::MemoryBuffer & iActual)
+{
+  return iExpected.getSize() == iActual.getSize() &&
+         (iExpected.getSize() == 0 || memcmp(iExpected.getBuffer(), iActual.getBuffer(), iExpected.getSize()) == 0);
+}
+
+//Creates a link in memory from the decoded properties of a link
+bool createLinkFromInfo(const lnk::LinkInfoEx & iInfo, lnk::MemoryBuffer & oBuffer)
+{
+  lnk::LNK_TARGET target;
+  static const uint32_t FILE_ATTRIBUTE_FOLDER = 0x10;
+  target.isFolder = ((iInfo.fileAttributes & FILE_ATTRIBUTE_FOLDER) != 0);
+  target.isFile = !target.isFolder;
+  target.fileSize = iInfo.fileSize;
+  target.shortPath = filesystem::getShortPathFormEstimation(iInfo.target);
+  return lnk::createLink(iInfo, target, oBuffer);
+}
+
+bool loadReferences(const std::string & iFolder, std::vector<REFERENCE> & oReferences)
+{
+  std::vector<std::string> files;
+  if (!filesystem::findFiles(iFolder.c_str(), true, files))
+    return false;
+
+  for(size_t i=0; i<files.size(); i++)
+  {
+    if (stringfunc::lowercase(filesystem::getFileExtention(files[i])) != "lnk")
+      continue;
+
+    oReferences.push_back(REFERENCE());
+    REFERENCE & r = oReferences.back();
+    r.path = files[i];
+    if (!r.content.loadFile(r.path.c_str()))
+      return false;
+    r.error = lnk::LNK_PARSE_OK;
+    r.success = lnk::getLinkInfo(r.path.c_str(), r.info, lnk::LNK_DEFAULT_PARSE_LIMITS, r.error);
+    r.command = lnk::getLinkCommand(r.path.c_str());
+    r.created = (r.success && createLinkFromInfo(r.info, r.link));
+  }
+  return !oReferences.empty();
+}
+
+void fail(THREAD_CONTEXT & ioContext, const std::string & iPath, const char * iOperation)
+{
+  if (ioContext.failures == 0)
+    ioContext.firstFailure = std::string(iOperation) + " on '" + iPath + "'";
+  ioContext.failures++;
+}
+
+//Runs every operation of the public API on each link and compares the results
+void runThread(THREAD_CONTEXT & ioContext)
+{
+  const std::vector<REFERENCE> & references = *ioContext.references;
+  const size_t count = references.size();
+
+  for(unsigned long iteration=0; iteration<ioContext.options->iterations; iteration++)
+  {
+    for(size_t j=0; j<count; j++)
+    {
+      //each thread starts at a different link
+      const REFERENCE & r = references[(j + ioContext.index) % count];
+
+      //from a file
+      {
+        lnk::LinkInfoEx info;
+        lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+        bool success = lnk::getLinkInfo(r.path.c_str(), info, lnk::LNK_DEFAULT_PARSE_LIMITS, error);
+        if (success != r.success || error != r.error || (success && !isSameLinkInfo(r.info, info)))
+          fail(ioContext, r.path, "getLinkInfo(file)");
+      }
+
+      //from memory
+      {
+        if (lnk::isLink(r.content.getBuffer(), r.content.getSize()) != (r.error != lnk::LNK_PARSE_ERROR_SIGNATURE && r.error != lnk::LNK_PARSE_ERROR_IO))
+          fail(ioContext, r.path, "isLink()");
+
+        lnk::LinkInfoEx info;
+        lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+        bool success = lnk::getLinkInfo(r.content.getBuffer(), r.content.getSize(), info, lnk::LNK_DEFAULT_PARSE_LIMITS, error);
+        if (success != r.success || error != r.error || (success && !isSameLinkInfo(r.info, info)))
+          fail(ioContext, r.path, "getLinkInfo(memory)");
+      }
+
+      if (lnk::getLinkCommand(r.path.c_str()) != r.command)
+        fail(ioContext, r.path, "getLinkCommand()");
+
+      //writer
+      if (r.success)
+      {
+        lnk::MemoryBuffer link;
+        bool created = createLinkFromInfo(r.info, link);
+        if (created != r.created || (created && !isSameBuffer(r.link, link)))
+          fail(ioContext, r.path, "createLink(memory)");
+      }
+    }
+
+    //file based writer: unique temporary names and target detection
+    if (!references.empty())
+    {
+      const REFERENCE & r = references[ioContext.index % count];
+      std::string path = filesystem::getTemporaryFilePath() + ".lnk";
+      if (r.success && lnk::createLink(path.c_str(), r.info))
+      {
+        lnk::LinkInfo info;
+        if (!lnk::getLinkInfo(path.c_str(), info) || info.target != r.info.target)
+          fail(ioContext, path, "createLink(file)");
+      }
+      remove(path.c_str());
+    }
+
+    //statistics and batch API
+    lnk::Stats stats;
+    lnk::getStats(stats);
+    if (iteration % 10 == 0)
+    {
+      std::vector<std::string> files;
+      for(size_t j=0; j<count; j++)
+        files.push_back(references[j].path);
+      lnk::ScanOptions options = lnk::LNK_DEFAULT_SCAN_OPTIONS;
+      lnk::ScanReport report;
+      if (!lnk::scanFiles(files, options, NULL, NULL, report) || report.numFiles != count)
+        fail(ioContext, ioContext.options->fixtures, "scanFiles()");
+    }
+  }
+}
+
+#ifdef WIN32
+unsigned __stdcall threadEntry(void * iContext)
+{
+  runThread(*(THREAD_CONTEXT *)iContext);
+  return 0;
+}
+#else
+void * threadEntry(void * iContext)
+{
+  runThread(*(THREAD_CONTEXT *)iContext);
+  return NULL;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+  OPTIONS options;
+  options.fixtures = "./tests";
+  options.numThreads = 8;
+  options.iterations = 50;
+
+  for(int i=1; i<argc; i++)
+  {
+    std::string arg = argv[i];
+    bool hasValue = (i+1 < argc);
+    if (arg == "--fixtures" && hasValue)
+      options.fixtures = argv[++i];
+    else if (arg == "--threads" && hasValue)
+      options.numThreads = strtoul(argv[++i], NULL, 10);
+    else if (arg == "--iterations" && hasValue)
+      options.iterations = strtoul(argv[++i], NULL, 10);
+    else
+    {
+      printUsage();
+      return (arg == "--help" || arg == "-h" ? 0 : 1);
+    }
+  }
+  if (options.numThreads == 0)
+    options.numThreads = 1;
+
+  std::vector<REFERENCE> references;
+  if (!loadReferences(options.fixtures, references))
+  {
+    printf("Unable to load links from '%s'\n", options.fixtures.c_str());
+    return 1;
+  }
+
+  std::vector<THREAD_CONTEXT> contexts(options.numThreads);
+  for(unsigned long i=0; i<options.numThreads; i++)
+  {
+    contexts[i].options = &options;
+    contexts[i].references = &references;
+    contexts[i].index = i;
+    contexts[i].failures = 0;
+  }
+
+  uint64_t start = nativefunc::getHighResolutionTime();
+
+#ifdef WIN32
+  std::vector<HANDLE> threads(options.numThreads);
+  for(unsigned long i=0; i<options.numThreads; i++)
+    threads[i] = (HANDLE)_beginthreadex(NULL, 0, &threadEntry, &contexts[i], 0, NULL);
+  for(unsigned long i=0; i<options.numThreads; i++)
+  {
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+  }
+#else
+  std::vector<pthread_t> threads(options.numThreads);
+  for(unsigned long i=0; i<options.numThreads; i++)
+    pthread_create(&threads[i], NULL, &threadEntry, &contexts[i]);
+  for(unsigned long i=0; i<options.numThreads; i++)
+    pthread_join(threads[i], NULL);
+#endif
+
+  uint64_t elapsed = nativefunc::getHighResolutionTime() - start;
+
+  unsigned long failures = 0;
+  for(unsigned long i=0; i<options.numThreads; i++)
+  {
+    if (contexts[i].failures > 0)
+      printf("Thread %lu: %lu failures, first is %s\n", i, contexts[i].failures, contexts[i].firstFailure.c_str());
+    failures += contexts[i].failures;
+  }
+
+  printf("%lu threads, %lu iterations over %lu links in %.2f seconds: %lu failures\n",
+    options.numThreads, options.iterations, (unsigned long)references.size(), (double)elapsed / 1e9, failures);
+  return (failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,212 @@
+#include "TestArchive.h"
+#include "Archive.h"
+#include "Inflate.h"
+#include "Scan.h"
+#include "MemoryBuffer.h"
+
+#include "filesystemfunc.h"
+
+using namespace lnk;
+
+void TestArchive::SetUp()
+{
+}
+
+void TestArchive::TearDown()
+{
+}
+
+//implemented in TestLNK.cpp
+void assertSameLinkInfo(const LinkInfoEx & iExpected, const LinkInfoEx & iActual);
+
+//Decodes a member of an archive like the link file it was created from.
+void assertSameAsFile(Archive & iArchive, size_t iIndex, const char * iFilePath)
+{
+  LinkInfoEx expected;
+  ASSERT_TRUE( getLinkInfo(iFilePath, expected) ) << iFilePath;
+
+  LinkInfoEx actual;
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  ASSERT_TRUE( iArchive.getLinkInfo(iIndex, actual, LNK_DEFAULT_PARSE_LIMITS, error, NULL) ) << iArchive.getMembers()[iIndex].name;
+  ASSERT_EQ( LNK_PARSE_OK, error );
+  assertSameLinkInfo(expected, actual);
+}
+
+void assertNotLink(Archive & iArchive, size_t iIndex)
+{
+  LinkInfoEx info;
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  ASSERT_FALSE( iArchive.getLinkInfo(iIndex, info, LNK_DEFAULT_PARSE_LIMITS, error, NULL) ) << iArchive.getMembers()[iIndex].name;
+  ASSERT_EQ( LNK_PARSE_ERROR_SIGNATURE, error );
+}
+
+void assertZipMembers(const char * iArchivePath)
+{
+  Archive archive;
+  ASSERT_TRUE( archive.open(iArchivePath) ) << iArchivePath;
+
+  //the folder is not listed
+  const std::vector<ArchiveMember> & members = archive.getMembers();
+  ASSERT_EQ( 6, members.size() );
+  ASSERT_EQ( "links/testWin7MappedDrive.lnk", members[0].name );
+  ASSERT_EQ( "links/testWinXpNotepadIconTree.lnk", members[1].name );
+  ASSERT_EQ( "links/testWin7LongFilename.lnk", members[2].name );
+  ASSERT_EQ( "readme.txt", members[3].name );
+  ASSERT_EQ( "google.url", members[4].name );
+  ASSERT_EQ( "renamed.bin", members[5].name );
+  ASSERT_EQ( ARCHIVE_METHOD_STORED, members[0].method );
+  ASSERT_EQ( ARCHIVE_METHOD_DEFLATED, members[1].method );
+  ASSERT_EQ( ARCHIVE_METHOD_DEFLATED, members[2].method );
+  ASSERT_EQ( filesystem::getFileSize("./tests/testWin7MappedDrive.lnk"), members[0].size );
+  ASSERT_EQ( filesystem::getFileSize("./tests/testWin7LongFilename.lnk"), members[2].uncompressedSize );
+  ASSERT_LT( members[2].size, members[2].uncompressedSize );
+
+  assertSameAsFile(archive, 0, "./tests/testWin7MappedDrive.lnk");
+  assertSameAsFile(archive, 1, "./tests/testWinXpNotepadIconTree.lnk");
+  assertSameAsFile(archive, 2, "./tests/testWin7LongFilename.lnk");
+  assertNotLink(archive, 3);
+  assertNotLink(archive, 4);
+  assertSameAsFile(archive, 5, "./tests/testWinXpArguments.lnk"); //found by its signature, not by its name
+
+  //members are decoded in any order with the same decompressor
+  assertSameAsFile(archive, 2, "./tests/testWin7LongFilename.lnk");
+  assertSameAsFile(archive, 1, "./tests/testWinXpNotepadIconTree.lnk");
+
+  LinkInfoEx info;
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  ASSERT_FALSE( archive.getLinkInfo(members.size(), info, LNK_DEFAULT_PARSE_LIMITS, error, NULL) );
+}
+
+TEST_F(TestArchive, testZip)
+{
+  assertZipMembers("./tests/testArchive.zip");
+}
+
+TEST_F(TestArchive, testZip64)
+{
+  //same members with ZIP64 records and extra fields
+  assertZipMembers("./tests/testArchive64.zip");
+}
+
+TEST_F(TestArchive, testTar)
+{
+  //pax extended header for the long name
+  {
+    Archive archive;
+    ASSERT_TRUE( archive.open("./tests/testArchive.tar") );
+    const std::vector<ArchiveMember> & members = archive.getMembers();
+    ASSERT_EQ( 4, members.size() );
+    ASSERT_EQ( "links/testWin7MappedDrive.lnk", members[0].name );
+    ASSERT_EQ( "links/" + std::string(120, 'c') + ".lnk", members[1].name );
+    ASSERT_EQ( "readme.txt", members[2].name );
+    ASSERT_EQ( "links/testWin7LongFilename.lnk", members[3].name );
+    assertSameAsFile(archive, 0, "./tests/testWin7MappedDrive.lnk");
+    assertSameAsFile(archive, 1, "./tests/testWinXpNotepadIconTree.lnk");
+    assertNotLink(archive, 2);
+    assertSameAsFile(archive, 3, "./tests/testWin7LongFilename.lnk");
+  }
+
+  //GNU long name
+  {
+    Archive archive;
+    ASSERT_TRUE( archive.open("./tests/testArchiveGnu.tar") );
+    const std::vector<ArchiveMember> & members = archive.getMembers();
+    ASSERT_EQ( 4, members.size() );
+    ASSERT_EQ( "links/" + std::string(120, 'c') + ".lnk", members[1].name );
+    assertSameAsFile(archive, 1, "./tests/testWinXpNotepadIconTree.lnk");
+    assertSameAsFile(archive, 3, "./tests/testWin7LongFilename.lnk");
+  }
+
+  //ustar prefix
+  {
+    Archive archive;
+    ASSERT_TRUE( archive.open("./tests/testArchiveUstar.tar") );
+    const std::vector<ArchiveMember> & members = archive.getMembers();
+    ASSERT_EQ( 1, members.size() );
+    ASSERT_EQ( "links/" + std::string(110, 'd') + "/testWinXpNotepadIconTree.lnk", members[0].name );
+    assertSameAsFile(archive, 0, "./tests/testWinXpNotepadIconTree.lnk");
+  }
+}
+
+TEST_F(TestArchive, testInvalidArchive)
+{
+  Archive archive;
+  ASSERT_FALSE( archive.open("./tests/archiveNotFound.zip") );
+  ASSERT_FALSE( archive.open("./tests/testWin7CdRom.lnk") );
+  ASSERT_EQ( 0, archive.getMembers().size() );
+
+  //the archive is closed
+  ASSERT_TRUE( archive.open("./tests/testArchive.zip") );
+  archive.close();
+  ASSERT_EQ( 0, archive.getMembers().size() );
+}
+
+TEST_F(TestArchive, testInflate)
+{
+  Archive archive;
+  ASSERT_TRUE( archive.open("./tests/testArchive.zip") );
+  const ArchiveMember & member = archive.getMembers()[2];
+  ASSERT_EQ( ARCHIVE_METHOD_DEFLATED, member.method );
+
+  MemoryBuffer expected;
+  ASSERT_TRUE( expected.loadFile("./tests/testWin7LongFilename.lnk") );
+  MemoryBuffer compressed;
+  ASSERT_TRUE( compressed.loadFile("./tests/testArchive.zip") );
+  const unsigned char * data = compressed.getBuffer() + member.offset;
+
+  //read in small chunks to resume the back references between calls
+  InflateReader inflater;
+  inflater.reset(data, (size_t)member.size);
+  std::string inflated;
+  unsigned char chunk[7];
+  unsigned long read = 0;
+  do
+  {
+    ASSERT_TRUE( inflater.read(chunk, sizeof(chunk), read) );
+    inflated.append((const char *)chunk, read);
+  } while(read == sizeof(chunk));
+  ASSERT_EQ( std::string((const char *)expected.getBuffer(), expected.getSize()), inflated );
+
+  //truncated data
+  inflater.reset(data, (size_t)member.size / 2);
+  MemoryBuffer output;
+  ASSERT_TRUE( output.allocate(expected.getSize()) );
+  ASSERT_FALSE( inflater.read(output.getBuffer(), expected.getSize(), read) );
+  ASSERT_LT( read, expected.getSize() );
+
+  //invalid block type
+  const unsigned char invalid[] = {0x07, 0x00};
+  inflater.reset(invalid, sizeof(invalid));
+  ASSERT_FALSE( inflater.read(output.getBuffer(), expected.getSize(), read) );
+  ASSERT_EQ( 0, read );
+}
+
+//Keeps the paths of the valid links of a scan
+bool addScannedPath(const char * iFilePath, const LinkInfoEx & iLinkInfo, const LNK_PARSE_ERROR & iError, void * iUserData)
+{
+  std::vector<std::string> & paths = *(std::vector<std::string> *)iUserData;
+  if (iError == LNK_PARSE_OK && !iLinkInfo.target.empty())
+    paths.push_back(iFilePath);
+  return true;
+}
+
+TEST_F(TestArchive, testScanArchive)
+{
+  std::vector<std::string> paths;
+  ScanReport report;
+  ASSERT_TRUE( scanArchive("./tests/testArchive.zip", LNK_DEFAULT_SCAN_OPTIONS, &addScannedPath, &paths, report) );
+
+  //the members which are not links are not reported
+  ASSERT_EQ( 4, report.numFiles );
+  ASSERT_EQ( 0, report.numRejected );
+  ASSERT_EQ( 4, report.total.getCount() );
+  ASSERT_EQ( 4, report.stages[LNK_STAGE_HEADER].getCount() );
+  ASSERT_EQ( 4, paths.size() );
+  const std::string prefix = std::string("./tests/testArchive.zip") + filesystem::getPathSeparator();
+  ASSERT_EQ( prefix + "links/testWin7MappedDrive.lnk", paths[0] );
+  ASSERT_EQ( prefix + "renamed.bin", paths[3] );
+  ASSERT_EQ( LNK_DEFAULT_SCAN_OPTIONS.numSlowest < 4 ? LNK_DEFAULT_SCAN_OPTIONS.numSlowest : 4, report.slowest.size() );
+
+  ASSERT_FALSE( scanArchive("./tests/archiveNotFound.zip", LNK_DEFAULT_SCAN_OPTIONS, NULL, NULL, report) );
+  ASSERT_EQ( 0, report.numFiles );
+}
@@ -0,0 +1,163 @@
+#include "TestByteCursor.h"
+#include "ByteCursor.h"
+
+using namespace lnk;
+
+void TestByteCursor::SetUp()
+{
+}
+
+void TestByteCursor::TearDown()
+{
+}
+
+TEST_F(TestByteCursor, testRead)
+{
+  const unsigned char buffer[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+  ByteCursor cursor(buffer, sizeof(buffer));
+
+  uint16_t value16 = 0;
+  ASSERT_TRUE( cursor.read(value16) );
+  ASSERT_EQ( 0x0201, value16 );
+  ASSERT_EQ( 2, cursor.getOffset() );
+
+  uint32_t value32 = 0;
+  ASSERT_TRUE( cursor.read(value32) );
+  ASSERT_EQ( 0x06050403, value32 );
+  ASSERT_EQ( 0, cursor.getRemaining() );
+  ASSERT_TRUE( cursor.good() );
+}
+
+TEST_F(TestByteCursor, testReadPastEnd)
+{
+  const unsigned char buffer[] = {0x01, 0x02, 0x03};
+  ByteCursor cursor(buffer, sizeof(buffer));
+
+  uint32_t value = 0xFFFFFFFF;
+  ASSERT_FALSE( cursor.read(value) );
+  ASSERT_EQ( 0xFFFFFFFF, value ); //untouched
+  ASSERT_EQ( LNK_PARSE_ERROR_TRUNCATED, cursor.getError() );
+
+  //all following reads must fail, even if they would fit
+  uint8_t value8 = 0;
+  ASSERT_FALSE( cursor.read(value8) );
+  ASSERT_FALSE( cursor.skip(1) );
+  ASSERT_EQ( 0, cursor.getOffset() );
+}
+
+TEST_F(TestByteCursor, testSkipAndSeek)
+{
+  const unsigned char buffer[] = {0x01, 0x02, 0x03, 0x04};
+  ByteCursor cursor(buffer, sizeof(buffer));
+
+  ASSERT_TRUE( cursor.skip(3) );
+  ASSERT_TRUE( cursor.seek(1) );
+  ASSERT_EQ( 1, cursor.getOffset() );
+  ASSERT_TRUE( cursor.seek(4) ); //end of buffer is valid
+  ASSERT_FALSE( cursor.seek(5) );
+  ASSERT_EQ( LNK_PARSE_ERROR_TRUNCATED, cursor.getError() );
+
+  ByteCursor cursor2(buffer, sizeof(buffer));
+  ASSERT_FALSE( cursor2.skip(0xFFFFFFFF) ); //no overflow
+}
+
+TEST_F(TestByteCursor, testSub)
+{
+  const unsigned char buffer[] = {0x01, 0x02, 0x03, 0x04};
+  ByteCursor cursor(buffer, sizeof(buffer));
+
+  ByteCursor sub = cursor.sub(1, 2);
+  ASSERT_TRUE( sub.good() );
+  ASSERT_EQ( 2, sub.getSize() );
+  uint16_t value = 0;
+  ASSERT_TRUE( sub.read(value) );
+  ASSERT_EQ( 0x0302, value );
+  ASSERT_FALSE( sub.read(value) );
+
+  ByteCursor invalid = cursor.sub(3, 2);
+  ASSERT_FALSE( invalid.good() );
+  ASSERT_EQ( 0, invalid.getSize() );
+}
+
+TEST_F(TestByteCursor, testReadString)
+{
+  const unsigned char buffer[] = {'f', 'o', 'o', '\0', 'b', 'a', 'r'};
+  ByteCursor cursor(buffer, sizeof(buffer));
+
+  std::string value;
+  ASSERT_TRUE( cursor.readString(255, value) );
+  ASSERT_TRUE( value == "foo" );
+  ASSERT_EQ( 4, cursor.getOffset() );
+
+  //no terminating character
+  ASSERT_FALSE( cursor.readString(255, value) );
+  ASSERT_EQ( LNK_PARSE_ERROR_TRUNCATED, cursor.getError() );
+  ASSERT_TRUE( value == "foo" );
+
+  //string too long
+  ByteCursor cursor2(buffer, sizeof(buffer));
+  ASSERT_FALSE( cursor2.readString(2, value) );
+  ASSERT_EQ( LNK_PARSE_ERROR_STRING_TOO_LONG, cursor2.getError() );
+
+  //in place
+  ByteCursor cursor3(buffer, sizeof(buffer));
+  const char * view = NULL;
+  unsigned long length = 0;
+  ASSERT_TRUE( cursor3.readString(255, view, length) );
+  ASSERT_EQ( (const char *)buffer, view );
+  ASSERT_EQ( 3, length );
+  ASSERT_EQ( 4, cursor3.getOffset() );
+}
+
+TEST_F(TestByteCursor, testReadUnicodeString)
+{
+  const unsigned char buffer[] = {'f', 0x00, 'o', 0x00, 'o', 0x00, 0x00, 0x00, 'b', 0x00};
+  ByteCursor cursor(buffer, sizeof(buffer));
+
+  //in place
+  const unsigned char * view = NULL;
+  unsigned long length = 0;
+  ASSERT_TRUE( cursor.readUnicodeString(255, view, length) );
+  ASSERT_EQ( buffer, view );
+  ASSERT_EQ( 3, length );
+  ASSERT_EQ( 8, cursor.getOffset() );
+  ASSERT_FALSE( cursor.readUnicodeString(255, view, length) );
+  ASSERT_EQ( LNK_PARSE_ERROR_TRUNCATED, cursor.getError() );
+
+  ByteCursor cursor1(buffer, sizeof(buffer));
+  ASSERT_FALSE( cursor1.readUnicodeString(2, view, length) );
+  ASSERT_EQ( LNK_PARSE_ERROR_STRING_TOO_LONG, cursor1.getError() );
+
+  //fixed length
+  std::string value;
+  ByteCursor cursor2(buffer, sizeof(buffer));
+  ASSERT_TRUE( cursor2.readUnicodeString(2, 255, value) );
+  ASSERT_TRUE( value == "fo" );
+  ASSERT_FALSE( cursor2.readUnicodeString(10, 255, value) );
+  ASSERT_EQ( LNK_PARSE_ERROR_TRUNCATED, cursor2.getError() );
+}
+
+TEST_F(TestByteCursor, testTrustedCursor)
+{
+  const unsigned char buffer[] = {0x01, 0x02, 0x03, 0x04, 'a', 'b', 0x00, 'c', 0x00, 0x00, 0x00};
+  TrustedByteCursor cursor(buffer, sizeof(buffer));
+
+  uint32_t value = 0;
+  ASSERT_TRUE( cursor.read(value) );
+  ASSERT_EQ( 0x04030201, value );
+
+  std::string text;
+  ASSERT_TRUE( cursor.readString(0, text) ); //limits are not enforced
+  ASSERT_EQ( "ab", text );
+  const unsigned char * view = NULL;
+  unsigned long length = 0;
+  ASSERT_TRUE( cursor.readUnicodeString(0, view, length) );
+  ASSERT_EQ( 1, length );
+  ASSERT_EQ( 'c', view[0] );
+  ASSERT_EQ( sizeof(buffer), cursor.getOffset() );
+
+  //a trusted cursor never fails
+  cursor.fail(LNK_PARSE_ERROR_TRUNCATED);
+  ASSERT_TRUE( cursor.good() );
+  ASSERT_EQ( LNK_PARSE_OK, cursor.getError() );
+}
@@ -0,0 +1,153 @@
+#include "TestCarve.h"
+#include "Carve.h"
+#include "MemoryBuffer.h"
+#include <stdio.h> //for remove()
+
+#include "filesystemfunc.h"
+
+using namespace lnk;
+
+void TestCarve::SetUp()
+{
+}
+
+void TestCarve::TearDown()
+{
+}
+
+static const unsigned char SIGNATURE[] = {
+  0x4C, 0x00, 0x00, 0x00,
+  0x01, 0x14, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46,
+};
+
+//Builds data which looks like a disk image: bytes of a pseudo random sequence where 1 byte of 8 is 0x4C.
+void fillNoise(std::string & oData, size_t iSize)
+{
+  oData.resize(iSize);
+  uint32_t value = 12345;
+  for(size_t i=0; i<iSize; i++)
+  {
+    value = value*1103515245 + 12345;
+    oData[i] = (i % 8 == 3 ? 0x4C : (char)(value >> 16));
+  }
+}
+
+//Copies a link file in the data.
+CarvedLink putLink(std::string & ioData, size_t iOffset, const char * iFilePath)
+{
+  MemoryBuffer content;
+  content.loadFile(iFilePath);
+  ioData.replace(iOffset, content.getSize(), (const char *)content.getBuffer(), content.getSize());
+  CarvedLink link;
+  link.offset = iOffset;
+  link.size = content.getSize();
+  return link;
+}
+
+void assertSameLinks(const std::vector<CarvedLink> & iExpected, const std::vector<CarvedLink> & iActual)
+{
+  ASSERT_EQ( iExpected.size(), iActual.size() );
+  for(size_t i=0; i<iExpected.size(); i++)
+  {
+    ASSERT_EQ( iExpected[i].offset, iActual[i].offset );
+    ASSERT_EQ( iExpected[i].size, iActual[i].size );
+  }
+}
+
+TEST_F(TestCarve, testFindLinkSignature)
+{
+  //every offset of the vectorized search and of the remaining bytes, in zeros and in header sizes
+  for(int fill=0; fill<2; fill++)
+  {
+    for(size_t offset=0; offset<=80; offset++)
+    {
+      std::string data(100, (fill == 0 ? '\0' : 0x4C));
+      data.replace(offset, sizeof(SIGNATURE), (const char *)SIGNATURE, sizeof(SIGNATURE));
+      data.resize(offset + sizeof(SIGNATURE) + (offset % 3));
+      const unsigned char * buffer = (const unsigned char *)data.data();
+      ASSERT_EQ( offset, findLinkSignature(buffer, data.size()) ) << "signature at offset " << offset;
+
+      //a signature which ends past the buffer
+      ASSERT_EQ( offset + sizeof(SIGNATURE) - 1, findLinkSignature(buffer, offset + sizeof(SIGNATURE) - 1) );
+
+      //any other byte of the CLSID
+      data[offset + 12] = 0x00;
+      ASSERT_EQ( data.size(), findLinkSignature(buffer, data.size()) ) << "invalid signature at offset " << offset;
+    }
+  }
+
+  //the first of many signatures
+  std::string data;
+  fillNoise(data, 1000);
+  data.replace(500, sizeof(SIGNATURE), (const char *)SIGNATURE, sizeof(SIGNATURE));
+  data.replace(700, sizeof(SIGNATURE), (const char *)SIGNATURE, sizeof(SIGNATURE));
+  ASSERT_EQ( 500, findLinkSignature((const unsigned char *)data.data(), data.size()) );
+  ASSERT_EQ( 200, findLinkSignature((const unsigned char *)data.data() + 501, data.size() - 501) + 1 );
+  ASSERT_EQ( 0, findLinkSignature(NULL, 0) );
+}
+
+TEST_F(TestCarve, testCarveLinks)
+{
+  std::string data;
+  fillNoise(data, 50000);
+
+  std::vector<CarvedLink> expected;
+  expected.push_back( putLink(data, 0, "./tests/testWin7MappedDrive.lnk") );
+  expected.push_back( putLink(data, 4090, "./tests/testWinXpNotepadIconTree.lnk") ); //signature across 2 chunks of 4096 bytes
+  expected.push_back( putLink(data, 16000, "./tests/testWin7LongFilename.lnk") );     //ExtraData in the next chunk
+  const CarvedLink & previous = expected.back();
+  expected.push_back( putLink(data, (size_t)previous.offset + previous.size, "./tests/testWinXpArguments.lnk") ); //right after the previous link
+
+  //signatures which are not followed by a valid link
+  data.replace(30000, sizeof(SIGNATURE), (const char *)SIGNATURE, sizeof(SIGNATURE));
+  data.replace(30100, 200, 200, (char)0xFF);
+  data.replace(30100, sizeof(SIGNATURE), (const char *)SIGNATURE, sizeof(SIGNATURE));
+  CarvedLink truncated = putLink(data, data.size() - 300, "./tests/testWin7CdRom.lnk");
+  data.resize((size_t)truncated.offset + truncated.size / 2);
+
+  const unsigned char * buffer = (const unsigned char *)data.data();
+  std::vector<CarvedLink> links;
+  ASSERT_TRUE( carveLinks(buffer, data.size(), LNK_DEFAULT_CARVE_OPTIONS, links) );
+  assertSameLinks(expected, links);
+
+  //many threads and small chunks
+  CarveOptions options = LNK_DEFAULT_CARVE_OPTIONS;
+  options.chunkSize = 4096;
+  options.numThreads = 4;
+  ASSERT_TRUE( carveLinks(buffer, data.size(), options, links) );
+  assertSameLinks(expected, links);
+  options.chunkSize = 1;
+  options.numThreads = 0;
+  ASSERT_TRUE( carveLinks(buffer, data.size(), options, links) );
+  assertSameLinks(expected, links);
+
+  //links larger than the limits
+  options = LNK_DEFAULT_CARVE_OPTIONS;
+  options.limits.maxFileSize = 1000;
+  ASSERT_TRUE( carveLinks(buffer, data.size(), options, links) );
+  ASSERT_EQ( 1, links.size() );
+  ASSERT_EQ( expected[3].offset, links[0].offset );
+
+  ASSERT_TRUE( carveLinks(NULL, 0, LNK_DEFAULT_CARVE_OPTIONS, links) );
+  ASSERT_EQ( 0, links.size() );
+  ASSERT_FALSE( carveLinks(NULL, 100, LNK_DEFAULT_CARVE_OPTIONS, links) );
+}
+
+TEST_F(TestCarve, testCarveFile)
+{
+  std::string data;
+  fillNoise(data, 20000);
+  std::vector<CarvedLink> expected;
+  expected.push_back( putLink(data, 777, "./tests/testWin7MappedDrive.lnk") );
+  expected.push_back( putLink(data, 15000, "./tests/testWinXpNotepadIconTree.lnk") );
+
+  std::string path = filesystem::getTemporaryFilePath();
+  ASSERT_TRUE( filesystem::writeFile(path.c_str(), data.data(), data.size(), false) );
+  std::vector<CarvedLink> links;
+  bool success = carveFile(path.c_str(), LNK_DEFAULT_CARVE_OPTIONS, links);
+  remove(path.c_str());
+  ASSERT_TRUE( success );
+  assertSameLinks(expected, links);
+
+  ASSERT_FALSE( carveFile("./tests/fileNotFound.bin", LNK_DEFAULT_CARVE_OPTIONS, links) );
+}
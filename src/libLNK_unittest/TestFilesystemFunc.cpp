@@ -3,6 +3,10 @@
 #include "nativefunc.h"
 #include "gtesthelper.h"
 
+#include <algorithm>
+#include <string.h> //for strlen()
+#include <direct.h> //for _rmdir()
+
 using namespace filesystem;
 
 namespace filesystem { namespace test
@@ -156,6 +160,16 @@ namespace filesystem { namespace test
       bool exists = filesystem::folderExists(currentFolder.c_str());
       ASSERT_TRUE(exists);
     }
+
+    //test current folder is not modified
+    {
+      std::string currentFolder = filesystem::getCurrentFolder();
+      std::string parentFolder = filesystem::getParentPath(currentFolder);
+
+      bool exists = filesystem::folderExists(parentFolder.c_str());
+      ASSERT_TRUE(exists);
+      ASSERT_EQ(currentFolder, filesystem::getCurrentFolder());
+    }
   }
   //--------------------------------------------------------------------------------------------------
   TEST_F(TestFilesystemFunc, testGetTemporaryFileName)
@@ -276,6 +290,112 @@ namespace filesystem { namespace test
     }
   }
   //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFilesystemFunc, testIsShortName)
+  {
+    static const char * SHORT_NAMES[] = {"README.TXT", "readme.txt", "ABCDEFGH.ABC", "A", "A.B", ".", "..", "~1", "PROGRA~1"};
+    static const char * LONG_NAMES[] = {"", "ABCDEFGHI", "ABC.ABCD", "A B.TXT", "A.B.C", ".CONFIG", "ABC.", "A+B", "A[1]", "ABCDEFGHIJKLM"};
+
+    for(size_t i=0; i<sizeof(SHORT_NAMES)/sizeof(SHORT_NAMES[0]); i++)
+    {
+      ASSERT_TRUE( filesystem::isShortName(SHORT_NAMES[i], strlen(SHORT_NAMES[i])) ) << SHORT_NAMES[i];
+    }
+    for(size_t i=0; i<sizeof(LONG_NAMES)/sizeof(LONG_NAMES[0]); i++)
+    {
+      ASSERT_FALSE( filesystem::isShortName(LONG_NAMES[i], strlen(LONG_NAMES[i])) ) << LONG_NAMES[i];
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFilesystemFunc, testBuildShortName)
+  {
+    static const std::string NAME = "Program Files (x86)";
+    ASSERT_EQ("PROGRA~1", filesystem::buildShortName(NAME.c_str(), NAME.size(), 1));
+    ASSERT_EQ("PROGRA~4", filesystem::buildShortName(NAME.c_str(), NAME.size(), 4));
+
+    //periods and invalid characters
+    {
+      static const std::string NAME = "my.long+file;name.tar.gz";
+      ASSERT_EQ("MYLONG~1.GZ", filesystem::buildShortName(NAME.c_str(), NAME.size(), 1));
+    }
+    {
+      static const std::string NAME = "a+b=c.txt";
+      ASSERT_EQ("A_B_C~1.TXT", filesystem::buildShortName(NAME.c_str(), NAME.size(), 1));
+    }
+    {
+      static const std::string NAME = ".gitignore";
+      ASSERT_EQ("GITIGN~1", filesystem::buildShortName(NAME.c_str(), NAME.size(), 1));
+    }
+
+    //from the 5th name, the name is hashed
+    {
+      std::string shortName = filesystem::buildShortName(NAME.c_str(), NAME.size(), 5);
+      ASSERT_EQ(8, shortName.size());
+      ASSERT_EQ("PR", shortName.substr(0, 2));
+      ASSERT_EQ("~1", shortName.substr(6, 2));
+      ASSERT_EQ(shortName, filesystem::buildShortName(NAME.c_str(), NAME.size(), 5)); //stable
+
+      //the tail grows into the hash
+      shortName = filesystem::buildShortName(NAME.c_str(), NAME.size(), 14);
+      ASSERT_EQ(8, shortName.size());
+      ASSERT_EQ("~10", shortName.substr(5, 3));
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFilesystemFunc, testShortNameGenerator)
+  {
+    //collisions within a folder
+    {
+      filesystem::ShortNameGenerator generator;
+      ASSERT_EQ("PROGRA~1", generator.getShortName("C:\\", "Program Files"));
+      ASSERT_EQ("PROGRA~2", generator.getShortName("C:\\", "Program Files (x86)"));
+      ASSERT_EQ("PROGRA~3", generator.getShortName("C:\\", "ProgramData"));
+
+      //same name, any case
+      ASSERT_EQ("PROGRA~1", generator.getShortName("C:\\", "Program Files"));
+      ASSERT_EQ("PROGRA~2", generator.getShortName("c:", "PROGRAM FILES (X86)"));
+
+      //other folders are independent
+      ASSERT_EQ("PROGRA~1", generator.getShortName("D:\\", "ProgramData"));
+
+      generator.clear();
+      ASSERT_EQ("PROGRA~1", generator.getShortName("C:\\", "ProgramData"));
+    }
+
+    //hashed names after 4 collisions
+    {
+      filesystem::ShortNameGenerator generator;
+      std::vector<std::string> shortNames;
+      for(int i=0; i<6; i++)
+      {
+        std::string name = std::string("abcdefgh") + (char)('0' + i) + ".txt";
+        shortNames.push_back(generator.getShortName("C:\\temp", name));
+      }
+      ASSERT_EQ("ABCDEF~1.TXT", shortNames[0]);
+      ASSERT_EQ("ABCDEF~4.TXT", shortNames[3]);
+      for(size_t i=4; i<shortNames.size(); i++)
+      {
+        ASSERT_EQ("AB", shortNames[i].substr(0, 2));
+        ASSERT_EQ("~1.TXT", shortNames[i].substr(6));
+      }
+      ASSERT_NE(shortNames[4], shortNames[5]);
+    }
+
+    //valid 8.3 names are kept and reserved
+    {
+      filesystem::ShortNameGenerator generator;
+      ASSERT_EQ("LONGNA~1.TXT", generator.getShortName("C:\\", "LONGNA~1.TXT"));
+      ASSERT_EQ("LONGNA~2.TXT", generator.getShortName("C:\\", "long name.txt"));
+    }
+
+    //paths
+    {
+      filesystem::ShortNameGenerator generator;
+      ASSERT_EQ("C:\\PROGRA~1\\MICROS~1\\OFFICE.EXE", generator.getShortPath("C:\\Program Files\\Microsoft Office\\OFFICE.EXE"));
+      ASSERT_EQ("C:\\PROGRA~2\\MICROS~1", generator.getShortPath("C:\\Program Files (x86)\\Microsoft Office"));
+      ASSERT_EQ("C:\\PROGRA~1\\MICROS~2", generator.getShortPath("C:\\Program Files\\Microsoft Games"));
+      ASSERT_EQ("\\\\my server\\my share\\MYFOLD~1", generator.getShortPath("\\\\my server\\my share\\my folder"));
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
   TEST_F(TestFilesystemFunc, testSplitPath)
   {
     //test baseline
@@ -377,6 +497,87 @@ namespace filesystem { namespace test
     }
   }
   //--------------------------------------------------------------------------------------------------
+  std::vector<std::string> tokenize(const char * iPath)
+  {
+    std::vector<std::string> elements;
+    filesystem::PathTokenizer tokenizer(iPath);
+    filesystem::PathElement element;
+    while(tokenizer.next(element))
+      elements.push_back(std::string(element.value, element.length));
+    return elements;
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFilesystemFunc, testPathTokenizer)
+  {
+    //test baseline
+    {
+      std::vector<std::string> elements = tokenize("C:\\Program Files\\7-Zip\\History.txt");
+      ASSERT_EQ(4, elements.size());
+      ASSERT_EQ("C:", elements[0]);
+      ASSERT_EQ("Program Files", elements[1]);
+      ASSERT_EQ("7-Zip", elements[2]);
+      ASSERT_EQ("History.txt", elements[3]);
+    }
+
+    //test both separators and empty elements
+    {
+      std::vector<std::string> elements = tokenize("/home//myFolder\\myFile.txt/");
+      ASSERT_EQ(3, elements.size());
+      ASSERT_EQ("home", elements[0]);
+      ASSERT_EQ("myFolder", elements[1]);
+      ASSERT_EQ("myFile.txt", elements[2]);
+    }
+
+    //test empty
+    {
+      ASSERT_EQ(0, tokenize("").size());
+      ASSERT_EQ(0, tokenize("\\").size());
+      ASSERT_EQ(0, tokenize(NULL).size());
+    }
+
+    //test drive root
+    {
+      filesystem::PathTokenizer tokenizer("C:\\");
+      ASSERT_TRUE(tokenizer.hasDrive());
+      ASSERT_FALSE(tokenizer.isUnc());
+      ASSERT_EQ(1, tokenizer.count());
+      filesystem::PathElement element;
+      ASSERT_TRUE(tokenizer.next(element));
+      ASSERT_EQ("C:", std::string(element.value, element.length));
+      ASSERT_FALSE(tokenizer.next(element));
+    }
+
+    //test UNC path
+    {
+      filesystem::PathTokenizer tokenizer("\\\\server\\share\\file.txt");
+      ASSERT_TRUE(tokenizer.isUnc());
+      ASSERT_FALSE(tokenizer.hasDrive());
+      ASSERT_EQ(3, tokenizer.count());
+      std::vector<std::string> elements = tokenize("\\\\server\\share\\file.txt");
+      ASSERT_EQ(3, elements.size());
+      ASSERT_EQ("server", elements[0]);
+      ASSERT_EQ("share", elements[1]);
+      ASSERT_EQ("file.txt", elements[2]);
+    }
+
+    //test elements point inside the path
+    {
+      const char * path = "/home/myFolder";
+      filesystem::PathTokenizer tokenizer(path);
+      filesystem::PathElement element;
+      ASSERT_TRUE(tokenizer.next(element));
+      ASSERT_EQ(path + 1, element.value);
+      ASSERT_EQ(4, element.length);
+
+      //test reset
+      ASSERT_TRUE(tokenizer.next(element));
+      ASSERT_FALSE(tokenizer.next(element));
+      tokenizer.reset();
+      ASSERT_TRUE(tokenizer.next(element));
+      ASSERT_EQ(path + 1, element.value);
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
   TEST_F(TestFilesystemFunc, testGetPathSeparator)
   {
 #ifdef WIN32
@@ -505,5 +706,99 @@ namespace filesystem { namespace test
     }
   }
   //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFilesystemFunc, testFindFiles)
+  {
+    std::string separator;
+    separator += filesystem::getPathSeparator();
+    const std::string folder = std::string(".") + separator + "tests";
+    const std::string expectedFile = folder + separator + "testWin7CdRom.lnk";
+    const std::string expectedSubFile = folder + separator + "slow" + separator + "slowLongString.lnk";
+
+    //not recursive
+    {
+      std::vector<std::string> files;
+      ASSERT_TRUE( filesystem::findFiles(folder.c_str(), false, files) );
+      ASSERT_TRUE( std::find(files.begin(), files.end(), expectedFile) != files.end() );
+      ASSERT_TRUE( std::find(files.begin(), files.end(), expectedSubFile) == files.end() );
+    }
+
+    //recursive
+    {
+      std::vector<std::string> files;
+      ASSERT_TRUE( filesystem::findFiles(folder.c_str(), true, files) );
+      ASSERT_TRUE( std::find(files.begin(), files.end(), expectedFile) != files.end() );
+      ASSERT_TRUE( std::find(files.begin(), files.end(), expectedSubFile) != files.end() );
+    }
+
+    //missing folder
+    {
+      std::vector<std::string> files;
+      ASSERT_FALSE( filesystem::findFiles("./missing_folder", true, files) );
+      ASSERT_TRUE( files.empty() );
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFilesystemFunc, testCreateFolder)
+  {
+    std::string folder = filesystem::getTemporaryFilePath();
+    folder += ".folder";
+    ASSERT_FALSE( filesystem::folderExists(folder.c_str()) );
+
+    ASSERT_TRUE( filesystem::createFolder(folder.c_str()) );
+    ASSERT_TRUE( filesystem::folderExists(folder.c_str()) );
+
+    //already exists
+    ASSERT_TRUE( filesystem::createFolder(folder.c_str()) );
+
+    //missing parent folder
+    std::string subFolder = folder + filesystem::getPathSeparator() + "missing" + filesystem::getPathSeparator() + "folder";
+    ASSERT_FALSE( filesystem::createFolder(subFolder.c_str()) );
+
+    //invalid
+    ASSERT_FALSE( filesystem::createFolder(NULL) );
+    ASSERT_FALSE( filesystem::createFolder("") );
+
+    _rmdir(folder.c_str());
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFilesystemFunc, testWriteFile)
+  {
+    std::string folder = filesystem::getTemporaryFilePath() + ".folder";
+    ASSERT_TRUE( filesystem::createFolder(folder.c_str()) );
+    std::string path = folder + filesystem::getPathSeparator() + "file.bin";
+
+    static const char CONTENT1[] = "first content";
+    static const char CONTENT2[] = "second";
+
+    for(int atomic=0; atomic<2; atomic++)
+    {
+      //create
+      ASSERT_TRUE( filesystem::writeFile(path.c_str(), CONTENT1, sizeof(CONTENT1), atomic != 0) );
+      ASSERT_EQ( sizeof(CONTENT1), filesystem::getFileSize(path.c_str()) );
+
+      //replace with a smaller content
+      ASSERT_TRUE( filesystem::writeFile(path.c_str(), CONTENT2, sizeof(CONTENT2), atomic != 0) );
+      ASSERT_EQ( sizeof(CONTENT2), filesystem::getFileSize(path.c_str()) );
+
+      //no temporary file is left in the folder
+      std::vector<std::string> files;
+      ASSERT_TRUE( filesystem::findFiles(folder.c_str(), false, files) );
+      ASSERT_EQ( 1, files.size() );
+
+      ASSERT_EQ( 0, remove(path.c_str()) );
+    }
+
+    //missing folder
+    std::string missing = folder + filesystem::getPathSeparator() + "missing" + filesystem::getPathSeparator() + "file.bin";
+    ASSERT_FALSE( filesystem::writeFile(missing.c_str(), CONTENT1, sizeof(CONTENT1), false) );
+    ASSERT_FALSE( filesystem::writeFile(missing.c_str(), CONTENT1, sizeof(CONTENT1), true) );
+
+    //invalid
+    ASSERT_FALSE( filesystem::writeFile(NULL, CONTENT1, sizeof(CONTENT1), false) );
+    ASSERT_FALSE( filesystem::writeFile("", CONTENT1, sizeof(CONTENT1), true) );
+
+    _rmdir(folder.c_str());
+  }
+  //--------------------------------------------------------------------------------------------------
 } // End namespace test
 } // End namespace filesystem
@@ -0,0 +1,155 @@
+#include "TestItemID.h"
+#include "ItemID.h"
+#include <string.h> //for memcmp()
+#include <string>
+#include <vector>
+
+using namespace lnk;
+
+void TestItemID::SetUp()
+{
+}
+
+void TestItemID::TearDown()
+{
+}
+
+TEST_F(TestItemID, testConstantItemIds)
+{
+  //all drive letters
+  for(char letter='A'; letter<='Z'; letter++)
+  {
+    unsigned char buffer[64] = {0};
+    ItemIDListBuilder builder(buffer, sizeof(buffer));
+    ASSERT_TRUE( builder.addComputerItemId() );
+    ASSERT_TRUE( builder.addDriveItemId(letter) );
+    ASSERT_EQ( 2 + 0x14 + 0x19 + 2, builder.finish() );
+
+    //IDListSize
+    ASSERT_EQ( 0x14 + 0x19 + 2, buffer[0] );
+    ASSERT_EQ( 0, buffer[1] );
+
+    //computer
+    const unsigned char * computer = &buffer[2];
+    ASSERT_EQ( 0x14, computer[0] );
+    ASSERT_EQ( 0x1F, computer[2] );
+
+    //drive
+    const unsigned char * drive = &buffer[2 + 0x14];
+    ASSERT_EQ( 0x19, drive[0] );
+    ASSERT_EQ( 0x2F, drive[2] );
+    ASSERT_EQ( letter, drive[3] );
+    ASSERT_EQ( ':', drive[4] );
+    ASSERT_EQ( '\\', drive[5] );
+
+    //terminal
+    ASSERT_EQ( 0, buffer[2 + 0x14 + 0x19] );
+    ASSERT_EQ( 0, buffer[2 + 0x14 + 0x19 + 1] );
+  }
+}
+
+TEST_F(TestItemID, testFileItemId)
+{
+  //file
+  {
+    static const unsigned char EXPECTED[] = {
+      0x30, 0x00,                                                                          //IDListSize
+      0x2E, 0x00, 0x32, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3A, 0x3E, 0x13, 0x6B, 0x20, 0x00, //header
+      'A', 'B', 0x00, 0x00,                                                                //short name and padding
+      0x1C, 0x00, 0x03, 0x00, 0x04, 0x00, 0xEF, 0xBE, 0x3A, 0x3E, 0x13, 0x6B, 0x3A, 0x3E, 0x13, 0x6B, 0x14, 0x00, 0x00, 0x00,
+      'a', 0x00, 0xE9, 0x00, 0x00, 0x00,                                                   //long name
+      0x18, 0x00,
+      0x00, 0x00,                                                                          //TerminalID
+    };
+    ASSERT_EQ( 0x2E, getFileItemIdSize(2, 2) );
+
+    unsigned char buffer[sizeof(EXPECTED)] = {0};
+    ItemIDListBuilder builder(buffer, sizeof(buffer));
+    ASSERT_TRUE( builder.addFileItemId("AB", 2, "a\xE9", 2, FA_NORMAL) );
+    ASSERT_EQ( sizeof(EXPECTED), builder.finish() );
+    ASSERT_EQ( 0, memcmp(EXPECTED, buffer, sizeof(EXPECTED)) );
+  }
+
+  //folder
+  {
+    unsigned char buffer[128] = {0};
+    ItemIDListBuilder builder(buffer, sizeof(buffer));
+    ASSERT_TRUE( builder.addFileItemId("PROGRA~1", 8, "Program Files", 13, FA_DIRECTORY) );
+    ASSERT_EQ( 2 + getFileItemIdSize(8, 13) + 2, builder.finish() );
+
+    const unsigned char * item = &buffer[2];
+    ASSERT_EQ( getFileItemIdSize(8, 13), (unsigned long)(item[0] | (item[1] << 8)) );
+    ASSERT_EQ( 0x31, item[2] );
+    ASSERT_EQ( 0x0E, item[10] );
+    ASSERT_EQ( 0x10, item[12] );
+    ASSERT_EQ( 0, memcmp("PROGRA~1", &item[14], 9) );
+
+    //ItemIDEx
+    const unsigned char * itemEx = &item[24];
+    ASSERT_EQ( getFileItemIdSize(8, 13) - 24, (unsigned long)(itemEx[0] | (itemEx[1] << 8)) );
+    ASSERT_EQ( 0x0E, itemEx[10] );
+    ASSERT_EQ( 0x0E, itemEx[14] );
+  }
+}
+
+TEST_F(TestItemID, testMeasure)
+{
+  ItemIDListBuilder measure;
+  ASSERT_TRUE( measure.addComputerItemId() );
+  ASSERT_TRUE( measure.addDriveItemId('C') );
+  ASSERT_TRUE( measure.addFileItemId("PROGRA~1", 8, "Program Files", 13, FA_DIRECTORY) );
+  ASSERT_TRUE( measure.addFileItemId("FILE.TXT", 8, "file.txt", 8, FA_NORMAL) );
+  unsigned long size = measure.finish();
+  ASSERT_EQ( 2 + 0x14 + 0x19 + getFileItemIdSize(8, 13) + getFileItemIdSize(8, 8) + 2, size );
+
+  //exact size
+  {
+    std::vector<unsigned char> buffer(size);
+    ItemIDListBuilder builder(&buffer[0], size);
+    builder.addComputerItemId();
+    builder.addDriveItemId('C');
+    builder.addFileItemId("PROGRA~1", 8, "Program Files", 13, FA_DIRECTORY);
+    builder.addFileItemId("FILE.TXT", 8, "file.txt", 8, FA_NORMAL);
+    ASSERT_EQ( size, builder.finish() );
+    ASSERT_EQ( size - 2, (unsigned long)(buffer[0] | (buffer[1] << 8)) );
+  }
+
+  //buffer too small
+  {
+    std::vector<unsigned char> buffer(size - 1);
+    ItemIDListBuilder builder(&buffer[0], size - 1);
+    ASSERT_TRUE( builder.addComputerItemId() );
+    ASSERT_TRUE( builder.addDriveItemId('C') );
+    ASSERT_TRUE( builder.addFileItemId("PROGRA~1", 8, "Program Files", 13, FA_DIRECTORY) );
+    ASSERT_TRUE( builder.addFileItemId("FILE.TXT", 8, "file.txt", 8, FA_NORMAL) );
+    ASSERT_EQ( 0, builder.finish() );
+  }
+}
+
+TEST_F(TestItemID, testOverflow)
+{
+  //an ItemID larger than 0xFFFF bytes
+  {
+    const std::string longName(0x8000, 'a');
+    ItemIDListBuilder measure;
+    ASSERT_TRUE( measure.addComputerItemId() );
+    ASSERT_FALSE( measure.addFileItemId("AAAAAA~1", 8, longName.c_str(), longName.size(), FA_NORMAL) );
+    ASSERT_EQ( 0, measure.finish() );
+
+    std::vector<unsigned char> buffer(0x20000);
+    ItemIDListBuilder builder(&buffer[0], (unsigned long)buffer.size());
+    ASSERT_FALSE( builder.addFileItemId("AAAAAA~1", 8, longName.c_str(), longName.size(), FA_NORMAL) );
+    ASSERT_EQ( 0, builder.finish() );
+  }
+
+  //a list larger than 0xFFFF bytes, made of valid ItemIDs
+  {
+    const std::string longName(0x2000, 'a');
+    ItemIDListBuilder measure;
+    for(int i=0; i<3; i++)
+      ASSERT_TRUE( measure.addFileItemId("AAAAAA~1", 8, longName.c_str(), longName.size(), FA_DIRECTORY) );
+    ASSERT_GT( measure.finish(), 0 );
+    ASSERT_TRUE( measure.addFileItemId("AAAAAA~1", 8, longName.c_str(), longName.size(), FA_NORMAL) );
+    ASSERT_EQ( 0, measure.finish() );
+  }
+}
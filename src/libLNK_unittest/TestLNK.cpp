@@ -2,7 +2,17 @@
 #include "gtesthelper.h"
 
 #include "libLNK.h"
+#include "MemoryBuffer.h"
+#include "Scan.h"
+#include "Batch.h"
+#include "Carve.h"
+#include "Stats.h"
+#include "Trace.h"
 #include "filesystemfunc.h"
+#include "nativefunc.h"
+#include "stringfunc.h"
+
+#include <direct.h> //for _rmdir()
 
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN // Exclude rarely-used stuff from Windows headers
@@ -150,6 +160,221 @@ TEST_F(TestLNK, testCreateCmdExe)
   //ASSERT_TRUE( fileAreEquals ) << reason.c_str();
 }
 
+TEST_F(TestLNK, testCreateLinkAtomic)
+{
+  std::string lnkFilePath = getTestLink();
+
+  lnk::LinkInfo info;
+  info.target = "C:\\WINDOWS\\system32\\cmd.exe";
+  info.arguments = std::string(4096, 'x'); //multi-KB link
+  info.hotKey = lnk::LNK_NO_HOTKEY;
+
+  //create, then replace an existing link
+  ASSERT_TRUE( lnk::createLink(lnkFilePath.c_str(), info, true) );
+  info.arguments = "/c";
+  ASSERT_TRUE( lnk::createLink(lnkFilePath.c_str(), info, true) );
+
+  lnk::LinkInfo actual;
+  ASSERT_TRUE( lnk::getLinkInfo(lnkFilePath.c_str(), actual) );
+  ASSERT_EQ( info.target, actual.target );
+  ASSERT_EQ( info.arguments, actual.arguments );
+
+  //same content as a regular creation
+  lnk::MemoryBuffer atomicContent;
+  ASSERT_TRUE( atomicContent.loadFile(lnkFilePath.c_str()) );
+  ASSERT_TRUE( lnk::createLink(lnkFilePath.c_str(), info) );
+  lnk::MemoryBuffer content;
+  ASSERT_TRUE( content.loadFile(lnkFilePath.c_str()) );
+  ASSERT_EQ( content.getSize(), atomicContent.getSize() );
+  ASSERT_EQ( 0, memcmp(content.getBuffer(), atomicContent.getBuffer(), content.getSize()) );
+
+  //unable to create the link in a missing folder
+  ASSERT_FALSE( lnk::createLink("./tests/missing/folder/link.lnk", info, true) );
+}
+
+TEST_F(TestLNK, testPatchLink)
+{
+  lnk::LinkInfo info;
+  info.target = "C:\\Program Files\\7-Zip\\History.txt";
+  info.arguments = "-a";
+  info.description = "";
+  info.workingDirectory = "C:\\Program Files\\7-Zip";
+  info.customIcon.index = 0;
+  info.hotKey = lnk::LNK_NO_HOTKEY;
+  lnk::LNK_TARGET target;
+  target.isFile = true;
+  target.isFolder = false;
+  target.fileSize = 1234;
+  target.shortPath = filesystem::getShortPathFormEstimation(info.target);
+  lnk::MemoryBuffer content;
+  ASSERT_TRUE( lnk::createLink(info, target, content) );
+
+  //a patched link is identical to a link created with the new values
+  lnk::LinkChanges changes;
+  changes.fields = lnk::LNK_FIELD_TARGET | lnk::LNK_FIELD_ARGUMENTS | lnk::LNK_FIELD_DESCRIPTION | lnk::LNK_FIELD_WORKING_DIRECTORY | lnk::LNK_FIELD_ICON;
+  changes.values = info;
+  changes.values.target = "C:\\Program Files (x86)\\Tools\\7-Zip\\Release Notes.txt";
+  changes.values.arguments = "";
+  changes.values.description = "Release notes";
+  changes.values.workingDirectory = "C:\\Temp";
+  changes.values.customIcon.filename = "C:\\Windows\\system32\\SHELL32.dll";
+  changes.values.customIcon.index = 3;
+  changes.shortPath = filesystem::getShortPathFormEstimation(changes.values.target);
+  unsigned long firstChange = 0;
+  ASSERT_TRUE( lnk::patchLink(content, changes, firstChange) );
+  ASSERT_EQ( 0x14, firstChange ); //LinkFlags
+
+  target.shortPath = changes.shortPath;
+  lnk::MemoryBuffer expected;
+  ASSERT_TRUE( lnk::createLink(changes.values, target, expected) );
+  ASSERT_EQ( expected.getSize(), content.getSize() );
+  ASSERT_EQ( 0, memcmp(expected.getBuffer(), content.getBuffer(), content.getSize()) );
+
+  //only the bytes of the arguments and after are modified
+  changes.fields = lnk::LNK_FIELD_ARGUMENTS;
+  changes.values.arguments = "/quiet";
+  ASSERT_TRUE( lnk::patchLink(content, changes, firstChange) );
+  changes.values.arguments = "/verbose";
+  ASSERT_TRUE( lnk::patchLink(content, changes, firstChange) );
+  ASSERT_EQ( content.getSize() - 4 - (2 + 2*31) - (2 + 2*8), firstChange ); //before the TerminalBlock, the icon and the arguments
+  ASSERT_TRUE( lnk::createLink(changes.values, target, expected) );
+  ASSERT_EQ( expected.getSize(), content.getSize() );
+  ASSERT_EQ( 0, memcmp(expected.getBuffer(), content.getBuffer(), content.getSize()) );
+
+  //same value
+  ASSERT_TRUE( lnk::patchLink(content, changes, firstChange) );
+  ASSERT_EQ( content.getSize(), firstChange );
+
+  //a section which shrinks before a section which grows
+  changes.fields = lnk::LNK_FIELD_DESCRIPTION | lnk::LNK_FIELD_ICON;
+  changes.values.description = "";
+  changes.values.customIcon.filename = "C:\\Windows\\system32\\imageres.dll";
+  ASSERT_TRUE( lnk::patchLink(content, changes, firstChange) );
+  ASSERT_TRUE( lnk::createLink(changes.values, target, expected) );
+  ASSERT_EQ( expected.getSize(), content.getSize() );
+  ASSERT_EQ( 0, memcmp(expected.getBuffer(), content.getBuffer(), content.getSize()) );
+
+  //strings longer than the default limits are rejected
+  const unsigned long maxLength = lnk::LNK_DEFAULT_PARSE_LIMITS.maxStringLength;
+  changes.fields = lnk::LNK_FIELD_ARGUMENTS;
+  changes.values.arguments = std::string(maxLength + 1, 'a');
+  ASSERT_FALSE( lnk::patchLink(content, changes, firstChange) );
+  changes.fields = lnk::LNK_FIELD_TARGET;
+  changes.values.target = "C:\\Temp\\" + std::string(maxLength, 'a');
+  ASSERT_FALSE( lnk::patchLink(content, changes, firstChange) );
+  ASSERT_EQ( expected.getSize(), content.getSize() );
+  ASSERT_EQ( 0, memcmp(expected.getBuffer(), content.getBuffer(), content.getSize()) );
+  changes.fields = lnk::LNK_FIELD_ARGUMENTS;
+  changes.values.arguments = std::string(maxLength, 'a');
+  ASSERT_TRUE( lnk::patchLink(content, changes, firstChange) );
+  lnk::LinkInfo decoded;
+  lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+  ASSERT_TRUE( lnk::getLinkInfo(content.getBuffer(), content.getSize(), decoded, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+  ASSERT_EQ( changes.values.arguments, decoded.arguments );
+
+  //links without the IsUnicode flag are rejected
+  content.getBuffer()[0x14] &= ~0x80;
+  lnk::MemoryBuffer nonUnicode = content;
+  changes.values.arguments = "-a";
+  for(uint32_t field = lnk::LNK_FIELD_TARGET; field <= lnk::LNK_FIELD_RELATIVE_PATH; field <<= 1)
+  {
+    changes.fields = field;
+    ASSERT_FALSE( lnk::patchLink(content, changes, firstChange) ) << field;
+    ASSERT_EQ( nonUnicode.getSize(), content.getSize() );
+    ASSERT_EQ( 0, memcmp(nonUnicode.getBuffer(), content.getBuffer(), content.getSize()) );
+  }
+}
+
+TEST_F(TestLNK, testPatchLinkFile)
+{
+  static const char * FIXTURE = "./tests/testWinXpNotepadHotKey.lnk";
+  std::string lnkFilePath = getTestLink();
+  lnk::MemoryBuffer original;
+  ASSERT_TRUE( original.loadFile(FIXTURE) );
+  ASSERT_TRUE( filesystem::writeFile(lnkFilePath.c_str(), original.getBuffer(), original.getSize(), false) );
+  lnk::LinkInfoEx before;
+  ASSERT_TRUE( lnk::getLinkInfo(lnkFilePath.c_str(), before) );
+
+  //strings
+  lnk::LinkChanges changes;
+  changes.fields = lnk::LNK_FIELD_ARGUMENTS | lnk::LNK_FIELD_DESCRIPTION;
+  changes.values = before;
+  changes.values.arguments = "C:\\boot.ini";
+  changes.values.description = "Patched";
+  ASSERT_TRUE( lnk::patchLink(lnkFilePath.c_str(), changes) );
+
+  lnk::LinkInfoEx after;
+  ASSERT_TRUE( lnk::getLinkInfo(lnkFilePath.c_str(), after) );
+  ASSERT_EQ( changes.values.arguments, after.arguments );
+  ASSERT_EQ( changes.values.description, after.description );
+  ASSERT_EQ( before.target, after.target );
+  ASSERT_EQ( before.workingDirectory, after.workingDirectory );
+  ASSERT_EQ( before.customIcon.filename, after.customIcon.filename );
+  ASSERT_EQ( before.hotKey.keyCode, after.hotKey.keyCode );
+  ASSERT_EQ( before.creationTime, after.creationTime );
+  ASSERT_EQ( before.volume.serialNumber, after.volume.serialNumber );
+
+  //restoring the values restores the original file, including its ExtraData
+  changes.values = before;
+  ASSERT_TRUE( lnk::patchLink(lnkFilePath.c_str(), changes) );
+  lnk::MemoryBuffer restored;
+  ASSERT_TRUE( restored.loadFile(lnkFilePath.c_str()) );
+  ASSERT_EQ( original.getSize(), restored.getSize() );
+  ASSERT_EQ( 0, memcmp(original.getBuffer(), restored.getBuffer(), original.getSize()) );
+
+  //target
+  changes.fields = lnk::LNK_FIELD_TARGET;
+  changes.values.target = "C:\\WINDOWS\\system32\\calc.exe";
+  changes.shortPath = changes.values.target;
+  ASSERT_TRUE( lnk::patchLink(lnkFilePath.c_str(), changes) );
+  ASSERT_TRUE( lnk::getLinkInfo(lnkFilePath.c_str(), after) );
+  ASSERT_EQ( changes.values.target, after.target );
+  ASSERT_EQ( changes.values.target, after.basePath );
+  ASSERT_EQ( before.arguments, after.arguments );
+  ASSERT_EQ( before.creationTime, after.creationTime );
+  ASSERT_EQ( before.volume.serialNumber, after.volume.serialNumber );
+  ASSERT_EQ( before.volume.label, after.volume.label );
+
+  //the paths of a network target are not replaced
+  ASSERT_TRUE( original.loadFile("./tests/testWin7NetworkPath.lnk") );
+  ASSERT_TRUE( filesystem::writeFile(lnkFilePath.c_str(), original.getBuffer(), original.getSize(), false) );
+  ASSERT_FALSE( lnk::patchLink(lnkFilePath.c_str(), changes) );
+  ASSERT_TRUE( restored.loadFile(lnkFilePath.c_str()) );
+  ASSERT_EQ( original.getSize(), restored.getSize() );
+  ASSERT_EQ( 0, memcmp(original.getBuffer(), restored.getBuffer(), original.getSize()) );
+
+  //a UNC target replaces the network volume table and removes the LinkTargetIDList
+  ASSERT_TRUE( original.loadFile("./tests/testWin7MappedDrive.lnk") );
+  ASSERT_TRUE( filesystem::writeFile(lnkFilePath.c_str(), original.getBuffer(), original.getSize(), false) );
+  ASSERT_EQ( 1, original.getBuffer()[0x14] & 0x01 ); //HasLinkTargetIDList
+  lnk::LinkInfoEx network;
+  ASSERT_TRUE( lnk::getLinkInfo(lnkFilePath.c_str(), network) );
+  changes.fields = lnk::LNK_FIELD_TARGET | lnk::LNK_FIELD_NETWORK_PATH;
+  changes.values = network;
+  changes.values.target = "\\\\d50fil02\\Standards\\STANDARD\\9000\\E\\9001E.PDF";
+  changes.values.networkPath = changes.values.target;
+  changes.shortPath = changes.values.target;
+  ASSERT_TRUE( lnk::patchLink(lnkFilePath.c_str(), changes) );
+  ASSERT_TRUE( lnk::getLinkInfo(lnkFilePath.c_str(), after) );
+  ASSERT_EQ( changes.values.target, after.networkPath );
+  ASSERT_EQ( "\\\\d50fil02\\Standards", after.networkShare.shareName );
+  ASSERT_EQ( "STANDARD\\9000\\E\\9001E.PDF", after.finalPath );
+  ASSERT_EQ( network.networkShare.providerType, after.networkShare.providerType );
+  ASSERT_EQ( network.creationTime, after.creationTime );
+  ASSERT_TRUE( restored.loadFile(lnkFilePath.c_str()) );
+  ASSERT_EQ( 0, restored.getBuffer()[0x14] & 0x01 ); //HasLinkTargetIDList
+
+  //the network path of a UNC target is the target
+  changes.values.target = "\\\\d50fil02\\Archives\\9001E.PDF";
+  ASSERT_FALSE( lnk::patchLink(lnkFilePath.c_str(), changes) );
+  changes.fields = lnk::LNK_FIELD_TARGET;
+  ASSERT_TRUE( lnk::patchLink(lnkFilePath.c_str(), changes) );
+  ASSERT_TRUE( lnk::getLinkInfo(lnkFilePath.c_str(), after) );
+  ASSERT_EQ( changes.values.target, after.networkPath );
+
+  ASSERT_FALSE( lnk::patchLink("./tests/missing.lnk", changes) );
+}
+
 TEST_F(TestLNK, DISABLED_testWinXpNotepadDefault_duplicate)
 {
   //Build test case link file
@@ -463,6 +688,134 @@ TEST_F(TestLNK, testWin7SpecialCharactersCcedil)
   ASSERT_TRUE( info.target == "G:\\Temp\\franais.txt" );
 }
 
+TEST_F(TestLNK, testLinkInfoExLocalVolume)
+{
+  lnk::LinkInfoEx info;
+  bool success = lnk::getLinkInfo("./tests/testWin7CdRom.lnk", info);
+  ASSERT_TRUE( success == true );
+  ASSERT_TRUE( info.target == "E:\\Specials\\IMG_5187_LR5.jpg" );
+  ASSERT_EQ( 0x00000020, info.fileAttributes );
+  ASSERT_EQ( 0x01d2563f39370080ull, info.creationTime );
+  ASSERT_EQ( 3114653, info.fileSize );
+  ASSERT_EQ( 1, info.showCommand );
+  ASSERT_TRUE( info.basePath == "E:\\Specials\\IMG_5187_LR5.jpg" );
+  ASSERT_TRUE( info.hasVolume == true );
+  ASSERT_EQ( lnk::LNK_VOLUME_TYPE_CDROM, info.volume.driveType );
+  ASSERT_EQ( 0xe12ef9dd, info.volume.serialNumber );
+  ASSERT_TRUE( info.volume.label == "2016-12-03-CAE" );
+  ASSERT_TRUE( info.hasNetworkShare == false );
+}
+
+TEST_F(TestLNK, testLinkInfoExNetworkShare)
+{
+  lnk::LinkInfoEx info;
+  bool success = lnk::getLinkInfo("./tests/testWinXpLongFilename.lnk", info);
+  ASSERT_TRUE( success == true );
+  ASSERT_TRUE( info.hasVolume == false );
+  ASSERT_TRUE( info.hasNetworkShare == true );
+  ASSERT_EQ( 0x00020000, info.networkShare.providerType );
+  ASSERT_TRUE( info.networkShare.shareName == "\\\\d49ads02\\users$\\BEAUCHAMP.A3" );
+  ASSERT_TRUE( info.networkShare.deviceName == "M:" );
+  ASSERT_TRUE( info.finalPath == "thisisanextralongfoldername\\thisisasuperhugelongfilename\\thisisasuperlongfilename.txt" );
+
+  //LinkInfo fields must match the basic api
+  lnk::LinkInfo basic;
+  ASSERT_TRUE( lnk::getLinkInfo("./tests/testWinXpLongFilename.lnk", basic) );
+  ASSERT_TRUE( info.target == basic.target );
+  ASSERT_TRUE( info.networkPath == basic.networkPath );
+  ASSERT_TRUE( info.workingDirectory == basic.workingDirectory );
+}
+
+TEST_F(TestLNK, testLinkInfoExShowCommand)
+{
+  lnk::LinkInfoEx info;
+  ASSERT_TRUE( lnk::getLinkInfo("./tests/testWinXpNotepadMinimized.lnk", info) );
+  ASSERT_EQ( 7, info.showCommand );
+  ASSERT_TRUE( lnk::getLinkInfo("./tests/testWinXpNotepadMaximized.lnk", info) );
+  ASSERT_EQ( 3, info.showCommand );
+}
+
+void assertSameLinkInfo(const lnk::LinkInfoEx & iExpected, const lnk::LinkInfoEx & iActual)
+{
+  ASSERT_EQ( iExpected.target, iActual.target );
+  ASSERT_EQ( iExpected.networkPath, iActual.networkPath );
+  ASSERT_EQ( iExpected.arguments, iActual.arguments );
+  ASSERT_EQ( iExpected.description, iActual.description );
+  ASSERT_EQ( iExpected.workingDirectory, iActual.workingDirectory );
+  ASSERT_EQ( iExpected.customIcon.filename, iActual.customIcon.filename );
+  ASSERT_EQ( iExpected.customIcon.index, iActual.customIcon.index );
+  ASSERT_EQ( iExpected.showCommand, iActual.showCommand );
+  ASSERT_EQ( iExpected.basePath, iActual.basePath );
+  ASSERT_EQ( iExpected.finalPath, iActual.finalPath );
+  ASSERT_EQ( iExpected.relativePath, iActual.relativePath );
+  ASSERT_EQ( iExpected.hasVolume, iActual.hasVolume );
+  ASSERT_EQ( iExpected.volume.label, iActual.volume.label );
+  ASSERT_EQ( iExpected.hasNetworkShare, iActual.hasNetworkShare );
+  ASSERT_EQ( iExpected.networkShare.shareName, iActual.networkShare.shareName );
+  ASSERT_EQ( iExpected.networkShare.deviceName, iActual.networkShare.deviceName );
+}
+
+TEST_F(TestLNK, testReuseLinkInfo)
+{
+  static const char * files[] = {
+    "./tests/testWin7CdRom.lnk",          //local volume
+    "./tests/testWinXpLongFilename.lnk",  //network share
+    "./tests/testWinXpNotepadIconTree.lnk",
+    "./tests/testWin7MultipleFolders.lnk",
+    "./tests/testWinXpArguments.lnk",
+  };
+  static const size_t numFiles = sizeof(files)/sizeof(files[0]);
+
+  //a reused object must give the same result as a new object
+  lnk::LinkInfoEx reused;
+  for(int round=0; round<2; round++)
+  {
+    for(size_t i=0; i<numFiles; i++)
+    {
+      lnk::LinkInfoEx expected;
+      ASSERT_TRUE( lnk::getLinkInfo(files[i], expected) ) << files[i];
+      ASSERT_TRUE( lnk::getLinkInfo(files[i], reused) ) << files[i];
+      assertSameLinkInfo(expected, reused);
+    }
+  }
+
+  //a file that cannot be read leaves no value of the previous file
+  lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+  ASSERT_TRUE( lnk::getLinkInfo(files[1], reused) );
+  ASSERT_FALSE( lnk::getLinkInfo("./tests/fooBAR.lnk", reused, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+  ASSERT_TRUE( reused.target.empty() );
+  ASSERT_TRUE( reused.networkShare.shareName.empty() );
+
+  //clear() keeps the capacity
+  ASSERT_TRUE( lnk::getLinkInfo(files[1], reused) );
+  size_t capacity = reused.target.capacity();
+  reused.clear();
+  ASSERT_TRUE( reused.target.empty() );
+  ASSERT_TRUE( reused.finalPath.empty() );
+  ASSERT_FALSE( reused.hasNetworkShare );
+  ASSERT_EQ( capacity, reused.target.capacity() );
+
+  //parsing the same file again does not allocate memory
+  lnk::MemoryBuffer buffer;
+  ASSERT_TRUE( buffer.loadFile(files[0]) );
+  ASSERT_TRUE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), reused, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+  const char * target = reused.target.c_str();
+  const char * label = reused.volume.label.c_str();
+  ASSERT_TRUE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), reused, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+  ASSERT_EQ( target, reused.target.c_str() );
+  ASSERT_EQ( label, reused.volume.label.c_str() );
+
+  //a buffer is reused when loading a smaller file
+  lnk::Stats before;
+  if (lnk::getStats(before))
+  {
+    ASSERT_TRUE( buffer.loadFile(files[1]) );
+    lnk::Stats after;
+    ASSERT_TRUE( lnk::getStats(after) );
+    ASSERT_EQ( 0, after.allocations - before.allocations );
+  }
+}
+
 TEST_F(TestLNK, testDocumentationExampleShortcutToFile)
 {
   //testing example from MSDN documentation
@@ -518,3 +871,782 @@ TEST_F(TestLNK, testDocumentationExampleShortcutToFile)
   ASSERT_TRUE( success == true );
   ASSERT_TRUE( info.target == "C:\\test\\a.txt" );
 }
+
+TEST_F(TestLNK, testParseLimits)
+{
+  lnk::MemoryBuffer buffer;
+  ASSERT_TRUE( buffer.loadFile("./tests/testWin7MultipleFolders.lnk") );
+
+  lnk::LinkInfo info;
+  lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+  ASSERT_TRUE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), info, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+  ASSERT_EQ( lnk::LNK_PARSE_OK, error );
+
+  lnk::ParseLimits limits = lnk::LNK_DEFAULT_PARSE_LIMITS;
+  limits.maxFileSize = buffer.getSize() - 1;
+  ASSERT_FALSE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), info, limits, error) );
+  ASSERT_EQ( lnk::LNK_PARSE_ERROR_FILE_TOO_LARGE, error );
+
+  limits = lnk::LNK_DEFAULT_PARSE_LIMITS;
+  limits.maxItemIds = 1;
+  ASSERT_FALSE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), info, limits, error) );
+  ASSERT_EQ( lnk::LNK_PARSE_ERROR_TOO_MANY_ITEMIDS, error );
+
+  limits = lnk::LNK_DEFAULT_PARSE_LIMITS;
+  limits.maxStringLength = 2;
+  ASSERT_FALSE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), info, limits, error) );
+  ASSERT_EQ( lnk::LNK_PARSE_ERROR_STRING_TOO_LONG, error );
+
+  limits = lnk::LNK_DEFAULT_PARSE_LIMITS;
+  limits.maxExtraDataBlocks = 0;
+  ASSERT_FALSE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), info, limits, error) );
+  ASSERT_EQ( lnk::LNK_PARSE_ERROR_TOO_MANY_EXTRADATA, error );
+}
+
+TEST_F(TestLNK, testParseErrors)
+{
+  lnk::LinkInfo info;
+  lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+
+  //not a link file
+  static const unsigned char NOT_A_LINK[] = "this is not a link file";
+  ASSERT_FALSE( lnk::getLinkInfo(NOT_A_LINK, sizeof(NOT_A_LINK), info, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+  ASSERT_EQ( lnk::LNK_PARSE_ERROR_SIGNATURE, error );
+  ASSERT_FALSE( lnk::isLink(NOT_A_LINK, sizeof(NOT_A_LINK)) );
+
+  //missing file
+  ASSERT_FALSE( lnk::getLinkInfo("./tests/missing.lnk", info, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+  ASSERT_EQ( lnk::LNK_PARSE_ERROR_IO, error );
+
+  //every truncated copy of a valid file must be rejected without crashing
+  lnk::MemoryBuffer buffer;
+  ASSERT_TRUE( buffer.loadFile("./tests/testWinXpLongFilename.lnk") );
+  ASSERT_TRUE( lnk::isLink(buffer.getBuffer(), buffer.getSize()) );
+  for(unsigned long size = 0; size < buffer.getSize(); size++)
+  {
+    lnk::MemoryBuffer truncated;
+    ASSERT_TRUE( truncated.allocate(size) );
+    if (size > 0)
+      memcpy(truncated.getBuffer(), buffer.getBuffer(), size);
+    bool success = lnk::getLinkInfo(truncated.getBuffer(), truncated.getSize(), info, lnk::LNK_DEFAULT_PARSE_LIMITS, error);
+    ASSERT_TRUE( success == false || error == lnk::LNK_PARSE_OK );
+    if (!success)
+    {
+      ASSERT_NE( lnk::LNK_PARSE_OK, error );
+      ASSERT_TRUE( lnk::getParseErrorDescription(error) != NULL );
+    }
+  }
+}
+
+TEST_F(TestLNK, testTrustedPolicy)
+{
+  static const char * FILES[] = {
+    "./tests/testWin7CdRom.lnk",
+    "./tests/testWin7LongFilename.lnk",
+    "./tests/testWin7MultipleFolders.lnk",
+    "./tests/testWin7NetworkPath.lnk",
+    "./tests/testWinXpIcon.lnk",
+    "./tests/testWinXpLongFilename.lnk",
+    "./tests/testWinXpNotepadArguments.lnk",
+    "./tests/testWinXpNotepadHotKey.lnk",
+  };
+  static const size_t NUM_FILES = sizeof(FILES)/sizeof(FILES[0]);
+
+  for(size_t i=0; i<NUM_FILES; i++)
+  {
+    lnk::MemoryBuffer buffer;
+    ASSERT_TRUE( buffer.loadFile(FILES[i]) );
+
+    lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+    lnk::LinkInfoEx untrusted;
+    ASSERT_TRUE( lnk::getLinkInfo<lnk::Untrusted>(buffer.getBuffer(), buffer.getSize(), untrusted, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+    lnk::LinkInfoEx trusted;
+    ASSERT_TRUE( lnk::getLinkInfo<lnk::Trusted>(buffer.getBuffer(), buffer.getSize(), trusted, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+    ASSERT_EQ( lnk::LNK_PARSE_OK, error );
+
+    //both policies must decode valid files identically
+    ASSERT_EQ( untrusted.target, trusted.target );
+    ASSERT_EQ( untrusted.networkPath, trusted.networkPath );
+    ASSERT_EQ( untrusted.arguments, trusted.arguments );
+    ASSERT_EQ( untrusted.description, trusted.description );
+    ASSERT_EQ( untrusted.workingDirectory, trusted.workingDirectory );
+    ASSERT_EQ( untrusted.customIcon.filename, trusted.customIcon.filename );
+    ASSERT_EQ( untrusted.customIcon.index, trusted.customIcon.index );
+    ASSERT_EQ( untrusted.hotKey.keyCode, trusted.hotKey.keyCode );
+    ASSERT_EQ( untrusted.relativePath, trusted.relativePath );
+    ASSERT_EQ( untrusted.volume.label, trusted.volume.label );
+    ASSERT_EQ( untrusted.networkShare.shareName, trusted.networkShare.shareName );
+  }
+}
+
+TEST_F(TestLNK, testSlowInputs)
+{
+  //slowest inputs found by libLNK_fuzz, kept as regression fixtures
+  struct SLOW_INPUT
+  {
+    const char * path;
+    lnk::LNK_PARSE_ERROR error;
+  };
+  static const SLOW_INPUT INPUTS[] = {
+    {"./tests/slow/slowExtraDataCount.lnk",         lnk::LNK_PARSE_ERROR_TOO_MANY_EXTRADATA},
+    {"./tests/slow/slowExtraDataHugeBlock.lnk",     lnk::LNK_PARSE_ERROR_TRUNCATED},
+    {"./tests/slow/slowExtraDataSmallBlock.lnk",    lnk::LNK_PARSE_OK},
+    {"./tests/slow/slowItemIdCount.lnk",            lnk::LNK_PARSE_ERROR_TOO_MANY_ITEMIDS},
+    {"./tests/slow/slowItemIdSizeOne.lnk",          lnk::LNK_PARSE_ERROR_INVALID_STRUCTURE},
+    {"./tests/slow/slowItemIdUnicodeScan.lnk",      lnk::LNK_PARSE_ERROR_INVALID_STRUCTURE},
+    {"./tests/slow/slowLinkInfoOffsets.lnk",        lnk::LNK_PARSE_ERROR_TRUNCATED},
+    {"./tests/slow/slowLinkInfoUnterminated.lnk",   lnk::LNK_PARSE_ERROR_TRUNCATED},
+    {"./tests/slow/slowLongString.lnk",             lnk::LNK_PARSE_OK},
+  };
+  static const size_t NUM_INPUTS = sizeof(INPUTS)/sizeof(INPUTS[0]);
+
+  //a 64 KB input must be parsed in linear time.
+  //the budget is large enough for debug builds but catches quadratic loops.
+  static const uint64_t MAX_NANOSECONDS = 100*1000*1000;
+
+  for(size_t i=0; i<NUM_INPUTS; i++)
+  {
+    const SLOW_INPUT & input = INPUTS[i];
+    lnk::MemoryBuffer buffer;
+    ASSERT_TRUE( buffer.loadFile(input.path) );
+
+    lnk::LinkInfoEx info;
+    lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+    uint64_t start = nativefunc::getHighResolutionTime();
+    bool success = lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), info, lnk::LNK_DEFAULT_PARSE_LIMITS, error);
+    uint64_t elapsed = nativefunc::getHighResolutionTime() - start;
+    ASSERT_EQ( input.error == lnk::LNK_PARSE_OK, success ) << input.path;
+    ASSERT_EQ( input.error, error ) << input.path;
+    ASSERT_LT( elapsed, MAX_NANOSECONDS ) << input.path;
+
+    //printLinkInfo() must also terminate
+    ASSERT_TRUE( lnk::printLinkInfo(input.path) ) << input.path;
+  }
+}
+
+TEST_F(TestLNK, testCreateLinkMemory)
+{
+  //local target
+  {
+    lnk::LinkInfo info;
+    info.target = "C:\\Program Files\\7-Zip\\History.txt";
+    info.arguments = "\"this is the arguments\"";
+    info.description = "this is my comment";
+    info.workingDirectory = "C:\\Program Files\\7-Zip";
+    info.customIcon.filename = "%SystemRoot%\\system32\\SHELL32.dll";
+    info.customIcon.index = 5;
+    info.hotKey = lnk::LNK_NO_HOTKEY;
+
+    lnk::LNK_TARGET target;
+    target.isFile = true;
+    target.isFolder = false;
+    target.fileSize = 1234;
+    target.shortPath = "C:\\PROGRA~1\\7-Zip\\HISTORY.TXT";
+
+    lnk::MemoryBuffer buffer;
+    ASSERT_TRUE( lnk::createLink(info, target, buffer) );
+
+    lnk::LinkInfoEx decoded;
+    lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+    ASSERT_TRUE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), decoded, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+    ASSERT_EQ( info.target, decoded.target );
+    ASSERT_EQ( "", decoded.networkPath );
+    ASSERT_EQ( info.arguments, decoded.arguments );
+    ASSERT_EQ( info.description, decoded.description );
+    ASSERT_EQ( info.workingDirectory, decoded.workingDirectory );
+    ASSERT_EQ( info.customIcon.filename, decoded.customIcon.filename );
+    ASSERT_EQ( info.customIcon.index, decoded.customIcon.index );
+    ASSERT_EQ( target.fileSize, decoded.fileSize );
+    ASSERT_TRUE( decoded.hasVolume );
+    ASSERT_FALSE( decoded.hasNetworkShare );
+  }
+
+  //mapped network drive with accented names
+  {
+    lnk::LinkInfo info;
+    info.target = "M:\\Projets\\R\xe9sum\xe9\\Caf\xe9.txt";
+    info.networkPath = "\\\\fileserver\\projects\\Projets\\R\xe9sum\xe9\\Caf\xe9.txt";
+    info.description = "Cr\xe9\xe9 par libLNK";
+    info.hotKey = lnk::LNK_NO_HOTKEY;
+
+    lnk::LNK_TARGET target;
+    target.isFile = true;
+    target.isFolder = false;
+    target.fileSize = 0;
+    target.shortPath = "M:\\Projets\\RSUM~1\\Caf\xe9.txt";
+
+    lnk::MemoryBuffer buffer;
+    ASSERT_TRUE( lnk::createLink(info, target, buffer) );
+
+    lnk::LinkInfoEx decoded;
+    lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+    ASSERT_TRUE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), decoded, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+    ASSERT_EQ( info.target, decoded.target );
+    ASSERT_EQ( info.networkPath, decoded.networkPath );
+    ASSERT_EQ( info.description, decoded.description );
+    ASSERT_FALSE( decoded.hasVolume );
+    ASSERT_TRUE( decoded.hasNetworkShare );
+    ASSERT_EQ( "\\\\fileserver\\projects", decoded.networkShare.shareName );
+    ASSERT_EQ( "M:", decoded.networkShare.deviceName );
+    ASSERT_EQ( "Projets\\R\xe9sum\xe9\\Caf\xe9.txt", decoded.finalPath );
+  }
+
+  //UNC target without a LinkTargetIDList
+  {
+    lnk::LinkInfo info;
+    info.target = "\\\\fileserver\\projects\\readme.txt";
+    info.networkPath = info.target;
+    info.hotKey = lnk::LNK_NO_HOTKEY;
+
+    lnk::LNK_TARGET target;
+    target.isFile = true;
+    target.isFolder = false;
+    target.fileSize = 0;
+    target.shortPath = info.target;
+
+    lnk::MemoryBuffer buffer;
+    ASSERT_TRUE( lnk::createLink(info, target, buffer) );
+
+    lnk::LinkInfoEx decoded;
+    lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+    ASSERT_TRUE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), decoded, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+    ASSERT_EQ( info.networkPath, decoded.networkPath );
+    ASSERT_EQ( "readme.txt", decoded.target );
+    ASSERT_EQ( "", decoded.networkShare.deviceName );
+  }
+
+  //local target without a drive letter
+  {
+    lnk::LinkInfo info;
+    info.target = "relative\\file.txt";
+    info.hotKey = lnk::LNK_NO_HOTKEY;
+
+    lnk::LNK_TARGET target;
+    target.isFile = true;
+    target.isFolder = false;
+    target.fileSize = 0;
+    target.shortPath = info.target;
+
+    lnk::MemoryBuffer buffer;
+    ASSERT_FALSE( lnk::createLink(info, target, buffer) );
+  }
+
+  //strings longer than the default limit
+  {
+    lnk::LinkInfo info;
+    info.target = "C:\\Program Files\\7-Zip\\History.txt";
+    info.hotKey = lnk::LNK_NO_HOTKEY;
+
+    lnk::LNK_TARGET target;
+    target.isFile = true;
+    target.isFolder = false;
+    target.fileSize = 1234;
+    target.shortPath = "C:\\PROGRA~1\\7-Zip\\HISTORY.TXT";
+
+    //the longest strings are readable with the default limits
+    const std::string longest(lnk::LNK_DEFAULT_PARSE_LIMITS.maxStringLength, 'a');
+    info.arguments = longest;
+    info.description = longest;
+    info.workingDirectory = longest;
+    info.customIcon.filename = longest;
+    lnk::MemoryBuffer buffer;
+    ASSERT_TRUE( lnk::createLink(info, target, buffer) );
+    lnk::LinkInfoEx decoded;
+    lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+    ASSERT_TRUE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), decoded, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+    ASSERT_EQ( longest, decoded.arguments );
+    ASSERT_EQ( longest, decoded.customIcon.filename );
+
+    //one more character, and more than the 16 bits of the length of a StringData
+    const std::string tooLong(longest.size() + 1, 'a');
+    const std::string wayTooLong(70000, 'a');
+    std::string * fields[] = {&info.arguments, &info.description, &info.workingDirectory, &info.customIcon.filename};
+    for(size_t i=0; i<sizeof(fields)/sizeof(fields[0]); i++)
+    {
+      std::string original = *fields[i];
+      *fields[i] = tooLong;
+      ASSERT_FALSE( lnk::createLink(info, target, buffer) );
+      *fields[i] = wayTooLong;
+      ASSERT_FALSE( lnk::createLink(info, target, buffer) );
+      *fields[i] = original;
+    }
+  }
+}
+
+uint64_t getTotalRejections(const lnk::Stats & iStats)
+{
+  uint64_t total = 0;
+  for(size_t i=0; i<lnk::LNK_PARSE_ERROR_COUNT; i++)
+    total += iStats.rejections[i];
+  return total;
+}
+
+TEST_F(TestLNK, testStats)
+{
+  lnk::Stats before;
+  if (!lnk::getStats(before))
+  {
+    //statistics are compiled out
+    for(size_t i=0; i<sizeof(before.itemIds)/sizeof(before.itemIds[0]); i++)
+      ASSERT_EQ( 0, before.itemIds[i] );
+    ASSERT_EQ( 0, before.filesParsed );
+    return;
+  }
+
+  const char * path = "./tests/testWin7LongFilename.lnk";
+  const unsigned long size = filesystem::getFileSize(path);
+
+  //probe
+  ASSERT_TRUE( lnk::isLink(path) );
+  lnk::Stats after;
+  ASSERT_TRUE( lnk::getStats(after) );
+  ASSERT_EQ( 1, after.filesProbed - before.filesProbed );
+  ASSERT_EQ( size, after.bytesRead - before.bytesRead );
+  ASSERT_EQ( 0, after.filesParsed - before.filesParsed );
+
+  //parse
+  lnk::MemoryBuffer buffer;
+  ASSERT_TRUE( buffer.loadFile(path) );
+  before = after;
+  lnk::LinkInfo info;
+  lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+  ASSERT_TRUE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), info, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+  ASSERT_TRUE( lnk::getStats(after) );
+  ASSERT_EQ( 0, after.filesProbed - before.filesProbed );
+  ASSERT_EQ( 1, after.filesParsed - before.filesParsed );
+  ASSERT_EQ( size, after.bytesParsed - before.bytesParsed );
+  ASSERT_EQ( 1, after.itemIds[0x1f] - before.itemIds[0x1f] ); //computer
+  ASSERT_EQ( 1, after.itemIds[0x2f] - before.itemIds[0x2f] ); //drive
+  ASSERT_EQ( 2, after.itemIds[0x31] - before.itemIds[0x31] ); //folders
+  ASSERT_EQ( 1, after.itemIds[0x32] - before.itemIds[0x32] ); //file
+  ASSERT_GT( after.stringBytesTranscoded, before.stringBytesTranscoded );
+  ASSERT_EQ( 1, after.extraDataBlocks[0xA0000003 - lnk::LNK_EXTRADATA_FIRST_SIGNATURE] - before.extraDataBlocks[0xA0000003 - lnk::LNK_EXTRADATA_FIRST_SIGNATURE] ); //TrackerDataBlock
+  ASSERT_EQ( 1, after.extraDataBlocks[0xA0000009 - lnk::LNK_EXTRADATA_FIRST_SIGNATURE] - before.extraDataBlocks[0xA0000009 - lnk::LNK_EXTRADATA_FIRST_SIGNATURE] ); //PropertyStoreDataBlock
+  ASSERT_EQ( 0, after.unknownExtraDataBlocks - before.unknownExtraDataBlocks );
+  ASSERT_EQ( 0, getTotalRejections(after) - getTotalRejections(before) );
+
+  //each rejected file is counted once, with its reason
+  before = after;
+  unsigned long numRejected = 0;
+  for(unsigned long length=0; length<buffer.getSize(); length++)
+  {
+    lnk::LinkInfo info;
+    if (!lnk::getLinkInfo(buffer.getBuffer(), length, info, lnk::LNK_DEFAULT_PARSE_LIMITS, error))
+      numRejected++;
+  }
+  ASSERT_TRUE( lnk::getStats(after) );
+  ASSERT_EQ( numRejected, getTotalRejections(after) - getTotalRejections(before) );
+  ASSERT_GT( after.rejections[lnk::LNK_PARSE_ERROR_SIGNATURE], before.rejections[lnk::LNK_PARSE_ERROR_SIGNATURE] );
+  ASSERT_GT( after.rejections[lnk::LNK_PARSE_ERROR_TRUNCATED], before.rejections[lnk::LNK_PARSE_ERROR_TRUNCATED] );
+  ASSERT_EQ( 0, after.rejections[lnk::LNK_PARSE_OK] );
+
+  //allocations of the library
+  before = after;
+  lnk::MemoryBuffer copy = buffer;
+  ASSERT_TRUE( lnk::getStats(after) );
+  ASSERT_EQ( 1, after.allocations - before.allocations );
+
+  //counters of the threads which have exited are kept, their memory is released
+  std::vector<unsigned char> image(buffer.getSize() * 8, 0);
+  for(size_t i=0; i<8; i++)
+    memcpy(&image[i * buffer.getSize()], buffer.getBuffer(), buffer.getSize());
+  lnk::CarveOptions options = lnk::LNK_DEFAULT_CARVE_OPTIONS;
+  options.numThreads = 4;
+  options.chunkSize = buffer.getSize();
+  const size_t numThreadStats = lnk::getNumThreadStats();
+  for(size_t i=0; i<10; i++)
+  {
+    before = after;
+    std::vector<lnk::CarvedLink> links;
+    ASSERT_TRUE( lnk::carveLinks(&image[0], image.size(), options, links) );
+    ASSERT_EQ( 8, links.size() );
+    ASSERT_TRUE( lnk::getStats(after) );
+    ASSERT_EQ( 8, after.filesParsed - before.filesParsed );
+    ASSERT_EQ( 8, after.itemIds[0x32] - before.itemIds[0x32] );
+    ASSERT_EQ( numThreadStats, lnk::getNumThreadStats() );
+  }
+}
+
+TEST_F(TestLNK, testDeepTargetPath)
+{
+  //deeper than the components collected before writing the target
+  static const int depths[] = {1, 20, 63, 64, 65, 150};
+  for(size_t i=0; i<sizeof(depths)/sizeof(depths[0]); i++)
+  {
+    lnk::LinkInfo info;
+    info.target = "C:";
+    for(int j=0; j<depths[i]; j++)
+    {
+      char folder[32];
+      sprintf(folder, "\\folder%03d", j);
+      info.target += folder;
+    }
+    info.target += "\\file.txt";
+    info.hotKey = lnk::LNK_NO_HOTKEY;
+
+    lnk::LNK_TARGET target;
+    target.isFile = true;
+    target.isFolder = false;
+    target.fileSize = 0;
+    target.shortPath = filesystem::getShortPathFormEstimation(info.target);
+
+    lnk::MemoryBuffer buffer;
+    ASSERT_TRUE( lnk::createLink(info, target, buffer) );
+
+    lnk::LinkInfo decoded;
+    lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+    ASSERT_TRUE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), decoded, lnk::LNK_DEFAULT_PARSE_LIMITS, error) ) << depths[i];
+    ASSERT_EQ( info.target, decoded.target );
+  }
+
+  //a folder with an empty long name does not repeat the separator
+  {
+    lnk::LinkInfo info;
+    info.target = "C:\\foo\\bar\\baz.txt";
+    info.hotKey = lnk::LNK_NO_HOTKEY;
+
+    lnk::LNK_TARGET target;
+    target.isFile = true;
+    target.isFolder = false;
+    target.fileSize = 0;
+    target.shortPath = info.target;
+
+    lnk::MemoryBuffer buffer;
+    ASSERT_TRUE( lnk::createLink(info, target, buffer) );
+    static const char LONG_NAME[] = "b\0a\0r\0\0"; //unicode name of the folder
+    std::string content((const char *)buffer.getBuffer(), buffer.getSize());
+    size_t offset = content.find(std::string(LONG_NAME, sizeof(LONG_NAME) - 1));
+    ASSERT_NE( std::string::npos, offset );
+    buffer.getBuffer()[offset + 4] = 0; //the name starts after the last NULL character
+
+    lnk::LinkInfo decoded;
+    lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+    ASSERT_TRUE( lnk::getLinkInfo(buffer.getBuffer(), buffer.getSize(), decoded, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+    ASSERT_EQ( "C:\\foo\\baz.txt", decoded.target );
+  }
+
+  //a LinkTargetIDList larger than 0xFFFF bytes
+  {
+    lnk::LinkInfo info;
+    info.target = "C:";
+    for(int j=0; j<300; j++)
+      info.target += "\\" + std::string(100, 'a' + j % 26);
+    info.hotKey = lnk::LNK_NO_HOTKEY;
+
+    lnk::LNK_TARGET target;
+    target.isFile = true;
+    target.isFolder = false;
+    target.fileSize = 0;
+    target.shortPath = filesystem::getShortPathFormEstimation(info.target);
+
+    lnk::MemoryBuffer buffer;
+    ASSERT_FALSE( lnk::createLink(info, target, buffer) );
+  }
+}
+
+struct SCAN_COUNTERS
+{
+  unsigned long numFiles;
+  unsigned long numRejected;
+  unsigned long maxFiles;
+};
+
+bool countScannedFile(const char * iFilePath, const lnk::LinkInfoEx & iLinkInfo, const lnk::LNK_PARSE_ERROR & iError, void * iUserData)
+{
+  SCAN_COUNTERS & counters = *(SCAN_COUNTERS *)iUserData;
+  counters.numFiles++;
+  if (iError != lnk::LNK_PARSE_OK)
+    counters.numRejected++;
+  return (counters.numFiles < counters.maxFiles);
+}
+
+TEST_F(TestLNK, testCreateLinks)
+{
+  std::string folder = filesystem::getTemporaryFilePath() + ".folder";
+  ASSERT_TRUE( filesystem::createFolder(folder.c_str()) );
+
+  static const size_t NUM_LINKS = 50;
+  static const size_t MISSING_FOLDER_INDEX = 17;
+  std::vector<lnk::BatchLink> links(NUM_LINKS);
+  for(size_t i=0; i<NUM_LINKS; i++)
+  {
+    lnk::BatchLink & link = links[i];
+    link.path = folder + filesystem::getPathSeparator() + "link" + stringfunc::toString((uint64_t)i) + ".lnk";
+    link.info.target = "C:\\WINDOWS\\system32\\cmd.exe";
+    link.info.arguments = "/c " + stringfunc::toString((uint64_t)i);
+    link.info.hotKey = lnk::LNK_NO_HOTKEY;
+  }
+  links[MISSING_FOLDER_INDEX].path = folder + filesystem::getPathSeparator() + "missing" + filesystem::getPathSeparator() + "link.lnk";
+
+  //an existing link is replaced
+  ASSERT_TRUE( lnk::createLink(links[0].path.c_str(), links[1].info) );
+
+  //with and without flushing, with the threads or with io_uring when available
+  for(int mode=0; mode<4; mode++)
+  {
+    lnk::BatchOptions options = lnk::LNK_DEFAULT_BATCH_OPTIONS;
+    options.durable = ((mode & 1) != 0);
+    options.useIoUring = ((mode & 2) != 0);
+    lnk::BatchReport report;
+    ASSERT_FALSE( lnk::createLinks(links, options, report) );
+    ASSERT_EQ( NUM_LINKS-1, report.numCreated );
+    ASSERT_EQ( 1, report.numFailed );
+    ASSERT_EQ( 1, report.failed.size() );
+    ASSERT_EQ( MISSING_FOLDER_INDEX, report.failed[0] );
+
+    //the links are complete
+    for(size_t i=0; i<NUM_LINKS; i++)
+    {
+      if (i == MISSING_FOLDER_INDEX)
+        continue;
+      lnk::LinkInfo info;
+      ASSERT_TRUE( lnk::getLinkInfo(links[i].path.c_str(), info) ) << links[i].path;
+      ASSERT_EQ( links[i].info.arguments, info.arguments );
+    }
+
+    //no temporary file is left in the folder
+    std::vector<std::string> files;
+    ASSERT_TRUE( filesystem::findFiles(folder.c_str(), false, files) );
+    ASSERT_EQ( NUM_LINKS-1, files.size() );
+  }
+
+  //targets which do not exist yet: the names of a same folder get distinct short names, in the order of the links
+  {
+    static const char * TARGETS[] = {
+      "C:\\libLNK missing folder\\Release Notes.txt",
+      "C:\\libLNK missing folder\\Release History.txt",
+      "C:\\libLNK missing folder\\Release Candidate.txt",
+    };
+    static const char * SHORT_PATHS[] = {
+      "C:\\LIBLNK~1\\RELEAS~1.TXT",
+      "C:\\LIBLNK~1\\RELEAS~2.TXT",
+      "C:\\LIBLNK~1\\RELEAS~3.TXT",
+    };
+    static const size_t NUM_TARGETS = sizeof(TARGETS)/sizeof(TARGETS[0]);
+    std::vector<lnk::BatchLink> collisions(NUM_TARGETS);
+    for(size_t i=0; i<NUM_TARGETS; i++)
+    {
+      collisions[i].path = folder + filesystem::getPathSeparator() + "collision" + stringfunc::toString((uint64_t)i) + ".lnk";
+      collisions[i].info.target = TARGETS[i];
+      collisions[i].info.hotKey = lnk::LNK_NO_HOTKEY;
+    }
+    lnk::BatchReport report;
+    ASSERT_TRUE( lnk::createLinks(collisions, lnk::LNK_DEFAULT_BATCH_OPTIONS, report) );
+    for(size_t i=0; i<NUM_TARGETS; i++)
+    {
+      lnk::LNK_TARGET target;
+      target.isFile = false;
+      target.isFolder = false;
+      target.fileSize = 0;
+      target.shortPath = SHORT_PATHS[i];
+      lnk::MemoryBuffer expected;
+      ASSERT_TRUE( lnk::createLink(collisions[i].info, target, expected) );
+      lnk::MemoryBuffer actual;
+      ASSERT_TRUE( actual.loadFile(collisions[i].path.c_str()) );
+      ASSERT_EQ( expected.getSize(), actual.getSize() ) << TARGETS[i];
+      ASSERT_EQ( 0, memcmp(expected.getBuffer(), actual.getBuffer(), expected.getSize()) ) << TARGETS[i];
+      remove(collisions[i].path.c_str());
+    }
+  }
+
+  //empty batch
+  {
+    std::vector<lnk::BatchLink> empty;
+    lnk::BatchReport report;
+    ASSERT_TRUE( lnk::createLinks(empty, lnk::LNK_DEFAULT_BATCH_OPTIONS, report) );
+    ASSERT_EQ( 0, report.numCreated );
+    ASSERT_EQ( 0, report.numFailed );
+  }
+
+  for(size_t i=0; i<NUM_LINKS; i++)
+    remove(links[i].path.c_str());
+  _rmdir(folder.c_str());
+}
+
+TEST_F(TestLNK, testScanFolder)
+{
+  lnk::ScanOptions options = lnk::LNK_DEFAULT_SCAN_OPTIONS;
+  options.numSlowest = 3;
+
+  //the fuzzing regression fixtures: 2 valid links and 7 rejected files
+  SCAN_COUNTERS counters = {0, 0, 1000};
+  lnk::ScanReport report;
+  ASSERT_TRUE( lnk::scanFolder("./tests/slow", false, options, &countScannedFile, &counters, report) );
+  ASSERT_EQ( 9, report.numFiles );
+  ASSERT_EQ( 7, report.numRejected );
+  ASSERT_EQ( 9, counters.numFiles );
+  ASSERT_EQ( 7, counters.numRejected );
+  ASSERT_EQ( 9, report.total.getCount() );
+  ASSERT_EQ( 9, report.stages[lnk::LNK_STAGE_OPEN].getCount() );
+  ASSERT_EQ( 9, report.stages[lnk::LNK_STAGE_HEADER].getCount() );
+  ASSERT_EQ( 9, report.stages[lnk::LNK_STAGE_IDLIST].getCount() );
+  ASSERT_LT( report.stages[lnk::LNK_STAGE_EXTRADATA].getCount(), 9 ); //not reached by files rejected in an earlier stage
+  ASSERT_GT( report.stages[lnk::LNK_STAGE_EXTRADATA].getCount(), 0 );
+
+  //slowest files, the slowest first
+  ASSERT_EQ( 3, report.slowest.size() );
+  ASSERT_EQ( report.total.getMax(), report.slowest[0].total );
+  for(size_t i=0; i<report.slowest.size(); i++)
+  {
+    const lnk::SlowFile & file = report.slowest[i];
+    if (i > 0)
+      ASSERT_GE( report.slowest[i-1].total, file.total );
+    ASSERT_EQ( "lnk", filesystem::getFileExtention(file.path) );
+    uint64_t sum = 0;
+    for(int j=0; j<lnk::LNK_STAGE_COUNT; j++)
+      sum += file.stages[j];
+    ASSERT_LE( sum, file.total );
+  }
+
+  //recursive scan also finds the links of the sub folders but skips other files (google.url)
+  lnk::ScanReport recursive;
+  ASSERT_TRUE( lnk::scanFolder("./tests", true, options, NULL, NULL, recursive) );
+  lnk::ScanReport flat;
+  ASSERT_TRUE( lnk::scanFolder("./tests", false, options, NULL, NULL, flat) );
+  ASSERT_EQ( flat.numFiles + 9, recursive.numFiles );
+  ASSERT_EQ( flat.numRejected + 7, recursive.numRejected );
+
+  //the callback stops the scan
+  SCAN_COUNTERS stop = {0, 0, 2};
+  ASSERT_FALSE( lnk::scanFolder("./tests/slow", false, options, &countScannedFile, &stop, report) );
+  ASSERT_EQ( 2, report.numFiles );
+  ASSERT_EQ( 2, stop.numFiles );
+
+  //no slow files
+  options.numSlowest = 0;
+  ASSERT_TRUE( lnk::scanFolder("./tests/slow", false, options, NULL, NULL, report) );
+  ASSERT_EQ( 0, report.slowest.size() );
+
+  ASSERT_FALSE( lnk::scanFolder("./tests/folderNotFound", false, options, NULL, NULL, report) );
+}
+
+struct TRACE_LOG
+{
+  std::vector<std::string> names; //names of the stages, in the order they begin
+  std::vector<std::string> stack; //stages currently open
+  bool nested;                    //each end matches the last begin
+};
+
+void onTraceBegin(const char * iName, void * iUserData)
+{
+  TRACE_LOG & log = *(TRACE_LOG *)iUserData;
+  log.names.push_back(iName);
+  log.stack.push_back(iName);
+}
+
+void onTraceEnd(const char * iName, void * iUserData)
+{
+  TRACE_LOG & log = *(TRACE_LOG *)iUserData;
+  if (log.stack.empty() || log.stack.back() != iName)
+    log.nested = false;
+  else
+    log.stack.pop_back();
+}
+
+TEST_F(TestLNK, testTraceHooks)
+{
+  TRACE_LOG log;
+  log.nested = true;
+
+  lnk::TraceHooks hooks;
+  hooks.begin = &onTraceBegin;
+  hooks.end = &onTraceEnd;
+  hooks.userData = &log;
+  if (!lnk::setTraceHooks(hooks))
+  {
+    //tracing is compiled out
+    lnk::LinkInfo info;
+    ASSERT_TRUE( lnk::getLinkInfo("./tests/testWin7LongFilename.lnk", info) );
+    ASSERT_EQ( 0, log.names.size() );
+    return;
+  }
+
+  //parser
+  lnk::LinkInfo info;
+  ASSERT_TRUE( lnk::getLinkInfo("./tests/testWin7LongFilename.lnk", info) );
+
+  static const char * EXPECTED_PARSER[] = {"loadLinkFile", "open", "read", "decodeLinkInfo", "header", "idlist", "linkinfo", "strings", "extradata"};
+  static const size_t NUM_EXPECTED_PARSER = sizeof(EXPECTED_PARSER)/sizeof(EXPECTED_PARSER[0]);
+  ASSERT_EQ( NUM_EXPECTED_PARSER, log.names.size() );
+  for(size_t i=0; i<NUM_EXPECTED_PARSER; i++)
+    ASSERT_EQ( EXPECTED_PARSER[i], log.names[i] );
+  ASSERT_TRUE( log.nested );
+  ASSERT_EQ( 0, log.stack.size() );
+
+  //a rejected file ends all its stages
+  log.names.clear();
+  lnk::LNK_PARSE_ERROR error = lnk::LNK_PARSE_OK;
+  const unsigned char truncated[] = {0x4C, 0x00, 0x00, 0x00};
+  ASSERT_FALSE( lnk::getLinkInfo(truncated, sizeof(truncated), info, lnk::LNK_DEFAULT_PARSE_LIMITS, error) );
+  ASSERT_EQ( 2, log.names.size() );
+  ASSERT_TRUE( log.nested );
+  ASSERT_EQ( 0, log.stack.size() );
+
+  //writer
+  log.names.clear();
+  info.target = "C:\\Program Files\\7-Zip\\History.txt";
+  info.arguments = "";
+  info.description = "this is my comment";
+  info.workingDirectory = "";
+  info.customIcon.filename = "";
+  lnk::LNK_TARGET target;
+  target.isFile = true;
+  target.isFolder = false;
+  target.fileSize = 1234;
+  target.shortPath = "C:\\PROGRA~1\\7-Zip\\HISTORY.TXT";
+  lnk::MemoryBuffer buffer;
+  ASSERT_TRUE( lnk::createLink(info, target, buffer) );
+
+  static const char * EXPECTED_WRITER[] = {"createLink", "createLinkTargetIDList", "addFileItemId", "addFileItemId", "addFileItemId", "writeStrings"};
+  static const size_t NUM_EXPECTED_WRITER = sizeof(EXPECTED_WRITER)/sizeof(EXPECTED_WRITER[0]);
+  ASSERT_EQ( NUM_EXPECTED_WRITER, log.names.size() );
+  for(size_t i=0; i<NUM_EXPECTED_WRITER; i++)
+    ASSERT_EQ( EXPECTED_WRITER[i], log.names[i] );
+  ASSERT_TRUE( log.nested );
+  ASSERT_EQ( 0, log.stack.size() );
+
+  //incomplete hooks are refused
+  hooks.end = NULL;
+  ASSERT_FALSE( lnk::setTraceHooks(hooks) );
+
+  //no more events after the hooks are removed
+  lnk::clearTraceHooks();
+  log.names.clear();
+  ASSERT_TRUE( lnk::getLinkInfo("./tests/testWin7LongFilename.lnk", info) );
+  ASSERT_EQ( 0, log.names.size() );
+}
+
+TEST_F(TestLNK, testTraceRecorder)
+{
+  lnk::TraceRecorder recorder;
+  if (!recorder.start())
+    return; //tracing is compiled out
+
+  lnk::ScanReport report;
+  ASSERT_TRUE( lnk::scanFolder("./tests/slow", false, lnk::LNK_DEFAULT_SCAN_OPTIONS, NULL, NULL, report) );
+  recorder.stop();
+
+  //each stage has a begin and an end event
+  size_t numEvents = recorder.getNumEvents();
+  ASSERT_GT( numEvents, 0 );
+  ASSERT_EQ( 0, numEvents % 2 );
+
+  //not recording anymore
+  lnk::LinkInfo info;
+  ASSERT_TRUE( lnk::getLinkInfo("./tests/testWin7LongFilename.lnk", info) );
+  ASSERT_EQ( numEvents, recorder.getNumEvents() );
+
+  //Chrome trace event format
+  std::string path = filesystem::getTemporaryFilePath() + ".json";
+  ASSERT_TRUE( recorder.save(path.c_str()) );
+  lnk::MemoryBuffer content;
+  ASSERT_TRUE( content.loadFile(path.c_str()) );
+  std::string json((const char *)content.getBuffer(), content.getSize());
+  remove(path.c_str());
+  ASSERT_EQ( 0, json.find("{\"traceEvents\":[") );
+  ASSERT_NE( std::string::npos, json.find("\"name\":\"scanFiles\",\"cat\":\"libLNK\",\"ph\":\"B\"") );
+  ASSERT_NE( std::string::npos, json.find("\"name\":\"extradata\",\"cat\":\"libLNK\",\"ph\":\"E\"") );
+
+  recorder.clear();
+  ASSERT_EQ( 0, recorder.getNumEvents() );
+}
@@ -0,0 +1,100 @@
+#include "TestLatencyHistogram.h"
+#include "LatencyHistogram.h"
+
+using namespace lnk;
+
+void TestLatencyHistogram::SetUp()
+{
+}
+
+void TestLatencyHistogram::TearDown()
+{
+}
+
+TEST_F(TestLatencyHistogram, testEmpty)
+{
+  LatencyHistogram histogram;
+  ASSERT_EQ( 0, histogram.getCount() );
+  ASSERT_EQ( 0, histogram.getMin() );
+  ASSERT_EQ( 0, histogram.getMax() );
+  ASSERT_EQ( 0.0, histogram.getMean() );
+  ASSERT_EQ( 0, histogram.getPercentile(50.0) );
+}
+
+TEST_F(TestLatencyHistogram, testBuckets)
+{
+  //small values have their own bucket
+  for(uint64_t value=0; value<32; value++)
+  {
+    size_t index = LatencyHistogram::getBucketIndex(value);
+    ASSERT_EQ( value, index );
+    ASSERT_EQ( value, LatencyHistogram::getBucketLowerBound(index) );
+    ASSERT_EQ( value, LatencyHistogram::getBucketUpperBound(index) );
+  }
+
+  //each value is within the bounds of its bucket and the buckets are contiguous
+  static const uint64_t VALUES[] = {32, 33, 63, 64, 100, 1000, 12345, 999999, 0x123456789ULL, 0x7FFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL};
+  for(size_t i=0; i<sizeof(VALUES)/sizeof(VALUES[0]); i++)
+  {
+    uint64_t value = VALUES[i];
+    size_t index = LatencyHistogram::getBucketIndex(value);
+    uint64_t lower = LatencyHistogram::getBucketLowerBound(index);
+    uint64_t upper = LatencyHistogram::getBucketUpperBound(index);
+    ASSERT_LE( lower, value ) << value;
+    ASSERT_GE( upper, value ) << value;
+    ASSERT_EQ( index, LatencyHistogram::getBucketIndex(lower) ) << value;
+    ASSERT_EQ( index, LatencyHistogram::getBucketIndex(upper) ) << value;
+    if (upper != 0xFFFFFFFFFFFFFFFFULL)
+      ASSERT_EQ( index+1, LatencyHistogram::getBucketIndex(upper+1) ) << value;
+
+    //relative error is at most 1/16
+    ASSERT_LE( (upper - lower), lower / 16 ) << value;
+  }
+}
+
+TEST_F(TestLatencyHistogram, testPercentiles)
+{
+  LatencyHistogram histogram;
+  for(uint64_t value=1; value<=1000; value++)
+    histogram.record(value * 1000);
+
+  ASSERT_EQ( 1000, histogram.getCount() );
+  ASSERT_EQ( 1000, histogram.getMin() );
+  ASSERT_EQ( 1000000, histogram.getMax() );
+  ASSERT_NEAR( 500500.0, histogram.getMean(), 0.001 );
+
+  ASSERT_EQ( 1000, histogram.getPercentile(0.0) );
+  ASSERT_EQ( 1000000, histogram.getPercentile(100.0) );
+
+  //the percentile is the upper bound of a bucket: never below the exact value and at most 6.25% above
+  static const double PERCENTILES[] = {1.0, 50.0, 90.0, 99.0, 99.9};
+  for(size_t i=0; i<sizeof(PERCENTILES)/sizeof(PERCENTILES[0]); i++)
+  {
+    double exact = PERCENTILES[i] * 10.0 * 1000.0;
+    uint64_t value = histogram.getPercentile(PERCENTILES[i]);
+    ASSERT_GE( (double)value, exact ) << PERCENTILES[i];
+    ASSERT_LE( (double)value, exact * 1.0625 ) << PERCENTILES[i];
+  }
+}
+
+TEST_F(TestLatencyHistogram, testAdd)
+{
+  LatencyHistogram fast;
+  LatencyHistogram slow;
+  for(int i=0; i<99; i++)
+    fast.record(100);
+  slow.record(1000000);
+
+  LatencyHistogram total;
+  total.add(fast);
+  total.add(slow);
+  ASSERT_EQ( 100, total.getCount() );
+  ASSERT_EQ( 100, total.getMin() );
+  ASSERT_EQ( 1000000, total.getMax() );
+  ASSERT_LE( total.getPercentile(99.0), 103 );
+  ASSERT_EQ( 1000000, total.getPercentile(99.5) );
+
+  total.clear();
+  ASSERT_EQ( 0, total.getCount() );
+  ASSERT_EQ( 0, total.getPercentile(99.0) );
+}
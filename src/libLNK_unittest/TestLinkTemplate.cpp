@@ -0,0 +1,195 @@
+#include "TestLinkTemplate.h"
+#include "LinkTemplate.h"
+#include "MemoryBuffer.h"
+#include <string.h> //for memcmp()
+
+#include "filesystemfunc.h"
+
+using namespace lnk;
+
+void TestLinkTemplate::SetUp()
+{
+}
+
+void TestLinkTemplate::TearDown()
+{
+}
+
+LNK_TARGET getFileTarget(const LinkInfo & iLinkInfo)
+{
+  LNK_TARGET target;
+  target.isFile = true;
+  target.isFolder = false;
+  target.fileSize = 1234;
+  target.shortPath = filesystem::getShortPathFormEstimation(iLinkInfo.target);
+  return target;
+}
+
+//Replaces the last element of a path
+std::string replaceFileName(const std::string & iPath, const std::string & iFileName)
+{
+  return iPath.substr(0, iPath.find_last_of('\\') + 1) + iFileName;
+}
+
+//Asserts that a link instantiated from a template is identical to the link created by createLink()
+void assertSameAsCreateLink(const LinkTemplate & iTemplate, const LinkInfo & iPrototype, const std::string & iArguments, const std::string & iFileName)
+{
+  LinkInfo info = iPrototype;
+  info.arguments = iArguments;
+  MemoryBuffer actual;
+  if (iFileName.empty())
+  {
+    ASSERT_TRUE( iTemplate.instantiate(iArguments, actual) );
+  }
+  else
+  {
+    ASSERT_TRUE( iTemplate.instantiate(iArguments, iFileName, "", actual) );
+    info.target = replaceFileName(info.target, iFileName);
+    if (!info.networkPath.empty())
+      info.networkPath = replaceFileName(info.networkPath, iFileName);
+  }
+
+  MemoryBuffer expected;
+  ASSERT_TRUE( createLink(info, getFileTarget(info), expected) );
+  ASSERT_EQ( expected.getSize(), actual.getSize() );
+  ASSERT_EQ( 0, memcmp(expected.getBuffer(), actual.getBuffer(), expected.getSize()) );
+
+  //the link is readable
+  LinkInfo decoded;
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  ASSERT_TRUE( getLinkInfo(actual.getBuffer(), actual.getSize(), decoded, LNK_DEFAULT_PARSE_LIMITS, error) );
+  ASSERT_NE( std::string::npos, info.target.find(decoded.target) ); //the target of a UNC path is decoded without its share
+  ASSERT_EQ( info.arguments, decoded.arguments );
+  ASSERT_EQ( info.description, decoded.description );
+  ASSERT_EQ( info.customIcon.filename, decoded.customIcon.filename );
+}
+
+void assertTemplate(const LinkInfo & iPrototype)
+{
+  LinkTemplate linkTemplate;
+  ASSERT_FALSE( linkTemplate.isCompiled() );
+  ASSERT_TRUE( linkTemplate.compile(iPrototype, getFileTarget(iPrototype)) );
+  ASSERT_TRUE( linkTemplate.isCompiled() );
+
+  static const char * ARGUMENTS[] = {"", "-a", "/install /quiet /log \"C:\\Temp\\setup.log\""};
+  static const char * FILE_NAMES[] = {"", "readme.txt", "README.TXT", "Release Notes.txt", "a", "A much longer file name than the prototype.html"};
+  for(size_t i=0; i<sizeof(ARGUMENTS)/sizeof(ARGUMENTS[0]); i++)
+  {
+    for(size_t j=0; j<sizeof(FILE_NAMES)/sizeof(FILE_NAMES[0]); j++)
+    {
+      SCOPED_TRACE(std::string("arguments='") + ARGUMENTS[i] + "' name='" + FILE_NAMES[j] + "'");
+      assertSameAsCreateLink(linkTemplate, iPrototype, ARGUMENTS[i], FILE_NAMES[j]);
+    }
+  }
+}
+
+TEST_F(TestLinkTemplate, testLocalTarget)
+{
+  LinkInfo info;
+  info.target = "C:\\Program Files\\7-Zip\\History.txt";
+  info.arguments = "";
+  info.description = "Release history of 7-Zip";
+  info.workingDirectory = "C:\\Program Files\\7-Zip";
+  info.customIcon.filename = "C:\\Windows\\system32\\SHELL32.dll";
+  info.customIcon.index = 23;
+  info.hotKey = LNK_NO_HOTKEY;
+  assertTemplate(info);
+
+  //prototype with arguments and without optional strings
+  info.arguments = "/prototype";
+  info.description = "";
+  info.workingDirectory = "";
+  info.customIcon.filename = "";
+  info.customIcon.index = 0;
+  assertTemplate(info);
+}
+
+TEST_F(TestLinkTemplate, testNetworkTarget)
+{
+  //mapped drive
+  LinkInfo info;
+  info.target = "Z:\\Documents\\History.txt";
+  info.networkPath = "\\\\server\\share\\Documents\\History.txt";
+  info.arguments = "-v";
+  info.description = "On a share";
+  info.workingDirectory = "";
+  info.customIcon.index = 0;
+  info.hotKey = LNK_NO_HOTKEY;
+  assertTemplate(info);
+
+  //UNC path
+  info.target = "\\\\server\\share\\History.txt";
+  info.networkPath = "\\\\server\\share\\History.txt";
+  assertTemplate(info);
+}
+
+TEST_F(TestLinkTemplate, testShortNameCollisions)
+{
+  LinkInfo info;
+  info.target = "C:\\Program Files\\7-Zip\\History.txt";
+  info.customIcon.index = 0;
+  info.hotKey = LNK_NO_HOTKEY;
+  LinkTemplate linkTemplate;
+  ASSERT_TRUE( linkTemplate.compile(info, getFileTarget(info)) );
+
+  //the names of a same folder get distinct short names, in the order of the links
+  static const char * FILE_NAMES[] = {"Release Notes.txt", "Release History.txt", "RELEASE NOTES.TXT", "readme.txt"};
+  static const char * SHORT_PATHS[] = {"C:\\PROGRA~1\\7-Zip\\RELEAS~1.TXT", "C:\\PROGRA~1\\7-Zip\\RELEAS~2.TXT", "C:\\PROGRA~1\\7-Zip\\RELEAS~1.TXT", "C:\\PROGRA~1\\7-Zip\\readme.txt"};
+  filesystem::ShortNameGenerator generator;
+  for(size_t i=0; i<sizeof(FILE_NAMES)/sizeof(FILE_NAMES[0]); i++)
+  {
+    SCOPED_TRACE(FILE_NAMES[i]);
+    MemoryBuffer actual;
+    ASSERT_TRUE( linkTemplate.instantiate("", FILE_NAMES[i], generator, actual) );
+
+    LinkInfo expectedInfo = info;
+    expectedInfo.target = replaceFileName(info.target, FILE_NAMES[i]);
+    LNK_TARGET target = getFileTarget(expectedInfo);
+    target.shortPath = SHORT_PATHS[i];
+    MemoryBuffer expected;
+    ASSERT_TRUE( createLink(expectedInfo, target, expected) );
+    ASSERT_EQ( expected.getSize(), actual.getSize() );
+    ASSERT_EQ( 0, memcmp(expected.getBuffer(), actual.getBuffer(), expected.getSize()) );
+  }
+
+  MemoryBuffer buffer;
+  ASSERT_FALSE( linkTemplate.instantiate("", "Lang\\en.ttt", generator, buffer) );
+  ASSERT_FALSE( linkTemplate.instantiate("", "", generator, buffer) );
+}
+
+TEST_F(TestLinkTemplate, testInvalid)
+{
+  LinkTemplate linkTemplate;
+  MemoryBuffer buffer;
+  ASSERT_FALSE( linkTemplate.instantiate("", buffer) );
+
+  //root of a share
+  LinkInfo info;
+  info.target = "\\\\server\\share";
+  info.networkPath = "\\\\server\\share";
+  info.customIcon.index = 0;
+  info.hotKey = LNK_NO_HOTKEY;
+  ASSERT_FALSE( linkTemplate.compile(info, getFileTarget(info)) );
+  ASSERT_FALSE( linkTemplate.isCompiled() );
+
+  //names with a folder
+  info.target = "C:\\Program Files\\7-Zip\\History.txt";
+  info.networkPath = "";
+  ASSERT_TRUE( linkTemplate.compile(info, getFileTarget(info)) );
+  ASSERT_FALSE( linkTemplate.instantiate("", "Lang\\en.ttt", "", buffer) );
+  ASSERT_FALSE( linkTemplate.instantiate("", "", "", buffer) );
+  ASSERT_TRUE( linkTemplate.instantiate("", "7z.exe", "", buffer) );
+
+  //a name larger than an ItemID
+  ASSERT_FALSE( linkTemplate.instantiate("", std::string(0x8000, 'a'), "", buffer) );
+
+  //arguments longer than the default limit
+  const std::string longest(LNK_DEFAULT_PARSE_LIMITS.maxStringLength, 'a');
+  ASSERT_TRUE( linkTemplate.instantiate(longest, buffer) );
+  LinkInfo decoded;
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  ASSERT_TRUE( getLinkInfo(buffer.getBuffer(), buffer.getSize(), decoded, LNK_DEFAULT_PARSE_LIMITS, error) );
+  ASSERT_EQ( longest, decoded.arguments );
+  ASSERT_FALSE( linkTemplate.instantiate(longest + "a", buffer) );
+  ASSERT_FALSE( linkTemplate.instantiate(std::string(40000, 'a'), buffer) );
+}
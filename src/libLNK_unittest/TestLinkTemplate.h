@@ -0,0 +1,10 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+class TestLinkTemplate : public ::testing::Test
+{
+public:
+  virtual void SetUp();
+  virtual void TearDown();
+};
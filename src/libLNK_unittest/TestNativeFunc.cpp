@@ -45,5 +45,27 @@ namespace nativefunc { namespace test
     ASSERT_LT(diff, EXPECTED+1); //allow 1 seconds of difference
   }
   //--------------------------------------------------------------------------------------------------
+  TEST_F(TestNativeFunc, testGetHighResolutionTime)
+  {
+    uint64_t time1 = nativefunc::getHighResolutionTime();
+    ASSERT_EQ(0, nativefunc::millisleep(100));
+    uint64_t time2 = nativefunc::getHighResolutionTime();
+
+    //the clock is monotonic and measures at least the sleeping time
+    ASSERT_GT(time2, time1);
+    uint64_t elapsedMs = (time2 - time1) / 1000000;
+    ASSERT_GE(elapsedMs, 90u);
+    ASSERT_LT(elapsedMs, 5000u);
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestNativeFunc, testGetCurrentThreadId)
+  {
+    //the identifier is stable for the calling thread
+    uint32_t id1 = nativefunc::getCurrentThreadId();
+    uint32_t id2 = nativefunc::getCurrentThreadId();
+    ASSERT_NE(0u, id1);
+    ASSERT_EQ(id1, id2);
+  }
+  //--------------------------------------------------------------------------------------------------
 } // End namespace test
 } // End namespace nativefunc
@@ -0,0 +1,229 @@
+#include "TestReader.h"
+#include "libLNK.h"
+#include "Reader.h"
+#include "MemoryBuffer.h"
+#include <stdio.h> //for fopen()
+
+#include "filesystemfunc.h"
+#include "stringfunc.h"
+
+using namespace lnk;
+
+void TestReader::SetUp()
+{
+}
+
+void TestReader::TearDown()
+{
+}
+
+//implemented in TestLNK.cpp
+void assertSameLinkInfo(const LinkInfoEx & iExpected, const LinkInfoEx & iActual);
+
+//A stream which counts the bytes read and skipped
+class CountingReader : public MemoryReader
+{
+public:
+  CountingReader(const unsigned char * iBuffer, unsigned long iSize) : MemoryReader(iBuffer, iSize), bytesRead(0), bytesSkipped(0) {}
+
+  virtual bool read(void * oBuffer, unsigned long iSize, unsigned long & oRead)
+  {
+    bool success = MemoryReader::read(oBuffer, iSize, oRead);
+    bytesRead += oRead;
+    return success;
+  }
+  virtual bool skip(unsigned long iSize, unsigned long & oSkipped)
+  {
+    bool success = MemoryReader::skip(iSize, oSkipped);
+    bytesSkipped += oSkipped;
+    return success;
+  }
+
+  unsigned long bytesRead;
+  unsigned long bytesSkipped;
+};
+
+//A stream which cannot be read
+class FailingReader : public Reader
+{
+public:
+  virtual bool read(void * oBuffer, unsigned long iSize, unsigned long & oRead)
+  {
+    oRead = 0;
+    return false;
+  }
+};
+
+std::vector<std::string> findTestLinks()
+{
+  std::vector<std::string> files;
+  std::vector<std::string> links;
+  filesystem::findFiles("./tests", false, files);
+  for(size_t i=0; i<files.size(); i++)
+  {
+    if (stringfunc::lowercase(filesystem::getFileExtention(files[i])) == "lnk")
+      links.push_back(files[i]);
+  }
+  return links;
+}
+
+TEST_F(TestReader, testSameAsBuffer)
+{
+  std::vector<std::string> links = findTestLinks();
+  ASSERT_GT( links.size(), 10 );
+
+  MemoryBuffer window;
+  for(size_t i=0; i<links.size(); i++)
+  {
+    MemoryBuffer content;
+    ASSERT_TRUE( content.loadFile(links[i].c_str()) );
+
+    LinkInfoEx expected;
+    LNK_PARSE_ERROR expectedError = LNK_PARSE_OK;
+    ASSERT_TRUE( getLinkInfo(content.getBuffer(), content.getSize(), expected, LNK_DEFAULT_PARSE_LIMITS, expectedError) ) << links[i];
+
+    //the ExtraData blocks are skipped, not kept in the window
+    CountingReader reader(content.getBuffer(), content.getSize());
+    LinkInfoEx actual;
+    LNK_PARSE_ERROR error = LNK_PARSE_OK;
+    ASSERT_TRUE( getLinkInfo(reader, actual, LNK_DEFAULT_PARSE_LIMITS, error, window) ) << links[i];
+    assertSameLinkInfo(expected, actual);
+    ASSERT_EQ( expected.linkFlags, actual.linkFlags );
+    ASSERT_EQ( expected.writeTime, actual.writeTime );
+    ASSERT_EQ( content.getSize(), reader.getOffset() ) << links[i];
+    ASSERT_EQ( content.getSize(), reader.bytesRead + reader.bytesSkipped );
+    ASSERT_LE( window.getSize(), reader.bytesRead );
+
+    LinkInfo info;
+    MemoryReader reader2(content.getBuffer(), content.getSize());
+    ASSERT_TRUE( getLinkInfo(reader2, info, LNK_DEFAULT_PARSE_LIMITS, error) );
+    ASSERT_EQ( expected.target, info.target );
+  }
+
+  //a link with a large ExtraData block
+  MemoryBuffer content;
+  ASSERT_TRUE( content.loadFile("./tests/testWin7LongFilename.lnk") );
+  CountingReader reader(content.getBuffer(), content.getSize());
+  LinkInfoEx info;
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  ASSERT_TRUE( getLinkInfo(reader, info, LNK_DEFAULT_PARSE_LIMITS, error, window) );
+  ASSERT_GT( reader.bytesSkipped, 0 );
+  ASSERT_LT( window.getSize(), content.getSize() );
+}
+
+TEST_F(TestReader, testTruncatedStream)
+{
+  static const char * files[] = {
+    "./tests/testWin7MappedDrive.lnk",
+    "./tests/testWinXpNotepadIconTree.lnk",
+  };
+  static const size_t numFiles = sizeof(files)/sizeof(files[0]);
+
+  //every prefix of a link is decoded the same way from a buffer and from a stream
+  for(size_t i=0; i<numFiles; i++)
+  {
+    MemoryBuffer content;
+    ASSERT_TRUE( content.loadFile(files[i]) );
+    for(unsigned long size=0; size<=content.getSize(); size++)
+    {
+      LinkInfo expected;
+      LNK_PARSE_ERROR expectedError = LNK_PARSE_OK;
+      bool expectedSuccess = getLinkInfo(content.getBuffer(), size, expected, LNK_DEFAULT_PARSE_LIMITS, expectedError);
+
+      MemoryReader reader(content.getBuffer(), size);
+      LinkInfo actual;
+      LNK_PARSE_ERROR error = LNK_PARSE_OK;
+      bool success = getLinkInfo(reader, actual, LNK_DEFAULT_PARSE_LIMITS, error);
+      ASSERT_EQ( expectedSuccess, success ) << files[i] << " truncated to " << size << " bytes";
+      ASSERT_EQ( expectedError, error ) << files[i] << " truncated to " << size << " bytes";
+      if (success)
+        ASSERT_EQ( expected.target, actual.target );
+    }
+  }
+}
+
+TEST_F(TestReader, testConsecutiveLinks)
+{
+  //links stored one after the other in a stream are read one at a time
+  static const char * files[] = {
+    "./tests/testWin7MappedDrive.lnk",
+    "./tests/testWinXpArguments.lnk",
+    "./tests/testWin7CdRom.lnk",
+  };
+  static const size_t numFiles = sizeof(files)/sizeof(files[0]);
+
+  MemoryBuffer stream;
+  std::vector<LinkInfoEx> expected(numFiles);
+  for(size_t i=0; i<numFiles; i++)
+  {
+    MemoryBuffer content;
+    ASSERT_TRUE( content.loadFile(files[i]) );
+    ASSERT_TRUE( getLinkInfo(files[i], expected[i]) );
+    ASSERT_TRUE( serialize(content.getBuffer(), content.getSize(), stream) );
+  }
+
+  MemoryReader reader(stream.getBuffer(), stream.getSize());
+  MemoryBuffer window;
+  LinkInfoEx info;
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  for(size_t i=0; i<numFiles; i++)
+  {
+    ASSERT_TRUE( getLinkInfo(reader, info, LNK_DEFAULT_PARSE_LIMITS, error, window) ) << files[i];
+    assertSameLinkInfo(expected[i], info);
+  }
+  ASSERT_EQ( stream.getSize(), reader.getOffset() );
+
+  //end of the stream
+  ASSERT_FALSE( getLinkInfo(reader, info, LNK_DEFAULT_PARSE_LIMITS, error, window) );
+  ASSERT_EQ( LNK_PARSE_ERROR_SIGNATURE, error );
+}
+
+TEST_F(TestReader, testFileReader)
+{
+  const char * path = "./tests/testWinXpNotepadIconTree.lnk";
+  LinkInfoEx expected;
+  ASSERT_TRUE( getLinkInfo(path, expected) );
+
+  FILE * f = fopen(path, "rb");
+  ASSERT_TRUE( f != NULL );
+  FileReader reader(f);
+  LinkInfoEx info;
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+  bool success = getLinkInfo(reader, info, LNK_DEFAULT_PARSE_LIMITS, error);
+  fclose(f);
+  ASSERT_TRUE( success );
+  assertSameLinkInfo(expected, info);
+}
+
+TEST_F(TestReader, testInvalidStream)
+{
+  MemoryBuffer content;
+  ASSERT_TRUE( content.loadFile("./tests/testWin7LongFilename.lnk") );
+  LinkInfo info;
+  LNK_PARSE_ERROR error = LNK_PARSE_OK;
+
+  //not a link: only the header is read
+  static const char * text = "[InternetShortcut]\r\nURL=http://www.google.com/\r\n........................................";
+  CountingReader textReader((const unsigned char *)text, (unsigned long)strlen(text));
+  ASSERT_FALSE( getLinkInfo(textReader, info, LNK_DEFAULT_PARSE_LIMITS, error) );
+  ASSERT_EQ( LNK_PARSE_ERROR_SIGNATURE, error );
+  ASSERT_LE( textReader.bytesRead, 0x4D );
+
+  //read errors
+  FailingReader failing;
+  ASSERT_FALSE( getLinkInfo(failing, info, LNK_DEFAULT_PARSE_LIMITS, error) );
+  ASSERT_EQ( LNK_PARSE_ERROR_IO, error );
+
+  //the limits are enforced while reading
+  ParseLimits limits = LNK_DEFAULT_PARSE_LIMITS;
+  limits.maxFileSize = content.getSize() - 1;
+  MemoryReader reader(content.getBuffer(), content.getSize());
+  ASSERT_FALSE( getLinkInfo(reader, info, limits, error) );
+  ASSERT_EQ( LNK_PARSE_ERROR_FILE_TOO_LARGE, error );
+
+  limits = LNK_DEFAULT_PARSE_LIMITS;
+  limits.maxExtraDataBlocks = 1;
+  MemoryReader reader2(content.getBuffer(), content.getSize());
+  ASSERT_FALSE( getLinkInfo(reader2, info, limits, error) );
+  ASSERT_EQ( LNK_PARSE_ERROR_TOO_MANY_EXTRADATA, error );
+}
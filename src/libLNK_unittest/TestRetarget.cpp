@@ -0,0 +1,203 @@
+#include "TestRetarget.h"
+#include "Retarget.h"
+#include "MemoryBuffer.h"
+#include <string.h> //for memcmp()
+#include <stdio.h> //for remove()
+
+#include "filesystemfunc.h"
+
+#include <direct.h> //for _rmdir()
+
+using namespace lnk;
+
+void TestRetarget::SetUp()
+{
+}
+
+void TestRetarget::TearDown()
+{
+}
+
+std::string rewritePath(const RetargetRules & iRules, const std::string & iPath)
+{
+  std::string path = "unchanged";
+  if (!iRules.rewrite(iPath, path))
+    return "no match";
+  return path;
+}
+
+TEST_F(TestRetarget, testRules)
+{
+  RetargetRules rules;
+  ASSERT_EQ( 0, rules.count() );
+  ASSERT_EQ( "no match", rewritePath(rules, "\\\\server\\share\\file.txt") );
+
+  ASSERT_TRUE( rules.addRule("\\\\server\\share", "\\\\newserver\\share") );
+  ASSERT_TRUE( rules.addRule("\\\\server\\share\\archive\\", "\\\\archive\\2024") );
+  ASSERT_TRUE( rules.addRule("Z:\\Projects", "Y:\\") );
+  ASSERT_EQ( 3, rules.count() );
+
+  //duplicates and empty prefixes
+  ASSERT_FALSE( rules.addRule("\\\\SERVER\\SHARE\\", "\\\\other\\share") );
+  ASSERT_FALSE( rules.addRule("//server/share", "\\\\other\\share") );
+  ASSERT_FALSE( rules.addRule("", "C:\\") );
+  ASSERT_FALSE( rules.addRule("\\\\", "C:\\") );
+  ASSERT_EQ( 3, rules.count() );
+
+  //case and separators are ignored
+  ASSERT_EQ( "\\\\newserver\\share\\folder\\file.txt", rewritePath(rules, "\\\\server\\share\\folder\\file.txt") );
+  ASSERT_EQ( "\\\\newserver\\share\\folder\\file.txt", rewritePath(rules, "\\\\SERVER\\Share\\folder\\file.txt") );
+  ASSERT_EQ( "\\\\newserver\\share/folder/file.txt", rewritePath(rules, "//server/share/folder/file.txt") );
+  ASSERT_EQ( "\\\\newserver\\share", rewritePath(rules, "\\\\server\\share") );
+  ASSERT_EQ( "\\\\newserver\\share\\", rewritePath(rules, "\\\\server\\share\\") );
+
+  //whole path elements only
+  ASSERT_EQ( "no match", rewritePath(rules, "\\\\server\\shared\\file.txt") );
+  ASSERT_EQ( "no match", rewritePath(rules, "\\\\server\\shar") );
+  ASSERT_EQ( "no match", rewritePath(rules, "\\\\server2\\share\\file.txt") );
+
+  //longest prefix
+  ASSERT_EQ( "\\\\archive\\2024\\file.txt", rewritePath(rules, "\\\\server\\share\\Archive\\file.txt") );
+  ASSERT_EQ( "\\\\newserver\\share\\archives\\file.txt", rewritePath(rules, "\\\\server\\share\\archives\\file.txt") );
+
+  //drive paths
+  ASSERT_EQ( "Y:\\setup.exe", rewritePath(rules, "z:\\projects\\setup.exe") );
+  ASSERT_EQ( "no match", rewritePath(rules, "C:\\Projects\\setup.exe") );
+}
+
+TEST_F(TestRetarget, testRetargetFolder)
+{
+  std::string folder = filesystem::getTemporaryFilePath() + ".folder";
+  ASSERT_TRUE( filesystem::createFolder(folder.c_str()) );
+
+  //links to a mapped drive, to a UNC path, to a local file and to an unrelated file
+  static const char * FIXTURES[] = {
+    "testWin7MappedDrive.lnk",
+    "testWin7NetworkPath.lnk",
+    "testWin7LongFilename.lnk",
+    "testWinXpNotepadDefault.lnk",
+  };
+  static const size_t NUM_FIXTURES = sizeof(FIXTURES)/sizeof(FIXTURES[0]);
+  std::vector<std::string> paths;
+  std::vector<MemoryBuffer> originals(NUM_FIXTURES);
+  for(size_t i=0; i<NUM_FIXTURES; i++)
+  {
+    ASSERT_TRUE( originals[i].loadFile((std::string("./tests/") + FIXTURES[i]).c_str()) );
+    paths.push_back(folder + filesystem::getPathSeparator() + FIXTURES[i]);
+    ASSERT_TRUE( filesystem::writeFile(paths[i].c_str(), originals[i].getBuffer(), originals[i].getSize(), false) );
+  }
+  std::string invalid = folder + filesystem::getPathSeparator() + "invalid.lnk";
+  ASSERT_TRUE( filesystem::writeFile(invalid.c_str(), "not a link", 10, false) );
+
+  RetargetRules rules;
+  ASSERT_TRUE( rules.addRule("\\\\d49fil01\\ISO", "\\\\d50fil02\\Standards") );
+  ASSERT_TRUE( rules.addRule("\\\\FILSRV01", "\\\\filsrv02") );
+  ASSERT_TRUE( rules.addRule("D:\\temp", "E:\\archive\\temp") );
+
+  //dry run
+  RetargetOptions options = LNK_DEFAULT_RETARGET_OPTIONS;
+  options.dryRun = true;
+  RetargetReport report;
+  ASSERT_FALSE( retargetFolder(folder.c_str(), false, rules, options, report) );
+  ASSERT_EQ( NUM_FIXTURES + 1, report.numLinks );
+  ASSERT_EQ( 3, report.numChanged );
+  ASSERT_EQ( 1, report.numFailed );
+  ASSERT_EQ( 4, report.changes.size() );
+  for(size_t i=0; i<NUM_FIXTURES; i++)
+  {
+    MemoryBuffer content;
+    ASSERT_TRUE( content.loadFile(paths[i].c_str()) );
+    ASSERT_EQ( originals[i].getSize(), content.getSize() );
+    ASSERT_EQ( 0, memcmp(originals[i].getBuffer(), content.getBuffer(), content.getSize()) );
+  }
+
+  //report of the changes, in the order of the files
+  ASSERT_EQ( invalid, report.changes[0].path );
+  ASSERT_FALSE( report.changes[0].success );
+  ASSERT_EQ( paths[2], report.changes[1].path );
+  ASSERT_TRUE( report.changes[1].success );
+  ASSERT_EQ( 2, report.changes[1].values.size() ); //target and working directory, the relative path does not match
+  ASSERT_EQ( LNK_FIELD_TARGET, report.changes[1].values[0].field );
+  ASSERT_EQ( "D:\\temp\\foo\\thisisalongfilename.txt", report.changes[1].values[0].oldValue );
+  ASSERT_EQ( "E:\\archive\\temp\\foo\\thisisalongfilename.txt", report.changes[1].values[0].newValue );
+  ASSERT_EQ( LNK_FIELD_WORKING_DIRECTORY, report.changes[1].values[1].field );
+  ASSERT_EQ( paths[0], report.changes[2].path );
+  ASSERT_EQ( paths[1], report.changes[3].path );
+
+  std::string csv = folder + ".csv";
+  ASSERT_TRUE( saveRetargetReport(report, csv.c_str()) );
+  MemoryBuffer csvContent;
+  ASSERT_TRUE( csvContent.loadFile(csv.c_str()) );
+  std::string csvText((const char *)csvContent.getBuffer(), csvContent.getSize());
+  ASSERT_EQ( 0, csvText.find("path,field,old value,new value,status\n") );
+  ASSERT_NE( std::string::npos, csvText.find(",networkPath,\"\\\\d49fil01\\ISO\\STANDARD\\9000\\E\\9001E.PDF\",\"\\\\d50fil02\\Standards\\STANDARD\\9000\\E\\9001E.PDF\",ok\n") );
+  ASSERT_NE( std::string::npos, csvText.find(",,,,failed\n") );
+  remove(csv.c_str());
+
+  //rewrite
+  options.dryRun = false;
+  ASSERT_FALSE( retargetFolder(folder.c_str(), false, rules, options, report) );
+  ASSERT_EQ( 3, report.numChanged );
+
+  LinkInfoEx info;
+  ASSERT_TRUE( getLinkInfo(paths[0].c_str(), info) );
+  ASSERT_EQ( "Z:\\STANDARD\\9000\\E\\9001E.PDF", info.target ); //mapped drive is kept
+  ASSERT_EQ( "\\\\d50fil02\\Standards\\STANDARD\\9000\\E\\9001E.PDF", info.networkPath );
+  ASSERT_EQ( "Z:", info.networkShare.deviceName );
+
+  ASSERT_TRUE( getLinkInfo(paths[1].c_str(), info) );
+  ASSERT_EQ( "\\\\filsrv02\\ISO\\HOME.PDF", info.networkPath );
+  ASSERT_EQ( "\\\\filsrv02\\ISO", info.workingDirectory );
+
+  ASSERT_TRUE( getLinkInfo(paths[2].c_str(), info) );
+  ASSERT_EQ( "E:\\archive\\temp\\foo\\thisisalongfilename.txt", info.target );
+  ASSERT_EQ( "E:\\archive\\temp\\foo", info.workingDirectory );
+  ASSERT_EQ( ".\\thisisalongfilename.txt", info.relativePath );
+
+  //unrelated links are not modified
+  MemoryBuffer content;
+  ASSERT_TRUE( content.loadFile(paths[3].c_str()) );
+  ASSERT_EQ( originals[3].getSize(), content.getSize() );
+  ASSERT_EQ( 0, memcmp(originals[3].getBuffer(), content.getBuffer(), content.getSize()) );
+
+  //nothing left to rewrite
+  ASSERT_FALSE( retargetFolder(folder.c_str(), false, rules, options, report) );
+  ASSERT_EQ( 0, report.numChanged );
+
+  for(size_t i=0; i<NUM_FIXTURES; i++)
+    remove(paths[i].c_str());
+  remove(invalid.c_str());
+  _rmdir(folder.c_str());
+}
+
+TEST_F(TestRetarget, testRetargetLargeLink)
+{
+  std::string folder = filesystem::getTemporaryFilePath() + ".folder";
+  ASSERT_TRUE( filesystem::createFolder(folder.c_str()) );
+
+  //a valid link followed by garbage, larger than the default limit
+  MemoryBuffer original;
+  ASSERT_TRUE( original.loadFile("./tests/testWin7LongFilename.lnk") );
+  const unsigned long size = LNK_DEFAULT_PARSE_LIMITS.maxFileSize + 1;
+  std::vector<unsigned char> content(size, 0);
+  memcpy(&content[0], original.getBuffer(), original.getSize());
+  std::string path = folder + filesystem::getPathSeparator() + "large.lnk";
+  ASSERT_TRUE( filesystem::writeFile(path.c_str(), &content[0], size, false) );
+
+  RetargetRules rules;
+  ASSERT_TRUE( rules.addRule("D:\\temp", "E:\\archive\\temp") );
+  RetargetReport report;
+  ASSERT_FALSE( retargetFolder(folder.c_str(), false, rules, LNK_DEFAULT_RETARGET_OPTIONS, report) );
+  ASSERT_EQ( 1, report.numLinks );
+  ASSERT_EQ( 0, report.numChanged );
+  ASSERT_EQ( 1, report.numFailed );
+
+  //the file is not modified
+  MemoryBuffer result;
+  ASSERT_TRUE( result.loadFile(path.c_str()) );
+  ASSERT_EQ( size, result.getSize() );
+  ASSERT_EQ( 0, memcmp(&content[0], result.getBuffer(), size) );
+
+  remove(path.c_str());
+  _rmdir(folder.c_str());
+}